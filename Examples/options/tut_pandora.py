@@ -82,6 +82,29 @@ pandoralg.AbsorberRadLengthHCal= 0.0569
 pandoralg.AbsorberIntLengthHCal= 0.006  
 pandoralg.AbsorberRadLengthOther= 0.0569
 pandoralg.AbsorberIntLengthOther= 0.006 
+#### Threads building the calo hit parameters; hits are still created in collection order
+pandoralg.CaloHitParameterThreads = 1
+pandoralg.CaloHitParameterChunkSize = 256
+#### Dead or noisy cells, lines of 'collection cellID [mipThreshold]'; empty for none
+pandoralg.CellMaskFile = ""
+#### Per subdetector [earliest, latest] hit time in ns passed to pandora; empty for no window
+pandoralg.ECalTimeWindow = []
+pandoralg.HCalTimeWindow = []
+pandoralg.MuonTimeWindow = []
+pandoralg.TimeWindowTofCorrection = False
+#### Fast mode: merge [N, M] neighbouring cells of each layer into one virtual cell; empty for no merging
+pandoralg.CellCoarsening = []
+#### Calo hits and tracks repeated across collections: none, keepFirst, sumEnergy or error
+pandoralg.DuplicatePolicy = "none"
+#### Per-stage timing of execute: counters, histograms (THistSvc) and a json summary at the end of the job
+pandoralg.StageTiming = False
+pandoralg.StageTimingFile = "PandoraStageTiming.json"
+#### Chrome trace-event json (chrome://tracing, Perfetto) of the per-stage and per-collection spans
+pandoralg.Trace = False
+pandoralg.TraceFile = "PandoraTrace.json"
+#### Record the geometry and the per-event pandora input, for Gaudi-free replay with PandoraReplay
+pandoralg.RecordInput = False
+pandoralg.RecordInputFile = "PandoraInput.bin"
 
 ##############################################################################
 
@@ -0,0 +1,433 @@
+/**
+ *
+ *  @brief  Throughput benchmark of the k4Pandora creators and pandora, without Gaudi. Synthetic events laid out on a GEAR
+ *          geometry are fed through the same stages as PandoraPFAlg::execute, and the time per stage is reported as a function
+ *          of the number of calo hits. Event generation is not timed.
+ *
+ *  $Log: $
+ */
+
+#include "gearxml/GearXML.h"
+#include "gear/BField.h"
+#include "gear/GEAR.h"
+#include "gear/GearMgr.h"
+
+#include "edm4hep/ClusterCollection.h"
+#include "edm4hep/ReconstructedParticleCollection.h"
+#include "edm4hep/VertexCollection.h"
+
+#include "Api/PandoraApi.h"
+#include "LCContent.h"
+
+#include "AllocationCounter.h"
+#include "BenchmarkBaseline.h"
+#include "BenchmarkCreatorSettings.h"
+#include "CaloHitCreator.h"
+#include "CollectionMaps.h"
+#include "GeometryCreator.h"
+#include "MCParticleCreator.h"
+#include "PfoCreator.h"
+#include "StageTimingMonitor.h"
+#include "SyntheticEventGenerator.h"
+#include "TrackCreator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /**
+     *  @brief  The command line parameters
+     */
+    class Parameters
+    {
+    public:
+        std::string     m_gearFile;                             ///< The gear xml file describing the detector
+        std::string     m_settingsFile = "PandoraSettingsDefault.xml"; ///< The pandora settings xml file
+        std::string     m_timingFile;                           ///< The stage timing json file, empty for none
+        std::string     m_baselineFile;                         ///< The baseline json file to compare with, empty for none
+        std::string     m_newBaselineFile;                      ///< The baseline json file to write, empty for none
+        BenchmarkBaseline::Settings m_baselineSettings;         ///< The tolerances of the comparison with the baseline
+        int             m_nEvents = 100;                        ///< The number of timed events
+        int             m_nWarmupEvents = 5;                    ///< The number of events processed before timing starts
+        int             m_nParameterThreads = 1;                ///< The number of threads building the calo hit parameters
+        SyntheticEventGenerator::Settings m_generatorSettings;  ///< The event generator settings
+    };
+
+    void PrintUsage(const char *const pProgramName)
+    {
+        const SyntheticEventGenerator::Settings defaults;
+
+        std::cout << "Usage: " << pProgramName << " -g FullDetGear.xml [-s PandoraSettings.xml] [-n nEvents] [-w nWarmup] [-j nJets|min-max]"
+                  << " [-p nParticles] [-i nIsolated] [-e jetEnergy] [-o occupancy] [-x nNoiseHits] [-m 0|1] [-r seed] [-t timing.json]"
+                  << " [-b baseline.json] [-u baseline.json] [-c timeTolerance] [-a allocationTolerance] [-T nThreads]" << std::endl
+                  << "    -g  gear xml file describing the detector" << std::endl
+                  << "    -s  pandora settings xml file, default PandoraSettingsDefault.xml" << std::endl
+                  << "    -n  number of timed events, default 100" << std::endl
+                  << "    -w  number of untimed warm up events, default 5" << std::endl
+                  << "    -j  number of jets per event, or a range drawn from uniformly, default " << defaults.m_minNJets << std::endl
+                  << "    -p  mean number of particles per jet, default " << defaults.m_nParticlesPerJet << std::endl
+                  << "    -i  number of isolated particles per event, default " << defaults.m_nIsolatedParticles << std::endl
+                  << "    -e  jet energy in GeV, default " << defaults.m_jetEnergy << std::endl
+                  << "    -o  calo hit occupancy scale factor, default " << defaults.m_occupancy << std::endl
+                  << "    -x  number of calo noise hits per event, default " << defaults.m_nNoiseHits << std::endl
+                  << "    -m  whether to create mc truth and the hit to mc associations, default " << defaults.m_createMCTruth << std::endl
+                  << "    -r  random seed, default " << defaults.m_seed << std::endl
+                  << "    -t  write per-stage timing statistics to a json file" << std::endl
+                  << "    -b  compare the median time and mean allocations of each stage with a baseline json file, exit with 2 on regression" << std::endl
+                  << "        or with 77 if the baseline has no entries" << std::endl
+                  << "    -u  write the median time and mean allocations of each stage to a baseline json file" << std::endl
+                  << "    -c  allowed relative time increase with respect to the baseline, negative for none, default "
+                  << BenchmarkBaseline::Settings().m_timeTolerance << std::endl
+                  << "    -a  allowed relative allocation increase with respect to the baseline, default "
+                  << BenchmarkBaseline::Settings().m_allocationTolerance << std::endl
+                  << "    -T  number of threads building the calo hit parameters, default 1" << std::endl;
+    }
+
+    bool ParseCommandLine(const int argc, char *argv[], Parameters &parameters)
+    {
+        SyntheticEventGenerator::Settings &settings(parameters.m_generatorSettings);
+
+        for (int iArg = 1; iArg < argc; ++iArg)
+        {
+            const std::string option(argv[iArg]);
+
+            if (iArg + 1 >= argc)
+                return false;
+
+            const std::string value(argv[++iArg]);
+
+            if ("-g" == option) parameters.m_gearFile = value;
+            else if ("-s" == option) parameters.m_settingsFile = value;
+            else if ("-t" == option) parameters.m_timingFile = value;
+            else if ("-b" == option) parameters.m_baselineFile = value;
+            else if ("-u" == option) parameters.m_newBaselineFile = value;
+            else if ("-c" == option) parameters.m_baselineSettings.m_timeTolerance = std::atof(value.c_str());
+            else if ("-a" == option) parameters.m_baselineSettings.m_allocationTolerance = std::atof(value.c_str());
+            else if ("-n" == option) parameters.m_nEvents = std::atoi(value.c_str());
+            else if ("-w" == option) parameters.m_nWarmupEvents = std::atoi(value.c_str());
+            else if ("-T" == option) parameters.m_nParameterThreads = std::atoi(value.c_str());
+            else if ("-p" == option) settings.m_nParticlesPerJet = std::atof(value.c_str());
+            else if ("-i" == option) settings.m_nIsolatedParticles = std::atoi(value.c_str());
+            else if ("-e" == option) settings.m_jetEnergy = std::atof(value.c_str());
+            else if ("-o" == option) settings.m_occupancy = std::atof(value.c_str());
+            else if ("-x" == option) settings.m_nNoiseHits = std::atoi(value.c_str());
+            else if ("-m" == option) settings.m_createMCTruth = (0 != std::atoi(value.c_str()));
+            else if ("-r" == option) settings.m_seed = std::atoi(value.c_str());
+            else if ("-j" == option)
+            {
+                const std::string::size_type separator(value.find('-'));
+                settings.m_minNJets = std::atoi(value.substr(0, separator).c_str());
+                settings.m_maxNJets = (std::string::npos == separator) ? settings.m_minNJets : std::atoi(value.substr(separator + 1).c_str());
+            }
+            else return false;
+        }
+
+        return !parameters.m_gearFile.empty() && (parameters.m_nEvents > 0) && (parameters.m_nWarmupEvents >= 0) &&
+            (settings.m_maxNJets >= settings.m_minNJets);
+    }
+
+    typedef std::array<unsigned long, StageTimingMonitor::N_STAGES> EventAllocations; ///< Heap allocations per stage in one event
+
+    /**
+     *  @brief  The hit counts, stage times and stage allocations of one timed event
+     */
+    class EventRecord
+    {
+    public:
+        unsigned int                    m_nCaloHits;            ///< The number of generated calo hits
+        unsigned int                    m_nTracks;              ///< The number of generated tracks
+        StageTimingMonitor::EventTimes  m_eventTimes;           ///< The stage times
+        EventAllocations                m_eventAllocations;     ///< The stage allocations
+    };
+
+    /**
+     *  @brief  ScopedStageCounter class, adds the time spent and the heap allocations made in its scope to a stage of an event
+     */
+    class ScopedStageCounter
+    {
+    public:
+        ScopedStageCounter(EventRecord &eventRecord, const StageTimingMonitor::Stage stage);
+        ~ScopedStageCounter();
+
+        ScopedStageCounter(const ScopedStageCounter &) = delete;
+        ScopedStageCounter &operator=(const ScopedStageCounter &) = delete;
+
+    private:
+        EventRecord                    &m_eventRecord;          ///< The event record
+        StageTimingMonitor::Stage       m_stage;                ///< The stage
+        unsigned long                   m_nAllocationsAtStart;  ///< The process allocation count when the scope was entered
+        ScopedStageTimer                m_timer;                ///< The stage timer
+    };
+
+    ScopedStageCounter::ScopedStageCounter(EventRecord &eventRecord, const StageTimingMonitor::Stage stage) :
+        m_eventRecord(eventRecord),
+        m_stage(stage),
+        m_nAllocationsAtStart(AllocationCounter::GetNAllocations()),
+        m_timer(&eventRecord.m_eventTimes, stage)
+    {
+    }
+
+    ScopedStageCounter::~ScopedStageCounter()
+    {
+        m_eventRecord.m_eventAllocations[m_stage] += AllocationCounter::GetNAllocations() - m_nAllocationsAtStart;
+    }
+
+    /**
+     *  @brief  Print the mean time of the main stages in bins of calo hit count, one bin per power of two
+     *
+     *  @param  eventRecords the timed events
+     */
+    void PrintScaling(const std::vector<EventRecord> &eventRecords)
+    {
+        const StageTimingMonitor::Stage stages[] = {StageTimingMonitor::CREATE_MC_PARTICLES, StageTimingMonitor::CREATE_CALO_HITS,
+            StageTimingMonitor::CREATE_CALO_HIT_TO_MC_RELATIONSHIPS, StageTimingMonitor::CREATE_TRACKS,
+            StageTimingMonitor::CREATE_TRACK_TO_MC_RELATIONSHIPS, StageTimingMonitor::PROCESS_EVENT,
+            StageTimingMonitor::CREATE_PARTICLE_FLOW_OBJECTS, StageTimingMonitor::EVENT};
+
+        std::map<int, std::vector<const EventRecord*> > bins;
+
+        for (const EventRecord &eventRecord : eventRecords)
+            bins[(eventRecord.m_nCaloHits > 0) ? static_cast<int>(std::log2(static_cast<double>(eventRecord.m_nCaloHits))) : -1].push_back(&eventRecord);
+
+        std::cout << "Mean stage time [ms] versus number of calo hits" << std::endl << std::setw(16) << "nCaloHits" << std::setw(8) << "events";
+
+        for (const StageTimingMonitor::Stage stage : stages)
+            std::cout << " " << StageTimingMonitor::GetStageName(stage);
+
+        std::cout << std::endl;
+
+        for (const auto &bin : bins)
+        {
+            const unsigned int lowEdge((bin.first < 0) ? 0 : (1U << bin.first)), highEdge((bin.first < 0) ? 1 : (2U << bin.first));
+            std::cout << std::setw(16) << (std::to_string(lowEdge) + "-" + std::to_string(highEdge)) << std::setw(8) << bin.second.size();
+
+            for (const StageTimingMonitor::Stage stage : stages)
+            {
+                double sum(0.);
+
+                for (const EventRecord *const pEventRecord : bin.second)
+                    sum += pEventRecord->m_eventTimes[stage];
+
+                std::cout << " " << std::setw(std::string(StageTimingMonitor::GetStageName(stage)).size()) << sum / bin.second.size();
+            }
+
+            std::cout << std::endl;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    Parameters parameters;
+
+    if (!ParseCommandLine(argc, argv, parameters))
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        gear::GearXML gearXML(parameters.m_gearFile);
+        std::unique_ptr<gear::GearMgr> pGearMgr(gearXML.createGearMgr());
+
+        const float innerBField(pGearMgr->getBField().at(gear::Vector3D(0., 0., 0.)).z());
+        const BenchmarkCreatorSettings creatorSettings(parameters.m_generatorSettings, innerBField);
+
+        // Same set up as PandoraPFAlg::initialize, with the default muon fields and no energy non-linearity correction
+        pandora::Pandora pandora;
+        GeometryCreator geometryCreator(creatorSettings.m_geometryCreatorSettings, &pandora);
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, geometryCreator.CreateGeometry(pGearMgr.get()));
+
+        CaloHitCreator::Settings caloHitCreatorSettings(creatorSettings.m_caloHitCreatorSettings);
+        caloHitCreatorSettings.m_nParameterThreads = std::max(1, parameters.m_nParameterThreads);
+
+        CaloHitCreator caloHitCreator(caloHitCreatorSettings, &pandora, pGearMgr.get(), 0);
+        TrackCreator trackCreator(creatorSettings.m_trackCreatorSettings, &pandora, pGearMgr.get());
+        MCParticleCreator mcParticleCreator(creatorSettings.m_mcParticleCreatorSettings, &pandora);
+        PfoCreator pfoCreator(creatorSettings.m_pfoCreatorSettings, &pandora);
+
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterAlgorithms(pandora));
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterBasicPlugins(pandora));
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterBFieldPlugin(pandora, innerBField, -1.5f, 0.01f));
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterNonLinearityEnergyCorrection(pandora,
+            "NonLinearity", pandora::HADRONIC, pandora::FloatVector(), pandora::FloatVector()));
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(pandora, parameters.m_settingsFile));
+
+        SyntheticEventGenerator generator(parameters.m_generatorSettings, pGearMgr.get());
+        SyntheticEventGenerator::Event event;
+        CollectionMaps collectionMaps;
+
+        edm4hep::ClusterCollection clusterCollection;
+        edm4hep::ReconstructedParticleCollection pfoCollection;
+        edm4hep::VertexCollection vertexCollection;
+
+        StageTimingMonitor stageTimingMonitor;
+        std::vector<EventRecord> eventRecords;
+        unsigned long nTotalCaloHits(0), nTotalPfos(0);
+
+        for (int iEvent = 0; iEvent < parameters.m_nWarmupEvents + parameters.m_nEvents; ++iEvent)
+        {
+            generator.Generate(event);
+            generator.FillCollectionMaps(event, collectionMaps);
+
+            clusterCollection.clear();
+            pfoCollection.clear();
+            vertexCollection.clear();
+
+            EventRecord eventRecord;
+            eventRecord.m_nCaloHits = event.GetNCaloHits();
+            eventRecord.m_nTracks = event.m_tracks.size();
+            eventRecord.m_eventTimes = StageTimingMonitor::EventTimes();
+            eventRecord.m_eventAllocations = EventAllocations();
+            {
+                ScopedStageCounter eventCounter(eventRecord, StageTimingMonitor::EVENT);
+                {
+                    ScopedStageCounter counter(eventRecord, StageTimingMonitor::CREATE_MC_PARTICLES);
+                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, mcParticleCreator.CreateMCParticles(collectionMaps));
+                }
+                {
+                    ScopedStageCounter counter(eventRecord, StageTimingMonitor::CREATE_CALO_HITS);
+                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, caloHitCreator.CreateCaloHits(collectionMaps));
+                }
+                {
+                    ScopedStageCounter counter(eventRecord, StageTimingMonitor::CREATE_CALO_HIT_TO_MC_RELATIONSHIPS);
+                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, mcParticleCreator.CreateCaloHitToMCParticleRelationships(collectionMaps,
+                        caloHitCreator.GetCalorimeterHitVector()));
+                }
+                {
+                    ScopedStageCounter counter(eventRecord, StageTimingMonitor::CREATE_TRACK_ASSOCIATIONS);
+                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, trackCreator.CreateTrackAssociations(collectionMaps));
+                }
+                {
+                    ScopedStageCounter counter(eventRecord, StageTimingMonitor::CREATE_TRACKS);
+                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, trackCreator.CreateTracks(collectionMaps));
+                }
+                {
+                    ScopedStageCounter counter(eventRecord, StageTimingMonitor::CREATE_TRACK_TO_MC_RELATIONSHIPS);
+                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, mcParticleCreator.CreateTrackToMCParticleRelationships(collectionMaps,
+                        trackCreator.GetTrackVector()));
+                }
+                {
+                    ScopedStageCounter counter(eventRecord, StageTimingMonitor::PROCESS_EVENT);
+                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(pandora));
+                }
+                {
+                    ScopedStageCounter counter(eventRecord, StageTimingMonitor::CREATE_PARTICLE_FLOW_OBJECTS);
+                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, pfoCreator.CreateParticleFlowObjects(collectionMaps, &clusterCollection,
+                        &pfoCollection, &vertexCollection));
+                }
+                {
+                    ScopedStageCounter counter(eventRecord, StageTimingMonitor::RESET);
+                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(pandora));
+                    caloHitCreator.Reset();
+                    trackCreator.Reset();
+                    mcParticleCreator.Reset();
+                    collectionMaps.clear();
+                }
+            }
+
+            if (iEvent < parameters.m_nWarmupEvents)
+                continue;
+
+            stageTimingMonitor.AddEvent(eventRecord.m_eventTimes);
+            eventRecords.push_back(eventRecord);
+            nTotalCaloHits += eventRecord.m_nCaloHits;
+            nTotalPfos += pfoCollection.size();
+        }
+
+        const StageTimingMonitor::Summary eventSummary(stageTimingMonitor.GetSummary(StageTimingMonitor::EVENT));
+        const double totalSeconds(1.e-3 * eventSummary.m_mean * eventSummary.m_nEvents);
+
+        std::cout << "Processed " << eventSummary.m_nEvents << " events, " << static_cast<double>(nTotalCaloHits) / eventSummary.m_nEvents
+                  << " calo hits and " << static_cast<double>(nTotalPfos) / eventSummary.m_nEvents << " pfos per event" << std::endl
+                  << "Throughput: " << eventSummary.m_nEvents / totalSeconds << " events/s, " << nTotalCaloHits / totalSeconds << " calo hits/s"
+                  << std::endl;
+
+        BenchmarkBaseline benchmarkBaseline("ms");
+
+        for (unsigned int iStage = 0; iStage < StageTimingMonitor::N_STAGES; ++iStage)
+        {
+            const StageTimingMonitor::Stage stage(static_cast<StageTimingMonitor::Stage>(iStage));
+
+            // Stages that only exist inside PandoraPFAlg are not run here
+            if ((StageTimingMonitor::UPDATE_MAP == stage) || (StageTimingMonitor::CREATE_MC_RECO_PARTICLE_ASSOCIATION == stage))
+                continue;
+
+            double nAllocations(0.);
+
+            for (const EventRecord &eventRecord : eventRecords)
+                nAllocations += eventRecord.m_eventAllocations[stage];
+
+            const StageTimingMonitor::Summary summary(stageTimingMonitor.GetSummary(stage));
+            const double meanAllocations(nAllocations / eventRecords.size());
+            std::cout << "Stage " << StageTimingMonitor::GetStageName(stage) << " [ms]: mean " << summary.m_mean << ", p50 " << summary.m_p50
+                      << ", p95 " << summary.m_p95 << ", p99 " << summary.m_p99 << ", max " << summary.m_max << "; allocations/event "
+                      << meanAllocations << std::endl;
+
+            // The median is compared rather than the mean, so that a few events delayed by the machine do not fail the comparison
+            benchmarkBaseline.SetEntry(StageTimingMonitor::GetStageName(stage), summary.m_p50, meanAllocations);
+        }
+
+        PrintScaling(eventRecords);
+
+        if (!parameters.m_timingFile.empty() && !stageTimingMonitor.WriteJson(parameters.m_timingFile))
+            std::cout << "Could not write stage timing to " << parameters.m_timingFile << std::endl;
+
+        if (!parameters.m_newBaselineFile.empty() && !benchmarkBaseline.WriteJson(parameters.m_newBaselineFile))
+            std::cout << "Could not write baseline to " << parameters.m_newBaselineFile << std::endl;
+
+        if (!parameters.m_baselineFile.empty())
+        {
+            BenchmarkBaseline referenceBaseline("ms");
+
+            if (!referenceBaseline.ReadJson(parameters.m_baselineFile))
+            {
+                std::cout << "Could not read baseline from " << parameters.m_baselineFile << std::endl;
+                return 1;
+            }
+
+            // Nothing to compare with is not a pass; ctest reports exit code 77 as a skipped test
+            if (referenceBaseline.GetEntries().empty())
+            {
+                std::cout << "Baseline " << parameters.m_baselineFile << " has no entries, write it with -u" << std::endl;
+                return 77;
+            }
+
+            // Stages shorter than the timer and scheduler noise cannot regress in time
+            BenchmarkBaseline::Settings baselineSettings(parameters.m_baselineSettings);
+            baselineSettings.m_minTimeIncrease = 0.05;
+
+            const unsigned int nRegressions(benchmarkBaseline.Compare(referenceBaseline, baselineSettings));
+
+            if (nRegressions > 0)
+            {
+                std::cout << "Pandora benchmark: " << nRegressions << " stages regressed with respect to " << parameters.m_baselineFile << std::endl;
+                return 2;
+            }
+        }
+    }
+    catch (pandora::StatusCodeException &statusCodeException)
+    {
+        std::cout << "Pandora benchmark failed: " << statusCodeException.ToString() << std::endl;
+        return 1;
+    }
+    catch (gear::Exception &exception)
+    {
+        std::cout << "Pandora benchmark failed to read the geometry: " << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
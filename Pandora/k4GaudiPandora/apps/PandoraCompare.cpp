@@ -0,0 +1,174 @@
+/**
+ *
+ *  @brief  Compares the pandora output of two podio files written from the same input, event by event, to validate that a change
+ *          to the creators or to pandora leaves the physics output unchanged, or to see exactly what it changed.
+ *
+ *  $Log: $
+ */
+
+#include "podio/EventStore.h"
+#include "podio/ROOTReader.h"
+
+#include "PfoComparator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    /**
+     *  @brief  The command line parameters
+     */
+    class Parameters
+    {
+    public:
+        std::string     m_firstFile;                            ///< The first (reference) output file
+        std::string     m_secondFile;                           ///< The second output file
+        int             m_nEvents = -1;                         ///< The maximum number of events to compare, negative for all
+        std::string     m_pfoCollectionName = "PandoraPFOs";    ///< The pfo collection name
+        std::string     m_clusterCollectionName = "PandoraClusters"; ///< The cluster collection name
+        std::string     m_startVertexCollectionName = "PandoraPFANewStartVertices"; ///< The start vertex collection name
+        std::string     m_associationCollectionName = "pfoMCRecoParticleAssociation"; ///< The pfo to mc particle association collection name
+        bool            m_requireBitwise = false;               ///< Whether differences within tolerance count as failures
+        PfoComparator::Settings m_comparatorSettings;           ///< The comparator settings
+    };
+
+    void PrintUsage(const char *const pProgramName)
+    {
+        const PfoComparator::Settings defaults;
+
+        std::cout << "Usage: " << pProgramName << " -a first.root -b second.root [-n nEvents] [-e energyTolerance] [-p momentumTolerance]"
+                  << " [-x positionTolerance] [-w weightTolerance] [-d nPrinted] [-B 0|1] [-P pfos] [-C clusters] [-V vertices] [-M associations]" << std::endl
+                  << "    -a  first, reference, output file" << std::endl
+                  << "    -b  second output file, from the same input" << std::endl
+                  << "    -n  maximum number of events to compare, default all" << std::endl
+                  << "    -e  allowed relative energy and mass difference, default " << defaults.m_energyTolerance << std::endl
+                  << "    -p  allowed momentum difference relative to the momentum, default " << defaults.m_momentumTolerance << std::endl
+                  << "    -x  allowed position difference in mm, default " << defaults.m_positionTolerance << std::endl
+                  << "    -w  allowed association weight difference, default " << defaults.m_weightTolerance << std::endl
+                  << "    -d  number of pfo differences printed in detail, default " << defaults.m_maxPrintedDifferences << std::endl
+                  << "    -B  whether any difference, even within tolerance, is a failure, default 0" << std::endl
+                  << "    -P, -C, -V, -M  pfo, cluster, start vertex and mc association collection names, defaults as in PandoraPFAlg" << std::endl;
+    }
+
+    bool ParseCommandLine(const int argc, char *argv[], Parameters &parameters)
+    {
+        PfoComparator::Settings &settings(parameters.m_comparatorSettings);
+
+        for (int iArg = 1; iArg < argc; ++iArg)
+        {
+            const std::string option(argv[iArg]);
+
+            if (iArg + 1 >= argc)
+                return false;
+
+            const std::string value(argv[++iArg]);
+
+            if ("-a" == option) parameters.m_firstFile = value;
+            else if ("-b" == option) parameters.m_secondFile = value;
+            else if ("-n" == option) parameters.m_nEvents = std::atoi(value.c_str());
+            else if ("-e" == option) settings.m_energyTolerance = std::atof(value.c_str());
+            else if ("-p" == option) settings.m_momentumTolerance = std::atof(value.c_str());
+            else if ("-x" == option) settings.m_positionTolerance = std::atof(value.c_str());
+            else if ("-w" == option) settings.m_weightTolerance = std::atof(value.c_str());
+            else if ("-d" == option) settings.m_maxPrintedDifferences = std::atoi(value.c_str());
+            else if ("-B" == option) parameters.m_requireBitwise = (0 != std::atoi(value.c_str()));
+            else if ("-P" == option) parameters.m_pfoCollectionName = value;
+            else if ("-C" == option) parameters.m_clusterCollectionName = value;
+            else if ("-V" == option) parameters.m_startVertexCollectionName = value;
+            else if ("-M" == option) parameters.m_associationCollectionName = value;
+            else return false;
+        }
+
+        return !parameters.m_firstFile.empty() && !parameters.m_secondFile.empty();
+    }
+
+    /**
+     *  @brief  Get the pandora output collections of the current event of a store, leaving absent ones NULL
+     *
+     *  @param  parameters the command line parameters
+     *  @param  store the event store
+     *  @param  collections to receive the collections
+     */
+    void GetEventCollections(const Parameters &parameters, podio::EventStore &store, PfoComparator::EventCollections &collections)
+    {
+        if (!store.get(parameters.m_pfoCollectionName, collections.m_pPfos))
+            collections.m_pPfos = NULL;
+
+        if (!store.get(parameters.m_clusterCollectionName, collections.m_pClusters))
+            collections.m_pClusters = NULL;
+
+        if (!store.get(parameters.m_startVertexCollectionName, collections.m_pStartVertices))
+            collections.m_pStartVertices = NULL;
+
+        if (!store.get(parameters.m_associationCollectionName, collections.m_pMCRecoParticleAssociations))
+            collections.m_pMCRecoParticleAssociations = NULL;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    Parameters parameters;
+
+    if (!ParseCommandLine(argc, argv, parameters))
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    podio::ROOTReader firstReader, secondReader;
+    firstReader.openFile(parameters.m_firstFile);
+    secondReader.openFile(parameters.m_secondFile);
+
+    podio::EventStore firstStore, secondStore;
+    firstStore.setReader(&firstReader);
+    secondStore.setReader(&secondReader);
+
+    const unsigned int nFirstEvents(firstReader.getEntries()), nSecondEvents(secondReader.getEntries());
+
+    if (nFirstEvents != nSecondEvents)
+        std::cout << "Event counts differ: " << nFirstEvents << " in " << parameters.m_firstFile << ", " << nSecondEvents << " in "
+                  << parameters.m_secondFile << "; comparing the common events" << std::endl;
+
+    unsigned int nEvents(std::min(nFirstEvents, nSecondEvents));
+
+    if (parameters.m_nEvents >= 0)
+        nEvents = std::min(nEvents, static_cast<unsigned int>(parameters.m_nEvents));
+
+    PfoComparator pfoComparator(parameters.m_comparatorSettings);
+
+    for (unsigned int iEvent = 0; iEvent < nEvents; ++iEvent)
+    {
+        PfoComparator::EventCollections firstCollections, secondCollections;
+        GetEventCollections(parameters, firstStore, firstCollections);
+        GetEventCollections(parameters, secondStore, secondCollections);
+
+        if (!firstCollections.m_pPfos || !secondCollections.m_pPfos)
+        {
+            std::cout << "Event " << iEvent << ": no " << parameters.m_pfoCollectionName << " collection in "
+                      << (firstCollections.m_pPfos ? parameters.m_secondFile : parameters.m_firstFile) << std::endl;
+        }
+
+        pfoComparator.CompareEvent(iEvent, firstCollections, secondCollections);
+
+        firstStore.clear();
+        secondStore.clear();
+        firstReader.endOfEvent();
+        secondReader.endOfEvent();
+    }
+
+    pfoComparator.PrintSummary();
+
+    firstReader.closeFile();
+    secondReader.closeFile();
+
+    const PfoComparator::Summary &summary(pfoComparator.GetSummary());
+    const bool isEquivalent((nFirstEvents == nSecondEvents) && (0 == summary.m_nEvents[PfoComparator::DIFFERENT]) &&
+        (!parameters.m_requireBitwise || (0 == summary.m_nEvents[PfoComparator::WITHIN_TOLERANCE])));
+
+    return isEquivalent ? 0 : 2;
+}
@@ -0,0 +1,510 @@
+/**
+ *
+ *  @brief  Microbenchmark of the per-object kernels of the k4Pandora creators: calo hit geometry, cell id decoding, track
+ *          projection to the calorimeter, cluster shapes and helix intersections. Each kernel is timed in isolation on the hits
+ *          and tracks of synthetic events laid out on a GEAR geometry, and reported in ns and heap allocations per call. The
+ *          heap allocations are counted by the operator new of AllocationCounter.cpp.
+ *
+ *  $Log: $
+ */
+
+#include "gearxml/GearXML.h"
+#include "gear/BField.h"
+#include "gear/CalorimeterParameters.h"
+#include "gear/GEAR.h"
+#include "gear/GearMgr.h"
+
+#include "Api/PandoraApi.h"
+
+#include "ClusterShapes.h"
+#include "HelixClass.h"
+
+#include "AllocationCounter.h"
+#include "BenchmarkBaseline.h"
+#include "BenchmarkCreatorSettings.h"
+#include "CaloHitCreator.h"
+#include "CellIDFieldDecoder.h"
+#include "cellIDDecoder.h"
+#include "SyntheticEventGenerator.h"
+#include "TrackCreator.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ *  @brief  KernelBenchmarkAccess class, forwards to the private kernels of the creators
+ */
+class KernelBenchmarkAccess
+{
+public:
+    typedef CaloHitCreator::LayerPropertiesTable LayerPropertiesTable;
+
+    static void BuildLayerTable(const CaloHitCreator &caloHitCreator, const gear::LayerLayout &layerLayout, const pandora::HitType hitType,
+        LayerPropertiesTable &layerTable)
+    {
+        caloHitCreator.BuildLayerTable(layerLayout, hitType, layerTable);
+    }
+
+    static int GetNLayersFromEdge(const CaloHitCreator &caloHitCreator, const edm4hep::CalorimeterHit *const pCaloHit)
+    {
+        return caloHitCreator.GetNLayersFromEdge(pCaloHit);
+    }
+
+    static float GetMaximumRadius(const CaloHitCreator &caloHitCreator, const edm4hep::CalorimeterHit *const pCaloHit)
+    {
+        return caloHitCreator.GetMaximumRadius(pCaloHit, caloHitCreator.m_hCalBarrelOuterPolygon);
+    }
+
+    static void GetBarrelCaloHitProperties(const CaloHitCreator &caloHitCreator, const edm4hep::CalorimeterHit *const pCaloHit,
+        const LayerPropertiesTable &layerTable, const unsigned int staveNumber, PandoraApi::CaloHit::Parameters &caloHitParameters,
+        float &absorberCorrection)
+    {
+        caloHitCreator.GetBarrelCaloHitProperties(pCaloHit, layerTable, caloHitCreator.m_eCalBarrelInnerPolygon, staveNumber,
+            caloHitParameters, absorberCorrection);
+    }
+
+    static float CalculateTrackTimeAtCalorimeter(const TrackCreator &trackCreator, const edm4hep::Track *const pTrack)
+    {
+        return trackCreator.CalculateTrackTimeAtCalorimeter(pTrack);
+    }
+
+    static void CalculateTrackTimesAtCalorimeter(TrackCreator &trackCreator, const TrackStore &tracks, pandora::FloatVector &genericTimes)
+    {
+        trackCreator.CalculateTrackTimesAtCalorimeter(tracks, genericTimes);
+    }
+
+    static void TrackReachesECAL(const TrackCreator &trackCreator, const edm4hep::Track *const pTrack, PandoraApi::Track::Parameters &trackParameters)
+    {
+        trackCreator.TrackReachesECAL(pTrack, trackParameters);
+    }
+
+    static float GetECalBarrelInnerR(const TrackCreator &trackCreator)
+    {
+        return trackCreator.m_eCalBarrelInnerR;
+    }
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+    /**
+     *  @brief  The command line parameters
+     */
+    class Parameters
+    {
+    public:
+        std::string     m_gearFile;                             ///< The gear xml file describing the detector
+        int             m_nEvents = 20;                         ///< The number of synthetic events providing the kernel inputs
+        double          m_minSeconds = 0.5;                     ///< The minimum time spent timing each kernel
+        unsigned int    m_seed = 42;                            ///< The random seed of the event generator
+        std::string     m_baselineFile;                         ///< The baseline json file to compare with, empty for none
+        std::string     m_newBaselineFile;                      ///< The baseline json file to write, empty for none
+        BenchmarkBaseline::Settings m_baselineSettings;         ///< The tolerances of the comparison with the baseline
+    };
+
+    void PrintUsage(const char *const pProgramName)
+    {
+        std::cout << "Usage: " << pProgramName << " -g FullDetGear.xml [-n nEvents] [-s minSeconds] [-r seed] [-b baseline.json] [-u baseline.json]"
+                  << " [-c timeTolerance] [-a allocationTolerance]" << std::endl
+                  << "    -g  gear xml file describing the detector" << std::endl
+                  << "    -n  number of synthetic events providing the kernel inputs, default 20" << std::endl
+                  << "    -s  minimum time spent timing each kernel, default 0.5 s" << std::endl
+                  << "    -r  random seed of the event generator, default 42" << std::endl
+                  << "    -b  compare the time and allocations per call of each kernel with a baseline json file, exit with 2 on regression" << std::endl
+                  << "        or with 77 if the baseline has no entries" << std::endl
+                  << "    -u  write the time and allocations per call of each kernel to a baseline json file" << std::endl
+                  << "    -c  allowed relative time increase with respect to the baseline, negative for none, default "
+                  << BenchmarkBaseline::Settings().m_timeTolerance << std::endl
+                  << "    -a  allowed relative allocation increase with respect to the baseline, default "
+                  << BenchmarkBaseline::Settings().m_allocationTolerance << std::endl;
+    }
+
+    bool ParseCommandLine(const int argc, char *argv[], Parameters &parameters)
+    {
+        for (int iArg = 1; iArg < argc; ++iArg)
+        {
+            const std::string option(argv[iArg]);
+
+            if (iArg + 1 >= argc)
+                return false;
+
+            const std::string value(argv[++iArg]);
+
+            if ("-g" == option) parameters.m_gearFile = value;
+            else if ("-n" == option) parameters.m_nEvents = std::atoi(value.c_str());
+            else if ("-s" == option) parameters.m_minSeconds = std::atof(value.c_str());
+            else if ("-r" == option) parameters.m_seed = std::atoi(value.c_str());
+            else if ("-b" == option) parameters.m_baselineFile = value;
+            else if ("-u" == option) parameters.m_newBaselineFile = value;
+            else if ("-c" == option) parameters.m_baselineSettings.m_timeTolerance = std::atof(value.c_str());
+            else if ("-a" == option) parameters.m_baselineSettings.m_allocationTolerance = std::atof(value.c_str());
+            else return false;
+        }
+
+        return !parameters.m_gearFile.empty() && (parameters.m_nEvents > 0) && (parameters.m_minSeconds > 0.);
+    }
+
+    /**
+     *  @brief  The timing of one kernel
+     */
+    class KernelResult
+    {
+    public:
+        std::string     m_name;                                 ///< The kernel name
+        unsigned long   m_nCalls;                               ///< The number of timed calls
+        double          m_nsPerCall;                            ///< The mean time per call, units ns
+        double          m_allocationsPerCall;                   ///< The mean number of heap allocations per call
+    };
+
+    /**
+     *  @brief  Time a kernel by repeating passes over its inputs until the minimum time has elapsed, after one untimed pass
+     *
+     *  @param  name the kernel name
+     *  @param  nCallsPerPass the number of kernel calls made by one pass
+     *  @param  minSeconds the minimum time spent timing
+     *  @param  pass runs the kernel once on each input
+     *
+     *  @return the kernel timing
+     */
+    template <typename Pass>
+    KernelResult TimeKernel(const std::string &name, const unsigned long nCallsPerPass, const double minSeconds, Pass pass)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        pass();
+
+        const unsigned long nAllocationsBefore(AllocationCounter::GetNAllocations());
+        const Clock::time_point start(Clock::now());
+        unsigned long nCalls(0);
+        double seconds(0.);
+
+        while ((0 == nCalls) || (seconds < minSeconds))
+        {
+            pass();
+            nCalls += nCallsPerPass;
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        KernelResult result;
+        result.m_name = name;
+        result.m_nCalls = nCalls;
+        result.m_nsPerCall = (nCalls > 0) ? 1.e9 * seconds / nCalls : 0.;
+        result.m_allocationsPerCall = (nCalls > 0) ? static_cast<double>(AllocationCounter::GetNAllocations() - nAllocationsBefore) / nCalls : 0.;
+
+        return result;
+    }
+
+    /**
+     *  @brief  A cluster of calo hits, as flat coordinate and amplitude arrays
+     */
+    class ClusterInput
+    {
+    public:
+        std::vector<float>  m_amplitudes;                       ///< The hit energies
+        std::vector<float>  m_x;                                ///< The hit x coordinates
+        std::vector<float>  m_y;                                ///< The hit y coordinates
+        std::vector<float>  m_z;                                ///< The hit z coordinates
+    };
+
+    volatile float g_sink = 0.f;                                ///< Receives the kernel results, so that the calls cannot be optimised away
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    Parameters parameters;
+
+    if (!ParseCommandLine(argc, argv, parameters))
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        gear::GearXML gearXML(parameters.m_gearFile);
+        std::unique_ptr<gear::GearMgr> pGearMgr(gearXML.createGearMgr());
+
+        // The creators are only used for their kernels, so they need the geometry but neither collections nor a pandora geometry
+        SyntheticEventGenerator::Settings generatorSettings;
+        generatorSettings.m_seed = parameters.m_seed;
+        generatorSettings.m_createMCTruth = false;
+
+        const float innerBField(pGearMgr->getBField().at(gear::Vector3D(0., 0., 0.)).z());
+        const BenchmarkCreatorSettings creatorSettings(generatorSettings, innerBField);
+
+        pandora::Pandora pandora;
+        const CaloHitCreator caloHitCreator(creatorSettings.m_caloHitCreatorSettings, &pandora, pGearMgr.get(), 0);
+        TrackCreator trackCreator(creatorSettings.m_trackCreatorSettings, &pandora, pGearMgr.get());
+
+        // Kernel inputs: the hits and tracks of synthetic jet events, in the order the creators would see them
+        SyntheticEventGenerator generator(generatorSettings, pGearMgr.get());
+
+        std::vector<std::unique_ptr<SyntheticEventGenerator::Event> > events;
+        std::vector<edm4hep::CalorimeterHit> caloHits, eCalBarrelHits;
+        std::vector<edm4hep::Track> tracks;
+        std::vector<ClusterInput> clusters;
+
+        std::mt19937 randomEngine(parameters.m_seed);
+        std::uniform_real_distribution<float> logClusterSizeDistribution(std::log(4.f), std::log(256.f));
+
+        for (int iEvent = 0; iEvent < parameters.m_nEvents; ++iEvent)
+        {
+            events.emplace_back(new SyntheticEventGenerator::Event());
+            SyntheticEventGenerator::Event &event(*events.back());
+            generator.Generate(event);
+
+            for (unsigned int iRegion = 0; iRegion < SyntheticEventGenerator::N_CALO_REGIONS; ++iRegion)
+            {
+                const edm4hep::CalorimeterHitCollection &caloHitCollection(event.m_caloHits[iRegion]);
+                unsigned int nClusterHits(0);
+
+                for (unsigned int iHit = 0, nHits = caloHitCollection.size(); iHit < nHits; ++iHit)
+                {
+                    const edm4hep::CalorimeterHit caloHit(caloHitCollection.at(iHit));
+                    caloHits.push_back(caloHit);
+
+                    if (SyntheticEventGenerator::ECAL_BARREL == iRegion)
+                        eCalBarrelHits.push_back(caloHit);
+
+                    // Hits are stored in order of first deposit, so consecutive hits mostly belong to the same shower
+                    if (0 == nClusterHits)
+                    {
+                        clusters.push_back(ClusterInput());
+                        nClusterHits = static_cast<unsigned int>(std::exp(logClusterSizeDistribution(randomEngine)));
+                    }
+
+                    ClusterInput &cluster(clusters.back());
+                    cluster.m_amplitudes.push_back(caloHit.getEnergy());
+                    cluster.m_x.push_back(caloHit.getPosition()[0]);
+                    cluster.m_y.push_back(caloHit.getPosition()[1]);
+                    cluster.m_z.push_back(caloHit.getPosition()[2]);
+                    --nClusterHits;
+                }
+            }
+
+            for (unsigned int iTrack = 0, nTracks = event.m_tracks.size(); iTrack < nTracks; ++iTrack)
+                tracks.push_back(event.m_tracks.at(iTrack));
+        }
+
+        unsigned long nClusterHits(0);
+
+        for (const ClusterInput &cluster : clusters)
+            nClusterHits += cluster.m_amplitudes.size();
+
+        std::cout << "Kernel inputs from " << parameters.m_nEvents << " events: " << caloHits.size() << " calo hits, " << eCalBarrelHits.size()
+                  << " ecal barrel hits, " << tracks.size() << " tracks, " << clusters.size() << " clusters of mean size "
+                  << (clusters.empty() ? 0. : static_cast<double>(nClusterHits) / clusters.size()) << std::endl;
+
+        const std::string cellIdEncoding("M:3,S-1:3,I:9,J:9,K-1:6");
+        KernelBenchmarkAccess::LayerPropertiesTable eCalBarrelLayerTable;
+        KernelBenchmarkAccess::BuildLayerTable(caloHitCreator, pGearMgr->getEcalBarrelParameters().getLayerLayout(), pandora::ECAL, eCalBarrelLayerTable);
+
+        // Per-call inputs that the creators fill in before calling the kernels
+        ID_UTIL::CellIDDecoder<edm4hep::CalorimeterHit> setupDecoder(cellIdEncoding);
+        std::vector<PandoraApi::CaloHit::Parameters> caloHitParametersVector(eCalBarrelHits.size());
+        std::vector<unsigned int> staveNumbers;
+
+        for (unsigned int iHit = 0; iHit < eCalBarrelHits.size(); ++iHit)
+        {
+            caloHitParametersVector[iHit].m_hitType = pandora::ECAL;
+            caloHitParametersVector[iHit].m_layer = setupDecoder(&eCalBarrelHits[iHit])["K-1"] + 1;
+            staveNumbers.push_back(setupDecoder(&eCalBarrelHits[iHit])["S-1"]);
+        }
+
+        std::vector<PandoraApi::Track::Parameters> trackParametersVector(tracks.size());
+        std::vector<HelixClass> helices(tracks.size());
+
+        for (unsigned int iTrack = 0; iTrack < tracks.size(); ++iTrack)
+        {
+            const edm4hep::TrackState trackState(tracks[iTrack].getTrackStates(0));
+            const float pt(innerBField * 2.99792e-4f / std::fabs(trackState.omega));
+            trackParametersVector[iTrack].m_momentumAtDca = pandora::CartesianVector(pt * std::cos(trackState.phi), pt * std::sin(trackState.phi),
+                pt * trackState.tanLambda);
+            helices[iTrack].Initialize_Canonical(trackState.phi, trackState.D0, trackState.Z0, trackState.omega, trackState.tanLambda, innerBField);
+        }
+
+        std::vector<KernelResult> results;
+
+        results.push_back(TimeKernel("CaloHitCreator::GetNLayersFromEdge", caloHits.size(), parameters.m_minSeconds, [&]()
+        {
+            for (const edm4hep::CalorimeterHit &caloHit : caloHits)
+                g_sink = g_sink + KernelBenchmarkAccess::GetNLayersFromEdge(caloHitCreator, &caloHit);
+        }));
+
+        results.push_back(TimeKernel("CaloHitCreator::GetMaximumRadius", caloHits.size(), parameters.m_minSeconds, [&]()
+        {
+            for (const edm4hep::CalorimeterHit &caloHit : caloHits)
+                g_sink = g_sink + KernelBenchmarkAccess::GetMaximumRadius(caloHitCreator, &caloHit);
+        }));
+
+        results.push_back(TimeKernel("CaloHitCreator::GetBarrelCaloHitProperties", eCalBarrelHits.size(), parameters.m_minSeconds, [&]()
+        {
+            for (unsigned int iHit = 0; iHit < eCalBarrelHits.size(); ++iHit)
+            {
+                float absorberCorrection(1.f);
+                KernelBenchmarkAccess::GetBarrelCaloHitProperties(caloHitCreator, &eCalBarrelHits[iHit], eCalBarrelLayerTable, staveNumbers[iHit],
+                    caloHitParametersVector[iHit], absorberCorrection);
+                g_sink = g_sink + absorberCorrection;
+            }
+        }));
+
+        results.push_back(TimeKernel("ID_UTIL::CellIDDecoder::operator()", caloHits.size(), parameters.m_minSeconds, [&]()
+        {
+            // A fresh decoder per pass, as the creators made one per collection and event before CellIDFieldDecoder
+            ID_UTIL::CellIDDecoder<edm4hep::CalorimeterHit> cellIdDecoder(cellIdEncoding);
+
+            for (const edm4hep::CalorimeterHit &caloHit : caloHits)
+                g_sink = g_sink + cellIdDecoder(&caloHit)["K-1"] + cellIdDecoder(&caloHit)["S-1"];
+        }));
+
+        const CellIDFieldDecoder cellIdFieldDecoder(cellIdEncoding);
+        const CellIDFieldDecoder::Field layerField(cellIdFieldDecoder.GetField("K-1")), staveField(cellIdFieldDecoder.GetField("S-1"));
+        CellIDFieldDecoder::CellIdVector cellIds;
+        CellIDFieldDecoder::FieldValueVector layers, staves;
+
+        for (const edm4hep::CalorimeterHit &caloHit : caloHits)
+            cellIds.push_back(caloHit.getCellID());
+
+        results.push_back(TimeKernel("CellIDFieldDecoder::DecodeColumn", caloHits.size(), parameters.m_minSeconds, [&]()
+        {
+            CellIDFieldDecoder::DecodeColumn(layerField, cellIds, layers);
+            CellIDFieldDecoder::DecodeColumn(staveField, cellIds, staves);
+            g_sink = g_sink + (layers.empty() ? 0 : layers.back() + staves.back());
+        }));
+
+        results.push_back(TimeKernel("TrackCreator::CalculateTrackTimeAtCalorimeter", tracks.size(), parameters.m_minSeconds, [&]()
+        {
+            for (const edm4hep::Track &track : tracks)
+            {
+                try
+                {
+                    g_sink = g_sink + KernelBenchmarkAccess::CalculateTrackTimeAtCalorimeter(trackCreator, &track);
+                }
+                catch (pandora::StatusCodeException &)
+                {
+                }
+            }
+        }));
+
+        pandora::FloatVector genericTimes;
+
+        results.push_back(TimeKernel("TrackCreator::CalculateTrackTimesAtCalorimeter", tracks.size(), parameters.m_minSeconds, [&]()
+        {
+            KernelBenchmarkAccess::CalculateTrackTimesAtCalorimeter(trackCreator, tracks, genericTimes);
+            g_sink = g_sink + (genericTimes.empty() ? 0.f : genericTimes.back());
+        }));
+
+        results.push_back(TimeKernel("TrackCreator::TrackReachesECAL", tracks.size(), parameters.m_minSeconds, [&]()
+        {
+            for (unsigned int iTrack = 0; iTrack < tracks.size(); ++iTrack)
+            {
+                KernelBenchmarkAccess::TrackReachesECAL(trackCreator, &tracks[iTrack], trackParametersVector[iTrack]);
+                g_sink = g_sink + trackParametersVector[iTrack].m_reachesCalorimeter.Get();
+            }
+        }));
+
+        results.push_back(TimeKernel("ClusterShapes gravity, inertia and eigensystem", clusters.size(), parameters.m_minSeconds, [&]()
+        {
+            for (ClusterInput &cluster : clusters)
+            {
+                ClusterShapes clusterShapes(static_cast<int>(cluster.m_amplitudes.size()), cluster.m_amplitudes.data(), cluster.m_x.data(), cluster.m_y.data(),
+                    cluster.m_z.data());
+                g_sink = g_sink + clusterShapes.getCentreOfGravity()[0] + clusterShapes.getEigenValInertia()[0] + clusterShapes.getEigenVecInertia()[0];
+            }
+        }));
+
+        const float eCalBarrelInnerR(KernelBenchmarkAccess::GetECalBarrelInnerR(trackCreator));
+
+        results.push_back(TimeKernel("HelixClass::getPointOnCircle", helices.size(), parameters.m_minSeconds, [&]()
+        {
+            for (HelixClass &helix : helices)
+            {
+                float referencePoint[3] = {helix.getReferencePoint()[0], helix.getReferencePoint()[1], helix.getReferencePoint()[2]};
+                float point[6] = {0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+                g_sink = g_sink + helix.getPointOnCircle(eCalBarrelInnerR, referencePoint, point);
+            }
+        }));
+
+        results.push_back(TimeKernel("HelixClass::getDistanceToHelix", (helices.size() > 1) ? helices.size() - 1 : 0, parameters.m_minSeconds, [&]()
+        {
+            for (unsigned int iHelix = 1; iHelix < helices.size(); ++iHelix)
+            {
+                float position[3] = {0.f, 0.f, 0.f}, momentum[3] = {0.f, 0.f, 0.f};
+                g_sink = g_sink + helices[iHelix - 1].getDistanceToHelix(&helices[iHelix], position, momentum);
+            }
+        }));
+
+        std::cout << std::left << std::setw(50) << "Kernel" << std::right << std::setw(14) << "calls" << std::setw(12) << "ns/call"
+                  << std::setw(14) << "allocs/call" << std::endl;
+
+        BenchmarkBaseline benchmarkBaseline("ns");
+
+        for (const KernelResult &result : results)
+        {
+            std::cout << std::left << std::setw(50) << result.m_name << std::right << std::setw(14) << result.m_nCalls << std::setw(12)
+                      << std::fixed << std::setprecision(1) << result.m_nsPerCall << std::setw(14) << std::setprecision(2)
+                      << result.m_allocationsPerCall << std::endl;
+
+            benchmarkBaseline.SetEntry(result.m_name, result.m_nsPerCall, result.m_allocationsPerCall);
+        }
+
+        std::cout << std::defaultfloat << std::setprecision(6);
+
+        if (!parameters.m_newBaselineFile.empty() && !benchmarkBaseline.WriteJson(parameters.m_newBaselineFile))
+            std::cout << "Could not write baseline to " << parameters.m_newBaselineFile << std::endl;
+
+        if (!parameters.m_baselineFile.empty())
+        {
+            BenchmarkBaseline referenceBaseline("ns");
+
+            if (!referenceBaseline.ReadJson(parameters.m_baselineFile))
+            {
+                std::cout << "Could not read baseline from " << parameters.m_baselineFile << std::endl;
+                return 1;
+            }
+
+            // Nothing to compare with is not a pass; ctest reports exit code 77 as a skipped test
+            if (referenceBaseline.GetEntries().empty())
+            {
+                std::cout << "Baseline " << parameters.m_baselineFile << " has no entries, write it with -u" << std::endl;
+                return 77;
+            }
+
+            // Kernels run from a few ns per call, and most should not allocate at all
+            BenchmarkBaseline::Settings baselineSettings(parameters.m_baselineSettings);
+            baselineSettings.m_minTimeIncrease = 1.;
+            baselineSettings.m_minAllocationIncrease = 0.1;
+
+            const unsigned int nRegressions(benchmarkBaseline.Compare(referenceBaseline, baselineSettings));
+
+            if (nRegressions > 0)
+            {
+                std::cout << "Pandora kernel benchmark: " << nRegressions << " kernels regressed with respect to " << parameters.m_baselineFile
+                          << std::endl;
+                return 2;
+            }
+        }
+    }
+    catch (pandora::StatusCodeException &statusCodeException)
+    {
+        std::cout << "Pandora kernel benchmark failed: " << statusCodeException.ToString() << std::endl;
+        return 1;
+    }
+    catch (gear::Exception &exception)
+    {
+        std::cout << "Pandora kernel benchmark failed to read the geometry: " << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+/**
+ *
+ *  @brief  Replays pandora input recorded by PandoraPFAlg (RecordInput = True) into a standalone pandora instance, without
+ *          Gaudi, podio or GEAR. All events are loaded before the first one is processed, so the timings are free of I/O.
+ *
+ *  $Log: $
+ */
+
+#include "Api/PandoraApi.h"
+#include "LCContent.h"
+
+#include "PandoraInputReader.h"
+#include "StageTimingMonitor.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /**
+     *  @brief  The command line parameters
+     */
+    class Parameters
+    {
+    public:
+        std::string     m_inputFile;                            ///< The recorded input file
+        std::string     m_settingsFile;                         ///< The pandora settings xml file, empty to use the recorded one
+        std::string     m_timingFile;                           ///< The stage timing json file, empty for none
+        int             m_nEvents = -1;                         ///< The maximum number of events to replay, negative for all
+        int             m_nRepeats = 1;                         ///< The number of passes over the events
+    };
+
+    void PrintUsage(const char *const pProgramName)
+    {
+        std::cout << "Usage: " << pProgramName << " -i input.bin [-s PandoraSettings.xml] [-n nEvents] [-r nRepeats] [-t timing.json]" << std::endl
+                  << "    -i  input file written by PandoraPFAlg with RecordInput = True" << std::endl
+                  << "    -s  pandora settings xml file, defaults to the one the input was recorded with" << std::endl
+                  << "    -n  maximum number of events to replay, default all" << std::endl
+                  << "    -r  number of passes over the events, default 1" << std::endl
+                  << "    -t  write per-stage timing statistics to a json file" << std::endl;
+    }
+
+    bool ParseCommandLine(const int argc, char *argv[], Parameters &parameters)
+    {
+        for (int iArg = 1; iArg < argc; ++iArg)
+        {
+            const std::string option(argv[iArg]);
+
+            if (iArg + 1 >= argc)
+                return false;
+
+            const std::string value(argv[++iArg]);
+
+            if ("-i" == option) parameters.m_inputFile = value;
+            else if ("-s" == option) parameters.m_settingsFile = value;
+            else if ("-t" == option) parameters.m_timingFile = value;
+            else if ("-n" == option) parameters.m_nEvents = std::atoi(value.c_str());
+            else if ("-r" == option) parameters.m_nRepeats = std::atoi(value.c_str());
+            else return false;
+        }
+
+        return !parameters.m_inputFile.empty() && (parameters.m_nRepeats > 0);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    Parameters parameters;
+
+    if (!ParseCommandLine(argc, argv, parameters))
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        PandoraInputReader reader;
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, reader.Open(parameters.m_inputFile));
+
+        const PandoraInputFormat::RunSettings &runSettings(reader.GetRunSettings());
+        const std::string settingsFile(parameters.m_settingsFile.empty() ? runSettings.m_pandoraSettingsXmlFile : parameters.m_settingsFile);
+
+        // Same set up as PandoraPFAlg::initialize, with the geometry taken from the file
+        pandora::Pandora pandora;
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, reader.CreateGeometry(pandora));
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterAlgorithms(pandora));
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterBasicPlugins(pandora));
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterBFieldPlugin(pandora,
+            runSettings.m_innerBField, runSettings.m_muonBarrelBField, runSettings.m_muonEndCapBField));
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterNonLinearityEnergyCorrection(pandora,
+            "NonLinearity", pandora::HADRONIC, runSettings.m_inputEnergyCorrectionPoints, runSettings.m_outputEnergyCorrectionPoints));
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(pandora, settingsFile));
+
+        std::vector<PandoraInputReader::Event> events;
+
+        while ((parameters.m_nEvents < 0) || (static_cast<int>(events.size()) < parameters.m_nEvents))
+        {
+            PandoraInputReader::Event event;
+            const pandora::StatusCode statusCode(reader.ReadEvent(event));
+
+            if (pandora::STATUS_CODE_NOT_FOUND == statusCode)
+                break;
+
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, statusCode);
+            events.push_back(event);
+        }
+
+        std::cout << "Loaded " << events.size() << " events from " << parameters.m_inputFile << ", settings " << settingsFile << std::endl;
+
+        StageTimingMonitor stageTimingMonitor;
+
+        for (int iRepeat = 0; iRepeat < parameters.m_nRepeats; ++iRepeat)
+        {
+            for (const PandoraInputReader::Event &event : events)
+            {
+                StageTimingMonitor::EventTimes eventTimes = {};
+                const pandora::PfoList *pPfoList(NULL);
+                {
+                    ScopedStageTimer eventTimer(&eventTimes, StageTimingMonitor::EVENT);
+                    {
+                        // Recorded events hold the output of all creation stages, which are timed together under CreateCaloHits
+                        ScopedStageTimer timer(&eventTimes, StageTimingMonitor::CREATE_CALO_HITS);
+                        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, reader.ReplayEvent(pandora, event));
+                    }
+                    {
+                        ScopedStageTimer timer(&eventTimes, StageTimingMonitor::PROCESS_EVENT);
+                        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(pandora));
+                    }
+
+                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::GetCurrentPfoList(pandora, pPfoList));
+                    const size_t nPfos(pPfoList->size());
+                    {
+                        ScopedStageTimer timer(&eventTimes, StageTimingMonitor::RESET);
+                        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(pandora));
+                    }
+
+                    if (0 == iRepeat)
+                        std::cout << "Event " << event.m_eventNumber << ": " << nPfos << " pfos" << std::endl;
+                }
+
+                stageTimingMonitor.AddEvent(eventTimes);
+            }
+        }
+
+        const StageTimingMonitor::Stage stages[] = {StageTimingMonitor::CREATE_CALO_HITS, StageTimingMonitor::PROCESS_EVENT,
+            StageTimingMonitor::RESET, StageTimingMonitor::EVENT};
+
+        for (const StageTimingMonitor::Stage stage : stages)
+        {
+            const StageTimingMonitor::Summary summary(stageTimingMonitor.GetSummary(stage));
+            std::cout << "Stage " << StageTimingMonitor::GetStageName(stage) << " [ms]: mean " << summary.m_mean << ", p50 " << summary.m_p50
+                      << ", p95 " << summary.m_p95 << ", p99 " << summary.m_p99 << ", max " << summary.m_max << std::endl;
+        }
+
+        if (!parameters.m_timingFile.empty() && !stageTimingMonitor.WriteJson(parameters.m_timingFile))
+            std::cout << "Could not write stage timing to " << parameters.m_timingFile << std::endl;
+    }
+    catch (pandora::StatusCodeException &statusCodeException)
+    {
+        std::cout << "Pandora replay failed: " << statusCodeException.ToString() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,26 @@
+/**
+ *
+ *  @brief  Header file for the allocation counter class.
+ *
+ *  $Log: $
+ */
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H 1
+
+/**
+ *  @brief  AllocationCounter class, counts the heap allocations made through operator new. Linking AllocationCounter.cpp replaces
+ *          the global operator new and delete of the executable, so it belongs in the standalone benchmarks only.
+ */
+class AllocationCounter
+{
+public:
+    /**
+     *  @brief  Get the number of allocations made by the process so far, from all threads
+     *
+     *  @return the number of allocations
+     */
+    static unsigned long GetNAllocations();
+};
+
+#endif // #ifndef ALLOCATION_COUNTER_H
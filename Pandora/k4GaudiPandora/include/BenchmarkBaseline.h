@@ -0,0 +1,110 @@
+/**
+ *
+ *  @brief  Header file for the benchmark baseline class.
+ *
+ *  $Log: $
+ */
+
+#ifndef BENCHMARK_BASELINE_H
+#define BENCHMARK_BASELINE_H 1
+
+#include <map>
+#include <string>
+
+/**
+ *  @brief  BenchmarkBaseline class, the time and allocation count of each measured entry (a stage or a kernel) of a benchmark run.
+ *          A baseline written on a reference machine is compared with later runs of the same workload to catch regressions.
+ */
+class BenchmarkBaseline
+{
+public:
+    /**
+     *  @brief  The measurement of one entry
+     */
+    class Entry
+    {
+    public:
+        double          m_time;                                 ///< The time, in the unit of the baseline
+        double          m_allocations;                          ///< The number of heap allocations
+    };
+
+    typedef std::map<std::string, Entry> EntryMap;
+
+    /**
+     *  @brief  Settings class, the tolerances of the comparison with a baseline
+     */
+    class Settings
+    {
+    public:
+        double          m_timeTolerance = 0.25;                 ///< The allowed relative time increase, negative to compare allocations only
+        double          m_allocationTolerance = 0.1;            ///< The allowed relative increase of the allocation count
+        double          m_minTimeIncrease = 0.;                 ///< Time increases below this are never regressions, absorbs timer noise
+        double          m_minAllocationIncrease = 1.;           ///< Allocation increases below this are never regressions
+    };
+
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  unit the unit of the entry times
+     */
+    explicit BenchmarkBaseline(const std::string &unit);
+
+    /**
+     *  @brief  Set the measurement of an entry, replacing any previous one
+     *
+     *  @param  name the entry name
+     *  @param  time the time
+     *  @param  allocations the number of heap allocations
+     */
+    void SetEntry(const std::string &name, const double time, const double allocations);
+
+    /**
+     *  @brief  Get the entries
+     *
+     *  @return the entries, keyed by name
+     */
+    const EntryMap &GetEntries() const;
+
+    /**
+     *  @brief  Write the baseline to a json file
+     *
+     *  @param  fileName the output file name
+     *
+     *  @return whether the file could be written
+     */
+    bool WriteJson(const std::string &fileName) const;
+
+    /**
+     *  @brief  Read a baseline written by WriteJson, replacing the current entries
+     *
+     *  @param  fileName the input file name
+     *
+     *  @return whether the file could be read and has the unit of this baseline
+     */
+    bool ReadJson(const std::string &fileName);
+
+    /**
+     *  @brief  Compare with a reference baseline and print one line per entry. A reference entry missing from this run is a
+     *          regression, as the stage or kernel it guards is no longer measured. Entries missing from the reference are reported
+     *          only, so that stages or kernels can be added without invalidating stored baselines.
+     *
+     *  @param  reference the reference baseline
+     *  @param  settings the comparison tolerances
+     *
+     *  @return the number of entries that regressed
+     */
+    unsigned int Compare(const BenchmarkBaseline &reference, const Settings &settings) const;
+
+private:
+    std::string         m_unit;                                 ///< The unit of the entry times
+    EntryMap            m_entries;                              ///< The entries, keyed by name
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const BenchmarkBaseline::EntryMap &BenchmarkBaseline::GetEntries() const
+{
+    return m_entries;
+}
+
+#endif // #ifndef BENCHMARK_BASELINE_H
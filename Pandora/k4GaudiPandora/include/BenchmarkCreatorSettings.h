@@ -0,0 +1,40 @@
+/**
+ *
+ *  @brief  Header file for the benchmark creator settings class.
+ *
+ *  $Log: $
+ */
+
+#ifndef BENCHMARK_CREATOR_SETTINGS_H
+#define BENCHMARK_CREATOR_SETTINGS_H 1
+
+#include "CaloHitCreator.h"
+#include "GeometryCreator.h"
+#include "MCParticleCreator.h"
+#include "PfoCreator.h"
+#include "SyntheticEventGenerator.h"
+#include "TrackCreator.h"
+
+/**
+ *  @brief  BenchmarkCreatorSettings class, the creator settings of the standalone benchmarks, with the values PandoraPFAlg uses by
+ *          default and the calibration matching the synthetic event generator
+ */
+class BenchmarkCreatorSettings
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  generatorSettings the settings of the generator providing the input collections
+     *  @param  innerBField the magnetic field at the ip, units T
+     */
+    BenchmarkCreatorSettings(const SyntheticEventGenerator::Settings &generatorSettings, const float innerBField);
+
+    GeometryCreator::Settings       m_geometryCreatorSettings;      ///< The geometry creator settings
+    CaloHitCreator::Settings        m_caloHitCreatorSettings;       ///< The calo hit creator settings
+    TrackCreator::Settings          m_trackCreatorSettings;         ///< The track creator settings
+    MCParticleCreator::Settings     m_mcParticleCreatorSettings;    ///< The mc particle creator settings
+    PfoCreator::Settings            m_pfoCreatorSettings;           ///< The pfo creator settings
+};
+
+#endif // #ifndef BENCHMARK_CREATOR_SETTINGS_H
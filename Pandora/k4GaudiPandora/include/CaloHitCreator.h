@@ -8,16 +8,25 @@
 #ifndef CALO_HIT_CREATOR_H
 #define CALO_HIT_CREATOR_H 1
 
-#include "GaudiKernel/ISvcLocator.h"
 #include "edm4hep/CalorimeterHit.h"
+#include "edm4hep/CalorimeterHitCollection.h"
 
 #include "gear/LayerLayout.h"
 
 #include "Api/PandoraApi.h"
 
+#include "CellIDFieldDecoder.h"
+#include "CellMask.h"
+#include "IdIndexMap.h"
+
 #include <string>
 
+class PandoraInputRecorder;
+class TraceRecorder;
+class WorkerPool;
+
 typedef std::vector<edm4hep::CalorimeterHit *> CalorimeterHitVector;
+typedef std::vector<edm4hep::CalorimeterHit> CalorimeterHitStore;
 
 namespace gear { class GearMgr; }
 
@@ -89,6 +98,28 @@ public:
         float           m_eCalScToHadGeVBarrel;                 ///< The calibration from deposited Sc-layer energy on the endcaps to hadronic energy
         float           m_eCalSiToHadGeVEndCap;                 ///< The calibration from deposited Si-layer energy on the enecaps to hadronic energy
         float           m_eCalScToHadGeVEndCap;                 ///< The calibration from deposited Sc-layer energy on the endcaps to hadronic energy
+
+        unsigned int    m_nParameterThreads;                    ///< The number of threads building calo hit parameters, one to build them serially
+        unsigned int    m_parameterChunkSize;                   ///< The number of calo hits whose parameters are built by one task
+
+        std::string     m_cellMaskFile;                         ///< The file listing masked cells and per cell mip thresholds, empty for none
+
+        float           m_eCalTimeWindowMin;                    ///< The earliest ecal hit time passed to pandora, units ns
+        float           m_eCalTimeWindowMax;                    ///< The latest ecal hit time passed to pandora, units ns
+        float           m_hCalTimeWindowMin;                    ///< The earliest hcal hit time passed to pandora, units ns
+        float           m_hCalTimeWindowMax;                    ///< The latest hcal hit time passed to pandora, units ns
+        float           m_muonTimeWindowMin;                    ///< The earliest muon hit time passed to pandora, units ns
+        float           m_muonTimeWindowMax;                    ///< The latest muon hit time passed to pandora, units ns
+        float           m_lCalTimeWindowMin;                    ///< The earliest lcal hit time passed to pandora, units ns
+        float           m_lCalTimeWindowMax;                    ///< The latest lcal hit time passed to pandora, units ns
+        float           m_lHCalTimeWindowMin;                   ///< The earliest lhcal hit time passed to pandora, units ns
+        float           m_lHCalTimeWindowMax;                   ///< The latest lhcal hit time passed to pandora, units ns
+        int             m_timeWindowTofCorrection;              ///< Whether the time windows apply to hit times less the time of flight from the ip
+
+        unsigned int    m_cellCoarseningFactor0;                ///< The number of cells merged along the first cell index in coarsening mode, one for no merging
+        unsigned int    m_cellCoarseningFactor1;                ///< The number of cells merged along the second cell index in coarsening mode, one for no merging
+
+        DuplicatePolicy m_duplicatePolicy;                      ///< The policy for hits sharing their cell id with an earlier hit of the event
     };
 
     /**
@@ -96,8 +127,10 @@ public:
      * 
      *  @param  settings the creator settings
      *  @param  pPandora address of the relevant pandora instance
+     *  @param  pGearMgr address of the gear manager describing the detector
+     *  @param  encoder_style the cell id encoding style, 0 for the LCIO style
      */
-     CaloHitCreator(const Settings &settings, const pandora::Pandora *const pPandora, ISvcLocator* svcloc, bool encoder_style);
+     CaloHitCreator(const Settings &settings, const pandora::Pandora *const pPandora, gear::GearMgr *const pGearMgr, bool encoder_style);
 
     /**
      *  @brief  Destructor
@@ -117,61 +150,380 @@ public:
      */
     const CalorimeterHitVector &GetCalorimeterHitVector() const;
 
+    /**
+     *  @brief  Get the number of hits of the current event rejected because their cell is masked
+     *
+     *  @return the number of masked hits
+     */
+    unsigned int GetNMaskedCaloHits() const;
+
+    /**
+     *  @brief  Get the number of hits of the current event rejected by the mip threshold of their own cell
+     *
+     *  @return the number of hits below their cell threshold
+     */
+    unsigned int GetNBelowCellThresholdCaloHits() const;
+
+    /**
+     *  @brief  Get the number of hits of the current event rejected by the time window of their subdetector
+     *
+     *  @return the number of out of time hits
+     */
+    unsigned int GetNOutOfTimeCaloHits() const;
+
+    /**
+     *  @brief  Get the number of hits of the current event merged into the virtual cell of another hit by cell coarsening
+     *
+     *  @return the number of merged hits
+     */
+    unsigned int GetNMergedCaloHits() const;
+
+    /**
+     *  @brief  Get the number of hits of the current event sharing their cell id with an earlier hit, in configuration order
+     *
+     *  @return the number of duplicate hits
+     */
+    unsigned int GetNDuplicateCaloHits() const;
+
     /**
      *  @brief  Reset the calo hit creator
      */
     void Reset();
 
+    /**
+     *  @brief  Set the trace recorder receiving a span per calo hit collection
+     *
+     *  @param  pTraceRecorder address of the trace recorder, NULL to switch tracing off
+     */
+    void SetTraceRecorder(TraceRecorder *const pTraceRecorder);
+
+    /**
+     *  @brief  Set the input recorder receiving the calo hits passed to pandora
+     *
+     *  @param  pInputRecorder address of the input recorder, NULL to switch recording off
+     */
+    void SetInputRecorder(PandoraInputRecorder *const pInputRecorder);
+
 private:
+    friend class KernelBenchmarkAccess;     ///< The kernel microbenchmark times the private per calo hit kernels in isolation
+
     /**
-     *  @brief  Create ecal calo hits
-     * 
+     *  @brief  LayerProperties class, the calo hit properties that depend only on the subdetector and the physical layer
      */
-    pandora::StatusCode CreateECalCaloHits(const CollectionMaps& collectionMaps);
+    class LayerProperties
+    {
+    public:
+        float           m_cellSize0;                            ///< The cell size 0
+        float           m_cellSize1;                            ///< The cell size 1
+        float           m_cellThickness;                        ///< The cell thickness
+        float           m_nCellRadiationLengths;                ///< The absorber thickness in radiation lengths
+        float           m_nCellInteractionLengths;              ///< The absorber thickness in interaction lengths
+        float           m_absorberCorrection;                   ///< The ratio of the first non-zero absorber thickness to that of this layer
+    };
+
+    typedef std::vector<LayerProperties> LayerPropertiesTable;
 
     /**
-     *  @brief  Create hcal calo hits
-     * 
+     *  @brief  PolygonNormals class, the normals of a regular polygon in the xy plane, precomputed for the distance of hits from
+     *          its faces and for the cell normals of barrel staves
      */
-    pandora::StatusCode CreateHCalCaloHits(const CollectionMaps& collectionMaps);
+    class PolygonNormals
+    {
+    public:
+        /**
+         *  @brief  Default constructor, a polygon with no faces, treated as a circle
+         */
+        PolygonNormals();
+
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  symmetryOrder the symmetry order, polygons of order 2 or below are treated as circles
+         *  @param  phi0 the phi coordinate of the first face
+         */
+        PolygonNormals(const unsigned int symmetryOrder, const float phi0);
+
+        unsigned int                        m_symmetryOrder;    ///< The symmetry order
+        float                               m_phi0;             ///< The phi coordinate of the first face
+        pandora::FloatVector                m_faceCosPhi;       ///< The x component of the unit normal of each face
+        pandora::FloatVector                m_faceSinPhi;       ///< The y component of the unit normal of each face
+        std::vector<pandora::CartesianVector> m_staveNormals;   ///< The cell normal of each stave number, 0 to the symmetry order
+    };
 
     /**
-     *  @brief  Create muon calo hits
-     * 
+     *  @brief  CollectionBinding class, everything the conversion of one calo hit collection needs that does not change between
+     *          events: the cell id fields, the layer properties, the region boundaries and the calibration
      */
-    pandora::StatusCode CreateMuonCaloHits(const CollectionMaps& collectionMaps);
+    class CollectionBinding
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  collectionName the calo hit collection name
+         */
+        explicit CollectionBinding(const std::string &collectionName);
+
+        std::string                     m_collectionName;           ///< The calo hit collection name
+        bool                            m_hasCellIdFields;          ///< Whether the cell id fields could be resolved from the encoding
+        CellIDFieldDecoder::Field       m_layerField;               ///< The layer field of the cell id
+        CellIDFieldDecoder::Field       m_staveField;               ///< The stave field of the cell id
+
+        LayerPropertiesTable            m_barrelLayerTable;         ///< The barrel layer properties, empty for endcap only subdetectors
+        LayerPropertiesTable            m_endCapLayerTable;         ///< The endcap layer properties
+        LayerPropertiesTable            m_plugLayerTable;           ///< The endcap plug layer properties, empty if there is no plug
+        float                           m_barrelOuterZ;             ///< The barrel outer z coordinate
+        PolygonNormals                  m_barrelInnerPolygon;       ///< The barrel inner polygon normals
+
+        float                           m_toMip;                    ///< The calibration from deposited energy to mip
+        float                           m_mipThreshold;             ///< Threshold for creating calo hits, units mip
+        float                           m_toEMGeV;                  ///< The calibration from deposited energy to EM energy
+        float                           m_toHadGeVBarrel;           ///< The calibration from deposited barrel energy to hadronic energy
+        float                           m_toHadGeVEndCap;           ///< The calibration from deposited endcap energy to hadronic energy
+        float                           m_maxHadronicEnergy;        ///< The maximum hadronic energy allowed for a single hit
+        bool                            m_splitStrips;              ///< Whether cell sizes are corrected for strip splitting
+        bool                            m_isDigital;                ///< Whether hits are digital, energy from the hit count
+        float                           m_digitalHitEnergy;         ///< The energy of a digital hit, units GeV
+        CellMask                        m_cellMask;                 ///< The masked cells and the cells with their own mip threshold
+        bool                            m_hasTimeWindow;            ///< Whether hits outside a time window are rejected
+        float                           m_timeWindowMin;            ///< The earliest hit time passed to pandora, units ns
+        float                           m_timeWindowMax;            ///< The latest hit time passed to pandora, units ns
+        bool                            m_isCoarsened;              ///< Whether neighbouring cells are merged into virtual cells
+        CellIDFieldDecoder::Field       m_cellIndexField0;          ///< The first cell index field of the cell id, used for coarsening
+        CellIDFieldDecoder::Field       m_cellIndexField1;          ///< The second cell index field of the cell id, used for coarsening
+        unsigned int                    m_coarseningFactor0;        ///< The number of cells merged along the first cell index
+        unsigned int                    m_coarseningFactor1;        ///< The number of cells merged along the second cell index
+    };
+
+    typedef std::vector<CollectionBinding> CollectionBindingVector;
+    typedef std::vector<PandoraApi::CaloHit::Parameters> CaloHitParametersVector;
+    typedef std::vector<pandora::StatusCode> StatusCodeVector;
 
     /**
-     *  @brief  Create lcal calo hits
-     * 
-     */    
-    pandora::StatusCode CreateLCalCaloHits(const CollectionMaps& collectionMaps);
+     *  @brief  CaloHitColumns class, the hits of one collection that pass the energy threshold, as flat columns filled by the
+     *          pre-pass before any pandora parameters are built. The capacity is reused between collections and events.
+     */
+    class CaloHitColumns
+    {
+    public:
+        pandora::FloatVector                m_collectionTimes;      ///< The time of every hit of the collection, filled only with a time window
+        std::vector<unsigned int>           m_candidates;           ///< The collection index of each candidate hit: within the raw time range of the window, and the first copy of its cell
+        pandora::FloatVector                m_collectionEnergies;   ///< The energy of every candidate hit
+        std::vector<unsigned int>           m_indices;              ///< The collection index of each selected hit
+        pandora::FloatVector                m_energies;             ///< The energies, summed over the member hits of virtual cells
+        CellIDFieldDecoder::CellIdVector    m_cellIds;              ///< The cell ids
+        CellIDFieldDecoder::FieldValueVector m_layers;              ///< The layer field of the cell ids
+        CellIDFieldDecoder::FieldValueVector m_staves;              ///< The stave field of the cell ids
+        pandora::FloatVector                m_x;                    ///< The x coordinates
+        pandora::FloatVector                m_y;                    ///< The y coordinates
+        pandora::FloatVector                m_z;                    ///< The z coordinates
+        pandora::FloatVector                m_magnitude;            ///< The distances from the origin
+        pandora::FloatVector                m_directionX;           ///< The x components of the unit position vectors
+        pandora::FloatVector                m_directionY;           ///< The y components of the unit position vectors
+        pandora::FloatVector                m_directionZ;           ///< The z components of the unit position vectors
+        std::vector<unsigned char>          m_isInBarrelRegion;     ///< Whether each hit lies within the barrel outer z
+        std::vector<unsigned char>          m_isWithinCoil;         ///< Whether each barrel region hit lies within the coil outer radius
+    };
 
     /**
-     *  @brief  Create lhcal calo hits
-     * 
+     *  @brief  VirtualCell class, the running sums of one virtual cell of the coarsening mode
      */
-    pandora::StatusCode CreateLHCalCaloHits(const CollectionMaps& collectionMaps);
+    class VirtualCell
+    {
+    public:
+        unsigned int    m_seed;                                 ///< The column index of the most energetic member hit
+        float           m_seedEnergy;                           ///< The energy of the most energetic member hit
+        float           m_energy;                               ///< The summed energy of the member hits
+        float           m_weight;                               ///< The summed position weights of the member hits
+        float           m_weightedX;                            ///< The summed weighted x coordinates of the member hits
+        float           m_weightedY;                            ///< The summed weighted y coordinates of the member hits
+        float           m_weightedZ;                            ///< The summed weighted z coordinates of the member hits
+    };
+
+    typedef std::vector<VirtualCell> VirtualCellVector;
 
     /**
-     *  @brief  Get common calo hit properties: position, parent address, input energy and time
-     * 
+     *  @brief  CaloHitOwner class, the first hit of a subdetector with a given cell id, which is converted in place of all its copies
+     */
+    class CaloHitOwner
+    {
+    public:
+        const CollectionBinding            *m_pBinding;         ///< Address of the binding of the hit collection
+        unsigned int                        m_index;            ///< The index of the hit in its collection
+        float                               m_extraEnergy;      ///< The summed energy of the later copies, under the sum energy policy
+    };
+
+    typedef std::vector<CaloHitOwner> CaloHitOwnerVector;
+
+    /**
+     *  @brief  Columnar pre-pass over a calo hit collection: select the hits passing the mip threshold from the energy column, then
+     *          decode the cell ids and compute the position derived quantities of the selected hits only, in flat loops. Hits in
+     *          masked cells are dropped by the selection, and cells with their own threshold use it instead of the collection one.
+     *          With a time window, hits outside it are dropped before the energy is read, and, with the time of flight correction,
+     *          the remaining out of time hits once their positions are known. With duplicate detection, hits that are not the first
+     *          of the event with their cell id are dropped before the threshold. In coarsening mode the selected hits are then merged
+     *          into virtual cells, and the remaining columns describe the virtual cells.
+     *
+     *  @param  binding the collection binding
+     *  @param  caloHitCollection the calo hit collection
+     *
+     *  @return the number of selected hits, or of virtual cells in coarsening mode
+     */
+    template <typename TRAITS>
+    unsigned int FillCaloHitColumns(const CollectionBinding &binding, const edm4hep::CalorimeterHitCollection &caloHitCollection);
+
+    /**
+     *  @brief  Build the pandora parameters of one selected hit of the pre-pass columns. Reads only the settings, the binding, the
+     *          columns and the hit itself, so may be called for different hits concurrently. The parent address is left unset.
+     *
+     *  @param  binding the collection binding
+     *  @param  caloHitCollection the calo hit collection
+     *  @param  iSelected the index of the hit in the pre-pass columns
+     *  @param  caloHitParameters to receive the calo hit parameters
+     */
+    template <typename TRAITS>
+    void BuildCaloHitParameters(const CollectionBinding &binding, const edm4hep::CalorimeterHitCollection &caloHitCollection,
+        const unsigned int iSelected, PandoraApi::CaloHit::Parameters &caloHitParameters) const;
+
+    /**
+     *  @brief  Resolve the bindings of all configured calo hit collections, once at initialization
+     */
+    void BindCollections();
+
+    /**
+     *  @brief  Build the properties of every physical layer of a layer layout
+     *
+     *  @param  layerLayout the layer layout
+     *  @param  hitType the hit type, selecting the absorber radiation and interaction lengths
+     *  @param  layerTable to receive the layer properties, indexed by physical layer
+     */
+    void BuildLayerTable(const gear::LayerLayout &layerLayout, const pandora::HitType hitType, LayerPropertiesTable &layerTable) const;
+
+    /**
+     *  @brief  Read the cell mask file and give each collection binding its mask
+     */
+    void BindCellMasks();
+
+    /**
+     *  @brief  Set the time window of a collection binding; the window is switched off if it covers all finite times
+     *
+     *  @param  timeWindowMin the earliest hit time passed to pandora
+     *  @param  timeWindowMax the latest hit time passed to pandora
+     *  @param  binding the collection binding
+     */
+    void SetTimeWindow(const float timeWindowMin, const float timeWindowMax, CollectionBinding &binding) const;
+
+    /**
+     *  @brief  Select the hits of a collection whose raw time lies in the raw time range of its window, which is widened by the
+     *          largest time of flight if the time of flight correction is on, in one flat pass over the time column. The
+     *          candidates are in collection order.
+     *
+     *  @param  binding the collection binding
+     *  @param  caloHitCollection the calo hit collection
+     *
+     *  @return the number of candidate hits
+     */
+    unsigned int SelectTimeWindowCandidates(const CollectionBinding &binding, const edm4hep::CalorimeterHitCollection &caloHitCollection);
+
+    /**
+     *  @brief  Find the first hit with each cell id, over the collections of one subdetector in the order the hits are created.
+     *          Later copies are counted as duplicates; under the sum energy policy their energies are added to the first copy, and
+     *          under the fail policy the first duplicate fails the event.
+     *
+     *  @param  bindings the bindings of the subdetector calo hit collections
+     *  @param  collectionMaps the event collections
+     */
+    pandora::StatusCode FindDuplicateCaloHits(const CollectionBindingVector &bindings, const CollectionMaps &collectionMaps);
+
+    /**
+     *  @brief  Drop the candidate hits of a collection that are not the first hit of their subdetector with their cell id, writing
+     *          the remaining candidates and their energies, plus the energies of their copies under the sum energy policy
+     *
+     *  @param  binding the collection binding
+     *  @param  caloHitCollection the calo hit collection
+     *  @param  nCandidates the number of candidates, which are the first hits of the collection if there is no time window
+     *
+     *  @return the number of remaining candidates
      */
-    void GetCommonCaloHitProperties(const edm4hep::CalorimeterHit *const pCaloHit, PandoraApi::CaloHit::Parameters &caloHitParameters) const;
+    unsigned int SelectFirstCopies(const CollectionBinding &binding, const edm4hep::CalorimeterHitCollection &caloHitCollection,
+        const unsigned int nCandidates);
+
+    /**
+     *  @brief  Resolve the cell index fields used by cell coarsening; on failure the collection is converted without coarsening
+     *
+     *  @param  encodingString the cell id encoding string
+     *  @param  binding the collection binding
+     */
+    void BindCellCoarsening(const std::string &encodingString, CollectionBinding &binding) const;
+
+    /**
+     *  @brief  Merge the selected hits of the pre-pass columns into virtual cells, keyed by the cell id with both cell indices
+     *          divided by the coarsening factors, so all other fields (layer, stave, module, side) still separate the cells. Each
+     *          virtual cell takes the summed energy and the energy weighted position of its members, and the collection index and
+     *          cell id of its most energetic member, the seed. Virtual cells are written in place, in the order of their first
+     *          member hit.
+     *
+     *  @param  binding the collection binding
+     *  @param  nSelected the number of selected hits
+     *
+     *  @return the number of virtual cells
+     */
+    unsigned int CoarsenCaloHitColumns(const CollectionBinding &binding, const unsigned int nSelected);
+
+    /**
+     *  @brief  Resolve the layer and stave fields of a collection binding from the cell id encoding. On failure the collection is
+     *          skipped in every event.
+     *
+     *  @param  encodingString the cell id encoding string
+     *  @param  usesStave whether the stave field is needed
+     *  @param  binding the collection binding
+     */
+    void BindCellIdFields(const std::string &encodingString, const bool usesStave, CollectionBinding &binding) const;
+
+    /**
+     *  @brief  Create the calo hits of one subdetector. The per hit loop is compiled once per subdetector traits type, so the hit
+     *          type, region rule and energy model are constants and all per hit branching on them is folded away. The parameters of
+     *          each collection are built in chunks, on the worker pool if there is one, then the hits are created serially in
+     *          collection order, so the pandora input does not depend on the number of threads.
+     *
+     *  @param  bindings the bindings of the subdetector calo hit collections
+     *  @param  collectionMaps the event collections
+     */
+    template <typename TRAITS>
+    pandora::StatusCode CreateSubDetectorCaloHits(const CollectionBindingVector &bindings, const CollectionMaps &collectionMaps);
+
+    /**
+     *  @brief  Keep a handle to a calo hit passed to pandora, the store is reserved up front so the returned address stays valid
+     *          until the creator is reset
+     *
+     *  @param  caloHit the calo hit
+     *
+     *  @return address of the stored handle, to be used as pandora parent address
+     */
+    edm4hep::CalorimeterHit *StoreCaloHit(const edm4hep::CalorimeterHit &caloHit);
+
+    /**
+     *  @brief  Set the layer specific calo hit properties: cell size, thickness, absorber radiation and interaction lengths
+     *
+     *  @param  layerTable the layer properties of the subdetector region, hit layers beyond the last are given the last layer properties
+     *  @param  caloHitParameters the calo hit parameters, with the layer already set
+     *  @param  absorberCorrection to receive the absorber correction
+     */
+    void SetLayerProperties(const LayerPropertiesTable &layerTable, PandoraApi::CaloHit::Parameters &caloHitParameters, float &absorberCorrection) const;
 
     /**
      *  @brief  Get end cap specific calo hit properties: cell size, absorber radiation and interaction lengths, normal vector
      * 
      */
-    void GetEndCapCaloHitProperties(const edm4hep::CalorimeterHit *const pCaloHit, const gear::LayerLayout &layerLayout,
+    void GetEndCapCaloHitProperties(const edm4hep::CalorimeterHit *const pCaloHit, const LayerPropertiesTable &layerTable,
         PandoraApi::CaloHit::Parameters &caloHitParameters, float &absorberCorrection) const;
 
     /**
      *  @brief  Get barrel specific calo hit properties: cell size, absorber radiation and interaction lengths, normal vector
      * 
      */
-    void GetBarrelCaloHitProperties(const edm4hep::CalorimeterHit *const pCaloHit, const gear::LayerLayout &layerLayout,
-        unsigned int barrelSymmetryOrder, float barrelPhi0, unsigned int staveNumber, PandoraApi::CaloHit::Parameters &caloHitParameters,
+    void GetBarrelCaloHitProperties(const edm4hep::CalorimeterHit *const pCaloHit, const LayerPropertiesTable &layerTable,
+        const PolygonNormals &barrelPolygon, unsigned int staveNumber, PandoraApi::CaloHit::Parameters &caloHitParameters,
         float &absorberCorrection) const;
 
     /**
@@ -184,7 +536,7 @@ private:
      *  @brief  Get the maximum radius of a calo hit in a polygonal detector structure
      * 
      */
-    float GetMaximumRadius(const edm4hep::CalorimeterHit *const pCaloHit, const unsigned int symmetryOrder, const float phi0) const;
+    float GetMaximumRadius(const edm4hep::CalorimeterHit *const pCaloHit, const PolygonNormals &polygon) const;
 
     /**
      *  @brief  Get the layer coding string from the provided cell id encoding string
@@ -207,11 +559,14 @@ private:
     const Settings                      m_settings;                         ///< The calo hit creator settings
 
     const pandora::Pandora             *m_pPandora;                         ///< Address of the pandora object to create calo hits
+    TraceRecorder                      *m_pTraceRecorder;                   ///< Address of the trace recorder, NULL when tracing is off
+    PandoraInputRecorder               *m_pInputRecorder;                   ///< Address of the input recorder, NULL when recording is off
 
     float                               m_eCalBarrelOuterZ;                 ///< ECal barrel outer z coordinate
     float                               m_hCalBarrelOuterZ;                 ///< HCal barrel outer z coordinate
     float                               m_muonBarrelOuterZ;                 ///< Muon barrel outer z coordinate
     float                               m_coilOuterR;                       ///< Coil outer r coordinate
+    float                               m_maxTimeOfFlight;                  ///< The time of flight from the ip to the outer corner of the yoke, units ns
 
     float                               m_eCalBarrelInnerPhi0;              ///< ECal barrel inner phi0 coordinate
     unsigned int                        m_eCalBarrelInnerSymmetry;          ///< ECal barrel inner symmetry order
@@ -226,10 +581,37 @@ private:
     float                               m_hCalBarrelOuterPhi0;              ///< HCal barrel outer phi0 coordinate
     unsigned int                        m_hCalBarrelOuterSymmetry;          ///< HCal barrel outer symmetry order
 
+    PolygonNormals                      m_eCalBarrelInnerPolygon;           ///< ECal barrel inner polygon normals
+    PolygonNormals                      m_hCalBarrelInnerPolygon;           ///< HCal barrel inner polygon normals
+    PolygonNormals                      m_muonBarrelInnerPolygon;           ///< Muon barrel inner polygon normals
+    PolygonNormals                      m_hCalBarrelOuterPolygon;           ///< HCal barrel outer polygon normals
+    PolygonNormals                      m_hCalEndCapInnerPolygon;           ///< HCal endcap inner polygon normals
+
     float                               m_hCalBarrelLayerThickness;         ///< HCal barrel layer thickness
     float                               m_hCalEndCapLayerThickness;         ///< HCal endcap layer thickness
 
+    CollectionBindingVector             m_eCalBindings;                     ///< The ecal calo hit collection bindings
+    CollectionBindingVector             m_hCalBindings;                     ///< The hcal calo hit collection bindings
+    CollectionBindingVector             m_muonBindings;                     ///< The muon calo hit collection bindings
+    CollectionBindingVector             m_lCalBindings;                     ///< The lcal calo hit collection bindings
+    CollectionBindingVector             m_lHCalBindings;                    ///< The lhcal calo hit collection bindings
+
+    CaloHitColumns                      m_caloHitColumns;                   ///< The pre-pass columns of the current collection
+    CaloHitParametersVector             m_caloHitParameters;                ///< The parameters built for the selected hits of the current collection
+    StatusCodeVector                    m_caloHitStatusCodes;               ///< Whether the parameters of each selected hit could be built
+    VirtualCellVector                   m_virtualCells;                     ///< The virtual cells of the current collection, in coarsening mode
+    IdIndexMap                          m_virtualCellIndices;               ///< The index of each virtual cell, by coarsened cell id
+    IdIndexMap                          m_cellIdOwners;                     ///< The index of the first hit of the subdetector with each cell id, with duplicate detection
+    CaloHitOwnerVector                  m_caloHitOwners;                    ///< The first hit of the subdetector with each cell id, with duplicate detection
+    WorkerPool                         *m_pWorkerPool;                      ///< Builds the calo hit parameters in parallel, NULL when built serially
+
+    CalorimeterHitStore                 m_caloHitStore;                     ///< Handles to the calo hits passed to pandora, capacity reused between events
     CalorimeterHitVector                m_calorimeterHitVector;             ///< The calorimeter hit vector
+    unsigned int                        m_nMaskedCaloHits;                  ///< The number of hits of the current event in masked cells
+    unsigned int                        m_nBelowCellThresholdCaloHits;      ///< The number of hits of the current event below their cell threshold
+    unsigned int                        m_nOutOfTimeCaloHits;               ///< The number of hits of the current event outside their time window
+    unsigned int                        m_nMergedCaloHits;                  ///< The number of hits of the current event merged into another hit's virtual cell
+    unsigned int                        m_nDuplicateCaloHits;               ///< The number of hits of the current event sharing the cell id of an earlier hit
     std::string                         m_encoder_str;
     std::string                         m_encoder_str_MUON ; 
     std::string                         m_encoder_str_LCal ; 
@@ -246,9 +628,64 @@ inline const CalorimeterHitVector &CaloHitCreator::GetCalorimeterHitVector() con
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+inline unsigned int CaloHitCreator::GetNMaskedCaloHits() const
+{
+    return m_nMaskedCaloHits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int CaloHitCreator::GetNBelowCellThresholdCaloHits() const
+{
+    return m_nBelowCellThresholdCaloHits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int CaloHitCreator::GetNOutOfTimeCaloHits() const
+{
+    return m_nOutOfTimeCaloHits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int CaloHitCreator::GetNMergedCaloHits() const
+{
+    return m_nMergedCaloHits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int CaloHitCreator::GetNDuplicateCaloHits() const
+{
+    return m_nDuplicateCaloHits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 inline void CaloHitCreator::Reset()
 {
     m_calorimeterHitVector.clear();
+    m_caloHitStore.clear();
+    m_nMaskedCaloHits = 0;
+    m_nBelowCellThresholdCaloHits = 0;
+    m_nOutOfTimeCaloHits = 0;
+    m_nMergedCaloHits = 0;
+    m_nDuplicateCaloHits = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void CaloHitCreator::SetTraceRecorder(TraceRecorder *const pTraceRecorder)
+{
+    m_pTraceRecorder = pTraceRecorder;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void CaloHitCreator::SetInputRecorder(PandoraInputRecorder *const pInputRecorder)
+{
+    m_pInputRecorder = pInputRecorder;
 }
 
 #endif // #ifndef CALO_HIT_CREATOR_H
@@ -0,0 +1,148 @@
+/**
+ *
+ *  @brief  Header file for the cell id field decoder class.
+ *
+ *  $Log: $
+ */
+
+#ifndef CELL_ID_FIELD_DECODER_H
+#define CELL_ID_FIELD_DECODER_H 1
+
+#include "edm4hep/CalorimeterHitCollection.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ *  @brief  CellIDFieldDecoder class, decodes cell id fields with shifts and masks resolved once from the encoding string. The
+ *          encoding has the UTIL::BitField64 format: comma separated "name:width" or "name:offset:width" fields, a negative width
+ *          marking a signed field. Unlike ID_UTIL::CellIDDecoder, no field is looked up by name once the decoder is built.
+ */
+class CellIDFieldDecoder
+{
+public:
+    typedef std::vector<uint64_t> CellIdVector;
+    typedef std::vector<int> FieldValueVector;
+
+    /**
+     *  @brief  Field class, the position of one field in the cell id
+     */
+    class Field
+    {
+    public:
+        /**
+         *  @brief  Default constructor, a field that always decodes to zero
+         */
+        Field();
+
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  offset the offset of the lowest bit of the field
+         *  @param  width the number of bits of the field
+         *  @param  isSigned whether the field is signed
+         */
+        Field(const unsigned int offset, const unsigned int width, const bool isSigned);
+
+        /**
+         *  @brief  Decode the field from a cell id
+         *
+         *  @param  cellId the cell id
+         *
+         *  @return the field value
+         */
+        long long Decode(const uint64_t cellId) const;
+
+        unsigned int    m_offset;                               ///< The offset of the lowest bit of the field
+        unsigned int    m_width;                                ///< The number of bits of the field
+        bool            m_isSigned;                             ///< Whether the field is signed
+        uint64_t        m_mask;                                 ///< The mask of the field bits, after shifting them down by the offset
+    };
+
+    /**
+     *  @brief  Constructor, throws STATUS_CODE_INVALID_PARAMETER if the encoding string is malformed
+     *
+     *  @param  encodingString the cell id encoding string
+     */
+    explicit CellIDFieldDecoder(const std::string &encodingString);
+
+    /**
+     *  @brief  Get the encoding string
+     *
+     *  @return the encoding string
+     */
+    const std::string &GetEncodingString() const;
+
+    /**
+     *  @brief  Whether the encoding has a field of a given name
+     *
+     *  @param  name the field name
+     *
+     *  @return boolean
+     */
+    bool HasField(const std::string &name) const;
+
+    /**
+     *  @brief  Get a field by name, throws STATUS_CODE_NOT_FOUND if there is no such field
+     *
+     *  @param  name the field name
+     *
+     *  @return the field
+     */
+    const Field &GetField(const std::string &name) const;
+
+    /**
+     *  @brief  Decode one field of many cell ids in a single pass. The loop has no branches, so that the compiler can vectorise it;
+     *          the field is assumed to fit in an int, as layer, stave and module fields do.
+     *
+     *  @param  field the field
+     *  @param  cellIds the cell ids
+     *  @param  values to receive the field values, resized to the number of cell ids
+     */
+    static void DecodeColumn(const Field &field, const CellIdVector &cellIds, FieldValueVector &values);
+
+    /**
+     *  @brief  Get the cell ids of all hits of a collection, in collection order
+     *
+     *  @param  caloHitCollection the calo hit collection
+     *  @param  cellIds to receive the cell ids, resized to the collection size
+     */
+    static void GetCellIds(const edm4hep::CalorimeterHitCollection &caloHitCollection, CellIdVector &cellIds);
+
+private:
+    typedef std::map<std::string, Field> FieldMap;
+
+    std::string         m_encodingString;                       ///< The encoding string
+    FieldMap            m_fieldMap;                             ///< The fields, keyed by name
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline long long CellIDFieldDecoder::Field::Decode(const uint64_t cellId) const
+{
+    if (0 == m_width)
+        return 0;
+
+    // Signed fields are moved to the top bits and shifted back down arithmetically, which sign extends them
+    return m_isSigned ? static_cast<int64_t>(cellId << (64 - m_offset - m_width)) >> (64 - m_width) :
+        static_cast<long long>((cellId >> m_offset) & m_mask);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const std::string &CellIDFieldDecoder::GetEncodingString() const
+{
+    return m_encodingString;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool CellIDFieldDecoder::HasField(const std::string &name) const
+{
+    return (m_fieldMap.end() != m_fieldMap.find(name));
+}
+
+#endif // #ifndef CELL_ID_FIELD_DECODER_H
@@ -0,0 +1,162 @@
+/**
+ *
+ *  @brief  Header file for the cell mask class.
+ *
+ *  $Log: $
+ */
+
+#ifndef CELL_MASK_H
+#define CELL_MASK_H 1
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ *  @brief  CellMask class, the cells of one calo hit collection that are masked (dead or noisy channels) or have their own mip
+ *          threshold. Lookups go through a bitmap filter first, so that cells that are not listed, nearly all of them, usually
+ *          cost a multiplication and one load rather than a hash map lookup.
+ */
+class CellMask
+{
+public:
+    /**
+     *  @brief  How a cell is treated
+     */
+    enum CellStatus
+    {
+        UNLISTED,                           ///< Not listed, the collection threshold applies
+        MASKED,                             ///< Masked, hits in the cell are always rejected
+        OWN_THRESHOLD                       ///< Listed with its own mip threshold, replacing the collection threshold
+    };
+
+    typedef std::map<std::string, CellMask> CollectionCellMaskMap;
+
+    /**
+     *  @brief  Default constructor, an empty mask
+     */
+    CellMask();
+
+    /**
+     *  @brief  Mask a cell, replacing any threshold it was given
+     *
+     *  @param  cellId the cell id
+     */
+    void MaskCell(const uint64_t cellId);
+
+    /**
+     *  @brief  Give a cell its own mip threshold, replacing any earlier entry for it
+     *
+     *  @param  cellId the cell id
+     *  @param  mipThreshold the mip threshold
+     */
+    void SetCellThreshold(const uint64_t cellId, const float mipThreshold);
+
+    /**
+     *  @brief  Whether no cells are listed
+     *
+     *  @return whether the mask is empty
+     */
+    bool IsEmpty() const;
+
+    /**
+     *  @brief  Get the number of listed cells
+     *
+     *  @return the number of listed cells
+     */
+    unsigned int GetNCells() const;
+
+    /**
+     *  @brief  Get how a cell is treated
+     *
+     *  @param  cellId the cell id
+     *  @param  mipThreshold to receive the cell threshold, only set for OWN_THRESHOLD
+     *
+     *  @return the cell status
+     */
+    CellStatus GetCellStatus(const uint64_t cellId, float &mipThreshold) const;
+
+    /**
+     *  @brief  Read the masks of all collections from a text file. Each line holds a collection name, a cell id (decimal, or hex
+     *          with a 0x prefix) and optionally a mip threshold; cells without a threshold are masked. Text after a # is ignored.
+     *
+     *  @param  fileName the file name
+     *  @param  cellMasks to receive the masks, keyed by collection name
+     */
+    static void ReadFile(const std::string &fileName, CollectionCellMaskMap &cellMasks);
+
+private:
+    /**
+     *  @brief  Add a cell, growing the filter so that it stays sparse
+     *
+     *  @param  cellId the cell id
+     *  @param  mipThreshold the mip threshold, infinite for a masked cell
+     */
+    void AddCell(const uint64_t cellId, const float mipThreshold);
+
+    /**
+     *  @brief  Get the filter bit of a cell, before masking with the filter size
+     *
+     *  @param  cellId the cell id
+     *
+     *  @return the unmasked filter bit
+     */
+    static uint64_t GetFilterBit(const uint64_t cellId);
+
+    typedef std::unordered_map<uint64_t, float> CellThresholdMap;
+
+    CellThresholdMap                    m_cellThresholds;           ///< The mip threshold of each listed cell, infinite for masked cells
+    std::vector<uint64_t>               m_filter;                   ///< One bit per filter slot, set for the slots of the listed cells
+    uint64_t                            m_filterBitMask;            ///< The number of filter bits minus one, a power of two minus one
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool CellMask::IsEmpty() const
+{
+    return m_cellThresholds.empty();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int CellMask::GetNCells() const
+{
+    return m_cellThresholds.size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline CellMask::CellStatus CellMask::GetCellStatus(const uint64_t cellId, float &mipThreshold) const
+{
+    if (m_filter.empty())
+        return UNLISTED;
+
+    const uint64_t bit(GetFilterBit(cellId) & m_filterBitMask);
+
+    if (0 == (m_filter[bit >> 6] & (uint64_t(1) << (bit & 63))))
+        return UNLISTED;
+
+    const CellThresholdMap::const_iterator iter(m_cellThresholds.find(cellId));
+
+    if (m_cellThresholds.end() == iter)
+        return UNLISTED;
+
+    if (std::isinf(iter->second))
+        return MASKED;
+
+    mipThreshold = iter->second;
+    return OWN_THRESHOLD;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline uint64_t CellMask::GetFilterBit(const uint64_t cellId)
+{
+    // Fibonacci hashing; the high bits mix all bits of the cell id, whose low bits often hold only the system and layer fields
+    return (cellId * UINT64_C(0x9E3779B97F4A7C15)) >> 32;
+}
+
+#endif // #ifndef CELL_MASK_H
@@ -0,0 +1,60 @@
+/**
+ *
+ *  @brief  Header file for the collection maps class.
+ *
+ *  $Log: $
+ */
+
+#ifndef COLLECTION_MAPS_H
+#define COLLECTION_MAPS_H 1
+
+#include "edm4hep/CalorimeterHitCollection.h"
+#include "edm4hep/MCParticleCollection.h"
+#include "edm4hep/MCRecoCaloAssociationCollection.h"
+#include "edm4hep/MCRecoTrackerAssociationCollection.h"
+#include "edm4hep/TrackCollection.h"
+#include "edm4hep/VertexCollection.h"
+
+#include <map>
+#include <string>
+
+/**
+ *  @brief  CollectionMaps class, non-owning views of the input collections of the current event, keyed by collection name.
+ *          The collections stay owned by the event store; clear() only forgets the pointers and keeps the keys, so
+ *          after the first event no map nodes are allocated.
+ */
+class CollectionMaps
+{
+public:
+    CollectionMaps();
+    void clear();
+
+    /**
+     *  @brief  Get the collection registered under a given name in the current event
+     *
+     *  @param  collectionMap the collection map to search
+     *  @param  name the collection name
+     *
+     *  @return address of the collection, NULL if it is not configured or not present in the current event
+     */
+    template <typename T>
+    static const T *Find(const std::map<std::string, const T*> &collectionMap, const std::string &name);
+
+    std::map<std::string, const edm4hep::MCParticleCollection*>               collectionMap_MC;
+    std::map<std::string, const edm4hep::CalorimeterHitCollection*>           collectionMap_CaloHit;
+    std::map<std::string, const edm4hep::VertexCollection*>                   collectionMap_Vertex;
+    std::map<std::string, const edm4hep::TrackCollection*>                    collectionMap_Track;
+    std::map<std::string, const edm4hep::MCRecoCaloAssociationCollection*>    collectionMap_CaloRel;
+    std::map<std::string, const edm4hep::MCRecoTrackerAssociationCollection*> collectionMap_TrkRel;
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+inline const T *CollectionMaps::Find(const std::map<std::string, const T*> &collectionMap, const std::string &name)
+{
+    typename std::map<std::string, const T*>::const_iterator iter = collectionMap.find(name);
+    return (collectionMap.end() == iter) ? NULL : iter->second;
+}
+
+#endif // #ifndef COLLECTION_MAPS_H
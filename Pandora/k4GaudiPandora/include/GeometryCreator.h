@@ -10,9 +10,10 @@
 
 #include "Api/PandoraApi.h"
 
-#include "GaudiKernel/ISvcLocator.h"
 namespace gear { class CalorimeterParameters; class GearMgr; }
 
+class PandoraInputRecorder;
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 /**
@@ -70,8 +71,17 @@ public:
 
     /**
      *  @brief  Create geometry
+     *
+     *  @param  pGearMgr address of the gear manager describing the detector
+     */
+    pandora::StatusCode CreateGeometry(gear::GearMgr *const pGearMgr);
+
+    /**
+     *  @brief  Set the input recorder receiving the sub detectors and gaps passed to pandora
+     *
+     *  @param  pInputRecorder address of the input recorder, NULL to switch recording off
      */
-    pandora::StatusCode CreateGeometry(ISvcLocator* svcloc);
+    void SetInputRecorder(PandoraInputRecorder *const pInputRecorder);
 
 private:
     typedef std::map<pandora::SubDetectorType, PandoraApi::Geometry::SubDetector::Parameters> SubDetectorTypeMap;
@@ -149,7 +159,15 @@ private:
 
     const Settings          m_settings;                     ///< The geometry creator settings
     const pandora::Pandora *m_pPandora;                     ///< Address of the pandora object to create the geometry
+    PandoraInputRecorder   *m_pInputRecorder;               ///< Address of the input recorder, NULL when recording is off
     gear::GearMgr* _GEAR;
 };
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void GeometryCreator::SetInputRecorder(PandoraInputRecorder *const pInputRecorder)
+{
+    m_pInputRecorder = pInputRecorder;
+}
+
 #endif // #ifndef GEOMETRY_CREATOR_H
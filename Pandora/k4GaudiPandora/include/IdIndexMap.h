@@ -0,0 +1,137 @@
+/**
+ *
+ *  @brief  Header file for the id index map class.
+ *
+ *  $Log: $
+ */
+
+#ifndef ID_INDEX_MAP_H
+#define ID_INDEX_MAP_H 1
+
+#include <cstdint>
+#include <vector>
+
+/**
+ *  @brief  The policy for input objects that appear more than once among the configured collections of an event: calo hits with
+ *          the same cell id, or tracks with the same object id
+ */
+enum DuplicatePolicy
+{
+    KEEP_DUPLICATES,                        ///< No duplicate detection, every copy is converted
+    KEEP_FIRST,                             ///< Only the first copy, in configuration order, is converted
+    SUM_ENERGY,                             ///< As keep first, but the calo hit energies of later copies are added to the first copy
+    FAIL_ON_DUPLICATE                       ///< A duplicate fails the event
+};
+
+/**
+ *  @brief  IdIndexMap class, a flat open addressing hash map from 64 bit ids to indices, for the per event lookups of cell ids and
+ *          object ids. Clear keeps the table, so after the first events filling the map does not allocate.
+ */
+class IdIndexMap
+{
+public:
+    /**
+     *  @brief  Default constructor, an empty map
+     */
+    IdIndexMap();
+
+    /**
+     *  @brief  Remove all entries, keeping the table
+     */
+    void Clear();
+
+    /**
+     *  @brief  Grow the table so that the given number of entries can be inserted without rehashing
+     *
+     *  @param  nEntries the number of entries
+     */
+    void Reserve(const unsigned int nEntries);
+
+    /**
+     *  @brief  Insert an id, unless it is already present
+     *
+     *  @param  id the id
+     *  @param  index the index to store with a new id
+     *  @param  existingIndex to receive the index stored with the id, if it was already present
+     *
+     *  @return whether the id was inserted
+     */
+    bool Insert(const uint64_t id, const unsigned int index, unsigned int &existingIndex);
+
+    /**
+     *  @brief  Find the index stored with an id
+     *
+     *  @param  id the id
+     *  @param  index to receive the index, if the id is present
+     *
+     *  @return whether the id is present
+     */
+    bool Find(const uint64_t id, unsigned int &index) const;
+
+    /**
+     *  @brief  Get the number of entries
+     *
+     *  @return the number of entries
+     */
+    unsigned int GetSize() const;
+
+private:
+    /**
+     *  @brief  Rebuild the table with the given number of slots, a power of two
+     *
+     *  @param  nSlots the number of slots
+     */
+    void Rehash(const unsigned int nSlots);
+
+    /**
+     *  @brief  Get the first slot probed for an id
+     *
+     *  @param  id the id
+     *
+     *  @return the slot
+     */
+    unsigned int GetHomeSlot(const uint64_t id) const;
+
+    std::vector<uint64_t>               m_ids;                      ///< The id of each slot
+    std::vector<unsigned int>           m_indices;                  ///< The index of each slot
+    std::vector<unsigned char>          m_isOccupied;               ///< Whether each slot holds an entry
+    unsigned int                        m_slotMask;                 ///< The number of slots minus one, a power of two minus one
+    unsigned int                        m_hashShift;                ///< The shift taking the hash product down to a slot
+    unsigned int                        m_nEntries;                 ///< The number of entries
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool IdIndexMap::Find(const uint64_t id, unsigned int &index) const
+{
+    if (0 == m_nEntries)
+        return false;
+
+    for (unsigned int slot = this->GetHomeSlot(id); m_isOccupied[slot]; slot = (slot + 1) & m_slotMask)
+    {
+        if (id == m_ids[slot])
+        {
+            index = m_indices[slot];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int IdIndexMap::GetSize() const
+{
+    return m_nEntries;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int IdIndexMap::GetHomeSlot(const uint64_t id) const
+{
+    // Fibonacci hashing, as cell ids and object ids differ mostly in a few fields
+    return static_cast<unsigned int>((id * UINT64_C(0x9E3779B97F4A7C15)) >> m_hashShift);
+}
+
+#endif // #ifndef ID_INDEX_MAP_H
@@ -9,6 +9,9 @@
 #define MC_PARTICLE_CREATOR_H 1
 
 #include "edm4hep/MCParticle.h"
+#include "edm4hep/MCParticleCollection.h"
+#include "edm4hep/MCRecoCaloAssociationCollection.h"
+#include "edm4hep/MCRecoTrackerAssociationCollection.h"
 #include "Api/PandoraApi.h"
 
 #include "CaloHitCreator.h"
@@ -18,6 +21,8 @@
  */
 
 class CollectionMaps;
+class PandoraInputRecorder;
+class TraceRecorder;
 
 class MCParticleCreator
 {
@@ -58,7 +63,7 @@ public:
      *  @brief  Create MCParticles
      * 
      */    
-    pandora::StatusCode CreateMCParticles(const CollectionMaps& collectionMaps ) const;
+    pandora::StatusCode CreateMCParticles(const CollectionMaps& collectionMaps );
 
     /**
      *  @brief  Create Track to mc particle relationships
@@ -67,6 +72,20 @@ public:
      pandora::StatusCode CreateTrackToMCParticleRelationships(const CollectionMaps& collectionMaps, const TrackVector &trackVector) const;
 
      void Reset();
+
+    /**
+     *  @brief  Set the trace recorder receiving a span per input collection
+     *
+     *  @param  pTraceRecorder address of the trace recorder, NULL to switch tracing off
+     */
+     void SetTraceRecorder(TraceRecorder *const pTraceRecorder);
+
+    /**
+     *  @brief  Set the input recorder receiving the mc particles and mc relationships passed to pandora
+     *
+     *  @param  pInputRecorder address of the input recorder, NULL to switch recording off
+     */
+     void SetInputRecorder(PandoraInputRecorder *const pInputRecorder);
     /**
      *  @brief  Create calo hit to mc particle relationships
      *
@@ -77,12 +96,26 @@ private:
     const Settings          m_settings;                         ///< The mc particle creator settings
     const pandora::Pandora *m_pPandora;                         ///< Address of the pandora object to create the mc particles
     const float             m_bField;                           ///< The bfield
+    TraceRecorder          *m_pTraceRecorder;                   ///< Address of the trace recorder, NULL when tracing is off
+    PandoraInputRecorder   *m_pInputRecorder;                   ///< Address of the input recorder, NULL when recording is off
     std::map<unsigned int, const edm4hep::MCParticle*>*  m_id_pMC_map;
+    std::vector<edm4hep::MCParticle> m_mcParticleStore;         ///< Handles to the mc particles passed to pandora, capacity reused between events
 };
 
 inline void MCParticleCreator::Reset()
 {
     m_id_pMC_map->clear();
+    m_mcParticleStore.clear();
+}
+
+inline void MCParticleCreator::SetTraceRecorder(TraceRecorder *const pTraceRecorder)
+{
+    m_pTraceRecorder = pTraceRecorder;
+}
+
+inline void MCParticleCreator::SetInputRecorder(PandoraInputRecorder *const pInputRecorder)
+{
+    m_pInputRecorder = pInputRecorder;
 }
 
 #endif // #ifndef MC_PARTICLE_CREATOR_H
@@ -0,0 +1,334 @@
+/**
+ *
+ *  @brief  Header file for the pandora input file format, shared by the input recorder and the input reader.
+ *
+ *  $Log: $
+ */
+
+#ifndef PANDORA_INPUT_FORMAT_H
+#define PANDORA_INPUT_FORMAT_H 1
+
+#include "Api/PandoraApi.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ *  @brief  PandoraInputFormat class, describes the binary file holding the input passed to pandora.
+ *
+ *          The file starts with a magic number and a version, followed by blocks. Each block is a block type, a payload size
+ *          in bytes and the payload. The first block holds the run settings, the second the geometry, every further block one
+ *          event. Geometry and event payloads are sequences of records, each a record type followed by the record fields.
+ *          Event payloads start with the event number and the number of distinct parent addresses in the event; parent
+ *          addresses are stored as event-local ids. Numbers are stored in native byte order.
+ */
+class PandoraInputFormat
+{
+public:
+    static const unsigned int MAGIC = 0x4950344b;               ///< "K4PI"
+    static const unsigned int VERSION = 1;                      ///< The format version
+
+    /**
+     *  @brief  The block types
+     */
+    enum BlockType
+    {
+        RUN_SETTINGS_BLOCK = 1,
+        GEOMETRY_BLOCK,
+        EVENT_BLOCK
+    };
+
+    /**
+     *  @brief  The record types, one per PandoraApi call
+     */
+    enum RecordType
+    {
+        SUB_DETECTOR = 1,
+        BOX_GAP,
+        CONCENTRIC_GAP,
+        MC_PARTICLE,
+        CALO_HIT,
+        TRACK,
+        MC_PARENT_DAUGHTER_RELATIONSHIP,
+        TRACK_PARENT_DAUGHTER_RELATIONSHIP,
+        TRACK_SIBLING_RELATIONSHIP,
+        CALO_HIT_TO_MC_PARTICLE_RELATIONSHIP,
+        TRACK_TO_MC_PARTICLE_RELATIONSHIP
+    };
+
+    /**
+     *  @brief  RunSettings class, the settings needed to set up a pandora instance like the one that was recorded
+     */
+    class RunSettings
+    {
+    public:
+        /**
+         *  @brief  Default constructor
+         */
+        RunSettings();
+
+        std::string         m_pandoraSettingsXmlFile;           ///< The pandora settings xml file
+        float               m_innerBField;                      ///< The bfield in the main tracker, ecal and hcal, units Tesla
+        float               m_muonBarrelBField;                 ///< The bfield in the muon barrel, units Tesla
+        float               m_muonEndCapBField;                 ///< The bfield in the muon endcap, units Tesla
+        pandora::FloatVector m_inputEnergyCorrectionPoints;     ///< The input energy points for non-linearity energy correction
+        pandora::FloatVector m_outputEnergyCorrectionPoints;    ///< The output energy points for non-linearity energy correction
+    };
+
+    /**
+     *  @brief  OutputBuffer class, appends values to a block payload
+     */
+    class OutputBuffer
+    {
+    public:
+        /**
+         *  @brief  Append a trivially copyable value
+         *
+         *  @param  value the value
+         */
+        template <typename T>
+        void Write(const T value);
+
+        /**
+         *  @brief  Append a string, as its size followed by its characters
+         *
+         *  @param  text the string
+         */
+        void WriteString(const std::string &text);
+
+        /**
+         *  @brief  Append a cartesian vector, as three floats
+         *
+         *  @param  vector the cartesian vector
+         */
+        void WriteVector(const pandora::CartesianVector &vector);
+
+        /**
+         *  @brief  Append a float vector, as its size followed by its elements
+         *
+         *  @param  floatVector the float vector
+         */
+        void WriteFloatVector(const pandora::FloatVector &floatVector);
+
+        /**
+         *  @brief  Append the payload of another buffer
+         *
+         *  @param  buffer the other buffer
+         */
+        void Append(const OutputBuffer &buffer);
+
+        /**
+         *  @brief  Get the payload
+         *
+         *  @return the payload
+         */
+        const std::string &GetPayload() const;
+
+        /**
+         *  @brief  Clear the payload, keeping its capacity
+         */
+        void Clear();
+
+    private:
+        std::string         m_payload;                          ///< The payload
+    };
+
+    /**
+     *  @brief  InputBuffer class, reads values back from a block payload. Reading past the end throws STATUS_CODE_OUT_OF_RANGE.
+     */
+    class InputBuffer
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  payload the payload, must outlive the buffer
+         */
+        explicit InputBuffer(const std::string &payload);
+
+        /**
+         *  @brief  Read a trivially copyable value
+         *
+         *  @return the value
+         */
+        template <typename T>
+        T Read();
+
+        /**
+         *  @brief  Read a string
+         *
+         *  @return the string
+         */
+        std::string ReadString();
+
+        /**
+         *  @brief  Read a cartesian vector
+         *
+         *  @return the cartesian vector
+         */
+        pandora::CartesianVector ReadVector();
+
+        /**
+         *  @brief  Read a float vector
+         *
+         *  @return the float vector
+         */
+        pandora::FloatVector ReadFloatVector();
+
+        /**
+         *  @brief  Whether the whole payload has been read
+         *
+         *  @return boolean
+         */
+        bool IsAtEnd() const;
+
+    private:
+        /**
+         *  @brief  Claim the next bytes of the payload
+         *
+         *  @param  nBytes the number of bytes
+         *
+         *  @return address of the first claimed byte
+         */
+        const char *Claim(const size_t nBytes);
+
+        const std::string  &m_payload;                          ///< The payload
+        size_t              m_position;                         ///< The position of the next byte to read
+    };
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline PandoraInputFormat::RunSettings::RunSettings() :
+    m_innerBField(0.f),
+    m_muonBarrelBField(0.f),
+    m_muonEndCapBField(0.f)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+inline void PandoraInputFormat::OutputBuffer::Write(const T value)
+{
+    m_payload.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void PandoraInputFormat::OutputBuffer::WriteString(const std::string &text)
+{
+    this->Write<unsigned int>(text.size());
+    m_payload.append(text);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void PandoraInputFormat::OutputBuffer::WriteVector(const pandora::CartesianVector &vector)
+{
+    this->Write<float>(vector.GetX());
+    this->Write<float>(vector.GetY());
+    this->Write<float>(vector.GetZ());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void PandoraInputFormat::OutputBuffer::WriteFloatVector(const pandora::FloatVector &floatVector)
+{
+    this->Write<unsigned int>(floatVector.size());
+
+    for (const float value : floatVector)
+        this->Write<float>(value);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void PandoraInputFormat::OutputBuffer::Append(const OutputBuffer &buffer)
+{
+    m_payload.append(buffer.m_payload);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const std::string &PandoraInputFormat::OutputBuffer::GetPayload() const
+{
+    return m_payload;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void PandoraInputFormat::OutputBuffer::Clear()
+{
+    m_payload.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline PandoraInputFormat::InputBuffer::InputBuffer(const std::string &payload) :
+    m_payload(payload),
+    m_position(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+inline T PandoraInputFormat::InputBuffer::Read()
+{
+    T value;
+    std::memcpy(&value, this->Claim(sizeof(T)), sizeof(T));
+    return value;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline std::string PandoraInputFormat::InputBuffer::ReadString()
+{
+    const unsigned int size(this->Read<unsigned int>());
+    return std::string(this->Claim(size), size);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline pandora::CartesianVector PandoraInputFormat::InputBuffer::ReadVector()
+{
+    const float x(this->Read<float>());
+    const float y(this->Read<float>());
+    const float z(this->Read<float>());
+    return pandora::CartesianVector(x, y, z);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline pandora::FloatVector PandoraInputFormat::InputBuffer::ReadFloatVector()
+{
+    const unsigned int size(this->Read<unsigned int>());
+    pandora::FloatVector floatVector;
+
+    for (unsigned int i = 0; i < size; ++i)
+        floatVector.push_back(this->Read<float>());
+
+    return floatVector;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool PandoraInputFormat::InputBuffer::IsAtEnd() const
+{
+    return (m_position == m_payload.size());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const char *PandoraInputFormat::InputBuffer::Claim(const size_t nBytes)
+{
+    if (nBytes > m_payload.size() - m_position)
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_OUT_OF_RANGE);
+
+    const char *const pBytes(m_payload.data() + m_position);
+    m_position += nBytes;
+    return pBytes;
+}
+
+#endif // #ifndef PANDORA_INPUT_FORMAT_H
@@ -0,0 +1,104 @@
+/**
+ *
+ *  @brief  Header file for the pandora input reader class.
+ *
+ *  $Log: $
+ */
+
+#ifndef PANDORA_INPUT_READER_H
+#define PANDORA_INPUT_READER_H 1
+
+#include "PandoraInputFormat.h"
+
+#include <fstream>
+
+/**
+ *  @brief  PandoraInputReader class, reads a file written by the PandoraInputRecorder and replays its content into a pandora
+ *          instance. Depends on the pandora sdk only.
+ */
+class PandoraInputReader
+{
+public:
+    /**
+     *  @brief  Event class, the undecoded payload of one recorded event
+     */
+    class Event
+    {
+    public:
+        int                 m_eventNumber;                      ///< The event number
+        std::string         m_payload;                          ///< The event block payload
+    };
+
+    /**
+     *  @brief  Open a file and read its header, run settings and geometry blocks
+     *
+     *  @param  fileName the input file name
+     */
+    pandora::StatusCode Open(const std::string &fileName);
+
+    /**
+     *  @brief  Get the run settings the file was recorded with
+     *
+     *  @return the run settings
+     */
+    const PandoraInputFormat::RunSettings &GetRunSettings() const;
+
+    /**
+     *  @brief  Create the recorded geometry in a pandora instance
+     *
+     *  @param  pandora the pandora instance
+     */
+    pandora::StatusCode CreateGeometry(const pandora::Pandora &pandora) const;
+
+    /**
+     *  @brief  Read the next event from the file
+     *
+     *  @param  event to receive the event
+     *
+     *  @return STATUS_CODE_SUCCESS, or STATUS_CODE_NOT_FOUND once all events were read
+     */
+    pandora::StatusCode ReadEvent(Event &event);
+
+    /**
+     *  @brief  Replay an event into a pandora instance, making the recorded PandoraApi calls in the recorded order. The parent
+     *          addresses handed to pandora stay valid until the next event is replayed.
+     *
+     *  @param  pandora the pandora instance
+     *  @param  event the event
+     */
+    pandora::StatusCode ReplayEvent(const pandora::Pandora &pandora, const Event &event);
+
+private:
+    /**
+     *  @brief  Read the next block from the file
+     *
+     *  @param  blockType to receive the block type
+     *  @param  payload to receive the block payload
+     *
+     *  @return STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND at the end of the file, or STATUS_CODE_FAILURE for a truncated block
+     */
+    pandora::StatusCode ReadBlock(unsigned int &blockType, std::string &payload);
+
+    /**
+     *  @brief  Read the parent address an id stands for
+     *
+     *  @param  buffer the buffer
+     *
+     *  @return the parent address
+     */
+    const void *ReadAddress(PandoraInputFormat::InputBuffer &buffer) const;
+
+    std::ifstream                       m_file;                 ///< The input file
+    PandoraInputFormat::RunSettings     m_runSettings;          ///< The run settings
+    std::string                         m_geometryPayload;      ///< The geometry block payload
+    std::vector<unsigned int>           m_addressSlots;         ///< One slot per id of the replayed event, their addresses act as parent addresses
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const PandoraInputFormat::RunSettings &PandoraInputReader::GetRunSettings() const
+{
+    return m_runSettings;
+}
+
+#endif // #ifndef PANDORA_INPUT_READER_H
@@ -0,0 +1,208 @@
+/**
+ *
+ *  @brief  Header file for the pandora input recorder classes.
+ *
+ *  $Log: $
+ */
+
+#ifndef PANDORA_INPUT_RECORDER_H
+#define PANDORA_INPUT_RECORDER_H 1
+
+#include "PandoraInputFormat.h"
+
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ *  @brief  PandoraInputWriter class, owns the output file and writes whole blocks to it. Shared by all pandora instances.
+ */
+class PandoraInputWriter
+{
+public:
+    /**
+     *  @brief  Default constructor
+     */
+    PandoraInputWriter();
+
+    /**
+     *  @brief  Open the output file and write the file header and the run settings
+     *
+     *  @param  fileName the output file name
+     *  @param  runSettings the run settings
+     *
+     *  @return whether the file could be written
+     */
+    bool Open(const std::string &fileName, const PandoraInputFormat::RunSettings &runSettings);
+
+    /**
+     *  @brief  Write a block, may be called concurrently
+     *
+     *  @param  blockType the block type
+     *  @param  buffer the buffer holding the block payload
+     */
+    void WriteBlock(const PandoraInputFormat::BlockType blockType, const PandoraInputFormat::OutputBuffer &buffer);
+
+    /**
+     *  @brief  Close the output file
+     *
+     *  @return whether all blocks were written
+     */
+    bool Close();
+
+    /**
+     *  @brief  Get the number of event blocks written
+     *
+     *  @return the number of event blocks
+     */
+    unsigned int GetNEvents() const;
+
+private:
+    std::ofstream           m_file;                             ///< The output file
+    unsigned int            m_nEvents;                          ///< The number of event blocks written
+    mutable std::mutex      m_mutex;                            ///< Guards the file
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  PandoraInputRecorder class, records the PandoraApi calls the creators of one pandora instance make, buffering them until
+ *          the geometry or an event is complete. Parent addresses are replaced by ids that are unique within the event.
+ */
+class PandoraInputRecorder
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  pWriter address of the writer the recorded blocks are handed to
+     */
+    explicit PandoraInputRecorder(PandoraInputWriter *const pWriter);
+
+    /**
+     *  @brief  Record a sub detector
+     *
+     *  @param  parameters the sub detector parameters
+     */
+    void RecordSubDetector(const PandoraApi::Geometry::SubDetector::Parameters &parameters);
+
+    /**
+     *  @brief  Record a box gap
+     *
+     *  @param  parameters the box gap parameters
+     */
+    void RecordBoxGap(const PandoraApi::Geometry::BoxGap::Parameters &parameters);
+
+    /**
+     *  @brief  Record a concentric gap
+     *
+     *  @param  parameters the concentric gap parameters
+     */
+    void RecordConcentricGap(const PandoraApi::Geometry::ConcentricGap::Parameters &parameters);
+
+    /**
+     *  @brief  Write the recorded geometry as the geometry block
+     */
+    void WriteGeometry();
+
+    /**
+     *  @brief  Record an mc particle
+     *
+     *  @param  parameters the mc particle parameters
+     */
+    void RecordMCParticle(const PandoraApi::MCParticle::Parameters &parameters);
+
+    /**
+     *  @brief  Record a calo hit
+     *
+     *  @param  parameters the calo hit parameters
+     */
+    void RecordCaloHit(const PandoraApi::CaloHit::Parameters &parameters);
+
+    /**
+     *  @brief  Record a track
+     *
+     *  @param  parameters the track parameters
+     */
+    void RecordTrack(const PandoraApi::Track::Parameters &parameters);
+
+    /**
+     *  @brief  Record an mc particle parent-daughter relationship
+     *
+     *  @param  pParentAddress address of the parent mc particle
+     *  @param  pDaughterAddress address of the daughter mc particle
+     */
+    void RecordMCParentDaughterRelationship(const void *const pParentAddress, const void *const pDaughterAddress);
+
+    /**
+     *  @brief  Record a track parent-daughter relationship
+     *
+     *  @param  pParentAddress address of the parent track
+     *  @param  pDaughterAddress address of the daughter track
+     */
+    void RecordTrackParentDaughterRelationship(const void *const pParentAddress, const void *const pDaughterAddress);
+
+    /**
+     *  @brief  Record a track sibling relationship
+     *
+     *  @param  pFirstSiblingAddress address of the first sibling track
+     *  @param  pSecondSiblingAddress address of the second sibling track
+     */
+    void RecordTrackSiblingRelationship(const void *const pFirstSiblingAddress, const void *const pSecondSiblingAddress);
+
+    /**
+     *  @brief  Record a calo hit to mc particle relationship
+     *
+     *  @param  pCaloHitAddress address of the calo hit
+     *  @param  pMCParticleAddress address of the mc particle
+     *  @param  mcParticleWeight the weight of the mc particle contribution
+     */
+    void RecordCaloHitToMCParticleRelationship(const void *const pCaloHitAddress, const void *const pMCParticleAddress, const float mcParticleWeight);
+
+    /**
+     *  @brief  Record a track to mc particle relationship
+     *
+     *  @param  pTrackAddress address of the track
+     *  @param  pMCParticleAddress address of the mc particle
+     *  @param  mcParticleWeight the weight of the mc particle contribution
+     */
+    void RecordTrackToMCParticleRelationship(const void *const pTrackAddress, const void *const pMCParticleAddress, const float mcParticleWeight);
+
+    /**
+     *  @brief  Write the recorded event as an event block and clear the recorder for the next event
+     *
+     *  @param  eventNumber the event number
+     */
+    void WriteEvent(const int eventNumber);
+
+    /**
+     *  @brief  Discard everything recorded since the last block was written
+     */
+    void Clear();
+
+private:
+    typedef std::unordered_map<const void*, unsigned int> AddressToIdMap;
+
+    /**
+     *  @brief  Append the event-local id of a parent address, assigning the next free id on first use
+     *
+     *  @param  pAddress the parent address
+     */
+    void WriteAddress(const void *const pAddress);
+
+    /**
+     *  @brief  Append a relationship between two parent addresses
+     *
+     *  @param  recordType the record type
+     *  @param  pFirstAddress the first parent address
+     *  @param  pSecondAddress the second parent address
+     */
+    void WriteRelationship(const PandoraInputFormat::RecordType recordType, const void *const pFirstAddress, const void *const pSecondAddress);
+
+    PandoraInputWriter                 *m_pWriter;              ///< Address of the writer
+    PandoraInputFormat::OutputBuffer    m_records;              ///< The records of the block being recorded
+    PandoraInputFormat::OutputBuffer    m_eventBlock;           ///< The event block being assembled, capacity reused between events
+    AddressToIdMap                      m_addressToIdMap;       ///< The parent address to id map of the event being recorded
+};
+
+#endif // #ifndef PANDORA_INPUT_RECORDER_H
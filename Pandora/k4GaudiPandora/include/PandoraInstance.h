@@ -0,0 +1,47 @@
+/**
+ *
+ *  @brief  Header file for the pandora instance class.
+ *
+ *  $Log: $
+ */
+
+#ifndef PANDORA_INSTANCE_H
+#define PANDORA_INSTANCE_H 1
+
+namespace pandora { class Pandora; }
+
+class CaloHitCreator;
+class CollectionMaps;
+class GeometryCreator;
+class MCParticleCreator;
+class PandoraInputRecorder;
+class PfoCreator;
+class TrackCreator;
+
+/**
+ *  @brief  PandoraInstance class, a pandora instance together with the creators and per-event state that belong to it
+ */
+class PandoraInstance
+{
+public:
+    /**
+     *  @brief  Default constructor
+     */
+    PandoraInstance();
+
+    /**
+     *  @brief  Destructor, deletes the pandora instance, the creators and the collection maps
+     */
+    ~PandoraInstance();
+
+    pandora::Pandora               *m_pPandora;                     ///< The pandora instance
+    GeometryCreator                *m_pGeometryCreator;             ///< The geometry creator
+    CaloHitCreator                 *m_pCaloHitCreator;              ///< The calo hit creator
+    TrackCreator                   *m_pTrackCreator;                ///< The track creator
+    MCParticleCreator              *m_pMCParticleCreator;           ///< The mc particle creator
+    PfoCreator                     *m_pPfoCreator;                  ///< The pfo creator
+    CollectionMaps                 *m_pCollectionMaps;              ///< The input collections of the event being processed
+    PandoraInputRecorder           *m_pInputRecorder;               ///< The input recorder, NULL when recording is switched off
+};
+
+#endif // #ifndef PANDORA_INSTANCE_H
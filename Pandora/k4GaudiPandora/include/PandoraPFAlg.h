@@ -26,6 +26,7 @@
 #include "TApplication.h"
 #endif
 
+#include <atomic>
 #include <iostream>
 #include <random>
 #include <string>
@@ -33,9 +34,14 @@
 
 
 #include "CaloHitCreator.h"
+#include "CollectionMaps.h"
 #include "GeometryCreator.h"
 #include "MCParticleCreator.h"
 #include "PfoCreator.h"
+#include "PandoraInputRecorder.h"
+#include "PandoraInstance.h"
+#include "StageTimingMonitor.h"
+#include "TraceRecorder.h"
 #include "TrackCreator.h"
 
 
@@ -46,19 +52,35 @@
 namespace pandora {class Pandora;}
 
 
-class CollectionMaps
+/**
+ *  @brief  CollectionBinding class, one configured input collection: its typed data handle and the CollectionMaps slot the
+ *          collection is written to at the start of an event
+ */
+template <typename T>
+class CollectionBinding
 {
 public:
-    CollectionMaps();
-    void clear();
-    std::map<std::string, std::vector<edm4hep::MCParticle> >     collectionMap_MC;
-    std::map<std::string, std::vector<edm4hep::CalorimeterHit> > collectionMap_CaloHit;
-    std::map<std::string, std::vector<edm4hep::Vertex> >         collectionMap_Vertex;
-    std::map<std::string, std::vector<edm4hep::Track> >          collectionMap_Track;
-    std::map<std::string, std::vector<edm4hep::MCRecoCaloAssociation> > collectionMap_CaloRel;
-    std::map<std::string, std::vector<edm4hep::MCRecoTrackerAssociation> > collectionMap_TrkRel;
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  name the collection name
+     *  @param  pHandle address of the data handle reading the collection
+     */
+    CollectionBinding(const std::string &name, DataHandle<T> *const pHandle);
+
+    std::string                     m_name;                         ///< The collection name
+    DataHandle<T>                  *m_pHandle;                      ///< The data handle reading the collection
+    const T                       **m_pSlot;                        ///< The CollectionMaps slot of the collection
 };
 
+template <typename T>
+inline CollectionBinding<T>::CollectionBinding(const std::string &name, DataHandle<T> *const pHandle) :
+    m_name(name),
+    m_pHandle(pHandle),
+    m_pSlot(NULL)
+{
+}
+
 
 
 class PandoraPFAlg : public GaudiAlgorithm
@@ -80,9 +102,10 @@ public:
   /** Called after data processing for clean up.
    */
   virtual StatusCode finalize() ;
+
  
   void FinaliseSteeringParameters(ISvcLocator* svcloc);
-  pandora::StatusCode RegisterUserComponents() const;
+  pandora::StatusCode RegisterUserComponents(const pandora::Pandora &pandora) const;
   void Reset();
   typedef std::vector<float> FloatVector;
   typedef std::vector<std::string> StringVector;
@@ -114,17 +137,26 @@ public:
      */
     const pandora::Pandora *GetPandora() const;
     StatusCode updateMap();
-    StatusCode CreateMCRecoParticleAssociation();
+    void RecordStageTimes(const StageTimingMonitor::EventTimes &eventTimes);
+    void WriteStageTimingSummary();
+    StatusCode CreateMCRecoParticleAssociation(const CollectionMaps &collectionMaps, const edm4hep::ReconstructedParticleCollection *const reco_col);
 protected:
  
   typedef std::vector<float> FloatVec;
 
-  int _nEvt ;
+  std::atomic<int> _nEvt ;
 
  
 
   Gaudi::Property< std::string >              m_PandoraSettingsXmlFile { this, "PandoraSettingsDefault_xml", "PandoraSettingsDefault.xml" };
   Gaudi::Property<int>                        m_NEventsToSkip                   { this, "NEventsToSkip", 0 };
+  Gaudi::Property<bool>                       m_StageTiming                     { this, "StageTiming", false, "Time each stage of execute, reported as counters, histograms and a json summary" };
+  Gaudi::Property< std::string >              m_StageTimingFile                 { this, "StageTimingFile", "PandoraStageTiming.json", "Output file of the stage timing summary" };
+  Gaudi::Property< std::string >              m_StageTimingHistDir              { this, "StageTimingHistDir", "/PandoraTiming/", "THistSvc directory of the stage timing histograms" };
+  Gaudi::Property<bool>                       m_Trace                           { this, "Trace", false, "Record a chrome trace-event span per stage and per creator collection loop" };
+  Gaudi::Property< std::string >              m_TraceFile                       { this, "TraceFile", "PandoraTrace.json", "Output file of the chrome trace, written at finalize" };
+  Gaudi::Property<bool>                       m_RecordInput                     { this, "RecordInput", false, "Record the geometry and the per-event input passed to pandora, for replay with PandoraReplay" };
+  Gaudi::Property< std::string >              m_RecordInputFile                 { this, "RecordInputFile", "PandoraInput.bin", "Output file of the recorded pandora input" };
 
   Gaudi::Property< std::vector<std::string> > m_TrackCollections{ this, "TrackCollections", {"Tracks"} };
   Gaudi::Property< std::vector<std::string> > m_ECalCaloHitCollections{ this, "ECalCaloHitCollections", {"ECALBarrel","ECALEndcap","ECALOther"} };
@@ -215,6 +247,17 @@ protected:
   Gaudi::Property<float>                      m_HCalRingOuterPhiCoordinate      { this, "HCalRingOuterPhiCoordinate",   0. };
   Gaudi::Property<bool>                       m_StripSplittingOn                { this, "StripSplittingOn", false };
   Gaudi::Property<bool>                       m_UseEcalScLayers                 { this, "UseEcalScLayers", false };
+  Gaudi::Property<int>                        m_CaloHitParameterThreads         { this, "CaloHitParameterThreads", 1, "Number of threads building the calo hit parameters of each pandora instance, 1 builds them serially" };
+  Gaudi::Property< std::string >              m_CellMaskFile                    { this, "CellMaskFile", "", "Text file of 'collection cellID [mipThreshold]' lines: cells without a threshold are masked, the others use their own mip threshold" };
+  Gaudi::Property<FloatVector>                m_ECalTimeWindow                  { this, "ECalTimeWindow", {}, "Earliest and latest ecal hit time passed to pandora, units ns; empty for no window" };
+  Gaudi::Property<FloatVector>                m_HCalTimeWindow                  { this, "HCalTimeWindow", {}, "Earliest and latest hcal hit time passed to pandora, units ns; empty for no window" };
+  Gaudi::Property<FloatVector>                m_MuonTimeWindow                  { this, "MuonTimeWindow", {}, "Earliest and latest muon hit time passed to pandora, units ns; empty for no window" };
+  Gaudi::Property<FloatVector>                m_LCalTimeWindow                  { this, "LCalTimeWindow", {}, "Earliest and latest lcal hit time passed to pandora, units ns; empty for no window" };
+  Gaudi::Property<FloatVector>                m_LHCalTimeWindow                 { this, "LHCalTimeWindow", {}, "Earliest and latest lhcal hit time passed to pandora, units ns; empty for no window" };
+  Gaudi::Property<bool>                       m_TimeWindowTofCorrection         { this, "TimeWindowTofCorrection", false, "Apply the time windows to the hit times less the time of flight from the ip" };
+  Gaudi::Property< std::string >              m_DuplicatePolicy                 { this, "DuplicatePolicy", "none", "Calo hits sharing a cell id within a subdetector and tracks sharing an object id across collections: none (convert all), keepFirst, sumEnergy or error" };
+  Gaudi::Property<std::vector<int>>           m_CellCoarsening                  { this, "CellCoarsening", {}, "Number of cells merged into one virtual cell along the first and second cell index of ecal, hcal, lcal and lhcal hits; empty for no merging" };
+  Gaudi::Property<int>                        m_CaloHitParameterChunkSize       { this, "CaloHitParameterChunkSize", 256, "Number of calo hits whose parameters are built by one task" };
   Gaudi::Property<float>                      m_ECalSiToMipCalibration          { this, "ECalSiToMipCalibration", 1. };
   Gaudi::Property<float>                      m_ECalScToMipCalibration          { this, "ECalScToMipCalibration", 1. };
   Gaudi::Property<float>                      m_ECalSiMipThreshold              { this, "ECalSiMipThreshold", 0. };
@@ -230,15 +273,20 @@ protected:
   Gaudi::Property<FloatVector>                m_OutputEnergyCorrectionPoints { this, "OutputEnergyCorrectionPoints", {} };
 
 
-  static pandora::Pandora        *m_pPandora;
-  GeometryCreator                *m_pGeometryCreator;             ///< The geometry creator
-  CaloHitCreator                 *m_pCaloHitCreator;              ///< The calo hit creator
-  TrackCreator                   *m_pTrackCreator;                ///< The track creator
-  MCParticleCreator              *m_pMCParticleCreator;           ///< The mc particle creator
-  PfoCreator                     *m_pPfoCreator;                  ///< The pfo creator
+  PandoraInstance                *m_pPandoraInstance;             ///< The pandora instance, with its creators and per-event state
+  StageTimingMonitor             *m_pStageTimingMonitor;          ///< The stage timing samples, NULL when stage timing is switched off
+  std::array<StatEntity*, StageTimingMonitor::N_STAGES> m_stageCounters; ///< The stage timing counters, units ms
+  StatEntity                     *m_pMaskedCaloHitCounter;        ///< The calo hits rejected per event as their cell is masked, NULL without a cell mask
+  StatEntity                     *m_pBelowCellThresholdCaloHitCounter; ///< The calo hits rejected per event by the threshold of their cell, NULL without a cell mask
+  StatEntity                     *m_pOutOfTimeCaloHitCounter;     ///< The calo hits rejected per event by the time windows, NULL without a time window
+  StatEntity                     *m_pDuplicateCaloHitCounter;     ///< The calo hits per event sharing the cell id of an earlier hit, NULL without duplicate detection
+  StatEntity                     *m_pDuplicateTrackCounter;       ///< The tracks per event repeating an earlier track, NULL without duplicate detection
+  StatEntity                     *m_pMergedCaloHitCounter;        ///< The calo hits merged per event into another hit's virtual cell, NULL without cell coarsening
+  TraceRecorder                  *m_pTraceRecorder;               ///< The chrome trace recorder, NULL when tracing is switched off
+  PandoraInputWriter             *m_pInputWriter;                 ///< Writes the recorded pandora input, NULL when recording is switched off
+  gear::GearMgr                  *m_pGearMgr;                     ///< The gear manager describing the detector, owned by the GearSvc
  
   Settings                        m_settings;                     ///< The settings for the pandora pfa new algo
-  CollectionMaps                  *m_CollectionMaps;               ///< The settings for the pandora pfa new algo
   GeometryCreator::Settings       m_geometryCreatorSettings;      ///< The geometry creator settings
   TrackCreator::Settings          m_trackCreatorSettings;         ///< The track creator settings
   CaloHitCreator::Settings        m_caloHitCreatorSettings;       ///< The calo hit creator settings
@@ -250,10 +298,14 @@ protected:
   unsigned int                    m_nEvent;                       ///< The event number
   //######################
   
-  std::map< std::string, std::string > m_collections;
   Gaudi::Property<std::vector<std::string>> m_readCols{this, "collections", {}, "Places of collections to read"};
- //the map of collection name to its corresponding DataHandle
-  std::map<std::string, DataObjectHandleBase*> m_dataHandles;
+ //the typed DataHandles of the collections, with the slots they fill in the CollectionMaps, resolved at initialize
+  std::vector< CollectionBinding<edm4hep::MCParticleCollection> >               m_mcParticleBindings;
+  std::vector< CollectionBinding<edm4hep::CalorimeterHitCollection> >           m_caloHitBindings;
+  std::vector< CollectionBinding<edm4hep::TrackCollection> >                    m_trackBindings;
+  std::vector< CollectionBinding<edm4hep::VertexCollection> >                   m_vertexBindings;
+  std::vector< CollectionBinding<edm4hep::MCRecoCaloAssociationCollection> >    m_caloRelBindings;
+  std::vector< CollectionBinding<edm4hep::MCRecoTrackerAssociationCollection> > m_trkRelBindings;
 
   DataHandle<edm4hep::ClusterCollection>                m_ClusterCollection_w {"PandoraClusters",Gaudi::DataHandle::Writer, this};
   DataHandle<edm4hep::ReconstructedParticleCollection>  m_ReconstructedParticleCollection_w {"PandoraPFOs"    ,Gaudi::DataHandle::Writer, this};
@@ -0,0 +1,243 @@
+/**
+ *
+ *  @brief  Header file for the pfo comparator class.
+ *
+ *  $Log: $
+ */
+
+#ifndef PFO_COMPARATOR_H
+#define PFO_COMPARATOR_H 1
+
+#include "edm4hep/ClusterCollection.h"
+#include "edm4hep/MCRecoParticleAssociationCollection.h"
+#include "edm4hep/ReconstructedParticleCollection.h"
+#include "edm4hep/VertexCollection.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ *  @brief  PfoComparator class, compares the output of two PandoraPFAlg runs on the same input, event by event. Pfos are matched
+ *          through the calo hits of their clusters and their tracks, which both runs share, so reordered output is still matched.
+ *          Each event is classed as bitwise identical, identical within tolerances or different, and the differences of the
+ *          matched pfos are accumulated so that the size of small numerical changes can be judged.
+ */
+class PfoComparator
+{
+public:
+    /**
+     *  @brief  The output collections of one event; a NULL address is treated as an empty collection
+     */
+    class EventCollections
+    {
+    public:
+        EventCollections();
+
+        const edm4hep::ReconstructedParticleCollection     *m_pPfos;                        ///< The pfos
+        const edm4hep::ClusterCollection                   *m_pClusters;                    ///< The clusters
+        const edm4hep::VertexCollection                    *m_pStartVertices;               ///< The pfo start vertices
+        const edm4hep::MCRecoParticleAssociationCollection *m_pMCRecoParticleAssociations;  ///< The pfo to mc particle associations
+    };
+
+    /**
+     *  @brief  Settings class
+     */
+    class Settings
+    {
+    public:
+        Settings();
+
+        float           m_energyTolerance;                      ///< The allowed relative difference of energies and masses
+        float           m_momentumTolerance;                    ///< The allowed difference of momenta, relative to the momentum magnitude
+        float           m_positionTolerance;                    ///< The allowed distance between positions, units mm
+        float           m_weightTolerance;                      ///< The allowed difference of association weights
+        unsigned int    m_maxPrintedDifferences;                ///< The number of pfo differences printed in detail
+    };
+
+    /**
+     *  @brief  How closely two events or pfos agree
+     */
+    enum Agreement
+    {
+        BITWISE_IDENTICAL,
+        WITHIN_TOLERANCE,
+        DIFFERENT,
+        N_AGREEMENTS
+    };
+
+    /**
+     *  @brief  RunningStatistic class, the count, mean, rms and largest absolute value of a difference
+     */
+    class RunningStatistic
+    {
+    public:
+        RunningStatistic();
+        void Add(const double value);
+        double GetMean() const;
+        double GetRms() const;
+
+        unsigned long   m_count;                                ///< The number of values
+        double          m_sum;                                  ///< The sum of the values
+        double          m_sumSquared;                           ///< The sum of the squared values
+        double          m_maxAbs;                               ///< The largest absolute value
+    };
+
+    /**
+     *  @brief  Summary class, the differences accumulated over all compared events
+     */
+    class Summary
+    {
+    public:
+        Summary();
+
+        unsigned int    m_nEvents[N_AGREEMENTS];                ///< The number of events per agreement
+        unsigned int    m_nPfos[N_AGREEMENTS];                  ///< The number of matched pfos per agreement
+        unsigned int    m_nUnmatchedPfos[2];                    ///< The number of pfos without a partner, per input
+        unsigned int    m_nTypeChanges;                         ///< The number of matched pfos with a different pid
+        unsigned int    m_nChargeChanges;                       ///< The number of matched pfos with a different charge
+        unsigned int    m_nHitMembershipChanges;                ///< The number of matched pfos whose clusters hold different calo hits
+        unsigned int    m_nTrackMembershipChanges;              ///< The number of matched pfos with different tracks
+        unsigned int    m_nClusterChanges;                      ///< The number of matched pfos whose clusters differ beyond tolerance
+        unsigned int    m_nStartVertexChanges;                  ///< The number of matched pfos whose start vertex moved beyond tolerance
+        unsigned int    m_nAssociationChanges;                  ///< The number of matched pfos whose mc associations differ beyond tolerance
+        unsigned int    m_nOrderChanges;                        ///< The number of events whose pfos are matched, but in a different order
+
+        RunningStatistic m_relativeEnergyDifference;            ///< The relative energy difference of matched pfos, second minus first
+        RunningStatistic m_relativeMomentumDifference;          ///< The momentum difference of matched pfos, relative to the momentum
+        RunningStatistic m_relativeMassDifference;              ///< The relative mass difference of matched pfos
+        RunningStatistic m_eventEnergyDifference;               ///< The difference of the total pfo energy per event, units GeV
+
+        std::map<int, unsigned int> m_typeCounts[2];            ///< The number of pfos of each pid, per input
+    };
+
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  settings the comparator settings
+     */
+    explicit PfoComparator(const Settings &settings);
+
+    /**
+     *  @brief  Compare the output of one event and add it to the summary
+     *
+     *  @param  eventNumber the event number, used in the printed differences
+     *  @param  first the output of the first run
+     *  @param  second the output of the second run
+     *
+     *  @return how closely the event agrees
+     */
+    Agreement CompareEvent(const unsigned int eventNumber, const EventCollections &first, const EventCollections &second);
+
+    /**
+     *  @brief  Get the summary of all compared events
+     *
+     *  @return the summary
+     */
+    const Summary &GetSummary() const;
+
+    /**
+     *  @brief  Print the summary of all compared events
+     */
+    void PrintSummary() const;
+
+    /**
+     *  @brief  Get the name of an agreement
+     *
+     *  @param  agreement the agreement
+     *
+     *  @return the name
+     */
+    static const char *GetAgreementName(const Agreement agreement);
+
+private:
+    typedef std::vector<uint64_t> ObjectIdVector;
+
+    /**
+     *  @brief  The properties of one pfo that are compared, with its hits, tracks, vertex and associations
+     */
+    class PfoRecord
+    {
+    public:
+        edm4hep::ConstReconstructedParticle     m_pfo;                      ///< The pfo
+        ObjectIdVector                          m_hitIds;                   ///< The sorted object ids of the calo hits of its clusters
+        ObjectIdVector                          m_trackIds;                 ///< The sorted object ids of its tracks
+        bool                                    m_hasStartVertex;           ///< Whether a start vertex points at the pfo
+        edm4hep::Vector3f                       m_startVertexPosition;      ///< The start vertex position
+        std::vector<std::pair<uint64_t, float> > m_associations;            ///< The sorted mc particle object ids and weights of its associations
+    };
+
+    typedef std::vector<PfoRecord> PfoRecordVector;
+
+    /**
+     *  @brief  Build the records of the pfos of one event
+     *
+     *  @param  collections the event collections
+     *  @param  pfoRecords to receive the records, in collection order
+     */
+    void BuildPfoRecords(const EventCollections &collections, PfoRecordVector &pfoRecords) const;
+
+    /**
+     *  @brief  Match the pfos of the two runs by their shared hits and tracks. Each pfo is paired with the unpaired partner sharing most
+     *          of its tracks, then most of its hits; pfos sharing nothing stay unmatched.
+     *
+     *  @param  first the records of the first run
+     *  @param  second the records of the second run
+     *  @param  matches to receive, per pfo of the first run, the index of its partner in the second run or -1
+     */
+    void MatchPfos(const PfoRecordVector &first, const PfoRecordVector &second, std::vector<int> &matches) const;
+
+    /**
+     *  @brief  Compare two matched pfos and add their differences to the summary
+     *
+     *  @param  eventNumber the event number
+     *  @param  first the pfo of the first run
+     *  @param  second the pfo of the second run
+     *
+     *  @return how closely the pfos agree
+     */
+    Agreement ComparePfos(const unsigned int eventNumber, const PfoRecord &first, const PfoRecord &second);
+
+    /**
+     *  @brief  Compare the clusters of two matched pfos, in the order they were added to the pfos
+     *
+     *  @param  first the pfo of the first run
+     *  @param  second the pfo of the second run
+     *
+     *  @return how closely the clusters agree
+     */
+    Agreement CompareClusters(const edm4hep::ConstReconstructedParticle &first, const edm4hep::ConstReconstructedParticle &second) const;
+
+    /**
+     *  @brief  Classify the difference of two floating point values
+     *
+     *  @param  first the first value
+     *  @param  second the second value
+     *  @param  tolerance the allowed absolute difference
+     *
+     *  @return how closely the values agree
+     */
+    static Agreement CompareValues(const float first, const float second, const float tolerance);
+
+    /**
+     *  @brief  Print one difference, as long as fewer than the configured number have been printed
+     *
+     *  @param  eventNumber the event number
+     *  @param  description the description of the difference
+     */
+    void PrintDifference(const unsigned int eventNumber, const std::string &description);
+
+    const Settings      m_settings;                             ///< The comparator settings
+    Summary             m_summary;                              ///< The summary of all compared events
+    unsigned int        m_nPrintedDifferences;                  ///< The number of differences printed so far
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const PfoComparator::Summary &PfoComparator::GetSummary() const
+{
+    return m_summary;
+}
+
+#endif // #ifndef PFO_COMPARATOR_H
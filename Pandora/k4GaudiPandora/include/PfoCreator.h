@@ -7,7 +7,6 @@
 #ifndef PFO_CREATOR_H
 #define PFO_CREATOR_H 1
 
-#include "k4FWCore/DataHandle.h"
 #include "edm4hep/Vector3f.h"
 #include "edm4hep/ClusterCollection.h"
 #include "edm4hep/Cluster.h"
@@ -67,8 +66,13 @@ public:
     /**
      *  @brief  Create particle flow objects
      * 
+     *  @param  collectionMaps the input collections of the current event
+     *  @param  pClusterCollection the output cluster collection
+     *  @param  pReconstructedParticleCollection the output pfo collection
+     *  @param  pStartVertexCollection the output start vertex collection
      */    
-    pandora::StatusCode CreateParticleFlowObjects(CollectionMaps& collectionMaps, DataHandle<edm4hep::ClusterCollection>& _pClusterCollection, DataHandle<edm4hep::ReconstructedParticleCollection>& _pReconstructedParticleCollection, DataHandle<edm4hep::VertexCollection>& _pStartVertexCollection);
+    pandora::StatusCode CreateParticleFlowObjects(CollectionMaps& collectionMaps, edm4hep::ClusterCollection *const pClusterCollection,
+        edm4hep::ReconstructedParticleCollection *const pReconstructedParticleCollection, edm4hep::VertexCollection *const pStartVertexCollection);
 
     CollectionMaps* m_collectionMaps;
 
@@ -0,0 +1,165 @@
+/**
+ *
+ *  @brief  Header file for the stage timing monitor class.
+ *
+ *  $Log: $
+ */
+
+#ifndef STAGE_TIMING_MONITOR_H
+#define STAGE_TIMING_MONITOR_H 1
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ *  @brief  StageTimingMonitor class, collects the wall time spent in each stage of PandoraPFAlg::execute, one sample per stage and event
+ */
+class StageTimingMonitor
+{
+public:
+    /**
+     *  @brief  The timed stages, in execution order
+     */
+    enum Stage
+    {
+        UPDATE_MAP,
+        CREATE_MC_PARTICLES,
+        CREATE_CALO_HITS,
+        CREATE_CALO_HIT_TO_MC_RELATIONSHIPS,
+        CREATE_TRACK_ASSOCIATIONS,
+        CREATE_TRACKS,
+        CREATE_TRACK_TO_MC_RELATIONSHIPS,
+        PROCESS_EVENT,
+        CREATE_PARTICLE_FLOW_OBJECTS,
+        CREATE_MC_RECO_PARTICLE_ASSOCIATION,
+        RESET,
+        EVENT,
+        N_STAGES
+    };
+
+    typedef std::array<double, N_STAGES> EventTimes;            ///< Time spent per stage in one event, units ms
+
+    /**
+     *  @brief  Summary statistics of one stage, units ms
+     */
+    class Summary
+    {
+    public:
+        unsigned int    m_nEvents;                              ///< The number of events
+        double          m_mean;                                 ///< The mean time
+        double          m_p50;                                  ///< The median time
+        double          m_p95;                                  ///< The 95th percentile
+        double          m_p99;                                  ///< The 99th percentile
+        double          m_max;                                  ///< The maximum time
+    };
+
+    /**
+     *  @brief  Get the name of a stage
+     *
+     *  @param  stage the stage
+     *
+     *  @return the stage name
+     */
+    static const char *GetStageName(const Stage stage);
+
+    /**
+     *  @brief  Add the stage times of one event, may be called concurrently
+     *
+     *  @param  eventTimes the stage times
+     */
+    void AddEvent(const EventTimes &eventTimes);
+
+    /**
+     *  @brief  Get the samples recorded for a stage, not to be called while events are added
+     *
+     *  @param  stage the stage
+     *
+     *  @return the samples, one per event
+     */
+    const std::vector<double> &GetSamples(const Stage stage) const;
+
+    /**
+     *  @brief  Get the summary statistics of a stage, not to be called while events are added
+     *
+     *  @param  stage the stage
+     *
+     *  @return the summary
+     */
+    Summary GetSummary(const Stage stage) const;
+
+    /**
+     *  @brief  Write the summary statistics of all stages to a json file
+     *
+     *  @param  fileName the output file name
+     *
+     *  @return whether the file could be written
+     */
+    bool WriteJson(const std::string &fileName) const;
+
+private:
+    std::array<std::vector<double>, N_STAGES>   m_samples;      ///< The samples of each stage
+    std::mutex                                  m_mutex;        ///< Guards the samples
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  ScopedStageTimer class, adds the time spent in its scope to a stage of an event. A NULL event times address disables
+ *          the timer, in which case the clock is never read.
+ */
+class ScopedStageTimer
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  pEventTimes address of the event's stage times, NULL when timing is switched off
+     *  @param  stage the stage the scope belongs to
+     */
+    ScopedStageTimer(StageTimingMonitor::EventTimes *const pEventTimes, const StageTimingMonitor::Stage stage);
+
+    /**
+     *  @brief  Destructor, adds the elapsed time to the stage
+     */
+    ~ScopedStageTimer();
+
+    ScopedStageTimer(const ScopedStageTimer &) = delete;
+    ScopedStageTimer &operator=(const ScopedStageTimer &) = delete;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    StageTimingMonitor::EventTimes     *m_pEventTimes;          ///< Address of the event's stage times
+    StageTimingMonitor::Stage           m_stage;                ///< The stage
+    Clock::time_point                   m_start;                ///< The time the scope was entered
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const std::vector<double> &StageTimingMonitor::GetSamples(const Stage stage) const
+{
+    return m_samples[stage];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline ScopedStageTimer::ScopedStageTimer(StageTimingMonitor::EventTimes *const pEventTimes, const StageTimingMonitor::Stage stage) :
+    m_pEventTimes(pEventTimes),
+    m_stage(stage)
+{
+    if (m_pEventTimes)
+        m_start = Clock::now();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline ScopedStageTimer::~ScopedStageTimer()
+{
+    if (m_pEventTimes)
+        (*m_pEventTimes)[m_stage] += std::chrono::duration<double, std::milli>(Clock::now() - m_start).count();
+}
+
+#endif // #ifndef STAGE_TIMING_MONITOR_H
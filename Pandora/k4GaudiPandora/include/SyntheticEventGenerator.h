@@ -0,0 +1,410 @@
+/**
+ *
+ *  @brief  Header file for the synthetic event generator class.
+ *
+ *  $Log: $
+ */
+
+#ifndef SYNTHETIC_EVENT_GENERATOR_H
+#define SYNTHETIC_EVENT_GENERATOR_H 1
+
+#include "edm4hep/CaloHitContributionCollection.h"
+#include "edm4hep/CalorimeterHitCollection.h"
+#include "edm4hep/MCParticleCollection.h"
+#include "edm4hep/MCRecoCaloAssociationCollection.h"
+#include "edm4hep/MCRecoTrackerAssociationCollection.h"
+#include "edm4hep/SimCalorimeterHitCollection.h"
+#include "edm4hep/SimTrackerHitCollection.h"
+#include "edm4hep/TrackCollection.h"
+#include "edm4hep/TrackerHitCollection.h"
+
+#include "Api/PandoraApi.h"
+#include "Objects/Helix.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gear { class CalorimeterParameters; class GearMgr; }
+namespace UTIL { class BitField64; }
+
+class CollectionMaps;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  SyntheticEventGenerator class, fills the input collections of PandoraPFAlg with jet-like events laid out on a gear
+ *          geometry: mc particles, ecal and hcal hits with LCIO style cell ids, tpc tracks with their track states and tracker
+ *          hits, and optionally the sim hits and associations linking hits to mc particles. Showers follow simple longitudinal
+ *          and lateral profiles, which is enough to give pandora realistic occupancies and topologies, not realistic physics.
+ */
+class SyntheticEventGenerator
+{
+public:
+    /**
+     *  @brief  The calorimeter regions hits are generated in, one calo hit collection each
+     */
+    enum CaloRegion
+    {
+        ECAL_BARREL,
+        ECAL_ENDCAP,
+        HCAL_BARREL,
+        HCAL_ENDCAP,
+        N_CALO_REGIONS
+    };
+
+    /**
+     *  @brief  Settings class
+     */
+    class Settings
+    {
+    public:
+        /**
+         *  @brief  Default constructor
+         */
+        Settings();
+
+        unsigned int    m_seed;                                 ///< The seed of the random number engine
+        unsigned int    m_minNJets;                             ///< The minimum number of jets per event
+        unsigned int    m_maxNJets;                             ///< The maximum number of jets per event, drawn uniformly from [min, max]
+        float           m_nParticlesPerJet;                     ///< The mean number of particles per jet, Poisson distributed
+        float           m_jetEnergy;                            ///< The jet energy, units GeV
+        float           m_jetConeAngle;                         ///< The rms angle between jet particles and the jet axis, units rad
+        unsigned int    m_nIsolatedParticles;                   ///< The number of isolated particles per event
+        float           m_maxIsolatedParticleEnergy;            ///< The isolated particle energies are drawn uniformly from [1, max], units GeV
+        float           m_photonFraction;                       ///< The fraction of photons among the generated particles
+        float           m_neutralHadronFraction;                ///< The fraction of neutral hadrons, all other particles are charged pions
+        float           m_maxCosTheta;                          ///< The maximum |cos(theta)| of jet axes and isolated particles
+        float           m_occupancy;                            ///< Scales the number of calo hits generated per GeV of shower energy
+        float           m_eCalHitsPerGeV;                       ///< The mean number of hits per GeV of electromagnetic showers, at unit occupancy
+        float           m_hCalHitsPerGeV;                       ///< The mean number of hits per GeV of hadronic showers, at unit occupancy
+        float           m_emShowerRadius;                       ///< The mean lateral distance of electromagnetic shower hits from the axis, units mm
+        float           m_hadShowerRadius;                      ///< The mean lateral distance of hadronic shower hits from the axis, units mm
+        unsigned int    m_nNoiseHits;                           ///< The number of single-mip noise hits per event, spread over all regions
+        unsigned int    m_maxTrackerHitsPerTrack;               ///< The maximum number of tpc hits stored per track, 0 to store one per pad row
+        bool            m_createMCTruth;                        ///< Whether to create the sim hits and associations linking hits to mc particles
+
+        float           m_absorberRadLengthECal;                ///< The absorber radiation length in the ecal, units 1/mm
+        float           m_absorberIntLengthECal;                ///< The absorber interaction length in the ecal, units 1/mm
+        float           m_absorberRadLengthHCal;                ///< The absorber radiation length in the hcal, units 1/mm
+        float           m_absorberIntLengthHCal;                ///< The absorber interaction length in the hcal, units 1/mm
+        float           m_eCalMipEnergy;                        ///< The energy of a mip hit in the ecal, units GeV
+        float           m_hCalMipEnergy;                        ///< The energy of a mip hit in the hcal, units GeV
+
+        std::string     m_mcParticleCollectionName;             ///< The name of the mc particle collection
+        std::string     m_caloHitCollectionNames[N_CALO_REGIONS]; ///< The names of the calo hit collections, per region
+        std::string     m_trackCollectionName;                  ///< The name of the track collection
+        std::string     m_caloHitRelationCollectionName;        ///< The name of the calo hit to sim calo hit association collection
+        std::string     m_trackerHitRelationCollectionName;     ///< The name of the tracker hit to sim tracker hit association collection
+    };
+
+    /**
+     *  @brief  Event class, owns the collections of one generated event. The collections are reused from event to event.
+     */
+    class Event
+    {
+    public:
+        /**
+         *  @brief  Default constructor, gives every collection its own collection id so that object ids are unique in the event
+         */
+        Event();
+
+        Event(const Event &) = delete;
+        Event &operator=(const Event &) = delete;
+
+        /**
+         *  @brief  Clear all collections
+         */
+        void Clear();
+
+        /**
+         *  @brief  Get the number of calo hits in the event, summed over all regions
+         *
+         *  @return the number of calo hits
+         */
+        unsigned int GetNCaloHits() const;
+
+        edm4hep::MCParticleCollection               m_mcParticles;                      ///< The mc particles
+        edm4hep::CalorimeterHitCollection           m_caloHits[N_CALO_REGIONS];         ///< The calo hits, per region
+        edm4hep::TrackerHitCollection               m_trackerHits;                      ///< The tracker hits of all tracks
+        edm4hep::TrackCollection                    m_tracks;                           ///< The tracks
+        edm4hep::SimCalorimeterHitCollection        m_simCaloHits;                      ///< The sim calo hits, one per calo hit
+        edm4hep::CaloHitContributionCollection      m_caloHitContributions;             ///< The sim calo hit contributions
+        edm4hep::MCRecoCaloAssociationCollection    m_caloHitAssociations;              ///< The calo hit to sim calo hit associations
+        edm4hep::SimTrackerHitCollection            m_simTrackerHits;                   ///< The sim tracker hits, one per tracker hit
+        edm4hep::MCRecoTrackerAssociationCollection m_trackerHitAssociations;           ///< The tracker hit to sim tracker hit associations
+    };
+
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  settings the generator settings
+     *  @param  pGearMgr address of the gear manager describing the detector
+     */
+    SyntheticEventGenerator(const Settings &settings, gear::GearMgr *const pGearMgr);
+
+    /**
+     *  @brief  Destructor
+     */
+    ~SyntheticEventGenerator();
+
+    SyntheticEventGenerator(const SyntheticEventGenerator &) = delete;
+    SyntheticEventGenerator &operator=(const SyntheticEventGenerator &) = delete;
+
+    /**
+     *  @brief  Generate the next event, replacing the content of the event collections
+     *
+     *  @param  event to receive the generated event
+     */
+    void Generate(Event &event);
+
+    /**
+     *  @brief  Register the collections of an event in the collection maps, under the configured collection names
+     *
+     *  @param  event the event
+     *  @param  collectionMaps the collection maps
+     */
+    void FillCollectionMaps(const Event &event, CollectionMaps &collectionMaps) const;
+
+    /**
+     *  @brief  Get the settings
+     *
+     *  @return the settings
+     */
+    const Settings &GetSettings() const;
+
+private:
+    /**
+     *  @brief  CaloLayout class, the layer structure of one calorimeter region, as read from gear
+     */
+    class CaloLayout
+    {
+    public:
+        bool                    m_isBarrel;                     ///< Whether the region is a barrel, otherwise it is an endcap
+        unsigned int            m_symmetryOrder;                ///< The barrel symmetry order
+        float                   m_phi0;                         ///< The barrel phi0
+        float                   m_innerR;                       ///< The inner radius
+        float                   m_outerR;                       ///< The outer radius
+        float                   m_innerZ;                       ///< The inner z coordinate, endcap only
+        float                   m_outerZ;                       ///< The outer z coordinate
+        float                   m_mipEnergy;                    ///< The energy of a mip hit, units GeV
+        pandora::FloatVector    m_layerCentres;                 ///< The distance of each layer centre from the ip, radial in the barrel and along z in the endcap
+        pandora::FloatVector    m_cellSize0;                    ///< The cell size 0 of each layer
+        pandora::FloatVector    m_cellSize1;                    ///< The cell size 1 of each layer
+        pandora::FloatVector    m_radiationLengths;             ///< The cumulative absorber radiation lengths at the back of each layer
+        pandora::FloatVector    m_interactionLengths;           ///< The cumulative absorber interaction lengths at the back of each layer
+    };
+
+    /**
+     *  @brief  CellDeposit class, the energy collected in one calorimeter cell
+     */
+    class CellDeposit
+    {
+    public:
+        /**
+         *  @brief  Constructor, for a cell without energy
+         *
+         *  @param  region the calorimeter region
+         *  @param  cellId the cell id
+         *  @param  position the cell centre
+         */
+        CellDeposit(const CaloRegion region, const uint64_t cellId, const pandora::CartesianVector &position);
+
+        CaloRegion              m_region;                       ///< The calorimeter region
+        uint64_t                m_cellId;                       ///< The cell id
+        pandora::CartesianVector m_position;                    ///< The cell centre
+        float                   m_energy;                       ///< The deposited energy, units GeV
+        float                   m_time;                         ///< The time of flight from the ip to the cell centre, units ns
+        std::vector<std::pair<int, float> > m_contributions;    ///< The mc particle index and energy of each contribution, -1 for noise
+    };
+
+    /**
+     *  @brief  ShowerAxis class, where a particle enters a calorimeter region and in which direction it travels
+     */
+    class ShowerAxis
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  origin a point on the axis
+         *  @param  direction the unit direction
+         */
+        ShowerAxis(const pandora::CartesianVector &origin, const pandora::CartesianVector &direction);
+
+        pandora::CartesianVector m_origin;                      ///< A point on the axis
+        pandora::CartesianVector m_direction;                   ///< The unit direction
+    };
+
+    /**
+     *  @brief  Generate one particle, its track and its calorimeter deposits
+     *
+     *  @param  event the event
+     *  @param  energy the particle energy
+     *  @param  direction the particle direction
+     *  @param  pParent address of the parent mc particle, NULL for none
+     */
+    void GenerateParticle(Event &event, float energy, const pandora::CartesianVector &direction, edm4hep::MCParticle *const pParent);
+
+    /**
+     *  @brief  Generate the track of a charged particle, with its tracker hits and track states
+     *
+     *  @param  event the event
+     *  @param  helix the particle trajectory
+     *  @param  mcIndex the index of the mc particle
+     *  @param  pCalorimeterEntry address of the point at which the particle reaches the ecal, NULL if it does not
+     */
+    void GenerateTrack(Event &event, const pandora::Helix &helix, const int mcIndex, const pandora::CartesianVector *const pCalorimeterEntry);
+
+    /**
+     *  @brief  Deposit an electromagnetic shower
+     *
+     *  @param  axis the shower axis
+     *  @param  energy the shower energy
+     *  @param  mcIndex the index of the mc particle
+     */
+    void DepositEMShower(const ShowerAxis &axis, const float energy, const int mcIndex);
+
+    /**
+     *  @brief  Deposit a hadronic shower, preceded by a mip track for charged particles
+     *
+     *  @param  axis the shower axis
+     *  @param  energy the shower energy
+     *  @param  isCharged whether the particle is charged
+     *  @param  mcIndex the index of the mc particle
+     */
+    void DepositHadronicShower(const ShowerAxis &axis, const float energy, const bool isCharged, const int mcIndex);
+
+    /**
+     *  @brief  Deposit energy in the layer of the ecal or hcal at a given material depth along a shower axis
+     *
+     *  @param  axis the shower axis
+     *  @param  depth the depth, in radiation or interaction lengths from the ecal front face
+     *  @param  useInteractionLengths whether the depth is in interaction lengths
+     *  @param  lateralRadius the distance of the deposit from the axis
+     *  @param  energy the energy
+     *  @param  mcIndex the index of the mc particle, -1 for noise
+     */
+    void DepositAtDepth(const ShowerAxis &axis, float depth, const bool useInteractionLengths, const float lateralRadius, const float energy,
+        const int mcIndex);
+
+    /**
+     *  @brief  Deposit energy in a given layer, at the point where the shower axis crosses it, displaced laterally
+     *
+     *  @param  region the calorimeter region
+     *  @param  stave the barrel stave, ignored in the endcaps
+     *  @param  layer the layer
+     *  @param  axis the shower axis
+     *  @param  lateralRadius the distance of the deposit from the axis
+     *  @param  energy the energy
+     *  @param  mcIndex the index of the mc particle, -1 for noise
+     */
+    void DepositInLayer(const CaloRegion region, const unsigned int stave, const unsigned int layer, const ShowerAxis &axis,
+        const float lateralRadius, const float energy, const int mcIndex);
+
+    /**
+     *  @brief  Add energy to the cell containing a given point of a layer, if the point lies within the region
+     *
+     *  @param  region the calorimeter region
+     *  @param  stave the barrel stave, ignored in the endcaps
+     *  @param  layer the layer
+     *  @param  position the point
+     *  @param  energy the energy
+     *  @param  mcIndex the index of the mc particle, -1 for noise
+     */
+    void AddToCell(const CaloRegion region, const unsigned int stave, const unsigned int layer, const pandora::CartesianVector &position,
+        const float energy, const int mcIndex);
+
+    /**
+     *  @brief  Find the region of the ecal or hcal a shower axis enters, and the barrel stave it enters through
+     *
+     *  @param  barrelRegion the barrel region
+     *  @param  axis the shower axis
+     *  @param  region to receive the region
+     *  @param  stave to receive the barrel stave
+     *
+     *  @return whether the axis enters the barrel or endcap
+     */
+    bool FindEntryRegion(const CaloRegion barrelRegion, const ShowerAxis &axis, CaloRegion &region, unsigned int &stave) const;
+
+    /**
+     *  @brief  Get the unit normal of a barrel stave, pointing outwards
+     *
+     *  @param  layout the barrel layout
+     *  @param  stave the stave
+     *
+     *  @return the unit normal
+     */
+    pandora::CartesianVector GetStaveNormal(const CaloLayout &layout, const unsigned int stave) const;
+
+    /**
+     *  @brief  Deposit the noise hits of an event
+     */
+    void DepositNoise();
+
+    /**
+     *  @brief  Write the collected cell deposits to the calo hit collections, with their sim hits and associations
+     *
+     *  @param  event the event
+     */
+    void WriteCaloHits(Event &event);
+
+    /**
+     *  @brief  Read the layout of a calorimeter region from gear
+     *
+     *  @param  parameters the gear calorimeter parameters
+     *  @param  radLength the absorber radiation length, units 1/mm
+     *  @param  intLength the absorber interaction length, units 1/mm
+     *  @param  mipEnergy the energy of a mip hit
+     *  @param  layout to receive the layout
+     */
+    static void ReadCaloLayout(const gear::CalorimeterParameters &parameters, const float radLength, const float intLength, const float mipEnergy,
+        CaloLayout &layout);
+
+    typedef std::unordered_map<uint64_t, unsigned int> CellIndexMap;
+    typedef std::vector<edm4hep::MCParticle> MCParticleVector;
+
+    const Settings              m_settings;                     ///< The generator settings
+    float                       m_bField;                       ///< The bfield at the ip, units Tesla
+    float                       m_tpcInnerR;                    ///< The tpc inner radius
+    float                       m_tpcOuterR;                    ///< The tpc outer radius
+    float                       m_tpcZmax;                      ///< The tpc half length
+    unsigned int                m_tpcNRows;                     ///< The number of tpc pad rows
+    CaloLayout                  m_caloLayouts[N_CALO_REGIONS];  ///< The calorimeter layouts, per region
+    UTIL::BitField64           *m_pCellIdEncoder;               ///< Encodes the calo hit cell ids, same encoding as the CaloHitCreator decodes
+    std::mt19937                m_randomEngine;                 ///< The random number engine
+
+    MCParticleVector            m_mcParticles;                  ///< The mc particles of the event being generated, indexed by mc index
+    std::vector<CellDeposit>    m_cellDeposits;                 ///< The cell deposits of the event being generated, in order of first deposit
+    CellIndexMap                m_cellIndices;                  ///< The index in the cell deposits of each region and cell id
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const SyntheticEventGenerator::Settings &SyntheticEventGenerator::GetSettings() const
+{
+    return m_settings;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline SyntheticEventGenerator::CellDeposit::CellDeposit(const CaloRegion region, const uint64_t cellId, const pandora::CartesianVector &position) :
+    m_region(region),
+    m_cellId(cellId),
+    m_position(position),
+    m_energy(0.f),
+    m_time(position.GetMagnitude() / 299.792458f)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline SyntheticEventGenerator::ShowerAxis::ShowerAxis(const pandora::CartesianVector &origin, const pandora::CartesianVector &direction) :
+    m_origin(origin),
+    m_direction(direction)
+{
+}
+
+#endif // #ifndef SYNTHETIC_EVENT_GENERATOR_H
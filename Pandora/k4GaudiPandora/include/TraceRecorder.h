@@ -0,0 +1,212 @@
+/**
+ *
+ *  @brief  Header file for the trace recorder class.
+ *
+ *  $Log: $
+ */
+
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H 1
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ *  @brief  TraceRecorder class, records timed spans and writes them as chrome trace-event json (chrome://tracing, Perfetto).
+ *          Spans are appended to a buffer owned by the recording thread, so recording takes no lock; the buffers are
+ *          only read when the trace is written, which must happen once no more spans are recorded.
+ */
+class TraceRecorder
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     *  @brief  Span class, one complete ("X") trace event
+     */
+    class Span
+    {
+    public:
+        static const unsigned int MAX_ARGS = 3;                 ///< The maximum number of integer arguments of a span
+
+        const char     *m_pName;                                ///< The span name, must be a string literal or otherwise outlive the recorder
+        std::string     m_detail;                               ///< Optional free text argument, e.g. a collection name
+        long long       m_start;                                ///< The start time, units us since the recorder was created
+        long long       m_duration;                             ///< The duration, units us
+        int             m_eventNumber;                          ///< The event number the span belongs to
+        unsigned int    m_nArgs;                                ///< The number of integer arguments
+        const char     *m_argNames[MAX_ARGS];                   ///< The integer argument names
+        long long       m_argValues[MAX_ARGS];                  ///< The integer argument values
+    };
+
+    /**
+     *  @brief  Default constructor
+     */
+    TraceRecorder();
+
+    /**
+     *  @brief  Set the event number that spans recorded by the calling thread are tagged with
+     *
+     *  @param  eventNumber the event number
+     */
+    void SetCurrentEvent(const int eventNumber);
+
+    /**
+     *  @brief  Add a span recorded by the calling thread
+     *
+     *  @param  span the span, the event number is filled by the recorder
+     */
+    void AddSpan(Span &span);
+
+    /**
+     *  @brief  Get the time elapsed since the recorder was created
+     *
+     *  @param  timePoint the time point
+     *
+     *  @return the elapsed time, units us
+     */
+    long long GetTimestamp(const Clock::time_point &timePoint) const;
+
+    /**
+     *  @brief  Write all recorded spans to a json file
+     *
+     *  @param  fileName the output file name
+     *
+     *  @return whether the file could be written
+     */
+    bool WriteJson(const std::string &fileName) const;
+
+private:
+    /**
+     *  @brief  ThreadBuffer class, the spans recorded by one thread
+     */
+    class ThreadBuffer
+    {
+    public:
+        unsigned int        m_threadIndex;                      ///< Small sequential thread id, used as trace tid
+        int                 m_currentEvent;                     ///< The event number currently processed by the thread
+        std::vector<Span>   m_spans;                            ///< The recorded spans
+    };
+
+    typedef std::unordered_map<std::thread::id, ThreadBuffer*> ThreadBufferMap;
+
+    /**
+     *  @brief  Get the buffer of the calling thread, registering it on first use. Each thread keeps one buffer per recorder,
+     *          so a thread alternating between recorders finds its existing buffers again.
+     *
+     *  @return the buffer
+     */
+    ThreadBuffer &GetThreadBuffer();
+
+    const unsigned int                          m_recorderId;   ///< Distinguishes recorders in the per-thread buffer cache
+    const Clock::time_point                     m_origin;       ///< The time the recorder was created
+    std::vector<std::unique_ptr<ThreadBuffer>>  m_buffers;      ///< The buffers of all threads that recorded spans
+    ThreadBufferMap                             m_threadBuffers; ///< The buffer of each thread that recorded spans, by thread id
+    mutable std::mutex                          m_mutex;        ///< Guards the buffer list and map
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  ScopedTraceSpan class, records a span covering its scope. A NULL recorder disables the span, in which case
+ *          the clock is never read.
+ */
+class ScopedTraceSpan
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  pRecorder address of the recorder, NULL when tracing is switched off
+     *  @param  pName the span name, must be a string literal
+     */
+    ScopedTraceSpan(TraceRecorder *const pRecorder, const char *const pName);
+
+    /**
+     *  @brief  Destructor, records the span
+     */
+    ~ScopedTraceSpan();
+
+    ScopedTraceSpan(const ScopedTraceSpan &) = delete;
+    ScopedTraceSpan &operator=(const ScopedTraceSpan &) = delete;
+
+    /**
+     *  @brief  Attach an integer argument, e.g. an input size, ignored beyond Span::MAX_ARGS arguments
+     *
+     *  @param  pName the argument name, must be a string literal
+     *  @param  value the argument value
+     */
+    void AddArg(const char *const pName, const long long value);
+
+    /**
+     *  @brief  Attach a free text argument
+     *
+     *  @param  detail the text
+     */
+    void SetDetail(const std::string &detail);
+
+private:
+    TraceRecorder                      *m_pRecorder;            ///< Address of the recorder
+    TraceRecorder::Span                 m_span;                 ///< The span being recorded
+    TraceRecorder::Clock::time_point    m_start;                ///< The time the scope was entered
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline long long TraceRecorder::GetTimestamp(const Clock::time_point &timePoint) const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(timePoint - m_origin).count();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline ScopedTraceSpan::ScopedTraceSpan(TraceRecorder *const pRecorder, const char *const pName) :
+    m_pRecorder(pRecorder)
+{
+    if (!m_pRecorder)
+        return;
+
+    m_span.m_pName = pName;
+    m_span.m_nArgs = 0;
+    m_start = TraceRecorder::Clock::now();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline ScopedTraceSpan::~ScopedTraceSpan()
+{
+    if (!m_pRecorder)
+        return;
+
+    const TraceRecorder::Clock::time_point end(TraceRecorder::Clock::now());
+    m_span.m_start = m_pRecorder->GetTimestamp(m_start);
+    m_span.m_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - m_start).count();
+    m_pRecorder->AddSpan(m_span);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void ScopedTraceSpan::AddArg(const char *const pName, const long long value)
+{
+    if (!m_pRecorder || (m_span.m_nArgs >= TraceRecorder::Span::MAX_ARGS))
+        return;
+
+    m_span.m_argNames[m_span.m_nArgs] = pName;
+    m_span.m_argValues[m_span.m_nArgs] = value;
+    ++m_span.m_nArgs;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void ScopedTraceSpan::SetDetail(const std::string &detail)
+{
+    if (m_pRecorder)
+        m_span.m_detail = detail;
+}
+
+#endif // #ifndef TRACE_RECORDER_H
@@ -10,9 +10,9 @@
 
 
 
-#include "GaudiKernel/ISvcLocator.h"
-
 #include "edm4hep/Track.h"
+#include "edm4hep/TrackCollection.h"
+#include "edm4hep/VertexCollection.h"
 #include "edm4hep/TrackConst.h"
 #include "edm4hep/TrackState.h"
 #include "edm4hep/ReconstructedParticleConst.h"
@@ -20,13 +20,17 @@
 #include "Api/PandoraApi.h"
 #include "Objects/Helix.h"
 
+#include "IdIndexMap.h"
+#include "VertexTopology.h"
+
 namespace gear { class GearMgr; }
 
 class CollectionMaps;
+class PandoraInputRecorder;
+class TraceRecorder;
 
 typedef std::vector<const edm4hep::Track *> TrackVector;
-typedef std::set<unsigned int> TrackList;
-typedef std::map<edm4hep::ConstTrack, int> TrackToPidMap;
+typedef std::vector<edm4hep::Track> TrackStore;
 /*
 inline LCCollectionVec *newTrkCol(const std::string &name, LCEvent *evt , bool isSubset)
 {
@@ -104,13 +108,18 @@ public:
         float           m_maxTpcInnerRDistance;                 ///< Track cut on distance from tpc inner r to id whether track can form pfo
         float           m_minTpcHitFractionOfExpected;          ///< Minimum fraction of TPC hits compared to expected
         int             m_minFtdHitsForTpcHitFraction;          ///< Minimum number of FTD hits to ignore TPC hit fraction
+
+        DuplicatePolicy m_duplicatePolicy;                      ///< The policy for tracks appearing in more than one track collection
     };
 
     /**
      *  @brief  Constructor
      * 
+     *  @param  settings the creator settings
+     *  @param  pPandora address of the relevant pandora instance
+     *  @param  pGearMgr address of the gear manager describing the detector
      */
-     TrackCreator(const Settings &settings, const pandora::Pandora *const pPandora, ISvcLocator* svcloc);
+     TrackCreator(const Settings &settings, const pandora::Pandora *const pPandora, gear::GearMgr *const pGearMgr);
 
     /**
      *  @brief  Destructor
@@ -123,7 +132,6 @@ public:
      */
     pandora::StatusCode CreateTrackAssociations(const CollectionMaps& collectionMaps);
 
-    const edm4hep::Track* GetTrackAddress(const CollectionMaps& collectionMaps, const edm4hep::ConstTrack& pTrack );
     /**
      *  @brief  Create tracks, insert user code here
      * 
@@ -137,66 +145,182 @@ public:
      */
     const TrackVector &GetTrackVector() const;
 
+    /**
+     *  @brief  Get the number of track collection entries of the current event repeating a track of an earlier entry
+     *
+     *  @return the number of duplicate tracks
+     */
+    unsigned int GetNDuplicateTracks() const;
+
+    /**
+     *  @brief  Get the kink, prong, split and v0 topology of the current event, whose track slots are given by GetSlotTrack
+     *
+     *  @return the vertex topology
+     */
+    const VertexTopology &GetVertexTopology() const;
+
+    /**
+     *  @brief  Get the address of the stored track of a track slot
+     *
+     *  @param  slot the track slot
+     *
+     *  @return address of the stored track, NULL for slots of tracks that are only in the vertex collections
+     */
+    const edm4hep::Track *GetSlotTrack(const unsigned int slot) const;
+
     /**
      *  @brief  Reset the track creator
      */
     void Reset();
 
+    /**
+     *  @brief  Set the trace recorder receiving a span per input collection
+     *
+     *  @param  pTraceRecorder address of the trace recorder, NULL to switch tracing off
+     */
+    void SetTraceRecorder(TraceRecorder *const pTraceRecorder);
+
+    /**
+     *  @brief  Set the input recorder receiving the tracks and track relationships passed to pandora
+     *
+     *  @param  pInputRecorder address of the input recorder, NULL to switch recording off
+     */
+    void SetInputRecorder(PandoraInputRecorder *const pInputRecorder);
+
 private:
+    friend class KernelBenchmarkAccess;     ///< The kernel microbenchmark times the private per track kernels in isolation
+
+    typedef std::vector<unsigned int> UIntVector;
+
     /**
-     *  @brief  Extract kink information from specified lcio collections
-     * 
+     *  @brief  ECalBarrelFaces class, the inner face planes of the ecal barrel polygon, precomputed from gear for the projection of
+     *          tracks to the calorimeter
+     */
+    class ECalBarrelFaces
+    {
+    public:
+        /**
+         *  @brief  Default constructor, no faces
+         */
+        ECalBarrelFaces();
+
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  symmetryOrder the symmetry order, zero for a cylinder, which has no faces
+         *  @param  phi0 the phi coordinate of the first face
+         *  @param  innerR the inner radius, the distance of the faces from the z axis
+         */
+        ECalBarrelFaces(const int symmetryOrder, const float phi0, const float innerR);
+
+        float                               m_phi0;             ///< The phi coordinate of the first face
+        float                               m_faceAngle;        ///< The phi range covered by each face
+        pandora::FloatVector                m_pointX;           ///< The x coordinate of the point of each face closest to the z axis
+        pandora::FloatVector                m_pointY;           ///< The y coordinate of the point of each face closest to the z axis
+        pandora::FloatVector                m_directionX;       ///< The x component of the direction of each face in the xy plane
+        pandora::FloatVector                m_directionY;       ///< The y component of the direction of each face in the xy plane
+    };
+
+    /**
+     *  @brief  TrackProjectionColumns class, the helices of the tracks of an event and the barrel faces each can leave the ecal
+     *          inner polygon through, as flat columns filled before any intersection is solved. The capacity is reused between events.
      */
-    pandora::StatusCode ExtractKinks(const CollectionMaps& collectionMaps);
+    class TrackProjectionColumns
+    {
+    public:
+        UIntVector                          m_selectedTracks;   ///< The store index of each track passing the hit count cuts
+        std::vector<pandora::Helix>         m_helices;          ///< The helix of each selected track with a track state at the ip
+        UIntVector                          m_trackIndices;     ///< The store index of each helix
+        pandora::FloatVector                m_centreX;          ///< The x coordinate of the centre of each helix
+        pandora::FloatVector                m_centreY;          ///< The y coordinate of the centre of each helix
+        pandora::FloatVector                m_radius;           ///< The radius of each helix
+        pandora::FloatVector                m_referenceR;       ///< The distance of the reference point of each helix from the z axis
+        UIntVector                          m_firstFaces;       ///< The first candidate barrel face of each helix
+        UIntVector                          m_nFaces;           ///< The number of candidate barrel faces of each helix, in increasing face order
+    };
 
     /**
-     *  @brief  Extract prong and split information from specified lcio collections
-     * 
-     *  @param  pLCEvent the lcio event
+     *  @brief  Fill the track store from the configured track collections, once per event, and index the stored tracks by object
+     *          id. With duplicate detection, tracks with the object id of an earlier track are counted and left out, or fail the
+     *          event under the fail policy.
+     *
      */
-    //pandora::StatusCode ExtractProngsAndSplits(const EVENT::LCEvent *const pLCEvent);
-    pandora::StatusCode ExtractProngsAndSplits(const CollectionMaps& collectionMaps);
+    void BindTracks(const CollectionMaps& collectionMaps);
 
     /**
-     *  @brief  Extract v0 information from specified lcio collections
-     * 
-     *  @param  pLCEvent the lcio event
+     *  @brief  Add the vertices of the specified collections to the vertex topology
+     *
+     *  @param  collectionMaps the event collections
+     *  @param  collectionNames the vertex collection names
+     *  @param  vertexType the vertex type of the collections
      */
-   //pandora::StatusCode ExtractV0s(const EVENT::LCEvent *const pLCEvent);
-    pandora::StatusCode ExtractV0s(const CollectionMaps& collectionMaps);
+    void AddVertices(const CollectionMaps& collectionMaps, const StringVector &collectionNames, const VertexTopology::VertexType vertexType);
 
     /**
-     *  @brief  Whether the track vertex conflicts with previously provided relationship information
-     * 
-     *  @param  trackVec the vector of tracks associated with the vertex
+     *  @brief  Pass the parent daughter and sibling relationships of the vertex topology to pandora
      */
-    bool IsConflictingRelationship(const edm4hep::ConstReconstructedParticle &Particle) const;
+    pandora::StatusCode SetTrackRelationships() const;
 
     /**
-     *  @brief  Whether a track is a v0 track
-     * 
-     * 
+     *  @brief  Get the particle id a vertex implies for one of its tracks
+     *
+     *  @param  vertexType the vertex type
+     *  @param  vertexPdgCode the pdg code of the vertex particle
+     *  @param  iTrack the index of the track in the vertex
+     *  @param  track the track
+     *
+     *  @return the particle id, unknown for prong and split vertices
      */
-    bool IsV0(unsigned int pTrack_id) const;
+    static int GetVertexTrackParticleId(const VertexTopology::VertexType vertexType, const int vertexPdgCode, const unsigned int iTrack,
+        const edm4hep::ConstTrack &track);
 
     /**
-     *  @brief  Whether a track is a parent track
-     * 
-     * 
+     *  @brief  Get the slot of a track in the vertex topology, adding a slot if the track is not yet indexed
+     *
+     *  @param  track the track
+     *
+     *  @return the slot
      */
-    bool IsParent(unsigned int pTrack_id) const;
+    unsigned int GetTrackSlot(const edm4hep::ConstTrack &track);
 
     /**
-     *  @brief  Whether a track is a daughter track
-     * 
+     *  @brief  Get the flags of a track, from its slot if it is a stored track, else through the id index
+     *
+     *  @param  pTrack address of the track
+     *
+     *  @return the track flags, zero for tracks without a slot
+     */
+    unsigned char GetTrackFlags(const edm4hep::Track *const pTrack) const;
+
+    /**
+     *  @brief  Whether track flags mark a v0 track
+     *
+     *  @param  trackFlags the track flags
+     */
+    static bool IsV0(const unsigned char trackFlags);
+
+    /**
+     *  @brief  Whether track flags mark a parent track
+     *
+     *  @param  trackFlags the track flags
      */
-    bool IsDaughter(unsigned int pTrack_id) const;
+    static bool IsParent(const unsigned char trackFlags);
+
+    /**
+     *  @brief  Whether track flags mark a daughter track
+     *
+     *  @param  trackFlags the track flags
+     */
+    static bool IsDaughter(const unsigned char trackFlags);
 
     /**
      *  @brief  Copy track states stored in tracks to pandora track parameters
-     * 
+     *
+     *  @param  pTrack address of the track
+     *  @param  genericTimeAtCalorimeter the generic time of the track at the calorimeter, NaN if it has no calorimeter projection
+     *  @param  trackParameters the track parameters
      */
-    void GetTrackStates(const edm4hep::Track *const pTrack, PandoraApi::Track::Parameters &trackParameters) const;
+    void GetTrackStates(const edm4hep::Track *const pTrack, const float genericTimeAtCalorimeter, PandoraApi::Track::Parameters &trackParameters) const;
 
     /**
      *  @brief  Copy track state from track state instance to pandora input track state
@@ -210,6 +334,44 @@ private:
      */
     float CalculateTrackTimeAtCalorimeter(const edm4hep::Track *const pTrack) const;
 
+    /**
+     *  @brief  Obtain the generic times at which the tracks of an event passing the hit count cuts reach the ecal, as
+     *          CalculateTrackTimeAtCalorimeter does for one track. The tracks are selected while the helices are built, then the
+     *          candidate barrel faces of all helices are found, then the intersections. The selected tracks are kept in the
+     *          projection columns.
+     *
+     *  @param  tracks the tracks
+     *  @param  genericTimes to receive the generic time of each track, NaN for rejected tracks and tracks without a calorimeter
+     *          projection
+     */
+    void CalculateTrackTimesAtCalorimeter(const TrackStore &tracks, pandora::FloatVector &genericTimes);
+
+    /**
+     *  @brief  Get the ecal barrel faces a helix can first reach the calorimeter through. Starting within the circle inscribed in the
+     *          inner polygon, the helix leaves the polygon at its first face plane crossing, at a point whose phi lies within the
+     *          span of the helix circle outside the inscribed circle. Other helices get all faces.
+     *
+     *  @param  centreX the x coordinate of the helix centre
+     *  @param  centreY the y coordinate of the helix centre
+     *  @param  radius the helix radius
+     *  @param  referenceR the distance of the helix reference point from the z axis
+     *  @param  firstFace to receive the first candidate face
+     *  @param  nFaces to receive the number of candidate faces, which follow the first in increasing face order
+     */
+    void GetCandidateECalFaces(const float centreX, const float centreY, const float radius, const float referenceR, unsigned int &firstFace,
+        unsigned int &nFaces) const;
+
+    /**
+     *  @brief  Get the generic time at which a helix reaches the ecal, the earliest of its endcap and barrel intersections
+     *
+     *  @param  helix the helix
+     *  @param  firstFace the first candidate barrel face
+     *  @param  nFaces the number of candidate barrel faces
+     *
+     *  @return the generic time, NaN if the helix has no calorimeter projection
+     */
+    float GetGenericTimeAtCalorimeter(const pandora::Helix &helix, const unsigned int firstFace, const unsigned int nFaces) const;
+
     /**
      *  @brief  Decide whether track reaches the ecal surface
      * 
@@ -244,8 +406,45 @@ private:
      */
     int GetNFtdHits(const edm4hep::Track *const pTrack) const;
 
+    /**
+     *  @brief  Build the ftd layer lookups: the sorted tan lambda acceptance bounds of the layers, and the candidate layers of each
+     *          bin in |z| for the assignment of tracker hits to layers
+     */
+    void InitialiseFtdLookups();
+
+    /**
+     *  @brief  Whether a track has an allowed number of tracker hits, with the minimum raised to the expected number of ftd hits
+     *          for forward tracks
+     *
+     *  @param  track the track
+     *
+     *  @return whether the track passes the hit count cuts
+     */
+    bool PassesTrackHitCuts(const edm4hep::Track &track) const;
+
+    /**
+     *  @brief  Get the number of ftd layers whose tan lambda acceptance window contains a track tan lambda
+     *
+     *  @param  tanLambda the absolute track tan lambda
+     *
+     *  @return the number of layers the track is expected to cross
+     */
+    int GetNExpectedFtdHits(const float tanLambda) const;
+
+    /**
+     *  @brief  Get the first ftd layer a tracker hit lies on, within its radial extent and the z tolerance of TrackReachesECAL
+     *
+     *  @param  r the hit distance from the z axis
+     *  @param  z the hit z coordinate
+     *
+     *  @return the layer, -1 if the hit lies on no layer
+     */
+    int GetFtdLayer(const float r, const float z) const;
+
     const Settings          m_settings;                     ///< The track creator settings
     const pandora::Pandora *m_pPandora;                     ///< Address of the pandora object to create tracks and track relationships
+    TraceRecorder          *m_pTraceRecorder;               ///< Address of the trace recorder, NULL when tracing is off
+    PandoraInputRecorder   *m_pInputRecorder;               ///< Address of the input recorder, NULL when recording is off
 
     float             m_bField;                       ///< The bfield
 
@@ -260,20 +459,32 @@ private:
     DoubleVector            m_ftdZPositions;                ///< List of ftd z positions
     unsigned int            m_nFtdLayers;                   ///< Number of ftd layers
     float                   m_tanLambdaFtd;                 ///< Tan lambda for first ftd layer
+    DoubleVector            m_ftdMinTanLambdas;             ///< The lower tan lambda bound of the acceptance of each ftd layer, sorted
+    DoubleVector            m_ftdMaxTanLambdas;             ///< The upper tan lambda bound of the acceptance of each ftd layer, sorted
+    double                  m_ftdZBinMin;                   ///< The |z| of the lower edge of the first ftd layer lookup bin
+    double                  m_ftdZBinInverseWidth;          ///< The inverse width in |z| of the ftd layer lookup bins
+    UIntVector              m_ftdZBinOffsets;               ///< The offset of the candidate layers of each bin, with a final entry for the end
+    UIntVector              m_ftdZBinLayers;                ///< The candidate layers of each bin, in increasing layer order
 
     int               m_eCalBarrelInnerSymmetry;      ///< ECal barrel inner symmetry order
     float             m_eCalBarrelInnerPhi0;          ///< ECal barrel inner phi 0
     float             m_eCalBarrelInnerR;             ///< ECal barrel inner radius
     float             m_eCalEndCapInnerZ;             ///< ECal endcap inner z
+    ECalBarrelFaces         m_eCalBarrelFaces;              ///< The ECal barrel inner face planes
 
     float                   m_minEtdZPosition;              ///< Min etd z position
     float                   m_minSetRadius;                 ///< Min set radius
 
+    TrackStore              m_trackStore;                   ///< Handles to all input tracks, addresses are passed to pandora, capacity reused between events
+    bool                    m_tracksBound;                  ///< Whether the track store has been filled for the current event
+    IdIndexMap              m_trackIds;                     ///< The slot of each track by object id, the store index of the first copy for stored tracks
+    UIntVector              m_trackSlots;                   ///< The slot of each stored track
+    unsigned int            m_nTrackSlots;                  ///< The number of slots, stored tracks first, then other tracks of the vertex collections
+    VertexTopology          m_vertexTopology;               ///< The kink, prong, split and v0 topology, by track slot
+    TrackProjectionColumns  m_projectionColumns;            ///< The helices and candidate ecal faces of the stored tracks
+    pandora::FloatVector    m_genericTimesAtCalorimeter;    ///< The generic time of each stored track at the calorimeter
+    unsigned int            m_nDuplicateTracks;             ///< The number of duplicate tracks of the current event
     TrackVector             m_trackVector;                  ///< The track vector
-    TrackList               m_v0TrackList;                  ///< The list of v0 tracks
-    TrackList               m_parentTrackList;              ///< The list of parent tracks
-    TrackList               m_daughterTrackList;            ///< The list of daughter tracks
-    TrackToPidMap           m_trackToPidMap;                ///< The map from track addresses to particle ids, where set by kinks/V0s
     gear::GearMgr* _GEAR;
 };
 
@@ -286,34 +497,72 @@ inline const TrackVector &TrackCreator::GetTrackVector() const
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+inline unsigned int TrackCreator::GetNDuplicateTracks() const
+{
+    return m_nDuplicateTracks;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const VertexTopology &TrackCreator::GetVertexTopology() const
+{
+    return m_vertexTopology;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const edm4hep::Track *TrackCreator::GetSlotTrack(const unsigned int slot) const
+{
+    return (slot < m_trackStore.size()) ? &m_trackStore[slot] : NULL;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 inline void TrackCreator::Reset()
 {
     m_trackVector.clear();
-    m_v0TrackList.clear();
-    m_parentTrackList.clear();
-    m_daughterTrackList.clear();
-    m_trackToPidMap.clear();
+    m_trackStore.clear();
+    m_tracksBound = false;
+    m_trackIds.Clear();
+    m_trackSlots.clear();
+    m_nTrackSlots = 0;
+    m_vertexTopology.Clear();
+    m_nDuplicateTracks = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void TrackCreator::SetTraceRecorder(TraceRecorder *const pTraceRecorder)
+{
+    m_pTraceRecorder = pTraceRecorder;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void TrackCreator::SetInputRecorder(PandoraInputRecorder *const pInputRecorder)
+{
+    m_pInputRecorder = pInputRecorder;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-inline bool TrackCreator::IsV0(unsigned int pTrack_id) const // should check here, if id is correct one to do this
+inline bool TrackCreator::IsV0(const unsigned char trackFlags)
 {
-    return (m_v0TrackList.end() != m_v0TrackList.find(pTrack_id));
+    return (0 != (trackFlags & VertexTopology::V0_TRACK));
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-inline bool TrackCreator::IsParent(unsigned int pTrack_id) const
+inline bool TrackCreator::IsParent(const unsigned char trackFlags)
 {
-    return (m_parentTrackList.end() != m_parentTrackList.find(pTrack_id));
+    return (0 != (trackFlags & VertexTopology::PARENT_TRACK));
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-inline bool TrackCreator::IsDaughter(unsigned int pTrack_id) const
+inline bool TrackCreator::IsDaughter(const unsigned char trackFlags)
 {
-    return (m_daughterTrackList.end() != m_daughterTrackList.find(pTrack_id));
+    return (0 != (trackFlags & VertexTopology::DAUGHTER_TRACK));
 }
 
 #endif // #ifndef TRACK_CREATOR_H
@@ -0,0 +1,335 @@
+/**
+ *
+ *  @brief  Header file for the vertex topology class.
+ *
+ *  $Log: $
+ */
+
+#ifndef VERTEX_TOPOLOGY_H
+#define VERTEX_TOPOLOGY_H 1
+
+#include <utility>
+#include <vector>
+
+/**
+ *  @brief  VertexTopology class, the track relationships of the kink, prong, split and v0 vertices of an event. Tracks are named
+ *          by dense slots, assigned by the track creator. The vertices of all collections are added first; resolving then accepts
+ *          them in the order they were added, rejecting any vertex with a track that an accepted vertex already uses, and fills the
+ *          per slot flags and particle ids and the parent, daughter and sibling graph, stored as offset and slot arrays.
+ */
+class VertexTopology
+{
+public:
+    /**
+     *  @brief  The vertex types
+     */
+    enum VertexType
+    {
+        KINK_VERTEX,                        ///< A kink, the first track is the parent of the others, which carry particle ids
+        PRONG_SPLIT_VERTEX,                 ///< A prong or split, the first track is the parent of the others
+        V0_VERTEX                           ///< A v0, all tracks are siblings and carry particle ids
+    };
+
+    /**
+     *  @brief  The flags of a track slot, one bit each
+     */
+    enum TrackFlag
+    {
+        PARENT_TRACK = 1,                   ///< The parent track of an accepted kink, prong or split vertex
+        DAUGHTER_TRACK = 2,                 ///< A daughter track of an accepted kink, prong or split vertex
+        V0_TRACK = 4,                       ///< A track of an accepted v0 vertex
+        HAS_PARTICLE_ID = 8                 ///< The track has a particle id from an accepted kink or v0 vertex
+    };
+
+    /**
+     *  @brief  SlotRange class, the slots adjacent to a slot in the relationship graph
+     */
+    class SlotRange
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  pBegin address of the first slot
+         *  @param  pEnd address past the last slot
+         */
+        SlotRange(const unsigned int *const pBegin, const unsigned int *const pEnd);
+
+        const unsigned int *begin() const;
+        const unsigned int *end() const;
+        unsigned int size() const;
+
+    private:
+        const unsigned int     *m_pBegin;                       ///< Address of the first slot
+        const unsigned int     *m_pEnd;                         ///< Address past the last slot
+    };
+
+    /**
+     *  @brief  Default constructor, an empty topology
+     */
+    VertexTopology();
+
+    /**
+     *  @brief  Remove all vertices and relationships, keeping the capacity
+     */
+    void Clear();
+
+    /**
+     *  @brief  Start adding a vertex, whose tracks follow in order
+     *
+     *  @param  vertexType the vertex type
+     */
+    void BeginVertex(const VertexType vertexType);
+
+    /**
+     *  @brief  Add a track to the vertex being added
+     *
+     *  @param  slot the track slot
+     *  @param  particleId the particle id the vertex implies for the track, ignored for prong and split vertices
+     */
+    void AddVertexTrack(const unsigned int slot, const int particleId);
+
+    /**
+     *  @brief  Complete the vertex being added
+     */
+    void EndVertex();
+
+    /**
+     *  @brief  Drop the vertex being added, with the tracks added to it so far
+     */
+    void DiscardVertex();
+
+    /**
+     *  @brief  Accept the vertices in the order they were added and build the flags, particle ids and relationship graph
+     *
+     *  @param  nSlots the number of track slots
+     */
+    void Resolve(const unsigned int nSlots);
+
+    /**
+     *  @brief  Get the number of vertices added
+     *
+     *  @return the number of vertices
+     */
+    unsigned int GetNVertices() const;
+
+    /**
+     *  @brief  Get the number of vertices accepted by the last resolve
+     *
+     *  @return the number of accepted vertices
+     */
+    unsigned int GetNAcceptedVertices() const;
+
+    /**
+     *  @brief  Get the number of track slots of the last resolve
+     *
+     *  @return the number of slots
+     */
+    unsigned int GetNSlots() const;
+
+    /**
+     *  @brief  Get the flags of a track slot
+     *
+     *  @param  slot the track slot
+     *
+     *  @return the track flags, zero for slots beyond those of the last resolve
+     */
+    unsigned char GetTrackFlags(const unsigned int slot) const;
+
+    /**
+     *  @brief  Get the particle id of a track slot, the one of the first accepted kink or v0 vertex using it
+     *
+     *  @param  slot the track slot
+     *  @param  particleId to receive the particle id, if the slot has one
+     *
+     *  @return whether the slot has a particle id
+     */
+    bool GetTrackParticleId(const unsigned int slot, int &particleId) const;
+
+    /**
+     *  @brief  Get the parents of a track slot
+     *
+     *  @param  slot the track slot, below the number of slots
+     *
+     *  @return the parent slots
+     */
+    SlotRange GetParents(const unsigned int slot) const;
+
+    /**
+     *  @brief  Get the daughters of a track slot
+     *
+     *  @param  slot the track slot, below the number of slots
+     *
+     *  @return the daughter slots
+     */
+    SlotRange GetDaughters(const unsigned int slot) const;
+
+    /**
+     *  @brief  Get the siblings of a track slot
+     *
+     *  @param  slot the track slot, below the number of slots
+     *
+     *  @return the sibling slots
+     */
+    SlotRange GetSiblings(const unsigned int slot) const;
+
+private:
+    typedef std::vector<unsigned int> UIntVector;
+    typedef std::vector<int> IntVector;
+    typedef std::vector<unsigned char> UCharVector;
+    typedef std::vector<VertexType> VertexTypeVector;
+    typedef std::pair<unsigned int, unsigned int> SlotPair;
+    typedef std::vector<SlotPair> SlotPairVector;
+
+    /**
+     *  @brief  Fill the offset and adjacent slot arrays of a graph from its slot pairs, keeping the pair order for each slot
+     *
+     *  @param  slotPairs the slot pairs
+     *  @param  addForward whether the second slot of a pair is adjacent to the first
+     *  @param  addReverse whether the first slot of a pair is adjacent to the second
+     *  @param  offsets to receive the offset of the adjacent slots of each slot, with a final entry for the end
+     *  @param  adjacentSlots to receive the adjacent slots
+     */
+    void FillAdjacency(const SlotPairVector &slotPairs, const bool addForward, const bool addReverse, UIntVector &offsets,
+        UIntVector &adjacentSlots);
+
+    VertexTypeVector                    m_vertexTypes;              ///< The type of each vertex
+    UIntVector                          m_vertexOffsets;            ///< The offset of the tracks of each vertex, with a final entry for the end
+    UIntVector                          m_vertexTrackSlots;         ///< The slot of each vertex track
+    IntVector                           m_vertexTrackParticleIds;   ///< The particle id implied for each vertex track
+    unsigned int                        m_nAcceptedVertices;        ///< The number of vertices accepted by the last resolve
+
+    UCharVector                         m_trackFlags;               ///< The flags of each slot
+    IntVector                           m_trackParticleIds;         ///< The particle id of each slot, where flagged
+    SlotPairVector                      m_parentDaughterPairs;      ///< The parent and daughter slot of each parent daughter relationship
+    SlotPairVector                      m_siblingPairs;             ///< The slots of each sibling relationship
+    UIntVector                          m_parentOffsets;            ///< The offset of the parents of each slot, with a final entry for the end
+    UIntVector                          m_parentSlots;              ///< The parent slots
+    UIntVector                          m_daughterOffsets;          ///< The offset of the daughters of each slot, with a final entry for the end
+    UIntVector                          m_daughterSlots;            ///< The daughter slots
+    UIntVector                          m_siblingOffsets;           ///< The offset of the siblings of each slot, with a final entry for the end
+    UIntVector                          m_siblingSlots;             ///< The sibling slots
+    UIntVector                          m_fillPositions;            ///< Scratch fill position of each slot, while filling a graph
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline VertexTopology::SlotRange::SlotRange(const unsigned int *const pBegin, const unsigned int *const pEnd) :
+    m_pBegin(pBegin),
+    m_pEnd(pEnd)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const unsigned int *VertexTopology::SlotRange::begin() const
+{
+    return m_pBegin;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const unsigned int *VertexTopology::SlotRange::end() const
+{
+    return m_pEnd;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int VertexTopology::SlotRange::size() const
+{
+    return m_pEnd - m_pBegin;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void VertexTopology::BeginVertex(const VertexType vertexType)
+{
+    m_vertexTypes.push_back(vertexType);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void VertexTopology::AddVertexTrack(const unsigned int slot, const int particleId)
+{
+    m_vertexTrackSlots.push_back(slot);
+    m_vertexTrackParticleIds.push_back(particleId);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void VertexTopology::EndVertex()
+{
+    m_vertexOffsets.push_back(m_vertexTrackSlots.size());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void VertexTopology::DiscardVertex()
+{
+    m_vertexTypes.pop_back();
+    m_vertexTrackSlots.resize(m_vertexOffsets.back());
+    m_vertexTrackParticleIds.resize(m_vertexOffsets.back());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int VertexTopology::GetNVertices() const
+{
+    return m_vertexTypes.size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int VertexTopology::GetNAcceptedVertices() const
+{
+    return m_nAcceptedVertices;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int VertexTopology::GetNSlots() const
+{
+    return m_trackFlags.size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned char VertexTopology::GetTrackFlags(const unsigned int slot) const
+{
+    return (slot < m_trackFlags.size()) ? m_trackFlags[slot] : 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool VertexTopology::GetTrackParticleId(const unsigned int slot, int &particleId) const
+{
+    if (0 == (this->GetTrackFlags(slot) & HAS_PARTICLE_ID))
+        return false;
+
+    particleId = m_trackParticleIds[slot];
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline VertexTopology::SlotRange VertexTopology::GetParents(const unsigned int slot) const
+{
+    return SlotRange(m_parentSlots.data() + m_parentOffsets[slot], m_parentSlots.data() + m_parentOffsets[slot + 1]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline VertexTopology::SlotRange VertexTopology::GetDaughters(const unsigned int slot) const
+{
+    return SlotRange(m_daughterSlots.data() + m_daughterOffsets[slot], m_daughterSlots.data() + m_daughterOffsets[slot + 1]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline VertexTopology::SlotRange VertexTopology::GetSiblings(const unsigned int slot) const
+{
+    return SlotRange(m_siblingSlots.data() + m_siblingOffsets[slot], m_siblingSlots.data() + m_siblingOffsets[slot + 1]);
+}
+
+#endif // #ifndef VERTEX_TOPOLOGY_H
@@ -0,0 +1,89 @@
+/**
+ *
+ *  @brief  Header file for the worker pool class.
+ *
+ *  $Log: $
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H 1
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ *  @brief  WorkerPool class, a fixed set of threads that run the numbered tasks of one job at a time. The thread calling Run takes
+ *          tasks too and returns once all tasks of the job have finished, so the pool adds no ordering of its own: callers write
+ *          each task's result to its own slot and consume the slots in task order afterwards.
+ */
+class WorkerPool
+{
+public:
+    typedef std::function<void(const unsigned int)> Task;
+
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  nThreads the number of threads running tasks, including the calling thread, so one means no worker threads
+     */
+    explicit WorkerPool(const unsigned int nThreads);
+
+    /**
+     *  @brief  Destructor, stops and joins the worker threads
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /**
+     *  @brief  Get the number of threads running tasks, including the calling thread
+     *
+     *  @return the number of threads
+     */
+    unsigned int GetNThreads() const;
+
+    /**
+     *  @brief  Run task(0) .. task(nTasks - 1) on the pool and the calling thread, returning when all have finished. The task
+     *          must not throw, and a pool runs one job at a time, so Run must not be called concurrently or from within a task.
+     *
+     *  @param  nTasks the number of tasks
+     *  @param  task the task, called once with each task number
+     */
+    void Run(const unsigned int nTasks, const Task &task);
+
+private:
+    /**
+     *  @brief  The loop of each worker thread, taking tasks of each new job until the pool is stopped
+     */
+    void WorkerLoop();
+
+    /**
+     *  @brief  Take and run tasks of the current job until none are left
+     */
+    void RunTasks();
+
+    std::vector<std::thread>            m_threads;                  ///< The worker threads
+    std::mutex                          m_mutex;                    ///< Guards the job description and the busy count
+    std::condition_variable             m_jobStarted;               ///< Signalled when a job is started or the pool is stopped
+    std::condition_variable             m_jobFinished;              ///< Signalled when the last busy worker finishes its tasks
+    const Task                         *m_pTask;                    ///< The task of the current job
+    unsigned int                        m_nTasks;                   ///< The number of tasks of the current job
+    std::atomic<unsigned int>           m_nextTask;                 ///< The number of the next task to be taken
+    unsigned int                        m_nBusyWorkers;             ///< The number of workers still running tasks of the current job
+    unsigned long                       m_jobNumber;                ///< Incremented per job, so that each worker joins each job once
+    bool                                m_isStopping;               ///< Whether the worker threads should exit
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int WorkerPool::GetNThreads() const
+{
+    return m_threads.size() + 1;
+}
+
+#endif // #ifndef WORKER_POOL_H
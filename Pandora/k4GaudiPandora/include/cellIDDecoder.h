@@ -74,11 +74,12 @@ namespace ID_UTIL{
     
     /** Provides access to the bit fields, e.g. <br>
      *   int layer =  myCellIDEncoding( hit )[ "layer" ] ;
-     * 
+     *  The decoded value is cached on the cell id, not on the hit address, as callers may pass
+     *  short-lived handles that reuse the same address for different hits.
      */
     inline const UTIL::BitField64 & operator()( const T* hit ){  
       
-      if( hit != _oldHit && hit ) {
+      if( hit && ( !_oldHit || hit->getCellID() != _oldCellID ) ) {
 	auto id = hit->getCellID();
         unsigned int id0 = id&0xFFFFFFFF;
         unsigned int id1 = id>>32;
@@ -88,6 +89,7 @@ namespace ID_UTIL{
 	_b->setValue( val ) ;
 
 	_oldHit = hit ;
+	_oldCellID = id ;
       }
       
       return  *_b ;
@@ -105,6 +107,7 @@ namespace ID_UTIL{
   protected:
     UTIL::BitField64* _b{} ;
     const T* _oldHit{NULL} ;
+    unsigned long long _oldCellID{0} ;
     
     static std::string _defaultEncoding;
   } ; 
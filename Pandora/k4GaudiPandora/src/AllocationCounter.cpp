@@ -0,0 +1,81 @@
+/**
+ *
+ *  @brief  Implementation of the allocation counter class.
+ *
+ *  $Log: $
+ */
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<unsigned long> g_nAllocations(0);
+
+unsigned long AllocationCounter::GetNAllocations()
+{
+    return g_nAllocations.load(std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void *operator new(std::size_t size)
+{
+    g_nAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *const pMemory = std::malloc(size ? size : 1))
+        return pMemory;
+
+    throw std::bad_alloc();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    g_nAllocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void *operator new[](std::size_t size, const std::nothrow_t &nothrow) noexcept
+{
+    return ::operator new(size, nothrow);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void operator delete(void *pMemory) noexcept
+{
+    std::free(pMemory);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void operator delete[](void *pMemory) noexcept
+{
+    std::free(pMemory);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void operator delete(void *pMemory, std::size_t) noexcept
+{
+    std::free(pMemory);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void operator delete[](void *pMemory, std::size_t) noexcept
+{
+    std::free(pMemory);
+}
@@ -0,0 +1,167 @@
+/**
+ *
+ *  @brief  Implementation of the benchmark baseline class.
+ *
+ *  $Log: $
+ */
+
+#include "BenchmarkBaseline.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+BenchmarkBaseline::BenchmarkBaseline(const std::string &unit) :
+    m_unit(unit)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkBaseline::SetEntry(const std::string &name, const double time, const double allocations)
+{
+    Entry &entry(m_entries[name]);
+    entry.m_time = time;
+    entry.m_allocations = allocations;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool BenchmarkBaseline::WriteJson(const std::string &fileName) const
+{
+    std::ofstream file(fileName.c_str());
+
+    if (!file.good())
+        return false;
+
+    file << std::setprecision(std::numeric_limits<double>::max_digits10);
+    file << "{" << std::endl << "  \"unit\": \"" << m_unit << "\"," << std::endl << "  \"entries\": {";
+
+    for (EntryMap::const_iterator iter = m_entries.begin(); iter != m_entries.end(); ++iter)
+    {
+        file << ((m_entries.begin() == iter) ? "" : ",") << std::endl
+             << "    \"" << iter->first << "\": {"
+             << "\"time\": " << iter->second.m_time
+             << ", \"allocations\": " << iter->second.m_allocations << "}";
+    }
+
+    file << std::endl << "  }" << std::endl << "}" << std::endl;
+
+    return file.good();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool BenchmarkBaseline::ReadJson(const std::string &fileName)
+{
+    std::ifstream file(fileName.c_str());
+
+    if (!file.good())
+        return false;
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string content(buffer.str());
+
+    // Only the layout written by WriteJson is understood: a unit string, then one flat object per entry
+    const std::string::size_type unitKey(content.find("\"unit\""));
+    const std::string::size_type unitStart((std::string::npos == unitKey) ? std::string::npos : content.find('"', content.find(':', unitKey)));
+    const std::string::size_type unitEnd((std::string::npos == unitStart) ? std::string::npos : content.find('"', unitStart + 1));
+
+    if ((std::string::npos == unitEnd) || (content.substr(unitStart + 1, unitEnd - unitStart - 1) != m_unit))
+    {
+        std::cout << "BenchmarkBaseline: " << fileName << " is not a baseline in units of " << m_unit << std::endl;
+        return false;
+    }
+
+    const std::string::size_type entriesKey(content.find("\"entries\""));
+
+    if (std::string::npos == entriesKey)
+        return false;
+
+    m_entries.clear();
+    std::string::size_type position(content.find('{', entriesKey));
+
+    while (std::string::npos != position)
+    {
+        const std::string::size_type nameStart(content.find('"', position + 1));
+
+        if (std::string::npos == nameStart)
+            break;
+
+        const std::string::size_type nameEnd(content.find('"', nameStart + 1));
+        const std::string::size_type objectStart(content.find('{', nameEnd));
+        const std::string::size_type objectEnd(content.find('}', objectStart));
+
+        if ((std::string::npos == nameEnd) || (std::string::npos == objectStart) || (std::string::npos == objectEnd))
+            return false;
+
+        const std::string object(content.substr(objectStart, objectEnd - objectStart));
+        const std::string::size_type timeKey(object.find("\"time\"")), allocationsKey(object.find("\"allocations\""));
+
+        if ((std::string::npos == timeKey) || (std::string::npos == allocationsKey))
+            return false;
+
+        this->SetEntry(content.substr(nameStart + 1, nameEnd - nameStart - 1), std::atof(object.c_str() + object.find(':', timeKey) + 1),
+            std::atof(object.c_str() + object.find(':', allocationsKey) + 1));
+
+        position = objectEnd;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+unsigned int BenchmarkBaseline::Compare(const BenchmarkBaseline &reference, const Settings &settings) const
+{
+    unsigned int nRegressions(0);
+
+    const bool isTimeCompared(settings.m_timeTolerance >= 0.);
+
+    std::cout << "Comparison with baseline, time tolerance ";
+
+    if (isTimeCompared)
+        std::cout << 100. * settings.m_timeTolerance << "%";
+    else
+        std::cout << "off";
+
+    std::cout << ", allocation tolerance " << 100. * settings.m_allocationTolerance << "%" << std::endl;
+
+    for (const EntryMap::value_type &referenceEntry : reference.GetEntries())
+    {
+        const EntryMap::const_iterator iter(m_entries.find(referenceEntry.first));
+
+        if (m_entries.end() == iter)
+        {
+            std::cout << "REGRESSION " << referenceEntry.first << ": not measured" << std::endl;
+            ++nRegressions;
+            continue;
+        }
+
+        const Entry &before(referenceEntry.second), &after(iter->second);
+
+        const bool isTimeRegression(isTimeCompared && (after.m_time > before.m_time * (1. + settings.m_timeTolerance)) &&
+            (after.m_time - before.m_time > settings.m_minTimeIncrease));
+        const bool isAllocationRegression((after.m_allocations > before.m_allocations * (1. + settings.m_allocationTolerance)) &&
+            (after.m_allocations - before.m_allocations >= settings.m_minAllocationIncrease));
+
+        std::cout << (isTimeRegression || isAllocationRegression ? "REGRESSION " : "    ") << referenceEntry.first << ": time "
+                  << before.m_time << " -> " << after.m_time << " " << m_unit << (isTimeRegression ? " (too slow)" : "") << ", allocations "
+                  << before.m_allocations << " -> " << after.m_allocations << (isAllocationRegression ? " (too many)" : "") << std::endl;
+
+        if (isTimeRegression || isAllocationRegression)
+            ++nRegressions;
+    }
+
+    for (const EntryMap::value_type &entry : m_entries)
+    {
+        if (reference.GetEntries().end() == reference.GetEntries().find(entry.first))
+            std::cout << "    " << entry.first << ": not in baseline" << std::endl;
+    }
+
+    return nRegressions;
+}
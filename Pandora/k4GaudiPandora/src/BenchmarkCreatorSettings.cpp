@@ -0,0 +1,88 @@
+/**
+ *
+ *  @brief  Implementation of the benchmark creator settings class.
+ *
+ *  $Log: $
+ */
+
+#include "BenchmarkCreatorSettings.h"
+
+BenchmarkCreatorSettings::BenchmarkCreatorSettings(const SyntheticEventGenerator::Settings &generatorSettings, const float innerBField)
+{
+    // The generator writes only the collections below; vertex collections are left out, as in events without a vertex finder
+    m_trackCreatorSettings.m_trackCollections.push_back(generatorSettings.m_trackCollectionName);
+    m_caloHitCreatorSettings.m_eCalCaloHitCollections.push_back(generatorSettings.m_caloHitCollectionNames[SyntheticEventGenerator::ECAL_BARREL]);
+    m_caloHitCreatorSettings.m_eCalCaloHitCollections.push_back(generatorSettings.m_caloHitCollectionNames[SyntheticEventGenerator::ECAL_ENDCAP]);
+    m_caloHitCreatorSettings.m_hCalCaloHitCollections.push_back(generatorSettings.m_caloHitCollectionNames[SyntheticEventGenerator::HCAL_BARREL]);
+    m_caloHitCreatorSettings.m_hCalCaloHitCollections.push_back(generatorSettings.m_caloHitCollectionNames[SyntheticEventGenerator::HCAL_ENDCAP]);
+    m_mcParticleCreatorSettings.m_mcParticleCollections.push_back(generatorSettings.m_mcParticleCollectionName);
+    m_mcParticleCreatorSettings.m_CaloHitRelationCollections.push_back(generatorSettings.m_caloHitRelationCollectionName);
+    m_mcParticleCreatorSettings.m_TrackRelationCollections.push_back(generatorSettings.m_trackerHitRelationCollectionName);
+    m_mcParticleCreatorSettings.m_bField = innerBField;
+
+    m_geometryCreatorSettings.m_absorberRadLengthECal = generatorSettings.m_absorberRadLengthECal;
+    m_geometryCreatorSettings.m_absorberIntLengthECal = generatorSettings.m_absorberIntLengthECal;
+    m_geometryCreatorSettings.m_absorberRadLengthHCal = generatorSettings.m_absorberRadLengthHCal;
+    m_geometryCreatorSettings.m_absorberIntLengthHCal = generatorSettings.m_absorberIntLengthHCal;
+    m_geometryCreatorSettings.m_absorberRadLengthOther = 0.0569f;
+    m_geometryCreatorSettings.m_absorberIntLengthOther = 0.006f;
+
+    m_caloHitCreatorSettings.m_absorberRadLengthECal = m_geometryCreatorSettings.m_absorberRadLengthECal;
+    m_caloHitCreatorSettings.m_absorberIntLengthECal = m_geometryCreatorSettings.m_absorberIntLengthECal;
+    m_caloHitCreatorSettings.m_absorberRadLengthHCal = m_geometryCreatorSettings.m_absorberRadLengthHCal;
+    m_caloHitCreatorSettings.m_absorberIntLengthHCal = m_geometryCreatorSettings.m_absorberIntLengthHCal;
+    m_caloHitCreatorSettings.m_absorberRadLengthOther = m_geometryCreatorSettings.m_absorberRadLengthOther;
+    m_caloHitCreatorSettings.m_absorberIntLengthOther = m_geometryCreatorSettings.m_absorberIntLengthOther;
+    m_caloHitCreatorSettings.m_hCalEndCapInnerSymmetryOrder = m_geometryCreatorSettings.m_hCalEndCapInnerSymmetryOrder;
+    m_caloHitCreatorSettings.m_hCalEndCapInnerPhiCoordinate = m_geometryCreatorSettings.m_hCalEndCapInnerPhiCoordinate;
+
+    // The mip calibrations match the mip energies of the generator
+    m_caloHitCreatorSettings.m_eCalToMip = 1.f / generatorSettings.m_eCalMipEnergy;
+    m_caloHitCreatorSettings.m_hCalToMip = 1.f / generatorSettings.m_hCalMipEnergy;
+    m_caloHitCreatorSettings.m_eCalMipThreshold = 0.5f;
+    m_caloHitCreatorSettings.m_hCalMipThreshold = 0.3f;
+    m_caloHitCreatorSettings.m_muonToMip = 10.f;
+    m_caloHitCreatorSettings.m_eCalToEMGeV = 1.007f;
+    m_caloHitCreatorSettings.m_hCalToEMGeV = 1.007f;
+    m_caloHitCreatorSettings.m_eCalToHadGeVEndCap = 1.12f;
+    m_caloHitCreatorSettings.m_eCalToHadGeVBarrel = 1.12f;
+    m_caloHitCreatorSettings.m_hCalToHadGeV = 1.07f;
+    m_caloHitCreatorSettings.m_muonDigitalHits = 0;
+    m_caloHitCreatorSettings.m_muonHitEnergy = 0.5f;
+    m_caloHitCreatorSettings.m_maxHCalHitHadronicEnergy = 1.f;
+    m_caloHitCreatorSettings.m_nOuterSamplingLayers = 3;
+    m_caloHitCreatorSettings.m_layersFromEdgeMaxRearDistance = 250.f;
+
+    m_trackCreatorSettings.m_shouldFormTrackRelationships = 1;
+    m_trackCreatorSettings.m_minTrackHits = 5;
+    m_trackCreatorSettings.m_minFtdTrackHits = 0;
+    m_trackCreatorSettings.m_maxTrackHits = 5000;
+    m_trackCreatorSettings.m_d0TrackCut = 50.f;
+    m_trackCreatorSettings.m_z0TrackCut = 50.f;
+    m_trackCreatorSettings.m_usingNonVertexTracks = 1;
+    m_trackCreatorSettings.m_usingUnmatchedNonVertexTracks = 0;
+    m_trackCreatorSettings.m_usingUnmatchedVertexTracks = 1;
+    m_trackCreatorSettings.m_unmatchedVertexTrackMaxEnergy = 5.f;
+    m_trackCreatorSettings.m_d0UnmatchedVertexTrackCut = 5.f;
+    m_trackCreatorSettings.m_z0UnmatchedVertexTrackCut = 5.f;
+    m_trackCreatorSettings.m_zCutForNonVertexTracks = 250.f;
+    m_trackCreatorSettings.m_reachesECalNTpcHits = 11;
+    m_trackCreatorSettings.m_reachesECalNFtdHits = 4;
+    m_trackCreatorSettings.m_reachesECalTpcOuterDistance = -100.f;
+    m_trackCreatorSettings.m_reachesECalMinFtdLayer = 9;
+    m_trackCreatorSettings.m_reachesECalTpcZMaxDistance = -50.f;
+    m_trackCreatorSettings.m_reachesECalFtdZMaxDistance = -1.f;
+    m_trackCreatorSettings.m_curvatureToMomentumFactor = 0.3f / 2000.f;
+    m_trackCreatorSettings.m_minTrackECalDistanceFromIp = 100.f;
+    m_trackCreatorSettings.m_maxTrackSigmaPOverP = 0.15f;
+    m_trackCreatorSettings.m_minMomentumForTrackHitChecks = 1.f;
+    m_trackCreatorSettings.m_tpcMembraneMaxZ = 10.f;
+    m_trackCreatorSettings.m_minTpcHitFractionOfExpected = 0.2f;
+    m_trackCreatorSettings.m_minFtdHitsForTpcHitFraction = 2;
+    m_trackCreatorSettings.m_maxTpcInnerRDistance = 50.f;
+
+    m_pfoCreatorSettings.m_clusterCollectionName = "PandoraClusters";
+    m_pfoCreatorSettings.m_pfoCollectionName = "PandoraPFOs";
+    m_pfoCreatorSettings.m_startVertexCollectionName = "PandoraPFANewStartVertices";
+    m_pfoCreatorSettings.m_startVertexAlgName = "PandoraPFANew";
+}
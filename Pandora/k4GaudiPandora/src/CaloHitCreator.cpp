@@ -15,21 +15,152 @@
 #include "gear/PadRowLayout2D.h"
 #include "gear/LayerLayout.h"
 
-#include "cellIDDecoder.h"
-#include "GaudiKernel/IService.h"
-#include "GearSvc/IGearSvc.h"
-
-#include "PandoraPFAlg.h"
+#include "CollectionMaps.h"
 #include "CaloHitCreator.h"
+#include "PandoraInputRecorder.h"
+#include "TraceRecorder.h"
+#include "WorkerPool.h"
 
 #include <algorithm>
 #include <cmath>
 #include <limits>
 
+namespace
+{
+    const float SPEED_OF_LIGHT = 299.792458f;   ///< The speed of light, units mm/ns
+
+    /**
+     *  @brief  How a subdetector assigns its hits to the barrel or endcap region
+     */
+    enum RegionRule
+    {
+        BARREL_OR_ENDCAP,                   ///< Barrel below the barrel outer z, endcap beyond
+        BARREL_PLUG_OR_ENDCAP,              ///< As above, but barrel hits within the coil belong to the endcap plug
+        ENDCAP_ONLY                         ///< Every hit is an endcap hit
+    };
+
+    /**
+     *  @brief  How the barrel stave number is obtained from the stave field of the cell id
+     */
+    enum StaveRule
+    {
+        STAVE_FROM_CELL_ID,                 ///< The stave field is the stave number
+        STAVE_FROM_HALF_CELL_ID             ///< Two stave field values per stave, counted down from the symmetry order
+    };
+
+    /**
+     *  @brief  How hits are flagged as outer sampling layer hits
+     */
+    enum OuterSamplingRule
+    {
+        NEVER_OUTER,                        ///< No hit is in an outer sampling layer
+        OUTER_FROM_EDGE,                    ///< Hits within the configured number of layers from the edge are outer layer hits
+        ALWAYS_OUTER                        ///< Every hit is in an outer sampling layer
+    };
+
+    /**
+     *  @brief  How the pandora energies of a hit are obtained
+     */
+    enum EnergyModel
+    {
+        CALIBRATED_ENERGY,                  ///< Calibrated deposited energy, with a mip threshold
+        DIGITAL_OR_ANALOGUE_ENERGY          ///< Fixed energy per hit if the binding is digital, else the deposited energy; no threshold
+    };
+
+    /**
+     *  @brief  ECalTraits class
+     */
+    class ECalTraits
+    {
+    public:
+        static const pandora::HitType       HIT_TYPE = pandora::ECAL;
+        static const int                    LAYER_OFFSET = 1;
+        static const RegionRule             REGION_RULE = BARREL_OR_ENDCAP;
+        static const StaveRule              STAVE_RULE = STAVE_FROM_CELL_ID;
+        static const OuterSamplingRule      OUTER_SAMPLING_RULE = NEVER_OUTER;
+        static const EnergyModel            ENERGY_MODEL = CALIBRATED_ENERGY;
+        static const char *GetHitName() { return "ecal calo hit"; }
+        static const char *GetTraceName() { return "CreateECalCaloHits"; }
+    };
+
+    /**
+     *  @brief  HCalTraits class
+     */
+    class HCalTraits
+    {
+    public:
+        static const pandora::HitType       HIT_TYPE = pandora::HCAL;
+        static const int                    LAYER_OFFSET = 0;
+        static const RegionRule             REGION_RULE = BARREL_OR_ENDCAP;
+        static const StaveRule              STAVE_RULE = STAVE_FROM_HALF_CELL_ID;
+        static const OuterSamplingRule      OUTER_SAMPLING_RULE = OUTER_FROM_EDGE;
+        static const EnergyModel            ENERGY_MODEL = CALIBRATED_ENERGY;
+        static const char *GetHitName() { return "hcal calo hit"; }
+        static const char *GetTraceName() { return "CreateHCalCaloHits"; }
+    };
+
+    /**
+     *  @brief  MuonTraits class
+     */
+    class MuonTraits
+    {
+    public:
+        static const pandora::HitType       HIT_TYPE = pandora::MUON;
+        static const int                    LAYER_OFFSET = 1;
+        static const RegionRule             REGION_RULE = BARREL_PLUG_OR_ENDCAP;
+        static const StaveRule              STAVE_RULE = STAVE_FROM_CELL_ID;
+        static const OuterSamplingRule      OUTER_SAMPLING_RULE = ALWAYS_OUTER;
+        static const EnergyModel            ENERGY_MODEL = DIGITAL_OR_ANALOGUE_ENERGY;
+        static const char *GetHitName() { return "muon hit"; }
+        static const char *GetTraceName() { return "CreateMuonCaloHits"; }
+    };
+
+    /**
+     *  @brief  LCalTraits class
+     */
+    class LCalTraits
+    {
+    public:
+        static const pandora::HitType       HIT_TYPE = pandora::ECAL;
+        static const int                    LAYER_OFFSET = 0;
+        static const RegionRule             REGION_RULE = ENDCAP_ONLY;
+        static const StaveRule              STAVE_RULE = STAVE_FROM_CELL_ID;
+        static const OuterSamplingRule      OUTER_SAMPLING_RULE = NEVER_OUTER;
+        static const EnergyModel            ENERGY_MODEL = CALIBRATED_ENERGY;
+        static const char *GetHitName() { return "lcal calo hit"; }
+        static const char *GetTraceName() { return "CreateLCalCaloHits"; }
+    };
+
+    /**
+     *  @brief  LHCalTraits class
+     */
+    class LHCalTraits
+    {
+    public:
+        static const pandora::HitType       HIT_TYPE = pandora::HCAL;
+        static const int                    LAYER_OFFSET = 0;
+        static const RegionRule             REGION_RULE = ENDCAP_ONLY;
+        static const StaveRule              STAVE_RULE = STAVE_FROM_CELL_ID;
+        static const OuterSamplingRule      OUTER_SAMPLING_RULE = OUTER_FROM_EDGE;
+        static const EnergyModel            ENERGY_MODEL = CALIBRATED_ENERGY;
+        static const char *GetHitName() { return "lhcal calo hit"; }
+        static const char *GetTraceName() { return "CreateLHCalCaloHits"; }
+    };
+}
+
 
-CaloHitCreator::CaloHitCreator(const Settings &settings, const pandora::Pandora *const pPandora, ISvcLocator* svcloc, bool encoder_style) :
+CaloHitCreator::CaloHitCreator(const Settings &settings, const pandora::Pandora *const pPandora, gear::GearMgr *const pGearMgr, bool encoder_style) :
     m_settings(settings),
-    m_pPandora(pPandora)
+    m_pPandora(pPandora),
+    m_pTraceRecorder(NULL),
+    m_pInputRecorder(NULL),
+    m_pWorkerPool(NULL),
+    m_nMaskedCaloHits(0),
+    m_nBelowCellThresholdCaloHits(0),
+    m_nOutOfTimeCaloHits(0),
+    m_nMergedCaloHits(0),
+    m_nDuplicateCaloHits(0),
+    _GEAR(pGearMgr)
 {
     m_encoder_str = ""; 
     m_encoder_str_MUON = ""; 
@@ -42,19 +173,12 @@ CaloHitCreator::CaloHitCreator(const Settings &settings, const pandora::Pandora
         m_encoder_str_LCal="I:10,J:10,K:10,S-1:2";
         m_encoder_str_LHCal=m_encoder_str;
     }
-    IGearSvc*  iSvc = 0;
-    StatusCode sc = svcloc->service("GearSvc", iSvc, false);
-    if ( !sc ) 
-    {
-        throw "Failed to find GearSvc ...";
-    }
-    _GEAR = iSvc->getGearMgr();
-
 
     m_eCalBarrelOuterZ        = (_GEAR->getEcalBarrelParameters().getExtent()[3]);
     m_hCalBarrelOuterZ        = (_GEAR->getHcalBarrelParameters().getExtent()[3]);
     m_muonBarrelOuterZ        = (_GEAR->getYokeBarrelParameters().getExtent()[3]);
     m_coilOuterR              = (_GEAR->getGearParameters("CoilParameters").getDoubleVal("Coil_cryostat_outer_radius"));
+    m_maxTimeOfFlight         = std::numeric_limits<float>::max();
     m_eCalBarrelInnerPhi0     = (_GEAR->getEcalBarrelParameters().getPhi0());
     m_eCalBarrelInnerSymmetry = (_GEAR->getEcalBarrelParameters().getSymmetryOrder());
     m_hCalBarrelInnerPhi0     = (_GEAR->getHcalBarrelParameters().getPhi0());
@@ -83,333 +207,621 @@ CaloHitCreator::CaloHitCreator(const Settings &settings, const pandora::Pandora
     if ((m_hCalEndCapLayerThickness < std::numeric_limits<float>::epsilon()) || (m_hCalBarrelLayerThickness < std::numeric_limits<float>::epsilon()))
         throw pandora::StatusCodeException(pandora::STATUS_CODE_INVALID_PARAMETER);
 
+    m_eCalBarrelInnerPolygon = PolygonNormals(m_eCalBarrelInnerSymmetry, m_eCalBarrelInnerPhi0);
+    m_hCalBarrelInnerPolygon = PolygonNormals(m_hCalBarrelInnerSymmetry, m_hCalBarrelInnerPhi0);
+    m_muonBarrelInnerPolygon = PolygonNormals(m_muonBarrelInnerSymmetry, m_muonBarrelInnerPhi0);
+    m_hCalBarrelOuterPolygon = PolygonNormals(m_hCalBarrelOuterSymmetry, m_hCalBarrelOuterPhi0);
+    m_hCalEndCapInnerPolygon = PolygonNormals(std::max(0, m_settings.m_hCalEndCapInnerSymmetryOrder), m_settings.m_hCalEndCapInnerPhiCoordinate);
 
+    // Every calo hit lies within the yoke, so its time of flight bounds the raw times that can pass a corrected time window
+    try
+    {
+        const std::vector<double> &yokeBarrelExtent(_GEAR->getYokeBarrelParameters().getExtent());
+        const std::vector<double> &yokeEndCapExtent(_GEAR->getYokeEndcapParameters().getExtent());
+        const double outerR(std::max(yokeBarrelExtent[1], yokeEndCapExtent[1])), outerZ(std::max(yokeBarrelExtent[3], yokeEndCapExtent[3]));
+        m_maxTimeOfFlight = std::sqrt(outerR * outerR + outerZ * outerZ) / SPEED_OF_LIGHT;
+    }
+    catch (...)
+    {
+        std::cout << "CaloHitCreator: no yoke extent, time of flight corrected time windows are applied without a raw time bound" << std::endl;
+    }
+
+    this->BindCollections();
+
+    if (m_settings.m_nParameterThreads > 1)
+        m_pWorkerPool = new WorkerPool(m_settings.m_nParameterThreads);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 CaloHitCreator::~CaloHitCreator()
 {
+    delete m_pWorkerPool;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 pandora::StatusCode CaloHitCreator::CreateCaloHits(const CollectionMaps& collectionMaps)
 {
-    
-    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->CreateECalCaloHits (collectionMaps));
-    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->CreateHCalCaloHits (collectionMaps));
-    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->CreateMuonCaloHits (collectionMaps));
-    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->CreateLCalCaloHits (collectionMaps));
-    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->CreateLHCalCaloHits(collectionMaps));
+    // Pandora keeps the addresses of the stored hits, so the store must never reallocate while the event is processed
+    const StringVector *const collectionLists[] = {&m_settings.m_eCalCaloHitCollections, &m_settings.m_hCalCaloHitCollections,
+        &m_settings.m_muonCaloHitCollections, &m_settings.m_lCalCaloHitCollections, &m_settings.m_lHCalCaloHitCollections};
+
+    size_t nCaloHits(0);
+
+    for (const StringVector *const pCollectionList : collectionLists)
+    {
+        for (StringVector::const_iterator iter = pCollectionList->begin(), iterEnd = pCollectionList->end(); iter != iterEnd; ++iter)
+        {
+            const edm4hep::CalorimeterHitCollection *const pCaloHitCollection(CollectionMaps::Find(collectionMaps.collectionMap_CaloHit, *iter));
+
+            if (NULL != pCaloHitCollection)
+                nCaloHits += pCaloHitCollection->size();
+        }
+    }
+
+    m_caloHitStore.reserve(nCaloHits);
+    m_calorimeterHitVector.reserve(nCaloHits);
+
+    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->CreateSubDetectorCaloHits<ECalTraits>(m_eCalBindings, collectionMaps));
+    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->CreateSubDetectorCaloHits<HCalTraits>(m_hCalBindings, collectionMaps));
+    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->CreateSubDetectorCaloHits<MuonTraits>(m_muonBindings, collectionMaps));
+    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->CreateSubDetectorCaloHits<LCalTraits>(m_lCalBindings, collectionMaps));
+    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->CreateSubDetectorCaloHits<LHCalTraits>(m_lHCalBindings, collectionMaps));
 
     return pandora::STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-pandora::StatusCode CaloHitCreator::CreateECalCaloHits(const CollectionMaps& collectionMaps)
+void CaloHitCreator::BindCollections()
 {
-    for (StringVector::const_iterator iter = m_settings.m_eCalCaloHitCollections.begin(), iterEnd = m_settings.m_eCalCaloHitCollections.end();
-        iter != iterEnd; ++iter)
+    for (const std::string &collectionName : m_settings.m_eCalCaloHitCollections)
     {
-        if(collectionMaps.collectionMap_CaloHit.find(*iter) == collectionMaps.collectionMap_CaloHit.end()) { std::cout<<"not find "<<(*iter)<<std::endl; continue;}
+        CollectionBinding binding(collectionName);
+
         try
         {
-            const std::vector<edm4hep::CalorimeterHit>& pCaloHitCollection = (collectionMaps.collectionMap_CaloHit.find(*iter))->second;
-            const int nElements(pCaloHitCollection.size());
-
-            if (0 == nElements)
-                continue;
-
-            const gear::LayerLayout &endcapLayerLayout(_GEAR->getEcalEndcapParameters().getLayerLayout());
-            const gear::LayerLayout &barrelLayerLayout(_GEAR->getEcalBarrelParameters().getLayerLayout()); 
+            this->BuildLayerTable(_GEAR->getEcalBarrelParameters().getLayerLayout(), pandora::ECAL, binding.m_barrelLayerTable);
+            this->BuildLayerTable(_GEAR->getEcalEndcapParameters().getLayerLayout(), pandora::ECAL, binding.m_endCapLayerTable);
+            binding.m_barrelOuterZ = m_eCalBarrelOuterZ;
+            binding.m_barrelInnerPolygon = m_eCalBarrelInnerPolygon;
+            binding.m_toMip = m_settings.m_eCalToMip;
+            binding.m_mipThreshold = m_settings.m_eCalMipThreshold;
+            binding.m_toEMGeV = m_settings.m_eCalToEMGeV;
+            binding.m_toHadGeVBarrel = m_settings.m_eCalToHadGeVBarrel;
+            binding.m_toHadGeVEndCap = m_settings.m_eCalToHadGeVEndCap;
+            binding.m_splitStrips = (0 != m_settings.m_stripSplittingOn);
+
+            // Hybrid ECAL including pure ScECAL, the layer technology is given by the collection name
+            if (m_settings.m_useEcalScLayers)
+            {
+                std::string lowerCaseName(collectionName);
+                std::transform(lowerCaseName.begin(), lowerCaseName.end(), lowerCaseName.begin(), ::tolower);
 
-            ID_UTIL::CellIDDecoder<const edm4hep::CalorimeterHit> cellIdDecoder(m_encoder_str);
-            const std::string layerCodingString(m_encoder_str);
-            const std::string layerCoding(this->GetLayerCoding(layerCodingString));
-            const std::string staveCoding(this->GetStaveCoding(layerCodingString));
+                if (lowerCaseName.find("ecal", 0) == std::string::npos)
+                    std::cout << "WARNING: mismatching hybrid Ecal collection name. " << lowerCaseName << std::endl;
 
-            for (int i = 0; i < nElements; ++i)
-            {
-                try
+                if (lowerCaseName.find("si", 0) != std::string::npos)
+                {
+                    binding.m_toMip = m_settings.m_eCalSiToMip;
+                    binding.m_mipThreshold = m_settings.m_eCalSiMipThreshold;
+                    binding.m_toEMGeV = m_settings.m_eCalSiToEMGeV;
+                    binding.m_toHadGeVBarrel = m_settings.m_eCalSiToHadGeVBarrel;
+                    binding.m_toHadGeVEndCap = m_settings.m_eCalSiToHadGeVEndCap;
+                }
+                else if (lowerCaseName.find("sc", 0) != std::string::npos)
                 {
-                    const edm4hep::CalorimeterHit& pCaloHit0 = pCaloHitCollection.at(i);
-                    const edm4hep::CalorimeterHit* pCaloHit = &(pCaloHit0);
+                    binding.m_toMip = m_settings.m_eCalScToMip;
+                    binding.m_mipThreshold = m_settings.m_eCalScMipThreshold;
+                    binding.m_toEMGeV = m_settings.m_eCalScToEMGeV;
+                    binding.m_toHadGeVBarrel = m_settings.m_eCalScToHadGeVBarrel;
+                    binding.m_toHadGeVEndCap = m_settings.m_eCalScToHadGeVEndCap;
+                }
+            }
 
-                    if (NULL == pCaloHit)
-                        throw ("CreateECalCaloHits pCaloHit Collection type mismatch");
+            this->SetTimeWindow(m_settings.m_eCalTimeWindowMin, m_settings.m_eCalTimeWindowMax, binding);
+            this->BindCellIdFields(m_encoder_str, true, binding);
+            this->BindCellCoarsening(m_encoder_str, binding);
+        }
+        catch (...)
+        {
+            std::cout << "CaloHitCreator: cannot bind calo hit collection " << collectionName << " to the detector geometry, it will be skipped" << std::endl;
+        }
 
-                    float eCalToMip(m_settings.m_eCalToMip), eCalMipThreshold(m_settings.m_eCalMipThreshold), eCalToEMGeV(m_settings.m_eCalToEMGeV),
-                        eCalToHadGeVBarrel(m_settings.m_eCalToHadGeVBarrel), eCalToHadGeVEndCap(m_settings.m_eCalToHadGeVEndCap);
+        m_eCalBindings.push_back(std::move(binding));
+    }
 
-                    // Hybrid ECAL including pure ScECAL.
-                    if (m_settings.m_useEcalScLayers)
-                    {
-                        std::string collectionName(*iter);
-                        std::transform(collectionName.begin(), collectionName.end(), collectionName.begin(), ::tolower);
-
-                        if (collectionName.find("ecal", 0) == std::string::npos)
-                            std::cout << "WARNING: mismatching hybrid Ecal collection name. " << collectionName << std::endl;
-
-                        if (collectionName.find("si", 0) != std::string::npos)
-                        {
-                             eCalToMip = m_settings.m_eCalSiToMip;
-                             eCalMipThreshold = m_settings.m_eCalSiMipThreshold;
-                             eCalToEMGeV = m_settings.m_eCalSiToEMGeV;
-                             eCalToHadGeVBarrel = m_settings.m_eCalSiToHadGeVBarrel;
-                             eCalToHadGeVEndCap = m_settings.m_eCalSiToHadGeVEndCap;
-                        }
-                        else if (collectionName.find("sc", 0) != std::string::npos)
-                        {
-                             eCalToMip = m_settings.m_eCalScToMip;
-                             eCalMipThreshold = m_settings.m_eCalScMipThreshold;
-                             eCalToEMGeV = m_settings.m_eCalScToEMGeV;
-                             eCalToHadGeVBarrel = m_settings.m_eCalScToHadGeVBarrel;
-                             eCalToHadGeVEndCap = m_settings.m_eCalScToHadGeVEndCap;
-                        }
-                    }
+    for (const std::string &collectionName : m_settings.m_hCalCaloHitCollections)
+    {
+        CollectionBinding binding(collectionName);
 
-                    PandoraApi::CaloHit::Parameters caloHitParameters;
-                    caloHitParameters.m_hitType = pandora::ECAL;
-                    caloHitParameters.m_isDigital = false;
-                    caloHitParameters.m_layer = cellIdDecoder(pCaloHit)[layerCoding.c_str()] + 1;
-                    caloHitParameters.m_isInOuterSamplingLayer = false;
-                    this->GetCommonCaloHitProperties(pCaloHit, caloHitParameters);
+        try
+        {
+            this->BuildLayerTable(_GEAR->getHcalBarrelParameters().getLayerLayout(), pandora::HCAL, binding.m_barrelLayerTable);
+            this->BuildLayerTable(_GEAR->getHcalEndcapParameters().getLayerLayout(), pandora::HCAL, binding.m_endCapLayerTable);
+            binding.m_barrelOuterZ = m_hCalBarrelOuterZ;
+            binding.m_barrelInnerPolygon = m_hCalBarrelInnerPolygon;
+            binding.m_toMip = m_settings.m_hCalToMip;
+            binding.m_mipThreshold = m_settings.m_hCalMipThreshold;
+            binding.m_toEMGeV = m_settings.m_hCalToEMGeV;
+            binding.m_toHadGeVBarrel = m_settings.m_hCalToHadGeV;
+            binding.m_toHadGeVEndCap = m_settings.m_hCalToHadGeV;
+            binding.m_maxHadronicEnergy = m_settings.m_maxHCalHitHadronicEnergy;
+
+            this->SetTimeWindow(m_settings.m_hCalTimeWindowMin, m_settings.m_hCalTimeWindowMax, binding);
+            this->BindCellIdFields(m_encoder_str, true, binding);
+            this->BindCellCoarsening(m_encoder_str, binding);
+        }
+        catch (...)
+        {
+            std::cout << "CaloHitCreator: cannot bind calo hit collection " << collectionName << " to the detector geometry, it will be skipped" << std::endl;
+        }
 
-                    float absorberCorrection(1.);
+        m_hCalBindings.push_back(std::move(binding));
+    }
 
-                    if (std::fabs(pCaloHit->getPosition()[2]) < m_eCalBarrelOuterZ)
-                    {
-                        this->GetBarrelCaloHitProperties(pCaloHit, barrelLayerLayout, m_eCalBarrelInnerSymmetry, m_eCalBarrelInnerPhi0,
-                            cellIdDecoder(pCaloHit)[ staveCoding], caloHitParameters, absorberCorrection);
+    for (const std::string &collectionName : m_settings.m_muonCaloHitCollections)
+    {
+        CollectionBinding binding(collectionName);
 
-                        caloHitParameters.m_hadronicEnergy = eCalToHadGeVBarrel * pCaloHit->getEnergy();
-                    }
-                    else
-                    {
-                        this->GetEndCapCaloHitProperties(pCaloHit, endcapLayerLayout, caloHitParameters, absorberCorrection);
-                        caloHitParameters.m_hadronicEnergy = eCalToHadGeVEndCap * pCaloHit->getEnergy();
-                    }
+        try
+        {
+            this->BuildLayerTable(_GEAR->getYokeBarrelParameters().getLayerLayout(), pandora::MUON, binding.m_barrelLayerTable);
+            this->BuildLayerTable(_GEAR->getYokeEndcapParameters().getLayerLayout(), pandora::MUON, binding.m_endCapLayerTable);
+            this->BuildLayerTable(_GEAR->getYokePlugParameters().getLayerLayout(), pandora::MUON, binding.m_plugLayerTable);
+            binding.m_barrelOuterZ = m_muonBarrelOuterZ;
+            binding.m_barrelInnerPolygon = m_muonBarrelInnerPolygon;
+            binding.m_toMip = m_settings.m_muonToMip;
+            binding.m_isDigital = (m_settings.m_muonDigitalHits > 0);
+            binding.m_digitalHitEnergy = m_settings.m_muonHitEnergy;
+
+            this->SetTimeWindow(m_settings.m_muonTimeWindowMin, m_settings.m_muonTimeWindowMax, binding);
+            this->BindCellIdFields(m_encoder_str_MUON, true, binding);
+        }
+        catch (...)
+        {
+            std::cout << "CaloHitCreator: cannot bind calo hit collection " << collectionName << " to the detector geometry, it will be skipped" << std::endl;
+        }
 
-                    //caloHitParameters.m_mipEquivalentEnergy = pCaloHit->getEnergy() * eCalToMip * absorberCorrection;
-                    caloHitParameters.m_mipEquivalentEnergy = pCaloHit->getEnergy() * eCalToMip;//FIXME. is absorberCorrection it needed for digi input
+        m_muonBindings.push_back(std::move(binding));
+    }
 
-                    if (caloHitParameters.m_mipEquivalentEnergy.Get() < eCalMipThreshold)
-                        continue;
+    for (const std::string &collectionName : m_settings.m_lCalCaloHitCollections)
+    {
+        CollectionBinding binding(collectionName);
+
+        try
+        {
+            this->BuildLayerTable(_GEAR->getLcalParameters().getLayerLayout(), pandora::ECAL, binding.m_endCapLayerTable);
+            binding.m_toMip = m_settings.m_eCalToMip;
+            binding.m_mipThreshold = m_settings.m_eCalMipThreshold;
+            binding.m_toEMGeV = m_settings.m_eCalToEMGeV;
+            binding.m_toHadGeVBarrel = m_settings.m_eCalToHadGeVEndCap;
+            binding.m_toHadGeVEndCap = m_settings.m_eCalToHadGeVEndCap;
+
+            this->SetTimeWindow(m_settings.m_lCalTimeWindowMin, m_settings.m_lCalTimeWindowMax, binding);
+            this->BindCellIdFields(m_encoder_str_LCal, false, binding);
+            this->BindCellCoarsening(m_encoder_str_LCal, binding);
+        }
+        catch (...)
+        {
+            std::cout << "CaloHitCreator: cannot bind calo hit collection " << collectionName << " to the detector geometry, it will be skipped" << std::endl;
+        }
 
-                    caloHitParameters.m_electromagneticEnergy = eCalToEMGeV * pCaloHit->getEnergy();
+        m_lCalBindings.push_back(std::move(binding));
+    }
 
-                    // ATTN If using strip splitting, must correct cell sizes for use in PFA to minimum of strip width and strip length
-                    if (m_settings.m_stripSplittingOn)
-                    {
-                        const float splitCellSize(std::min(caloHitParameters.m_cellSize0.Get(), caloHitParameters.m_cellSize1.Get()));
-                        caloHitParameters.m_cellSize0 = splitCellSize;
-                        caloHitParameters.m_cellSize1 = splitCellSize;
-                    }
+    for (const std::string &collectionName : m_settings.m_lHCalCaloHitCollections)
+    {
+        CollectionBinding binding(collectionName);
 
-                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*m_pPandora, caloHitParameters));
-                    m_calorimeterHitVector.push_back(const_cast<edm4hep::CalorimeterHit*>(pCaloHit));
-                }
-                catch (pandora::StatusCodeException &statusCodeException)
-                {
-                    std::cout<<"Failed to extract ecal calo hit: " << statusCodeException.ToString() << std::endl;
-                }
-                catch (...)
-                {
-                    std::cout<<"Failed to extract ecal calo hit" <<  std::endl;
-                }
-            }
+        try
+        {
+            this->BuildLayerTable(_GEAR->getLHcalParameters().getLayerLayout(), pandora::HCAL, binding.m_endCapLayerTable);
+            binding.m_toMip = m_settings.m_hCalToMip;
+            binding.m_mipThreshold = m_settings.m_hCalMipThreshold;
+            binding.m_toEMGeV = m_settings.m_hCalToEMGeV;
+            binding.m_toHadGeVBarrel = m_settings.m_hCalToHadGeV;
+            binding.m_toHadGeVEndCap = m_settings.m_hCalToHadGeV;
+            binding.m_maxHadronicEnergy = m_settings.m_maxHCalHitHadronicEnergy;
+
+            this->SetTimeWindow(m_settings.m_lHCalTimeWindowMin, m_settings.m_lHCalTimeWindowMax, binding);
+            this->BindCellIdFields(m_encoder_str_LHCal, false, binding);
+            this->BindCellCoarsening(m_encoder_str_LHCal, binding);
         }
         catch (...)
         {
-            std::cout<< "Failed to extract ecal calo hit collection: " << *iter << std::endl;
+            std::cout << "CaloHitCreator: cannot bind calo hit collection " << collectionName << " to the detector geometry, it will be skipped" << std::endl;
         }
+
+        m_lHCalBindings.push_back(std::move(binding));
     }
 
-    return pandora::STATUS_CODE_SUCCESS;
+    if (!m_settings.m_cellMaskFile.empty())
+        this->BindCellMasks();
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-pandora::StatusCode CaloHitCreator::CreateHCalCaloHits(const CollectionMaps& collectionMaps)
+void CaloHitCreator::BindCellMasks()
 {
-    for (StringVector::const_iterator iter = m_settings.m_hCalCaloHitCollections.begin(), iterEnd = m_settings.m_hCalCaloHitCollections.end();
-        iter != iterEnd; ++iter)
+    CellMask::CollectionCellMaskMap cellMasks;
+    CellMask::ReadFile(m_settings.m_cellMaskFile, cellMasks);
+
+    CollectionBindingVector *const bindingVectors[] = {&m_eCalBindings, &m_hCalBindings, &m_muonBindings, &m_lCalBindings, &m_lHCalBindings};
+
+    for (CollectionBindingVector *const pBindings : bindingVectors)
     {
-        if(collectionMaps.collectionMap_CaloHit.find(*iter) == collectionMaps.collectionMap_CaloHit.end()) { std::cout<<"not find "<<(*iter)<<std::endl; continue;}
-        try
+        for (CollectionBinding &binding : *pBindings)
         {
-            const std::vector<edm4hep::CalorimeterHit>& pCaloHitCollection = (collectionMaps.collectionMap_CaloHit.find(*iter))->second;
-            const int nElements(pCaloHitCollection.size());
+            const CellMask::CollectionCellMaskMap::const_iterator iter(cellMasks.find(binding.m_collectionName));
 
-            if (0 == nElements)
+            if (cellMasks.end() == iter)
                 continue;
 
-            const gear::LayerLayout &endcapLayerLayout(_GEAR->getHcalEndcapParameters().getLayerLayout());
-            const gear::LayerLayout &barrelLayerLayout(_GEAR->getHcalBarrelParameters().getLayerLayout());
+            binding.m_cellMask = iter->second;
+            std::cout << "CaloHitCreator: " << binding.m_cellMask.GetNCells() << " masked or separately thresholded cells in calo hit collection "
+                      << binding.m_collectionName << std::endl;
+        }
+    }
 
-            ID_UTIL::CellIDDecoder<const edm4hep::CalorimeterHit> cellIdDecoder(m_encoder_str);
-            const std::string layerCodingString(m_encoder_str);
-            const std::string layerCoding(this->GetLayerCoding(layerCodingString));
-            const std::string staveCoding(this->GetStaveCoding(layerCodingString));
+    for (const CellMask::CollectionCellMaskMap::value_type &cellMask : cellMasks)
+    {
+        bool isBound(false);
 
-            for (int i = 0; i < nElements; ++i)
-            {
-                try
-                {
-                    const edm4hep::CalorimeterHit& pCaloHit0 = pCaloHitCollection.at(i);
-                    const edm4hep::CalorimeterHit* pCaloHit = &(pCaloHit0);
+        for (CollectionBindingVector *const pBindings : bindingVectors)
+        {
+            for (const CollectionBinding &binding : *pBindings)
+                isBound = isBound || (binding.m_collectionName == cellMask.first);
+        }
 
-                    if (NULL == pCaloHit)
-                        throw ("CreateHCalCaloHits Collection type mismatch");
+        if (!isBound)
+            std::cout << "CaloHitCreator: cell mask file " << m_settings.m_cellMaskFile << " lists cells of " << cellMask.first
+                      << ", which is not a configured calo hit collection" << std::endl;
+    }
+}
 
-                    PandoraApi::CaloHit::Parameters caloHitParameters;
-                    caloHitParameters.m_hitType = pandora::HCAL;
-                    caloHitParameters.m_isDigital = false;
-                    caloHitParameters.m_layer = cellIdDecoder(pCaloHit)[layerCoding.c_str()];
-                    caloHitParameters.m_isInOuterSamplingLayer = (this->GetNLayersFromEdge(pCaloHit) <= m_settings.m_nOuterSamplingLayers);
-                    this->GetCommonCaloHitProperties(pCaloHit, caloHitParameters);
+//------------------------------------------------------------------------------------------------------------------------------------------
 
-                    float absorberCorrection(1.);
+void CaloHitCreator::SetTimeWindow(const float timeWindowMin, const float timeWindowMax, CollectionBinding &binding) const
+{
+    binding.m_timeWindowMin = timeWindowMin;
+    binding.m_timeWindowMax = timeWindowMax;
+    binding.m_hasTimeWindow = (timeWindowMin > -std::numeric_limits<float>::max()) || (timeWindowMax < std::numeric_limits<float>::max());
+}
 
-                    if (std::fabs(pCaloHit->getPosition()[2]) < m_hCalBarrelOuterZ)
-                    {
-                        this->GetBarrelCaloHitProperties(pCaloHit, barrelLayerLayout, m_hCalBarrelInnerSymmetry, m_hCalBarrelInnerPhi0,
-                            m_hCalBarrelInnerSymmetry - int(cellIdDecoder(pCaloHit)[ staveCoding] / 2), caloHitParameters, absorberCorrection);
-                    }
-                    else
-                    {
-                        this->GetEndCapCaloHitProperties(pCaloHit, endcapLayerLayout, caloHitParameters, absorberCorrection);
-                    }
+//------------------------------------------------------------------------------------------------------------------------------------------
 
-                    //caloHitParameters.m_mipEquivalentEnergy = pCaloHit->getEnergy() * m_settings.m_hCalToMip * absorberCorrection;
-                    caloHitParameters.m_mipEquivalentEnergy = pCaloHit->getEnergy() * m_settings.m_hCalToMip;
+unsigned int CaloHitCreator::SelectTimeWindowCandidates(const CollectionBinding &binding, const edm4hep::CalorimeterHitCollection &caloHitCollection)
+{
+    CaloHitColumns &columns(m_caloHitColumns);
+    const unsigned int nCaloHits(caloHitCollection.size());
 
-                    if (caloHitParameters.m_mipEquivalentEnergy.Get() < m_settings.m_hCalMipThreshold)
-                        continue;
+    // A time of flight corrected time lies between the raw time less the largest time of flight and the raw time
+    const float rawTimeMin(binding.m_timeWindowMin);
+    const float rawTimeMax(m_settings.m_timeWindowTofCorrection ? binding.m_timeWindowMax + m_maxTimeOfFlight : binding.m_timeWindowMax);
 
-                    caloHitParameters.m_hadronicEnergy = std::min(m_settings.m_hCalToHadGeV * pCaloHit->getEnergy(), m_settings.m_maxHCalHitHadronicEnergy);
-                    caloHitParameters.m_electromagneticEnergy = m_settings.m_hCalToEMGeV * pCaloHit->getEnergy();
+    columns.m_collectionTimes.resize(nCaloHits);
+    columns.m_candidates.resize(nCaloHits);
 
-                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*m_pPandora, caloHitParameters));
-                    m_calorimeterHitVector.push_back(const_cast<edm4hep::CalorimeterHit*>(pCaloHit));
-                }
-                catch (pandora::StatusCodeException &statusCodeException)
-                {
-                    std::cout << "Failed to extract hcal calo hit: " << statusCodeException.ToString() << std::endl;
-                }
-                catch (...)
-                {
-                    std::cout<<"Failed to extract hcal calo hit" << std::endl;
-                }
-            }
-        }
-        catch (...)
+    float *const pTimes(columns.m_collectionTimes.data());
+    unsigned int *const pCandidates(columns.m_candidates.data());
+
+    for (unsigned int i = 0; i < nCaloHits; ++i)
+        pTimes[i] = caloHitCollection.at(i).getTime();
+
+    unsigned int nCandidates(0);
+
+    // Comparisons written so that hits with a NaN time are always out of time
+    for (unsigned int i = 0; i < nCaloHits; ++i)
+    {
+        pCandidates[nCandidates] = i;
+        nCandidates += (pTimes[i] >= rawTimeMin) && (pTimes[i] <= rawTimeMax);
+    }
+
+    columns.m_candidates.resize(nCandidates);
+    m_nOutOfTimeCaloHits += nCaloHits - nCandidates;
+
+    return nCandidates;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+pandora::StatusCode CaloHitCreator::FindDuplicateCaloHits(const CollectionBindingVector &bindings, const CollectionMaps &collectionMaps)
+{
+    ScopedTraceSpan traceSpan(m_pTraceRecorder, "FindDuplicateCaloHits");
+    const unsigned int nDuplicatesBefore(m_nDuplicateCaloHits);
+
+    m_cellIdOwners.Clear();
+    m_caloHitOwners.clear();
+
+    for (const CollectionBinding &binding : bindings)
+    {
+        const edm4hep::CalorimeterHitCollection *const pCaloHitCollection(CollectionMaps::Find(collectionMaps.collectionMap_CaloHit, binding.m_collectionName));
+
+        if ((NULL == pCaloHitCollection) || !binding.m_hasCellIdFields)
+            continue;
+
+        const unsigned int nCaloHits(pCaloHitCollection->size());
+        m_cellIdOwners.Reserve(m_caloHitOwners.size() + nCaloHits);
+
+        for (unsigned int i = 0; i < nCaloHits; ++i)
         {
-            std::cout << "Failed to extract hcal calo hit collection: " << *iter << std::endl;
+            const edm4hep::CalorimeterHit caloHit(pCaloHitCollection->at(i));
+            unsigned int iOwner(0);
+
+            if (m_cellIdOwners.Insert(caloHit.getCellID(), m_caloHitOwners.size(), iOwner))
+            {
+                CaloHitOwner caloHitOwner;
+                caloHitOwner.m_pBinding = &binding;
+                caloHitOwner.m_index = i;
+                caloHitOwner.m_extraEnergy = 0.f;
+                m_caloHitOwners.push_back(caloHitOwner);
+                continue;
+            }
+
+            ++m_nDuplicateCaloHits;
+
+            if (FAIL_ON_DUPLICATE == m_settings.m_duplicatePolicy)
+            {
+                std::cout << "CaloHitCreator: hit " << i << " of calo hit collection " << binding.m_collectionName << " duplicates cell "
+                          << caloHit.getCellID() << " of calo hit collection " << m_caloHitOwners[iOwner].m_pBinding->m_collectionName << std::endl;
+                return pandora::STATUS_CODE_ALREADY_PRESENT;
+            }
+
+            if (SUM_ENERGY == m_settings.m_duplicatePolicy)
+                m_caloHitOwners[iOwner].m_extraEnergy += caloHit.getEnergy();
         }
     }
 
+    traceSpan.AddArg("nInput", m_caloHitOwners.size() + m_nDuplicateCaloHits - nDuplicatesBefore);
+    traceSpan.AddArg("nDuplicate", m_nDuplicateCaloHits - nDuplicatesBefore);
+
     return pandora::STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-pandora::StatusCode CaloHitCreator::CreateMuonCaloHits(const CollectionMaps& collectionMaps)
+unsigned int CaloHitCreator::SelectFirstCopies(const CollectionBinding &binding, const edm4hep::CalorimeterHitCollection &caloHitCollection,
+    const unsigned int nCandidates)
+{
+    CaloHitColumns &columns(m_caloHitColumns);
+
+    // Without a time window the candidates are all hits of the collection, and the candidate list is written here
+    if (!binding.m_hasTimeWindow)
+        columns.m_candidates.resize(nCandidates);
+
+    columns.m_collectionEnergies.resize(nCandidates);
+    unsigned int *const pCandidates(columns.m_candidates.data());
+    unsigned int nFirstCopies(0);
+
+    for (unsigned int i = 0; i < nCandidates; ++i)
+    {
+        const unsigned int hitIndex(binding.m_hasTimeWindow ? pCandidates[i] : i);
+        const edm4hep::CalorimeterHit caloHit(caloHitCollection.at(hitIndex));
+        unsigned int iOwner(0);
+
+        if (!m_cellIdOwners.Find(caloHit.getCellID(), iOwner))
+            throw pandora::StatusCodeException(pandora::STATUS_CODE_NOT_FOUND);
+
+        const CaloHitOwner &caloHitOwner(m_caloHitOwners[iOwner]);
+
+        if ((&binding != caloHitOwner.m_pBinding) || (hitIndex != caloHitOwner.m_index))
+            continue;
+
+        pCandidates[nFirstCopies] = hitIndex;
+        columns.m_collectionEnergies[nFirstCopies] = caloHit.getEnergy() + caloHitOwner.m_extraEnergy;
+        ++nFirstCopies;
+    }
+
+    columns.m_candidates.resize(nFirstCopies);
+    columns.m_collectionEnergies.resize(nFirstCopies);
+
+    return nFirstCopies;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CaloHitCreator::BuildLayerTable(const gear::LayerLayout &layerLayout, const pandora::HitType hitType, LayerPropertiesTable &layerTable) const
+{
+    const float radiationLength((pandora::ECAL == hitType) ? m_settings.m_absorberRadLengthECal :
+        (pandora::HCAL == hitType) ? m_settings.m_absorberRadLengthHCal : m_settings.m_absorberRadLengthOther);
+    const float interactionLength((pandora::ECAL == hitType) ? m_settings.m_absorberIntLengthECal :
+        (pandora::HCAL == hitType) ? m_settings.m_absorberIntLengthHCal : m_settings.m_absorberIntLengthOther);
+
+    const int nLayers(layerLayout.getNLayers());
+
+    // The absorber correction of every layer is relative to the first layer with a non-zero absorber
+    float firstAbsorberThickness(0.f);
+
+    for (int i = 0; i < nLayers; ++i)
+    {
+        firstAbsorberThickness = layerLayout.getAbsorberThickness(i);
+
+        if (firstAbsorberThickness >= std::numeric_limits<float>::epsilon())
+            break;
+    }
+
+    layerTable.clear();
+    layerTable.reserve(std::max(nLayers, 0));
+
+    for (int i = 0; i < nLayers; ++i)
+    {
+        const float layerAbsorberThickness(layerLayout.getAbsorberThickness(i));
+
+        LayerProperties layerProperties;
+        layerProperties.m_cellSize0 = layerLayout.getCellSize0(i);
+        layerProperties.m_cellSize1 = layerLayout.getCellSize1(i);
+        layerProperties.m_cellThickness = layerLayout.getThickness(i);
+        layerProperties.m_nCellRadiationLengths = radiationLength * layerAbsorberThickness;
+        layerProperties.m_nCellInteractionLengths = interactionLength * layerAbsorberThickness;
+        layerProperties.m_absorberCorrection = ((firstAbsorberThickness >= std::numeric_limits<float>::epsilon()) &&
+            (layerAbsorberThickness > std::numeric_limits<float>::epsilon())) ? firstAbsorberThickness / layerAbsorberThickness : 1.f;
+        layerTable.push_back(layerProperties);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CaloHitCreator::BindCellIdFields(const std::string &encodingString, const bool usesStave, CollectionBinding &binding) const
+{
+    try
+    {
+        const CellIDFieldDecoder cellIdFieldDecoder(encodingString);
+        binding.m_layerField = cellIdFieldDecoder.GetField(this->GetLayerCoding(encodingString));
+
+        if (usesStave)
+            binding.m_staveField = cellIdFieldDecoder.GetField(this->GetStaveCoding(encodingString));
+
+        binding.m_hasCellIdFields = true;
+    }
+    catch (...)
+    {
+        std::cout << "CaloHitCreator: cannot resolve the layer and stave fields of cell id encoding '" << encodingString
+                  << "', calo hit collection " << binding.m_collectionName << " will be skipped" << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CaloHitCreator::BindCellCoarsening(const std::string &encodingString, CollectionBinding &binding) const
+{
+    if ((m_settings.m_cellCoarseningFactor0 < 2) && (m_settings.m_cellCoarseningFactor1 < 2))
+        return;
+
+    try
+    {
+        // The cell indices are I and J in the LCIO style encodings, x and y in the DD4hep style ones
+        const CellIDFieldDecoder cellIdFieldDecoder(encodingString);
+        const bool isLcioStyle(cellIdFieldDecoder.HasField("I"));
+        binding.m_cellIndexField0 = cellIdFieldDecoder.GetField(isLcioStyle ? "I" : "x");
+        binding.m_cellIndexField1 = cellIdFieldDecoder.GetField(isLcioStyle ? "J" : "y");
+        binding.m_coarseningFactor0 = std::max(1u, m_settings.m_cellCoarseningFactor0);
+        binding.m_coarseningFactor1 = std::max(1u, m_settings.m_cellCoarseningFactor1);
+        binding.m_isCoarsened = true;
+
+        std::cout << "CaloHitCreator: merging " << binding.m_coarseningFactor0 << "x" << binding.m_coarseningFactor1
+                  << " cells into virtual cells in calo hit collection " << binding.m_collectionName << std::endl;
+    }
+    catch (...)
+    {
+        std::cout << "CaloHitCreator: cannot resolve the cell index fields of cell id encoding '" << encodingString
+                  << "', calo hit collection " << binding.m_collectionName << " will not be coarsened" << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename TRAITS>
+pandora::StatusCode CaloHitCreator::CreateSubDetectorCaloHits(const CollectionBindingVector &bindings, const CollectionMaps &collectionMaps)
 {
-    for (StringVector::const_iterator iter = m_settings.m_muonCaloHitCollections.begin(), iterEnd = m_settings.m_muonCaloHitCollections.end();
-        iter != iterEnd; ++iter)
+    // Cell ids are only unique within a subdetector: the ecal, hcal and lhcal encodings have no system field
+    if (KEEP_DUPLICATES != m_settings.m_duplicatePolicy)
+        PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->FindDuplicateCaloHits(bindings, collectionMaps));
+
+    for (const CollectionBinding &binding : bindings)
     {
-        if(collectionMaps.collectionMap_CaloHit.find(*iter) == collectionMaps.collectionMap_CaloHit.end()) { std::cout<<"not find "<<(*iter)<<std::endl; continue;}
+        const edm4hep::CalorimeterHitCollection *const pCaloHitCollection(CollectionMaps::Find(collectionMaps.collectionMap_CaloHit, binding.m_collectionName));
+        if(NULL == pCaloHitCollection) { std::cout<<"not find "<<binding.m_collectionName<<std::endl; continue;}
         try
         {
-            const std::vector<edm4hep::CalorimeterHit>& pCaloHitCollection = (collectionMaps.collectionMap_CaloHit.find(*iter))->second;
-            const int nElements(pCaloHitCollection.size());
+            const int nElements(pCaloHitCollection->size());
 
             if (0 == nElements)
                 continue;
 
-            const gear::LayerLayout &endcapLayerLayout(_GEAR->getYokeEndcapParameters().getLayerLayout());
-            const gear::LayerLayout &barrelLayerLayout(_GEAR->getYokeBarrelParameters().getLayerLayout()); 
-            const gear::LayerLayout &plugLayerLayout(_GEAR->getYokePlugParameters().getLayerLayout());
+            if (!binding.m_hasCellIdFields)
+                throw pandora::StatusCodeException(pandora::STATUS_CODE_NOT_INITIALIZED);
 
-            ID_UTIL::CellIDDecoder<const edm4hep::CalorimeterHit> cellIdDecoder(m_encoder_str_MUON);
-            const std::string layerCodingString(m_encoder_str_MUON);
-            const std::string layerCoding(this->GetLayerCoding(layerCodingString));
-            const std::string staveCoding(this->GetStaveCoding(layerCodingString));
+            ScopedTraceSpan traceSpan(m_pTraceRecorder, TRAITS::GetTraceName());
+            traceSpan.SetDetail(binding.m_collectionName);
+            traceSpan.AddArg("nInput", nElements);
+            const size_t nCreatedBefore(m_calorimeterHitVector.size());
+            const unsigned int nMaskedBefore(m_nMaskedCaloHits), nOutOfTimeBefore(m_nOutOfTimeCaloHits), nMergedBefore(m_nMergedCaloHits);
 
-            for (int i = 0; i < nElements; ++i)
-            {
-                try
-                {
-                    const edm4hep::CalorimeterHit& pCaloHit0 = pCaloHitCollection.at(i);
-                    const edm4hep::CalorimeterHit* pCaloHit = &(pCaloHit0);
+            const unsigned int nSelected(this->FillCaloHitColumns<TRAITS>(binding, *pCaloHitCollection));
+            traceSpan.AddArg("nAboveThreshold", nSelected + m_nMergedCaloHits - nMergedBefore);
 
-                    if (NULL == pCaloHit)
-                        throw ("Muon Collection type mismatch");
+            if (!binding.m_cellMask.IsEmpty())
+                traceSpan.AddArg("nMasked", m_nMaskedCaloHits - nMaskedBefore);
 
-                    PandoraApi::CaloHit::Parameters caloHitParameters;
-                    caloHitParameters.m_hitType = pandora::MUON;
-                    caloHitParameters.m_layer = cellIdDecoder(pCaloHit)[layerCoding.c_str()] + 1;
-                    caloHitParameters.m_isInOuterSamplingLayer = true;
-                    this->GetCommonCaloHitProperties(pCaloHit, caloHitParameters);
+            if (binding.m_hasTimeWindow)
+                traceSpan.AddArg("nOutOfTime", m_nOutOfTimeCaloHits - nOutOfTimeBefore);
 
-                    const float radius(std::sqrt(pCaloHit->getPosition()[0] * pCaloHit->getPosition()[0] +
-                        pCaloHit->getPosition()[1] * pCaloHit->getPosition()[1]));
+            if (binding.m_isCoarsened)
+                traceSpan.AddArg("nVirtualCells", nSelected);
 
-                    const bool isWithinCoil(radius < m_coilOuterR);
-                    const bool isInBarrelRegion(std::fabs(pCaloHit->getPosition()[2]) < m_muonBarrelOuterZ);
+            m_caloHitParameters.resize(nSelected);
+            m_caloHitStatusCodes.resize(nSelected);
 
-                    float absorberCorrection(1.);
+            // Each hit is read and written by exactly one task, and nothing shared is modified until all tasks have finished
+            const unsigned int chunkSize(std::max(1u, m_settings.m_parameterChunkSize));
+            const unsigned int nChunks((nSelected + chunkSize - 1) / chunkSize);
 
-                    if (isInBarrelRegion && isWithinCoil)
+            const WorkerPool::Task buildChunk([this, &binding, pCaloHitCollection, nSelected, chunkSize](const unsigned int iChunk)
+            {
+                for (unsigned int iSelected = iChunk * chunkSize, iEnd = std::min(nSelected, iSelected + chunkSize); iSelected < iEnd; ++iSelected)
+                {
+                    try
                     {
-                        this->GetEndCapCaloHitProperties(pCaloHit, plugLayerLayout, caloHitParameters, absorberCorrection);
+                        this->BuildCaloHitParameters<TRAITS>(binding, *pCaloHitCollection, iSelected, m_caloHitParameters[iSelected]);
+                        m_caloHitStatusCodes[iSelected] = pandora::STATUS_CODE_SUCCESS;
                     }
-                    else if (isInBarrelRegion)
+                    catch (pandora::StatusCodeException &statusCodeException)
                     {
-                        this->GetBarrelCaloHitProperties(pCaloHit, barrelLayerLayout, m_muonBarrelInnerSymmetry, m_muonBarrelInnerPhi0,
-                            cellIdDecoder(pCaloHit)[ staveCoding ], caloHitParameters, absorberCorrection);
+                        m_caloHitStatusCodes[iSelected] = statusCodeException.GetStatusCode();
                     }
-                    else
+                    catch (...)
                     {
-                        this->GetEndCapCaloHitProperties(pCaloHit, endcapLayerLayout, caloHitParameters, absorberCorrection);
+                        m_caloHitStatusCodes[iSelected] = pandora::STATUS_CODE_FAILURE;
                     }
+                }
+            });
 
-                    if (m_settings.m_muonDigitalHits > 0)
-                    {
-                        caloHitParameters.m_isDigital = true;
-                        caloHitParameters.m_inputEnergy = m_settings.m_muonHitEnergy;
-                        caloHitParameters.m_hadronicEnergy = m_settings.m_muonHitEnergy;
-                        caloHitParameters.m_electromagneticEnergy = m_settings.m_muonHitEnergy;
-                        caloHitParameters.m_mipEquivalentEnergy = 1.f;
-                    }
-                    else
-                    {
-                        caloHitParameters.m_isDigital = false;
-                        caloHitParameters.m_inputEnergy = pCaloHit->getEnergy();
-                        caloHitParameters.m_hadronicEnergy = pCaloHit->getEnergy();
-                        caloHitParameters.m_electromagneticEnergy = pCaloHit->getEnergy();
-                        caloHitParameters.m_mipEquivalentEnergy = pCaloHit->getEnergy() * m_settings.m_muonToMip;
-                    }
+            if (NULL != m_pWorkerPool)
+            {
+                traceSpan.AddArg("nThreads", m_pWorkerPool->GetNThreads());
+                m_pWorkerPool->Run(nChunks, buildChunk);
+            }
+            else
+            {
+                for (unsigned int iChunk = 0; iChunk < nChunks; ++iChunk)
+                    buildChunk(iChunk);
+            }
+
+            for (unsigned int iSelected = 0; iSelected < nSelected; ++iSelected)
+            {
+                try
+                {
+                    if (pandora::STATUS_CODE_SUCCESS != m_caloHitStatusCodes[iSelected])
+                        throw pandora::StatusCodeException(m_caloHitStatusCodes[iSelected]);
+
+                    PandoraApi::CaloHit::Parameters &caloHitParameters(m_caloHitParameters[iSelected]);
+                    edm4hep::CalorimeterHit *const pStoredCaloHit(this->StoreCaloHit(pCaloHitCollection->at(m_caloHitColumns.m_indices[iSelected])));
+                    caloHitParameters.m_pParentAddress = pStoredCaloHit;
 
                     PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*m_pPandora, caloHitParameters));
-                    m_calorimeterHitVector.push_back(const_cast<edm4hep::CalorimeterHit*>(pCaloHit));
+
+                    if (NULL != m_pInputRecorder)
+                        m_pInputRecorder->RecordCaloHit(caloHitParameters);
+                    m_calorimeterHitVector.push_back(pStoredCaloHit);
                 }
                 catch (pandora::StatusCodeException &statusCodeException)
                 {
-                    std::cout << "Failed to extract muon hit: " << statusCodeException.ToString() << std::endl;
+                    std::cout << "Failed to extract " << TRAITS::GetHitName() << ": " << statusCodeException.ToString() << std::endl;
                 }
                 catch (...)
                 {
-                    std::cout << "Failed to extract muon hit"  << std::endl;
+                    std::cout << "Failed to extract " << TRAITS::GetHitName() << std::endl;
                 }
             }
+
+            traceSpan.AddArg("nCreated", m_calorimeterHitVector.size() - nCreatedBefore);
         }
         catch (...)
         {
-            std::cout << "Failed to extract muon hit collection: " << *iter  << std::endl;
+            std::cout << "Failed to extract " << TRAITS::GetHitName() << " collection: " << binding.m_collectionName << std::endl;
         }
     }
 
@@ -418,258 +830,423 @@ pandora::StatusCode CaloHitCreator::CreateMuonCaloHits(const CollectionMaps& col
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-pandora::StatusCode CaloHitCreator::CreateLCalCaloHits(const CollectionMaps& collectionMaps)
+template <typename TRAITS>
+void CaloHitCreator::BuildCaloHitParameters(const CollectionBinding &binding, const edm4hep::CalorimeterHitCollection &caloHitCollection,
+    const unsigned int iSelected, PandoraApi::CaloHit::Parameters &caloHitParameters) const
 {
-    for (StringVector::const_iterator iter = m_settings.m_lCalCaloHitCollections.begin(), iterEnd = m_settings.m_lCalCaloHitCollections.end();
-        iter != iterEnd; ++iter)
-    {
-        if(collectionMaps.collectionMap_CaloHit.find(*iter) == collectionMaps.collectionMap_CaloHit.end()) { std::cout<<"not find "<<(*iter)<<std::endl; continue;}
-        try
-        {
-            const std::vector<edm4hep::CalorimeterHit>& pCaloHitCollection = (collectionMaps.collectionMap_CaloHit.find(*iter))->second;
-            const int nElements(pCaloHitCollection.size());
-
-            if (0 == nElements)
-                continue;
-
-            const gear::LayerLayout &endcapLayerLayout(_GEAR->getLcalParameters().getLayerLayout()); 
+    const pandora::HitType hitType(TRAITS::HIT_TYPE);
+    const CaloHitColumns &columns(m_caloHitColumns);
+    const edm4hep::CalorimeterHit pCaloHit0(caloHitCollection.at(columns.m_indices[iSelected]));
+    const edm4hep::CalorimeterHit *const pCaloHit(&pCaloHit0);
+
+    // As pandora::CartesianVector::GetUnitVector, which the direction columns replace
+    if (std::fabs(columns.m_magnitude[iSelected]) < std::numeric_limits<float>::epsilon())
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_NOT_ALLOWED);
+
+    caloHitParameters = PandoraApi::CaloHit::Parameters();
+    caloHitParameters.m_hitType = hitType;
+    caloHitParameters.m_isDigital = binding.m_isDigital;
+    caloHitParameters.m_layer = columns.m_layers[iSelected] + TRAITS::LAYER_OFFSET;
+    caloHitParameters.m_isInOuterSamplingLayer = (OUTER_FROM_EDGE == TRAITS::OUTER_SAMPLING_RULE) ?
+        (this->GetNLayersFromEdge(pCaloHit) <= m_settings.m_nOuterSamplingLayers) : (ALWAYS_OUTER == TRAITS::OUTER_SAMPLING_RULE);
+    caloHitParameters.m_cellGeometry = pandora::RECTANGULAR;
+    caloHitParameters.m_positionVector = pandora::CartesianVector(columns.m_x[iSelected], columns.m_y[iSelected], columns.m_z[iSelected]);
+    caloHitParameters.m_expectedDirection = pandora::CartesianVector(columns.m_directionX[iSelected], columns.m_directionY[iSelected],
+        columns.m_directionZ[iSelected]);
+    caloHitParameters.m_inputEnergy = columns.m_energies[iSelected];
+    caloHitParameters.m_time = pCaloHit->getTime();
 
-            ID_UTIL::CellIDDecoder<const edm4hep::CalorimeterHit> cellIdDecoder(m_encoder_str_LCal);
-            const std::string layerCodingString(m_encoder_str_LCal);
-            const std::string layerCoding(this->GetLayerCoding(layerCodingString));
+    const bool isInBarrelRegion(columns.m_isInBarrelRegion[iSelected]);
+    const bool isWithinCoil(columns.m_isWithinCoil[iSelected]);
 
-            for (int i = 0; i < nElements; ++i)
-            {
-                try
-                {
-                    const edm4hep::CalorimeterHit& pCaloHit0 = pCaloHitCollection.at(i);
-                    const edm4hep::CalorimeterHit* pCaloHit = &(pCaloHit0);
+    float absorberCorrection(1.);
 
-                    if (NULL == pCaloHit)
-                        throw ("LCal Collection type mismatch");
+    if (isWithinCoil)
+    {
+        this->GetEndCapCaloHitProperties(pCaloHit, binding.m_plugLayerTable, caloHitParameters, absorberCorrection);
+    }
+    else if (isInBarrelRegion)
+    {
+        const int staveField(columns.m_staves[iSelected]);
+        const unsigned int staveNumber((STAVE_FROM_HALF_CELL_ID == TRAITS::STAVE_RULE) ?
+            binding.m_barrelInnerPolygon.m_symmetryOrder - staveField / 2 : staveField);
 
-                    PandoraApi::CaloHit::Parameters caloHitParameters;
-                    caloHitParameters.m_hitType = pandora::ECAL;
-                    caloHitParameters.m_isDigital = false;
-                    caloHitParameters.m_layer = cellIdDecoder(pCaloHit)[layerCoding.c_str()];
-                    caloHitParameters.m_isInOuterSamplingLayer = false;
-                    this->GetCommonCaloHitProperties(pCaloHit, caloHitParameters);
+        this->GetBarrelCaloHitProperties(pCaloHit, binding.m_barrelLayerTable, binding.m_barrelInnerPolygon, staveNumber,
+            caloHitParameters, absorberCorrection);
+    }
+    else
+    {
+        this->GetEndCapCaloHitProperties(pCaloHit, binding.m_endCapLayerTable, caloHitParameters, absorberCorrection);
+    }
 
-                    float absorberCorrection(1.);
-                    this->GetEndCapCaloHitProperties(pCaloHit, endcapLayerLayout, caloHitParameters, absorberCorrection);
+    if (binding.m_isCoarsened)
+    {
+        caloHitParameters.m_cellSize0 = caloHitParameters.m_cellSize0.Get() * binding.m_coarseningFactor0;
+        caloHitParameters.m_cellSize1 = caloHitParameters.m_cellSize1.Get() * binding.m_coarseningFactor1;
+    }
 
-                    //caloHitParameters.m_mipEquivalentEnergy = pCaloHit->getEnergy() * m_settings.m_eCalToMip * absorberCorrection;
-                    caloHitParameters.m_mipEquivalentEnergy = pCaloHit->getEnergy() * m_settings.m_eCalToMip;
+    const float inputEnergy(columns.m_energies[iSelected]);
 
-                    if (caloHitParameters.m_mipEquivalentEnergy.Get() < m_settings.m_eCalMipThreshold)
-                        continue;
+    if (DIGITAL_OR_ANALOGUE_ENERGY == TRAITS::ENERGY_MODEL)
+    {
+        const float energy(binding.m_isDigital ? binding.m_digitalHitEnergy : inputEnergy);
+        caloHitParameters.m_inputEnergy = energy;
+        caloHitParameters.m_hadronicEnergy = energy;
+        caloHitParameters.m_electromagneticEnergy = energy;
+        caloHitParameters.m_mipEquivalentEnergy = binding.m_isDigital ? 1.f : inputEnergy * binding.m_toMip;
+    }
+    else
+    {
+        // The mip threshold was applied by the pre-pass
+        //caloHitParameters.m_mipEquivalentEnergy = pCaloHit->getEnergy() * binding.m_toMip * absorberCorrection;
+        caloHitParameters.m_mipEquivalentEnergy = inputEnergy * binding.m_toMip;//FIXME. is absorberCorrection it needed for digi input
 
-                    caloHitParameters.m_electromagneticEnergy = m_settings.m_eCalToEMGeV * pCaloHit->getEnergy();
-                    caloHitParameters.m_hadronicEnergy = m_settings.m_eCalToHadGeVEndCap * pCaloHit->getEnergy();
+        const float toHadGeV((isInBarrelRegion && !isWithinCoil) ? binding.m_toHadGeVBarrel : binding.m_toHadGeVEndCap);
+        caloHitParameters.m_hadronicEnergy = std::min(toHadGeV * inputEnergy, binding.m_maxHadronicEnergy);
+        caloHitParameters.m_electromagneticEnergy = binding.m_toEMGeV * inputEnergy;
 
-                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*m_pPandora, caloHitParameters));
-                    m_calorimeterHitVector.push_back(const_cast<edm4hep::CalorimeterHit*>(pCaloHit));
-                }
-                catch (pandora::StatusCodeException &statusCodeException)
-                {
-                    std::cout << "Failed to extract lcal calo hit: " << statusCodeException.ToString() << std::endl;
-                }
-                catch (...)
-                {
-                    std::cout << "Failed to extract lcal calo hit" << std::endl;
-                }
-            }
-        }
-        catch (...)
+        // ATTN If using strip splitting, must correct cell sizes for use in PFA to minimum of strip width and strip length
+        if (binding.m_splitStrips)
         {
-            std::cout << "Failed to extract lcal calo hit collection: " << *iter << std::endl;
+            const float splitCellSize(std::min(caloHitParameters.m_cellSize0.Get(), caloHitParameters.m_cellSize1.Get()));
+            caloHitParameters.m_cellSize0 = splitCellSize;
+            caloHitParameters.m_cellSize1 = splitCellSize;
         }
     }
-
-    return pandora::STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-pandora::StatusCode CaloHitCreator::CreateLHCalCaloHits(const CollectionMaps& collectionMaps)
+template <typename TRAITS>
+unsigned int CaloHitCreator::FillCaloHitColumns(const CollectionBinding &binding, const edm4hep::CalorimeterHitCollection &caloHitCollection)
 {
-    for (StringVector::const_iterator iter = m_settings.m_lHCalCaloHitCollections.begin(), iterEnd = m_settings.m_lHCalCaloHitCollections.end();
-        iter != iterEnd; ++iter)
+    CaloHitColumns &columns(m_caloHitColumns);
+    const unsigned int nCaloHits(caloHitCollection.size());
+
+    // Hits outside the time window are dropped before their energy is read; without a window every hit is a candidate
+    const bool findsDuplicates(KEEP_DUPLICATES != m_settings.m_duplicatePolicy);
+    unsigned int nCandidates(binding.m_hasTimeWindow ? this->SelectTimeWindowCandidates(binding, caloHitCollection) : nCaloHits);
+
+    // Later copies of a cell are dropped here, and the first copy reads the energy of its copies along with its own
+    if (findsDuplicates)
+        nCandidates = this->SelectFirstCopies(binding, caloHitCollection, nCandidates);
+
+    const unsigned int *const pCandidates((binding.m_hasTimeWindow || findsDuplicates) ? columns.m_candidates.data() : NULL);
+    const auto getHitIndex = [pCandidates](const unsigned int iCandidate) { return (NULL == pCandidates) ? iCandidate : pCandidates[iCandidate]; };
+
+    // Select on the energy column first, so that hits below threshold never reach the geometry
+    columns.m_indices.resize(nCandidates);
+
+    if (!findsDuplicates)
     {
-        if(collectionMaps.collectionMap_CaloHit.find(*iter) == collectionMaps.collectionMap_CaloHit.end()) { std::cout<<"not find "<<(*iter)<<std::endl; continue;}
-        try
+        columns.m_collectionEnergies.resize(nCandidates);
+
+        for (unsigned int i = 0; i < nCandidates; ++i)
+            columns.m_collectionEnergies[i] = caloHitCollection.at(getHitIndex(i)).getEnergy();
+    }
+
+    unsigned int nSelected(0);
+
+    if (!binding.m_cellMask.IsEmpty())
+    {
+        // The cell id is needed before the threshold, as a cell threshold may be lower than the collection threshold
+        const CellMask &cellMask(binding.m_cellMask);
+        const float *const pEnergies(columns.m_collectionEnergies.data());
+        unsigned int *const pIndices(columns.m_indices.data());
+        const float toMip(binding.m_toMip);
+        const float collectionMipThreshold((CALIBRATED_ENERGY == TRAITS::ENERGY_MODEL) ? binding.m_mipThreshold : -std::numeric_limits<float>::max());
+
+        for (unsigned int i = 0; i < nCandidates; ++i)
         {
-            const std::vector<edm4hep::CalorimeterHit>& pCaloHitCollection = (collectionMaps.collectionMap_CaloHit.find(*iter))->second;
-            const int nElements(pCaloHitCollection.size());
+            float mipThreshold(collectionMipThreshold);
+            const CellMask::CellStatus cellStatus(cellMask.GetCellStatus(caloHitCollection.at(getHitIndex(i)).getCellID(), mipThreshold));
 
-            if (0 == nElements)
+            if (CellMask::MASKED == cellStatus)
+            {
+                ++m_nMaskedCaloHits;
                 continue;
+            }
 
-            const gear::LayerLayout &endcapLayerLayout(_GEAR->getLHcalParameters().getLayerLayout());
+            if (pEnergies[i] * toMip < mipThreshold)
+            {
+                if (CellMask::OWN_THRESHOLD == cellStatus)
+                    ++m_nBelowCellThresholdCaloHits;
 
-            ID_UTIL::CellIDDecoder<const edm4hep::CalorimeterHit> cellIdDecoder(m_encoder_str_LHCal);
-            const std::string layerCodingString(m_encoder_str_LHCal);
-            const std::string layerCoding(this->GetLayerCoding(layerCodingString));
+                continue;
+            }
 
-            for (int i = 0; i < nElements; ++i)
-            {
-                try
-                {
-                    const edm4hep::CalorimeterHit& pCaloHit0 = pCaloHitCollection.at(i);
-                    const edm4hep::CalorimeterHit* pCaloHit = &(pCaloHit0);
+            pIndices[nSelected++] = i;
+        }
+    }
+    else if (CALIBRATED_ENERGY == TRAITS::ENERGY_MODEL)
+    {
+        const float *const pEnergies(columns.m_collectionEnergies.data());
+        unsigned int *const pIndices(columns.m_indices.data());
+        const float toMip(binding.m_toMip), mipThreshold(binding.m_mipThreshold);
 
-                    if (NULL == pCaloHit)
-                        throw ("LHCal Collection type mismatch");
+        for (unsigned int i = 0; i < nCandidates; ++i)
+        {
+            pIndices[nSelected] = i;
+            nSelected += !(pEnergies[i] * toMip < mipThreshold);
+        }
+    }
+    else
+    {
+        for (unsigned int i = 0; i < nCandidates; ++i)
+            columns.m_indices[i] = i;
 
-                    PandoraApi::CaloHit::Parameters caloHitParameters;
-                    caloHitParameters.m_hitType = pandora::HCAL;
-                    caloHitParameters.m_isDigital = false;
-                    caloHitParameters.m_layer = cellIdDecoder(pCaloHit)[layerCoding.c_str()];
-                    caloHitParameters.m_isInOuterSamplingLayer = (this->GetNLayersFromEdge(pCaloHit) <= m_settings.m_nOuterSamplingLayers);
-                    this->GetCommonCaloHitProperties(pCaloHit, caloHitParameters);
+        nSelected = nCandidates;
+    }
 
-                    float absorberCorrection(1.);
-                    this->GetEndCapCaloHitProperties(pCaloHit, endcapLayerLayout, caloHitParameters, absorberCorrection);
+    columns.m_energies.resize(nSelected);
 
-                    //caloHitParameters.m_mipEquivalentEnergy = pCaloHit->getEnergy() * m_settings.m_hCalToMip * absorberCorrection;
-                    caloHitParameters.m_mipEquivalentEnergy = pCaloHit->getEnergy() * m_settings.m_hCalToMip;
+    for (unsigned int iSelected = 0; iSelected < nSelected; ++iSelected)
+        columns.m_energies[iSelected] = columns.m_collectionEnergies[columns.m_indices[iSelected]];
 
-                    if (caloHitParameters.m_mipEquivalentEnergy.Get() < m_settings.m_hCalMipThreshold)
-                        continue;
+    if (NULL != pCandidates)
+    {
+        for (unsigned int iSelected = 0; iSelected < nSelected; ++iSelected)
+            columns.m_indices[iSelected] = pCandidates[columns.m_indices[iSelected]];
+    }
 
-                    caloHitParameters.m_hadronicEnergy = std::min(m_settings.m_hCalToHadGeV * pCaloHit->getEnergy(), m_settings.m_maxHCalHitHadronicEnergy);
-                    caloHitParameters.m_electromagneticEnergy = m_settings.m_hCalToEMGeV * pCaloHit->getEnergy();
+    columns.m_indices.resize(nSelected);
+    columns.m_cellIds.resize(nSelected);
+    columns.m_x.resize(nSelected);
+    columns.m_y.resize(nSelected);
+    columns.m_z.resize(nSelected);
 
-                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*m_pPandora, caloHitParameters));
-                    m_calorimeterHitVector.push_back(const_cast<edm4hep::CalorimeterHit*>(pCaloHit));
-                }
-                catch (pandora::StatusCodeException &statusCodeException)
-                {
-                    std::cout << "Failed to extract lhcal calo hit: " << statusCodeException.ToString() << std::endl;
-                }
-                catch (...)
-                {
-                    std::cout << "Failed to extract lhcal calo hit" << std::endl;
-                }
-            }
-        }
-        catch (...)
+    for (unsigned int iSelected = 0; iSelected < nSelected; ++iSelected)
+    {
+        const edm4hep::CalorimeterHit caloHit(caloHitCollection.at(columns.m_indices[iSelected]));
+        columns.m_cellIds[iSelected] = caloHit.getCellID();
+        columns.m_x[iSelected] = caloHit.getPosition()[0];
+        columns.m_y[iSelected] = caloHit.getPosition()[1];
+        columns.m_z[iSelected] = caloHit.getPosition()[2];
+    }
+
+    if (binding.m_hasTimeWindow && m_settings.m_timeWindowTofCorrection)
+    {
+        // The exact time of flight correction, now that the positions of the remaining hits are known
+        const float *const pTimes(columns.m_collectionTimes.data());
+        const float timeWindowMin(binding.m_timeWindowMin), timeWindowMax(binding.m_timeWindowMax);
+        unsigned int nInTime(0);
+
+        for (unsigned int iSelected = 0; iSelected < nSelected; ++iSelected)
         {
-            std::cout << "Failed to extract lhcal calo hit collection: " << *iter << std::endl;
+            const float x(columns.m_x[iSelected]), y(columns.m_y[iSelected]), z(columns.m_z[iSelected]);
+            const float correctedTime(pTimes[columns.m_indices[iSelected]] - std::sqrt((x * x) + (y * y) + (z * z)) / SPEED_OF_LIGHT);
+
+            columns.m_indices[nInTime] = columns.m_indices[iSelected];
+            columns.m_energies[nInTime] = columns.m_energies[iSelected];
+            columns.m_cellIds[nInTime] = columns.m_cellIds[iSelected];
+            columns.m_x[nInTime] = x;
+            columns.m_y[nInTime] = y;
+            columns.m_z[nInTime] = z;
+            nInTime += (correctedTime >= timeWindowMin) && (correctedTime <= timeWindowMax);
         }
+
+        m_nOutOfTimeCaloHits += nSelected - nInTime;
+        nSelected = nInTime;
+
+        columns.m_indices.resize(nSelected);
+        columns.m_energies.resize(nSelected);
+        columns.m_cellIds.resize(nSelected);
+        columns.m_x.resize(nSelected);
+        columns.m_y.resize(nSelected);
+        columns.m_z.resize(nSelected);
     }
 
-    return pandora::STATUS_CODE_SUCCESS;
-}
+    if (binding.m_isCoarsened)
+        nSelected = this->CoarsenCaloHitColumns(binding, nSelected);
 
-//------------------------------------------------------------------------------------------------------------------------------------------
+    CellIDFieldDecoder::DecodeColumn(binding.m_layerField, columns.m_cellIds, columns.m_layers);
 
-void CaloHitCreator::GetCommonCaloHitProperties(const edm4hep::CalorimeterHit *const pCaloHit, PandoraApi::CaloHit::Parameters &caloHitParameters) const
-{
-    const float pCaloHitPosition[3]={pCaloHit->getPosition()[0], pCaloHit->getPosition()[1], pCaloHit->getPosition()[2]};
-    const pandora::CartesianVector positionVector(pCaloHitPosition[0], pCaloHitPosition[1], pCaloHitPosition[2]);
+    if (ENDCAP_ONLY != TRAITS::REGION_RULE)
+        CellIDFieldDecoder::DecodeColumn(binding.m_staveField, columns.m_cellIds, columns.m_staves);
 
-    caloHitParameters.m_cellGeometry = pandora::RECTANGULAR;
-    caloHitParameters.m_positionVector = positionVector;
-    caloHitParameters.m_expectedDirection = positionVector.GetUnitVector();
-    caloHitParameters.m_pParentAddress = pCaloHit;
-    caloHitParameters.m_inputEnergy = pCaloHit->getEnergy();
-    caloHitParameters.m_time = pCaloHit->getTime();
+    // Position derived quantities of the selected hits, in a flat loop without calls or data dependent branches
+    columns.m_magnitude.resize(nSelected);
+    columns.m_directionX.resize(nSelected);
+    columns.m_directionY.resize(nSelected);
+    columns.m_directionZ.resize(nSelected);
+    columns.m_isInBarrelRegion.resize(nSelected);
+    columns.m_isWithinCoil.resize(nSelected);
+
+    const float *const pX(columns.m_x.data()), *const pY(columns.m_y.data()), *const pZ(columns.m_z.data());
+    float *const pMagnitude(columns.m_magnitude.data());
+    float *const pDirectionX(columns.m_directionX.data()), *const pDirectionY(columns.m_directionY.data()), *const pDirectionZ(columns.m_directionZ.data());
+    unsigned char *const pIsInBarrelRegion(columns.m_isInBarrelRegion.data()), *const pIsWithinCoil(columns.m_isWithinCoil.data());
+    const float barrelOuterZ(binding.m_barrelOuterZ), coilOuterR(m_coilOuterR);
+
+    for (unsigned int iSelected = 0; iSelected < nSelected; ++iSelected)
+    {
+        const float x(pX[iSelected]), y(pY[iSelected]), z(pZ[iSelected]);
+        const float magnitude(std::sqrt((x * x) + (y * y) + (z * z)));
+        const bool isInBarrelRegion((ENDCAP_ONLY != TRAITS::REGION_RULE) && (std::fabs(z) < barrelOuterZ));
+
+        pMagnitude[iSelected] = magnitude;
+        pDirectionX[iSelected] = x / magnitude;
+        pDirectionY[iSelected] = y / magnitude;
+        pDirectionZ[iSelected] = z / magnitude;
+        pIsInBarrelRegion[iSelected] = isInBarrelRegion;
+        pIsWithinCoil[iSelected] = (BARREL_PLUG_OR_ENDCAP == TRAITS::REGION_RULE) && isInBarrelRegion && (std::sqrt((x * x) + (y * y)) < coilOuterR);
+    }
+
+    return nSelected;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void CaloHitCreator::GetEndCapCaloHitProperties(const edm4hep::CalorimeterHit *const pCaloHit, const gear::LayerLayout &layerLayout,
-    PandoraApi::CaloHit::Parameters &caloHitParameters, float &absorberCorrection) const
+unsigned int CaloHitCreator::CoarsenCaloHitColumns(const CollectionBinding &binding, const unsigned int nSelected)
 {
-    caloHitParameters.m_hitRegion = pandora::ENDCAP;
-
-    const int physicalLayer(std::min(static_cast<int>(caloHitParameters.m_layer.Get()), layerLayout.getNLayers() - 1));
-    caloHitParameters.m_cellSize0 = layerLayout.getCellSize0(physicalLayer);
-    caloHitParameters.m_cellSize1 = layerLayout.getCellSize1(physicalLayer);
-    caloHitParameters.m_cellThickness = layerLayout.getThickness(physicalLayer);
+    CaloHitColumns &columns(m_caloHitColumns);
+    const CellIDFieldDecoder::Field &field0(binding.m_cellIndexField0), &field1(binding.m_cellIndexField1);
+    const long long factor0(binding.m_coarseningFactor0), factor1(binding.m_coarseningFactor1);
+    const uint64_t otherFieldsMask(~((field0.m_mask << field0.m_offset) | (field1.m_mask << field1.m_offset)));
 
-    const float radiationLength((pandora::ECAL == caloHitParameters.m_hitType.Get()) ? m_settings.m_absorberRadLengthECal :
-        (pandora::HCAL == caloHitParameters.m_hitType.Get()) ? m_settings.m_absorberRadLengthHCal : m_settings.m_absorberRadLengthOther);
-    const float interactionLength((pandora::ECAL == caloHitParameters.m_hitType.Get()) ? m_settings.m_absorberIntLengthECal :
-        (pandora::HCAL == caloHitParameters.m_hitType.Get()) ? m_settings.m_absorberIntLengthHCal : m_settings.m_absorberIntLengthOther);
+    // Floor division, so that signed cell indices are merged in blocks of the same size on both sides of zero
+    const auto coarsenIndex = [](const long long index, const long long factor) { return (index >= 0) ? index / factor : (index - factor + 1) / factor; };
 
-    const float layerAbsorberThickness(layerLayout.getAbsorberThickness(physicalLayer));
-    caloHitParameters.m_nCellRadiationLengths = radiationLength * layerAbsorberThickness;
-    caloHitParameters.m_nCellInteractionLengths = interactionLength * layerAbsorberThickness;
+    m_virtualCells.clear();
+    m_virtualCellIndices.Clear();
+    m_virtualCellIndices.Reserve(nSelected);
 
-    if (caloHitParameters.m_nCellRadiationLengths.Get() < std::numeric_limits<float>::epsilon() || caloHitParameters.m_nCellInteractionLengths.Get() < std::numeric_limits<float>::epsilon())
+    for (unsigned int iSelected = 0; iSelected < nSelected; ++iSelected)
     {
-        std::cout<<"WARNING CaloHitCreator::GetEndCapCaloHitProperties Calo hit has 0 radiation length or interaction length: \
-            not creating a Pandora calo hit." << std::endl;
-        throw pandora::StatusCodeException(pandora::STATUS_CODE_INVALID_PARAMETER);
-    }
+        const uint64_t cellId(columns.m_cellIds[iSelected]);
+        const uint64_t virtualCellId((cellId & otherFieldsMask) |
+            ((static_cast<uint64_t>(coarsenIndex(field0.Decode(cellId), factor0)) & field0.m_mask) << field0.m_offset) |
+            ((static_cast<uint64_t>(coarsenIndex(field1.Decode(cellId), factor1)) & field1.m_mask) << field1.m_offset));
 
-    absorberCorrection = 1.;
-    for (unsigned int i = 0, iMax = layerLayout.getNLayers(); i < iMax; ++i)
-    {
-        const float absorberThickness(layerLayout.getAbsorberThickness(i));
+        unsigned int virtualCellIndex(0);
+        const bool isNewVirtualCell(m_virtualCellIndices.Insert(virtualCellId, m_virtualCells.size(), virtualCellIndex));
+
+        // Hits without positive energy get a vanishing weight, so a virtual cell of only such hits sits at the mean of their positions
+        const float energy(columns.m_energies[iSelected]);
+        const float weight(std::max(energy, std::numeric_limits<float>::min()));
 
-        if (absorberThickness < std::numeric_limits<float>::epsilon())
+        if (isNewVirtualCell)
+        {
+            VirtualCell virtualCell;
+            virtualCell.m_seed = iSelected;
+            virtualCell.m_seedEnergy = energy;
+            virtualCell.m_energy = energy;
+            virtualCell.m_weight = weight;
+            virtualCell.m_weightedX = weight * columns.m_x[iSelected];
+            virtualCell.m_weightedY = weight * columns.m_y[iSelected];
+            virtualCell.m_weightedZ = weight * columns.m_z[iSelected];
+            m_virtualCells.push_back(virtualCell);
             continue;
+        }
 
-        if (layerAbsorberThickness > std::numeric_limits<float>::epsilon())
-            absorberCorrection = absorberThickness / layerAbsorberThickness;
+        VirtualCell &virtualCell(m_virtualCells[virtualCellIndex]);
+
+        if (energy > virtualCell.m_seedEnergy)
+        {
+            virtualCell.m_seed = iSelected;
+            virtualCell.m_seedEnergy = energy;
+        }
 
-        break;
+        virtualCell.m_energy += energy;
+        virtualCell.m_weight += weight;
+        virtualCell.m_weightedX += weight * columns.m_x[iSelected];
+        virtualCell.m_weightedY += weight * columns.m_y[iSelected];
+        virtualCell.m_weightedZ += weight * columns.m_z[iSelected];
     }
 
-    caloHitParameters.m_cellNormalVector = (pCaloHit->getPosition()[2] > 0) ? pandora::CartesianVector(0, 0, 1) :
-        pandora::CartesianVector(0, 0, -1);
+    // The members of virtual cell i all sit at column index i or above, so writing the cells in order only overwrites columns already read
+    const unsigned int nVirtualCells(m_virtualCells.size());
+
+    for (unsigned int iCell = 0; iCell < nVirtualCells; ++iCell)
+    {
+        const VirtualCell &virtualCell(m_virtualCells[iCell]);
+        columns.m_indices[iCell] = columns.m_indices[virtualCell.m_seed];
+        columns.m_cellIds[iCell] = columns.m_cellIds[virtualCell.m_seed];
+        columns.m_energies[iCell] = virtualCell.m_energy;
+        columns.m_x[iCell] = virtualCell.m_weightedX / virtualCell.m_weight;
+        columns.m_y[iCell] = virtualCell.m_weightedY / virtualCell.m_weight;
+        columns.m_z[iCell] = virtualCell.m_weightedZ / virtualCell.m_weight;
+    }
+
+    columns.m_indices.resize(nVirtualCells);
+    columns.m_energies.resize(nVirtualCells);
+    columns.m_cellIds.resize(nVirtualCells);
+    columns.m_x.resize(nVirtualCells);
+    columns.m_y.resize(nVirtualCells);
+    columns.m_z.resize(nVirtualCells);
+
+    m_nMergedCaloHits += nSelected - nVirtualCells;
+    return nVirtualCells;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void CaloHitCreator::GetBarrelCaloHitProperties(const edm4hep::CalorimeterHit *const pCaloHit, const gear::LayerLayout &layerLayout,
-    unsigned int barrelSymmetryOrder, float barrelPhi0, unsigned int staveNumber, PandoraApi::CaloHit::Parameters &caloHitParameters,
-    float &absorberCorrection) const
+edm4hep::CalorimeterHit *CaloHitCreator::StoreCaloHit(const edm4hep::CalorimeterHit &caloHit)
 {
-    caloHitParameters.m_hitRegion = pandora::BARREL;
+    if (m_caloHitStore.size() == m_caloHitStore.capacity())
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_OUT_OF_RANGE);
 
-    const int physicalLayer(std::min(static_cast<int>(caloHitParameters.m_layer.Get()), layerLayout.getNLayers() - 1));
-    caloHitParameters.m_cellSize0 = layerLayout.getCellSize0(physicalLayer);
-    caloHitParameters.m_cellSize1 = layerLayout.getCellSize1(physicalLayer);
-    caloHitParameters.m_cellThickness = layerLayout.getThickness(physicalLayer);
+    m_caloHitStore.push_back(caloHit);
+    return &m_caloHitStore.back();
+}
 
-    const float radiationLength((pandora::ECAL == caloHitParameters.m_hitType.Get()) ? m_settings.m_absorberRadLengthECal :
-        (pandora::HCAL == caloHitParameters.m_hitType.Get()) ? m_settings.m_absorberRadLengthHCal : m_settings.m_absorberRadLengthOther);
-    const float interactionLength((pandora::ECAL == caloHitParameters.m_hitType.Get()) ? m_settings.m_absorberIntLengthECal :
-        (pandora::HCAL == caloHitParameters.m_hitType.Get()) ? m_settings.m_absorberIntLengthHCal : m_settings.m_absorberIntLengthOther);
+//------------------------------------------------------------------------------------------------------------------------------------------
 
-    const float layerAbsorberThickness(layerLayout.getAbsorberThickness(physicalLayer));
-    caloHitParameters.m_nCellRadiationLengths = radiationLength * layerAbsorberThickness;
-    caloHitParameters.m_nCellInteractionLengths = interactionLength * layerAbsorberThickness;
+void CaloHitCreator::SetLayerProperties(const LayerPropertiesTable &layerTable, PandoraApi::CaloHit::Parameters &caloHitParameters,
+    float &absorberCorrection) const
+{
+    if (layerTable.empty())
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_INVALID_PARAMETER);
+
+    const LayerProperties &layerProperties(layerTable[std::min(static_cast<size_t>(caloHitParameters.m_layer.Get()), layerTable.size() - 1)]);
+
+    caloHitParameters.m_cellSize0 = layerProperties.m_cellSize0;
+    caloHitParameters.m_cellSize1 = layerProperties.m_cellSize1;
+    caloHitParameters.m_cellThickness = layerProperties.m_cellThickness;
+    caloHitParameters.m_nCellRadiationLengths = layerProperties.m_nCellRadiationLengths;
+    caloHitParameters.m_nCellInteractionLengths = layerProperties.m_nCellInteractionLengths;
+    absorberCorrection = layerProperties.m_absorberCorrection;
 
-    if (caloHitParameters.m_nCellRadiationLengths.Get() < std::numeric_limits<float>::epsilon() || caloHitParameters.m_nCellInteractionLengths.Get() < std::numeric_limits<float>::epsilon())
+    if (layerProperties.m_nCellRadiationLengths < std::numeric_limits<float>::epsilon() || layerProperties.m_nCellInteractionLengths < std::numeric_limits<float>::epsilon())
     {
-        std::cout<<"WARNIN CaloHitCreator::GetBarrelCaloHitProperties Calo hit has 0 radiation length or interaction length: \
+        std::cout<<"WARNING CaloHitCreator::SetLayerProperties Calo hit has 0 radiation length or interaction length: \
             not creating a Pandora calo hit." << std::endl;
         throw pandora::StatusCodeException(pandora::STATUS_CODE_INVALID_PARAMETER);
     }
+}
 
-    absorberCorrection = 1.;
-    for (unsigned int i = 0, iMax = layerLayout.getNLayers(); i < iMax; ++i)
-    {
-        const float absorberThickness(layerLayout.getAbsorberThickness(i));
+//------------------------------------------------------------------------------------------------------------------------------------------
 
-        if (absorberThickness < std::numeric_limits<float>::epsilon())
-            continue;
+void CaloHitCreator::GetEndCapCaloHitProperties(const edm4hep::CalorimeterHit *const pCaloHit, const LayerPropertiesTable &layerTable,
+    PandoraApi::CaloHit::Parameters &caloHitParameters, float &absorberCorrection) const
+{
+    caloHitParameters.m_hitRegion = pandora::ENDCAP;
+    this->SetLayerProperties(layerTable, caloHitParameters, absorberCorrection);
 
-        if (layerAbsorberThickness > std::numeric_limits<float>::epsilon())
-            absorberCorrection = absorberThickness / layerAbsorberThickness;
+    caloHitParameters.m_cellNormalVector = (pCaloHit->getPosition()[2] > 0) ? pandora::CartesianVector(0, 0, 1) :
+        pandora::CartesianVector(0, 0, -1);
+}
 
-        break;
-    }
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CaloHitCreator::GetBarrelCaloHitProperties(const edm4hep::CalorimeterHit *const pCaloHit, const LayerPropertiesTable &layerTable,
+    const PolygonNormals &barrelPolygon, unsigned int staveNumber, PandoraApi::CaloHit::Parameters &caloHitParameters,
+    float &absorberCorrection) const
+{
+    caloHitParameters.m_hitRegion = pandora::BARREL;
+    this->SetLayerProperties(layerTable, caloHitParameters, absorberCorrection);
 
-    if (barrelSymmetryOrder > 2)
+    if (barrelPolygon.m_symmetryOrder > 2)
     {
-        const float phi = barrelPhi0 + (2. * M_PI * static_cast<float>(staveNumber) / static_cast<float>(barrelSymmetryOrder));
-        caloHitParameters.m_cellNormalVector = pandora::CartesianVector(-std::sin(phi), std::cos(phi), 0);
+        if (staveNumber < barrelPolygon.m_staveNormals.size())
+        {
+            caloHitParameters.m_cellNormalVector = barrelPolygon.m_staveNormals[staveNumber];
+        }
+        else
+        {
+            const float phi = barrelPolygon.m_phi0 + (2. * M_PI * static_cast<float>(staveNumber) / static_cast<float>(barrelPolygon.m_symmetryOrder));
+            caloHitParameters.m_cellNormalVector = pandora::CartesianVector(-std::sin(phi), std::cos(phi), 0);
+        }
     }
     else
     {
@@ -677,7 +1254,7 @@ void CaloHitCreator::GetBarrelCaloHitProperties(const edm4hep::CalorimeterHit *c
 
         if (pCaloHitPosition[1] != 0)
         {
-            const float phi = barrelPhi0 + std::atan(pCaloHitPosition[0] / pCaloHitPosition[1]);
+            const float phi = barrelPolygon.m_phi0 + std::atan(pCaloHitPosition[0] / pCaloHitPosition[1]);
             caloHitParameters.m_cellNormalVector = pandora::CartesianVector(std::sin(phi), std::cos(phi), 0);
         }
         else
@@ -693,8 +1270,8 @@ void CaloHitCreator::GetBarrelCaloHitProperties(const edm4hep::CalorimeterHit *c
 int CaloHitCreator::GetNLayersFromEdge(const edm4hep::CalorimeterHit *const pCaloHit) const
 {
     // Calo hit coordinate calculations
-    const float barrelMaximumRadius(this->GetMaximumRadius(pCaloHit, m_hCalBarrelOuterSymmetry, m_hCalBarrelOuterPhi0));
-    const float endCapMaximumRadius(this->GetMaximumRadius(pCaloHit, m_settings.m_hCalEndCapInnerSymmetryOrder, m_settings.m_hCalEndCapInnerPhiCoordinate));
+    const float barrelMaximumRadius(this->GetMaximumRadius(pCaloHit, m_hCalBarrelOuterPolygon));
+    const float endCapMaximumRadius(this->GetMaximumRadius(pCaloHit, m_hCalEndCapInnerPolygon));
     const float caloHitAbsZ(std::fabs(pCaloHit->getPosition()[2]));
 
     // Distance from radial outer
@@ -732,24 +1309,20 @@ int CaloHitCreator::GetNLayersFromEdge(const edm4hep::CalorimeterHit *const pCal
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-float CaloHitCreator::GetMaximumRadius(const edm4hep::CalorimeterHit *const pCaloHit, const unsigned int symmetryOrder, const float phi0) const
+float CaloHitCreator::GetMaximumRadius(const edm4hep::CalorimeterHit *const pCaloHit, const PolygonNormals &polygon) const
 {
-    
-    const float pCaloHitPosition[3]={pCaloHit->getPosition()[0], pCaloHit->getPosition()[1], pCaloHit->getPosition()[2]};
-    if (symmetryOrder <= 2)
-        return std::sqrt((pCaloHitPosition[0] * pCaloHitPosition[0]) + (pCaloHitPosition[1] * pCaloHitPosition[1]));
+    const float x(pCaloHit->getPosition()[0]), y(pCaloHit->getPosition()[1]);
 
-    float maximumRadius(0.f);
-    const float twoPi(2.f * M_PI);
+    if (polygon.m_symmetryOrder <= 2)
+        return std::sqrt((x * x) + (y * y));
 
-    for (unsigned int i = 0; i < symmetryOrder; ++i)
-    {
-        const float phi = phi0 + i * twoPi / static_cast<float>(symmetryOrder);
-        float radius = pCaloHitPosition[0] * std::cos(phi) + pCaloHitPosition[1] * std::sin(phi);
+    // Distance to each face along its normal, a fixed length reduction without branches
+    const float *const pCosPhi(polygon.m_faceCosPhi.data());
+    const float *const pSinPhi(polygon.m_faceSinPhi.data());
+    float maximumRadius(0.f);
 
-        if (radius > maximumRadius)
-            maximumRadius = radius;
-    }
+    for (unsigned int i = 0, iMax = polygon.m_faceCosPhi.size(); i < iMax; ++i)
+        maximumRadius = std::max(maximumRadius, x * pCosPhi[i] + y * pSinPhi[i]);
 
     return maximumRadius;
 }
@@ -822,6 +1395,80 @@ CaloHitCreator::Settings::Settings() :
     m_eCalSiToHadGeVBarrel(1.f),
     m_eCalScToHadGeVBarrel(1.f),
     m_eCalSiToHadGeVEndCap(1.f),
-    m_eCalScToHadGeVEndCap(1.f)
+    m_eCalScToHadGeVEndCap(1.f),
+    m_nParameterThreads(1),
+    m_parameterChunkSize(256),
+    m_eCalTimeWindowMin(-std::numeric_limits<float>::max()),
+    m_eCalTimeWindowMax(std::numeric_limits<float>::max()),
+    m_hCalTimeWindowMin(-std::numeric_limits<float>::max()),
+    m_hCalTimeWindowMax(std::numeric_limits<float>::max()),
+    m_muonTimeWindowMin(-std::numeric_limits<float>::max()),
+    m_muonTimeWindowMax(std::numeric_limits<float>::max()),
+    m_lCalTimeWindowMin(-std::numeric_limits<float>::max()),
+    m_lCalTimeWindowMax(std::numeric_limits<float>::max()),
+    m_lHCalTimeWindowMin(-std::numeric_limits<float>::max()),
+    m_lHCalTimeWindowMax(std::numeric_limits<float>::max()),
+    m_timeWindowTofCorrection(0),
+    m_cellCoarseningFactor0(1),
+    m_cellCoarseningFactor1(1),
+    m_duplicatePolicy(KEEP_DUPLICATES)
 {
 }
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CaloHitCreator::CollectionBinding::CollectionBinding(const std::string &collectionName) :
+    m_collectionName(collectionName),
+    m_hasCellIdFields(false),
+    m_barrelOuterZ(0.f),
+    m_toMip(1.f),
+    m_mipThreshold(0.f),
+    m_toEMGeV(1.f),
+    m_toHadGeVBarrel(1.f),
+    m_toHadGeVEndCap(1.f),
+    m_maxHadronicEnergy(std::numeric_limits<float>::max()),
+    m_splitStrips(false),
+    m_isDigital(false),
+    m_digitalHitEnergy(0.f),
+    m_hasTimeWindow(false),
+    m_timeWindowMin(-std::numeric_limits<float>::max()),
+    m_timeWindowMax(std::numeric_limits<float>::max()),
+    m_isCoarsened(false),
+    m_coarseningFactor0(1),
+    m_coarseningFactor1(1)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CaloHitCreator::PolygonNormals::PolygonNormals() :
+    m_symmetryOrder(0),
+    m_phi0(0.f)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CaloHitCreator::PolygonNormals::PolygonNormals(const unsigned int symmetryOrder, const float phi0) :
+    m_symmetryOrder(symmetryOrder),
+    m_phi0(phi0)
+{
+    if (symmetryOrder <= 2)
+        return;
+
+    // Evaluated exactly as the per hit calculations they replace, so that the results do not change
+    const float twoPi(2.f * M_PI);
+
+    for (unsigned int i = 0; i < symmetryOrder; ++i)
+    {
+        const float phi = phi0 + i * twoPi / static_cast<float>(symmetryOrder);
+        m_faceCosPhi.push_back(std::cos(phi));
+        m_faceSinPhi.push_back(std::sin(phi));
+    }
+
+    for (unsigned int staveNumber = 0; staveNumber <= symmetryOrder; ++staveNumber)
+    {
+        const float phi = phi0 + (2. * M_PI * static_cast<float>(staveNumber) / static_cast<float>(symmetryOrder));
+        m_staveNormals.push_back(pandora::CartesianVector(-std::sin(phi), std::cos(phi), 0));
+    }
+}
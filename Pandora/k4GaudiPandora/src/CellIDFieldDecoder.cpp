@@ -0,0 +1,126 @@
+/**
+ *
+ *  @brief  Implementation of the cell id field decoder class.
+ *
+ *  $Log: $
+ */
+
+#include "Pandora/StatusCodes.h"
+
+#include "CellIDFieldDecoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+CellIDFieldDecoder::CellIDFieldDecoder(const std::string &encodingString) :
+    m_encodingString(encodingString)
+{
+    std::stringstream encodingStream(encodingString);
+    std::string fieldDescription;
+    int nextOffset(0);
+
+    while (std::getline(encodingStream, fieldDescription, ','))
+    {
+        std::vector<std::string> tokens;
+        std::stringstream fieldStream(fieldDescription);
+
+        for (std::string token; std::getline(fieldStream, token, ':'); )
+            tokens.push_back(token);
+
+        if ((tokens.size() < 2) || (tokens.size() > 3) || tokens[0].empty() || this->HasField(tokens[0]))
+        {
+            std::cout << "CellIDFieldDecoder: invalid field '" << fieldDescription << "' in encoding " << encodingString << std::endl;
+            throw pandora::StatusCodeException(pandora::STATUS_CODE_INVALID_PARAMETER);
+        }
+
+        const int offset((3 == tokens.size()) ? std::atoi(tokens[1].c_str()) : nextOffset);
+        const int signedWidth(std::atoi(tokens.back().c_str()));
+        const int width(std::abs(signedWidth));
+
+        if ((offset < 0) || (0 == width) || (offset + width > 64))
+        {
+            std::cout << "CellIDFieldDecoder: field '" << fieldDescription << "' does not fit in 64 bits, encoding " << encodingString << std::endl;
+            throw pandora::StatusCodeException(pandora::STATUS_CODE_INVALID_PARAMETER);
+        }
+
+        m_fieldMap.insert(FieldMap::value_type(tokens[0], Field(offset, width, signedWidth < 0)));
+        nextOffset = offset + width;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const CellIDFieldDecoder::Field &CellIDFieldDecoder::GetField(const std::string &name) const
+{
+    const FieldMap::const_iterator iter(m_fieldMap.find(name));
+
+    if (m_fieldMap.end() == iter)
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_NOT_FOUND);
+
+    return iter->second;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CellIDFieldDecoder::DecodeColumn(const Field &field, const CellIdVector &cellIds, FieldValueVector &values)
+{
+    const size_t nCellIds(cellIds.size());
+    values.resize(nCellIds);
+
+    const uint64_t *const pCellIds(cellIds.data());
+    int *const pValues(values.data());
+
+    if (0 == field.m_width)
+    {
+        std::fill(pValues, pValues + nCellIds, 0);
+    }
+    else if (field.m_isSigned)
+    {
+        const unsigned int upShift(64 - field.m_offset - field.m_width), downShift(64 - field.m_width);
+
+        for (size_t i = 0; i < nCellIds; ++i)
+            pValues[i] = static_cast<int>(static_cast<int64_t>(pCellIds[i] << upShift) >> downShift);
+    }
+    else
+    {
+        const unsigned int offset(field.m_offset);
+        const uint64_t mask(field.m_mask);
+
+        for (size_t i = 0; i < nCellIds; ++i)
+            pValues[i] = static_cast<int>((pCellIds[i] >> offset) & mask);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CellIDFieldDecoder::GetCellIds(const edm4hep::CalorimeterHitCollection &caloHitCollection, CellIdVector &cellIds)
+{
+    const size_t nCaloHits(caloHitCollection.size());
+    cellIds.resize(nCaloHits);
+
+    for (size_t i = 0; i < nCaloHits; ++i)
+        cellIds[i] = caloHitCollection.at(i).getCellID();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CellIDFieldDecoder::Field::Field() :
+    m_offset(0),
+    m_width(0),
+    m_isSigned(false),
+    m_mask(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CellIDFieldDecoder::Field::Field(const unsigned int offset, const unsigned int width, const bool isSigned) :
+    m_offset(offset),
+    m_width(width),
+    m_isSigned(isSigned),
+    m_mask((width >= 64) ? ~uint64_t(0) : ((uint64_t(1) << width) - 1))
+{
+}
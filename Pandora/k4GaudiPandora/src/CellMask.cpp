@@ -0,0 +1,124 @@
+/**
+ *
+ *  @brief  Implementation of the cell mask class.
+ *
+ *  $Log: $
+ */
+
+#include "Pandora/StatusCodes.h"
+
+#include "CellMask.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+CellMask::CellMask() :
+    m_filterBitMask(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CellMask::MaskCell(const uint64_t cellId)
+{
+    this->AddCell(cellId, std::numeric_limits<float>::infinity());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CellMask::SetCellThreshold(const uint64_t cellId, const float mipThreshold)
+{
+    if (!std::isfinite(mipThreshold))
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_INVALID_PARAMETER);
+
+    this->AddCell(cellId, mipThreshold);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CellMask::ReadFile(const std::string &fileName, CollectionCellMaskMap &cellMasks)
+{
+    std::ifstream file(fileName.c_str());
+
+    if (!file.good())
+    {
+        std::cout << "CellMask: cannot open cell mask file " << fileName << std::endl;
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_NOT_FOUND);
+    }
+
+    unsigned int lineNumber(0);
+
+    for (std::string line; std::getline(file, line); )
+    {
+        ++lineNumber;
+        const std::string::size_type commentStart(line.find('#'));
+
+        if (std::string::npos != commentStart)
+            line.erase(commentStart);
+
+        std::stringstream lineStream(line);
+        std::string collectionName, cellIdString, mipThresholdString, extra;
+
+        if (!(lineStream >> collectionName))
+            continue;
+
+        lineStream >> cellIdString >> mipThresholdString >> extra;
+
+        char *pCellIdEnd(NULL), *pMipThresholdEnd(NULL);
+        errno = 0;
+        const uint64_t cellId(std::strtoull(cellIdString.c_str(), &pCellIdEnd, 0));
+        const float mipThreshold(mipThresholdString.empty() ? 0.f : std::strtof(mipThresholdString.c_str(), &pMipThresholdEnd));
+
+        if (cellIdString.empty() || ('-' == cellIdString[0]) || (0 != *pCellIdEnd) || (0 != errno) || !extra.empty() ||
+            (!mipThresholdString.empty() && ((0 != *pMipThresholdEnd) || !std::isfinite(mipThreshold))))
+        {
+            std::cout << "CellMask: malformed line " << lineNumber << " of " << fileName << ", expected 'collection cellID [mipThreshold]'" << std::endl;
+            throw pandora::StatusCodeException(pandora::STATUS_CODE_INVALID_PARAMETER);
+        }
+
+        if (mipThresholdString.empty())
+        {
+            cellMasks[collectionName].MaskCell(cellId);
+        }
+        else
+        {
+            cellMasks[collectionName].SetCellThreshold(cellId, mipThreshold);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CellMask::AddCell(const uint64_t cellId, const float mipThreshold)
+{
+    m_cellThresholds[cellId] = mipThreshold;
+
+    // At least sixteen filter bits per listed cell keep the filter below ~6% occupancy
+    const uint64_t nRequiredBits(std::max(uint64_t(64), uint64_t(16) * m_cellThresholds.size()));
+
+    if (!m_filter.empty() && (m_filterBitMask + 1 >= nRequiredBits))
+    {
+        const uint64_t bit(GetFilterBit(cellId) & m_filterBitMask);
+        m_filter[bit >> 6] |= uint64_t(1) << (bit & 63);
+        return;
+    }
+
+    uint64_t nBits(64);
+
+    while (nBits < nRequiredBits)
+        nBits <<= 1;
+
+    m_filterBitMask = nBits - 1;
+    m_filter.assign(nBits / 64, 0);
+
+    for (const CellThresholdMap::value_type &cellThreshold : m_cellThresholds)
+    {
+        const uint64_t bit(GetFilterBit(cellThreshold.first) & m_filterBitMask);
+        m_filter[bit >> 6] |= uint64_t(1) << (bit & 63);
+    }
+}
@@ -0,0 +1,33 @@
+/**
+ *
+ *  @brief  Implementation of the collection maps class.
+ *
+ *  $Log: $
+ */
+
+#include "CollectionMaps.h"
+
+CollectionMaps::CollectionMaps()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+static void ForgetCollections(std::map<std::string, const T*> &collectionMap)
+{
+    for (typename std::map<std::string, const T*>::iterator iter = collectionMap.begin(); iter != collectionMap.end(); ++iter)
+        iter->second = NULL;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CollectionMaps::clear()
+{
+    ForgetCollections(collectionMap_MC);
+    ForgetCollections(collectionMap_CaloHit);
+    ForgetCollections(collectionMap_Vertex);
+    ForgetCollections(collectionMap_Track);
+    ForgetCollections(collectionMap_CaloRel);
+    ForgetCollections(collectionMap_TrkRel);
+}
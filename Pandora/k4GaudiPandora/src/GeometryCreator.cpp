@@ -4,8 +4,6 @@
  * 
  *  $Log: $
  */
-#include "GaudiKernel/IService.h"
-#include "GearSvc/IGearSvc.h"
 #include "gear/BField.h"
 #include "gear/GEAR.h"
 #include "gear/GearParameters.h"
@@ -14,10 +12,12 @@
 #include "gear/PadRowLayout2D.h"
 #include "gear/LayerLayout.h"
 #include "GeometryCreator.h"
+#include "PandoraInputRecorder.h"
 
 GeometryCreator::GeometryCreator(const Settings &settings, const pandora::Pandora *const pPandora) :
     m_settings(settings),
-    m_pPandora(pPandora)
+    m_pPandora(pPandora),
+    m_pInputRecorder(NULL)
 {
 }
 
@@ -29,16 +29,9 @@ GeometryCreator::~GeometryCreator()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-pandora::StatusCode GeometryCreator::CreateGeometry(ISvcLocator* svcloc) 
+pandora::StatusCode GeometryCreator::CreateGeometry(gear::GearMgr *const pGearMgr)
 {
-    IGearSvc*  iSvc = 0;
-    StatusCode sc = svcloc->service("GearSvc", iSvc, false);
-    if ( !sc ) 
-    {
-        throw "Failed to find GearSvc ...";
-    }
-    _GEAR = iSvc->getGearMgr();
-    
+    _GEAR = pGearMgr;
 
     try
     {
@@ -52,10 +45,20 @@ pandora::StatusCode GeometryCreator::CreateGeometry(ISvcLocator* svcloc)
             this->SetILDSpecificGeometry(subDetectorTypeMap, subDetectorNameMap);
         
         for (SubDetectorTypeMap::const_iterator iter = subDetectorTypeMap.begin(), iterEnd = subDetectorTypeMap.end(); iter != iterEnd; ++iter)
+        {
             PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Geometry::SubDetector::Create(*m_pPandora, iter->second));
 
+            if (NULL != m_pInputRecorder)
+                m_pInputRecorder->RecordSubDetector(iter->second);
+        }
+
         for (SubDetectorNameMap::const_iterator iter = subDetectorNameMap.begin(), iterEnd = subDetectorNameMap.end(); iter != iterEnd; ++iter)
+        {
             PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Geometry::SubDetector::Create(*m_pPandora, iter->second));
+
+            if (NULL != m_pInputRecorder)
+                m_pInputRecorder->RecordSubDetector(iter->second);
+        }
     }
     catch (gear::Exception &exception)
     {
@@ -358,6 +361,9 @@ pandora::StatusCode GeometryCreator::CreateHCalBarrelConcentricGaps() const
 
     PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Geometry::ConcentricGap::Create(*m_pPandora, gapParameters));
 
+    if (NULL != m_pInputRecorder)
+        m_pInputRecorder->RecordConcentricGap(gapParameters);
+
     return pandora::STATUS_CODE_SUCCESS;
 }
 
@@ -389,6 +395,9 @@ pandora::StatusCode GeometryCreator::CreateRegularBoxGaps(unsigned int symmetryO
             -sinPhi * basicSide3.GetX() + cosPhi * basicSide3.GetY(), basicSide3.GetZ());
 
         PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Geometry::BoxGap::Create(*m_pPandora, gapParameters));
+
+        if (NULL != m_pInputRecorder)
+            m_pInputRecorder->RecordBoxGap(gapParameters);
     }
 
     return pandora::STATUS_CODE_SUCCESS;
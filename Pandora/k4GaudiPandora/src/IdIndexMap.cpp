@@ -0,0 +1,100 @@
+/**
+ *
+ *  @brief  Implementation of the id index map class.
+ *
+ *  $Log: $
+ */
+
+#include "IdIndexMap.h"
+
+#include <algorithm>
+
+IdIndexMap::IdIndexMap() :
+    m_slotMask(0),
+    m_hashShift(64),
+    m_nEntries(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void IdIndexMap::Clear()
+{
+    if (0 == m_nEntries)
+        return;
+
+    std::fill(m_isOccupied.begin(), m_isOccupied.end(), 0);
+    m_nEntries = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void IdIndexMap::Reserve(const unsigned int nEntries)
+{
+    // At most half the slots are occupied, which keeps the linear probe sequences short
+    unsigned int nSlots(std::max(16u, static_cast<unsigned int>(m_isOccupied.size())));
+
+    while (nSlots < 2 * nEntries)
+        nSlots <<= 1;
+
+    if (nSlots != m_isOccupied.size())
+        this->Rehash(nSlots);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool IdIndexMap::Insert(const uint64_t id, const unsigned int index, unsigned int &existingIndex)
+{
+    if (2 * (m_nEntries + 1) > m_isOccupied.size())
+        this->Reserve(m_nEntries + 1);
+
+    unsigned int slot(this->GetHomeSlot(id));
+
+    for (; m_isOccupied[slot]; slot = (slot + 1) & m_slotMask)
+    {
+        if (id == m_ids[slot])
+        {
+            existingIndex = m_indices[slot];
+            return false;
+        }
+    }
+
+    m_ids[slot] = id;
+    m_indices[slot] = index;
+    m_isOccupied[slot] = 1;
+    ++m_nEntries;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void IdIndexMap::Rehash(const unsigned int nSlots)
+{
+    std::vector<uint64_t> ids(nSlots);
+    std::vector<unsigned int> indices(nSlots);
+    std::vector<unsigned char> isOccupied(nSlots, 0);
+
+    m_ids.swap(ids);
+    m_indices.swap(indices);
+    m_isOccupied.swap(isOccupied);
+    m_slotMask = nSlots - 1;
+    m_hashShift = 64;
+
+    for (unsigned int n = nSlots; n > 1; n >>= 1)
+        --m_hashShift;
+
+    for (unsigned int oldSlot = 0, nOldSlots = isOccupied.size(); oldSlot < nOldSlots; ++oldSlot)
+    {
+        if (!isOccupied[oldSlot])
+            continue;
+
+        unsigned int slot(this->GetHomeSlot(ids[oldSlot]));
+
+        while (m_isOccupied[slot])
+            slot = (slot + 1) & m_slotMask;
+
+        m_ids[slot] = ids[oldSlot];
+        m_indices[slot] = indices[oldSlot];
+        m_isOccupied[slot] = 1;
+    }
+}
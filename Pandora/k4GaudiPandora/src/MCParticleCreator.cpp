@@ -14,8 +14,10 @@
 #include "edm4hep/Track.h" 
 #include "edm4hep/MCRecoTrackerAssociation.h" 
 #include "edm4hep/SimTrackerHitConst.h" 
-#include "PandoraPFAlg.h"
+#include "CollectionMaps.h"
 #include "MCParticleCreator.h"
+#include "PandoraInputRecorder.h"
+#include "TraceRecorder.h"
 
 #include <cmath>
 #include <limits>
@@ -24,7 +26,9 @@
 MCParticleCreator::MCParticleCreator(const Settings &settings, const pandora::Pandora *const pPandora) :
     m_settings(settings),
     m_pPandora(pPandora),
-    m_bField(settings.m_bField)
+    m_bField(settings.m_bField),
+    m_pTraceRecorder(NULL),
+    m_pInputRecorder(NULL)
 {
 m_id_pMC_map = new std::map<unsigned int, const edm4hep::MCParticle*>;
 }
@@ -33,25 +37,46 @@ m_id_pMC_map = new std::map<unsigned int, const edm4hep::MCParticle*>;
 
 MCParticleCreator::~MCParticleCreator()
 {
+    delete m_id_pMC_map;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-pandora::StatusCode MCParticleCreator::CreateMCParticles(const CollectionMaps& collectionMaps ) const
+pandora::StatusCode MCParticleCreator::CreateMCParticles(const CollectionMaps& collectionMaps )
 {
+    // Pandora keeps the addresses of the stored particles, so the store must never reallocate while the event is processed
+    size_t nMCParticles(0);
+
+    for (StringVector::const_iterator iter = m_settings.m_mcParticleCollections.begin(), iterEnd = m_settings.m_mcParticleCollections.end();
+        iter != iterEnd; ++iter)
+    {
+        const edm4hep::MCParticleCollection *const pMCParticleCollection(CollectionMaps::Find(collectionMaps.collectionMap_MC, *iter));
+
+        if (NULL != pMCParticleCollection)
+            nMCParticles += pMCParticleCollection->size();
+    }
+
+    m_mcParticleStore.reserve(nMCParticles);
+
     for (StringVector::const_iterator iter = m_settings.m_mcParticleCollections.begin(), iterEnd = m_settings.m_mcParticleCollections.end();
         iter != iterEnd; ++iter)
     {
-        if(collectionMaps.collectionMap_MC.find(*iter) == collectionMaps.collectionMap_MC.end()) continue;
+        const edm4hep::MCParticleCollection *const pMCParticleCollection(CollectionMaps::Find(collectionMaps.collectionMap_MC, *iter));
+        if(NULL == pMCParticleCollection) continue;
         try
         {
-            const std::vector<edm4hep::MCParticle>& pMCParticleCollection = (collectionMaps.collectionMap_MC.find(*iter))->second;
-            std::cout<<"Do CreateMCParticles, collection:"<<(*iter)<<", size="<<pMCParticleCollection.size()<<std::endl;
-            for (int im = 0; im < pMCParticleCollection.size(); im++)
+            std::cout<<"Do CreateMCParticles, collection:"<<(*iter)<<", size="<<pMCParticleCollection->size()<<std::endl;
+            ScopedTraceSpan traceSpan(m_pTraceRecorder, "CreateMCParticles");
+            traceSpan.SetDetail(*iter);
+            traceSpan.AddArg("nInput", pMCParticleCollection->size());
+            const size_t firstStoreIndex(m_mcParticleStore.size());
+
+            for (int im = 0; im < pMCParticleCollection->size(); im++)
             {
                 try
                 {
-                    const edm4hep::MCParticle& pMcParticle = pMCParticleCollection.at(im);
+                    m_mcParticleStore.push_back(pMCParticleCollection->at(im));
+                    const edm4hep::MCParticle& pMcParticle = m_mcParticleStore.back();
                     PandoraApi::MCParticle::Parameters mcParticleParameters;
                     mcParticleParameters.m_energy =   sqrt(pMcParticle.getMomentum()[0] * pMcParticle.getMomentum()[0] + pMcParticle.getMomentum()[1] * pMcParticle.getMomentum()[1] + pMcParticle.getMomentum()[2] * pMcParticle.getMomentum()[2] + pMcParticle.getMass() * pMcParticle.getMass());
                     mcParticleParameters.m_particleId = pMcParticle.getPDG();
@@ -69,23 +94,8 @@ pandora::StatusCode MCParticleCreator::CreateMCParticles(const CollectionMaps& c
 
                     PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::MCParticle::Create(*m_pPandora, mcParticleParameters));
 
-                    // Create parent-daughter relationships
-                    for(std::vector<edm4hep::ConstMCParticle>::const_iterator itDaughter = pMcParticle.daughters_begin(),
-                        itDaughterEnd = pMcParticle.daughters_end(); itDaughter != itDaughterEnd; ++itDaughter)
-                    {   
-                        for (int ida = 0; ida < pMCParticleCollection.size(); ida++)
-                        {
-                           if(pMCParticleCollection.at(ida).id()==(*itDaughter).id())
-                           {
-                              
-                                const edm4hep::MCParticle& dMcParticle = pMCParticleCollection.at(ida);
-                                if(&pMcParticle == &dMcParticle){std::cout<< "error, mother and daughter are the same mc particle, don't save SetMCParentDaughterRelationship"<<std::endl;}
-                                else PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetMCParentDaughterRelationship(*m_pPandora, &pMcParticle, &dMcParticle));
-                                break;
-                           }
-                        }
-                    }
-                    
+                    if (NULL != m_pInputRecorder)
+                        m_pInputRecorder->RecordMCParticle(mcParticleParameters);
                 }
                 catch (pandora::StatusCodeException &statusCodeException)
                 {
@@ -96,6 +106,36 @@ pandora::StatusCode MCParticleCreator::CreateMCParticles(const CollectionMaps& c
                     std::cout << "Failed to extract MCParticle: " <<  std::endl;
                 }
             }
+
+            // Create parent-daughter relationships, once all particles of the collection are known to pandora
+            for (size_t iStore = firstStoreIndex; iStore < m_mcParticleStore.size(); iStore++)
+            {
+                const edm4hep::MCParticle& pMcParticle = m_mcParticleStore[iStore];
+
+                for(std::vector<edm4hep::ConstMCParticle>::const_iterator itDaughter = pMcParticle.daughters_begin(),
+                    itDaughterEnd = pMcParticle.daughters_end(); itDaughter != itDaughterEnd; ++itDaughter)
+                {
+                    try
+                    {
+                        std::map<unsigned int, const edm4hep::MCParticle*>::const_iterator daughterIter = m_id_pMC_map->find((*itDaughter).id());
+                        if(daughterIter == m_id_pMC_map->end()) continue;
+
+                        const edm4hep::MCParticle* pDaughter = daughterIter->second;
+                        if(&pMcParticle == pDaughter){std::cout<< "error, mother and daughter are the same mc particle, don't save SetMCParentDaughterRelationship"<<std::endl;}
+                        else
+                        {
+                            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetMCParentDaughterRelationship(*m_pPandora, &pMcParticle, pDaughter));
+
+                            if (NULL != m_pInputRecorder)
+                                m_pInputRecorder->RecordMCParentDaughterRelationship(&pMcParticle, pDaughter);
+                        }
+                    }
+                    catch (pandora::StatusCodeException &statusCodeException)
+                    {
+                        std::cout << "Failed to extract MCParticle relationship: " << statusCodeException.ToString() << std::endl;
+                    }
+                }
+            }
         }
         catch (...)
         {
@@ -114,21 +154,26 @@ pandora::StatusCode MCParticleCreator::CreateCaloHitToMCParticleRelationships(co
     for (StringVector::const_iterator iter = m_settings.m_CaloHitRelationCollections.begin(), iterEnd = m_settings.m_CaloHitRelationCollections.end();
          iter != iterEnd; ++iter)
     {
-        if(collectionMaps.collectionMap_CaloRel.find(*iter) == collectionMaps.collectionMap_CaloRel.end()) continue;
+        const edm4hep::MCRecoCaloAssociationCollection *const pMCRecoCaloAssociationCollection(CollectionMaps::Find(collectionMaps.collectionMap_CaloRel, *iter));
+        if(NULL == pMCRecoCaloAssociationCollection) continue;
         try
         {
-            const std::vector<edm4hep::MCRecoCaloAssociation>& pMCRecoCaloAssociationCollection = (collectionMaps.collectionMap_CaloRel.find(*iter))->second;
+            ScopedTraceSpan traceSpan(m_pTraceRecorder, "CreateCaloHitToMCParticleRelationships");
+            traceSpan.SetDetail(*iter);
+            traceSpan.AddArg("nCaloHits", calorimeterHitVector.size());
+            traceSpan.AddArg("nAssociations", pMCRecoCaloAssociationCollection->size());
 
             for (unsigned i_calo=0; i_calo < calorimeterHitVector.size(); i_calo++)
             {
                 try
                 {
                     mcParticleToEnergyWeightMap.clear();
-                    for(unsigned ic=0; ic < pMCRecoCaloAssociationCollection.size(); ic++)
+                    for(unsigned ic=0; ic < pMCRecoCaloAssociationCollection->size(); ic++)
                     {
-                        if( pMCRecoCaloAssociationCollection.at(ic).getRec().id() != (*(calorimeterHitVector.at(i_calo))).id() ) continue;
+                        const edm4hep::MCRecoCaloAssociation association = pMCRecoCaloAssociationCollection->at(ic);
+                        if( association.getRec().id() != (*(calorimeterHitVector.at(i_calo))).id() ) continue;
                         
-                        const edm4hep::ConstSimCalorimeterHit pSimHit = pMCRecoCaloAssociationCollection.at(ic).getSim();
+                        const edm4hep::ConstSimCalorimeterHit pSimHit = association.getSim();
                         for (int iCont = 0, iEnd = pSimHit.contributions_size(); iCont < iEnd; ++iCont)
                         {
                             edm4hep::ConstCaloHitContribution conb = pSimHit.getContributions(iCont);
@@ -146,6 +191,9 @@ pandora::StatusCode MCParticleCreator::CreateCaloHitToMCParticleRelationships(co
                     {
                         PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetCaloHitToMCParticleRelationship(*m_pPandora,
                             calorimeterHitVector.at(i_calo), mcParticleIter->first, mcParticleIter->second));
+
+                        if (NULL != m_pInputRecorder)
+                            m_pInputRecorder->RecordCaloHitToMCParticleRelationship(calorimeterHitVector.at(i_calo), mcParticleIter->first, mcParticleIter->second);
                     }
                 }
                 catch (pandora::StatusCodeException &statusCodeException)
@@ -170,6 +218,9 @@ pandora::StatusCode MCParticleCreator::CreateCaloHitToMCParticleRelationships(co
 
 pandora::StatusCode MCParticleCreator::CreateTrackToMCParticleRelationships(const CollectionMaps& collectionMaps, const TrackVector &trackVector) const
 {
+    ScopedTraceSpan traceSpan(m_pTraceRecorder, "CreateTrackToMCParticleRelationships");
+    traceSpan.AddArg("nTracks", trackVector.size());
+
     for (unsigned ik = 0; ik < trackVector.size(); ik++)
     {
         const edm4hep::Track *pTrack = trackVector.at(ik);
@@ -183,14 +234,15 @@ pandora::StatusCode MCParticleCreator::CreateTrackToMCParticleRelationships(cons
         {
             for (StringVector::const_iterator iter = m_settings.m_TrackRelationCollections.begin(), iterEnd = m_settings.m_TrackRelationCollections.end(); iter != iterEnd; ++iter)
             {
-                if(collectionMaps.collectionMap_TrkRel.find(*iter) == collectionMaps.collectionMap_TrkRel.end()) continue;
-                const std::vector<edm4hep::MCRecoTrackerAssociation>& pMCRecoTrackerAssociationCollection = (collectionMaps.collectionMap_TrkRel.find(*iter))->second;
+                const edm4hep::MCRecoTrackerAssociationCollection *const pMCRecoTrackerAssociationCollection(CollectionMaps::Find(collectionMaps.collectionMap_TrkRel, *iter));
+                if(NULL == pMCRecoTrackerAssociationCollection) continue;
                 for(unsigned ith=0 ; ith<pTrack->trackerHits_size(); ith++)
                 {
-                    for(unsigned ic=0; ic < pMCRecoTrackerAssociationCollection.size(); ic++)
+                    for(unsigned ic=0; ic < pMCRecoTrackerAssociationCollection->size(); ic++)
                     {
-                        if( pMCRecoTrackerAssociationCollection.at(ic).getRec().id() != pTrack->getTrackerHits(ith).id() ) continue;
-                        const edm4hep::ConstSimTrackerHit pSimHit = pMCRecoTrackerAssociationCollection.at(ic).getSim();
+                        const edm4hep::MCRecoTrackerAssociation association = pMCRecoTrackerAssociationCollection->at(ic);
+                        if( association.getRec().id() != pTrack->getTrackerHits(ith).id() ) continue;
+                        const edm4hep::ConstSimTrackerHit pSimHit = association.getSim();
                         const edm4hep::ConstMCParticle ipa = pSimHit.getMCParticle();
                         if( m_id_pMC_map->find(ipa.id()) == m_id_pMC_map->end() ) continue;
                         const float trueMomentum(pandora::CartesianVector(ipa.getMomentum()[0], ipa.getMomentum()[1], ipa.getMomentum()[2]).GetMagnitude());
@@ -206,6 +258,9 @@ pandora::StatusCode MCParticleCreator::CreateTrackToMCParticleRelationships(cons
             
             if (NULL == pBestMCParticle) continue;
             PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetTrackToMCParticleRelationship(*m_pPandora, pTrack, pBestMCParticle));
+
+            if (NULL != m_pInputRecorder)
+                m_pInputRecorder->RecordTrackToMCParticleRelationship(pTrack, pBestMCParticle, 1.f);
         }
         catch (pandora::StatusCodeException &statusCodeException)
         {
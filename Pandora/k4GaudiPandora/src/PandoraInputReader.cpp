@@ -0,0 +1,303 @@
+/**
+ *
+ *  @brief  Implementation of the pandora input reader class.
+ *
+ *  $Log: $
+ */
+
+#include "PandoraInputReader.h"
+
+#include <iostream>
+
+pandora::StatusCode PandoraInputReader::Open(const std::string &fileName)
+{
+    m_file.open(fileName.c_str(), std::ios::binary);
+
+    if (!m_file.good())
+    {
+        std::cout << "PandoraInputReader: cannot open " << fileName << std::endl;
+        return pandora::STATUS_CODE_NOT_FOUND;
+    }
+
+    unsigned int header[2] = {0, 0};
+    m_file.read(reinterpret_cast<char*>(header), sizeof(header));
+
+    if (!m_file.good() || (PandoraInputFormat::MAGIC != header[0]) || (PandoraInputFormat::VERSION != header[1]))
+    {
+        std::cout << "PandoraInputReader: " << fileName << " is not a pandora input file of version " << PandoraInputFormat::VERSION << std::endl;
+        return pandora::STATUS_CODE_INVALID_PARAMETER;
+    }
+
+    unsigned int blockType(0);
+    std::string payload;
+
+    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->ReadBlock(blockType, payload));
+
+    if (PandoraInputFormat::RUN_SETTINGS_BLOCK != blockType)
+        return pandora::STATUS_CODE_FAILURE;
+
+    PandoraInputFormat::InputBuffer buffer(payload);
+    m_runSettings.m_pandoraSettingsXmlFile = buffer.ReadString();
+    m_runSettings.m_innerBField = buffer.Read<float>();
+    m_runSettings.m_muonBarrelBField = buffer.Read<float>();
+    m_runSettings.m_muonEndCapBField = buffer.Read<float>();
+    m_runSettings.m_inputEnergyCorrectionPoints = buffer.ReadFloatVector();
+    m_runSettings.m_outputEnergyCorrectionPoints = buffer.ReadFloatVector();
+
+    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->ReadBlock(blockType, m_geometryPayload));
+
+    if (PandoraInputFormat::GEOMETRY_BLOCK != blockType)
+        return pandora::STATUS_CODE_FAILURE;
+
+    return pandora::STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+pandora::StatusCode PandoraInputReader::CreateGeometry(const pandora::Pandora &pandora) const
+{
+    PandoraInputFormat::InputBuffer buffer(m_geometryPayload);
+
+    while (!buffer.IsAtEnd())
+    {
+        const unsigned char recordType(buffer.Read<unsigned char>());
+
+        if (PandoraInputFormat::SUB_DETECTOR == recordType)
+        {
+            PandoraApi::Geometry::SubDetector::Parameters parameters;
+            parameters.m_subDetectorName = buffer.ReadString();
+            parameters.m_subDetectorType = static_cast<pandora::SubDetectorType>(buffer.Read<unsigned int>());
+            parameters.m_innerRCoordinate = buffer.Read<float>();
+            parameters.m_innerZCoordinate = buffer.Read<float>();
+            parameters.m_innerPhiCoordinate = buffer.Read<float>();
+            parameters.m_innerSymmetryOrder = buffer.Read<unsigned int>();
+            parameters.m_outerRCoordinate = buffer.Read<float>();
+            parameters.m_outerZCoordinate = buffer.Read<float>();
+            parameters.m_outerPhiCoordinate = buffer.Read<float>();
+            parameters.m_outerSymmetryOrder = buffer.Read<unsigned int>();
+            parameters.m_isMirroredInZ = (0 != buffer.Read<unsigned char>());
+            parameters.m_nLayers = buffer.Read<unsigned int>();
+
+            const unsigned int nLayerParameters(buffer.Read<unsigned int>());
+
+            for (unsigned int iLayer = 0; iLayer < nLayerParameters; ++iLayer)
+            {
+                PandoraApi::Geometry::LayerParameters layerParameters;
+                layerParameters.m_closestDistanceToIp = buffer.Read<float>();
+                layerParameters.m_nRadiationLengths = buffer.Read<float>();
+                layerParameters.m_nInteractionLengths = buffer.Read<float>();
+                parameters.m_layerParametersVector.push_back(layerParameters);
+            }
+
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Geometry::SubDetector::Create(pandora, parameters));
+        }
+        else if (PandoraInputFormat::BOX_GAP == recordType)
+        {
+            PandoraApi::Geometry::BoxGap::Parameters parameters;
+            parameters.m_vertex = buffer.ReadVector();
+            parameters.m_side1 = buffer.ReadVector();
+            parameters.m_side2 = buffer.ReadVector();
+            parameters.m_side3 = buffer.ReadVector();
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Geometry::BoxGap::Create(pandora, parameters));
+        }
+        else if (PandoraInputFormat::CONCENTRIC_GAP == recordType)
+        {
+            PandoraApi::Geometry::ConcentricGap::Parameters parameters;
+            parameters.m_minZCoordinate = buffer.Read<float>();
+            parameters.m_maxZCoordinate = buffer.Read<float>();
+            parameters.m_innerRCoordinate = buffer.Read<float>();
+            parameters.m_innerPhiCoordinate = buffer.Read<float>();
+            parameters.m_innerSymmetryOrder = buffer.Read<unsigned int>();
+            parameters.m_outerRCoordinate = buffer.Read<float>();
+            parameters.m_outerPhiCoordinate = buffer.Read<float>();
+            parameters.m_outerSymmetryOrder = buffer.Read<unsigned int>();
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Geometry::ConcentricGap::Create(pandora, parameters));
+        }
+        else
+        {
+            std::cout << "PandoraInputReader: unexpected geometry record type " << static_cast<unsigned int>(recordType) << std::endl;
+            return pandora::STATUS_CODE_FAILURE;
+        }
+    }
+
+    return pandora::STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+pandora::StatusCode PandoraInputReader::ReadEvent(Event &event)
+{
+    unsigned int blockType(0);
+    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->ReadBlock(blockType, event.m_payload));
+
+    if (PandoraInputFormat::EVENT_BLOCK != blockType)
+        return pandora::STATUS_CODE_FAILURE;
+
+    PandoraInputFormat::InputBuffer buffer(event.m_payload);
+    event.m_eventNumber = buffer.Read<int>();
+
+    return pandora::STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+pandora::StatusCode PandoraInputReader::ReplayEvent(const pandora::Pandora &pandora, const Event &event)
+{
+    PandoraInputFormat::InputBuffer buffer(event.m_payload);
+    buffer.Read<int>();
+    m_addressSlots.assign(buffer.Read<unsigned int>(), 0);
+
+    while (!buffer.IsAtEnd())
+    {
+        const unsigned char recordType(buffer.Read<unsigned char>());
+
+        switch (recordType)
+        {
+        case PandoraInputFormat::MC_PARTICLE :
+        {
+            PandoraApi::MCParticle::Parameters parameters;
+            parameters.m_pParentAddress = this->ReadAddress(buffer);
+            parameters.m_energy = buffer.Read<float>();
+            parameters.m_momentum = buffer.ReadVector();
+            parameters.m_vertex = buffer.ReadVector();
+            parameters.m_endpoint = buffer.ReadVector();
+            parameters.m_particleId = buffer.Read<int>();
+            parameters.m_mcParticleType = static_cast<pandora::MCParticleType>(buffer.Read<unsigned int>());
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::MCParticle::Create(pandora, parameters));
+            break;
+        }
+        case PandoraInputFormat::CALO_HIT :
+        {
+            PandoraApi::CaloHit::Parameters parameters;
+            parameters.m_pParentAddress = this->ReadAddress(buffer);
+            parameters.m_cellGeometry = static_cast<pandora::CellGeometry>(buffer.Read<unsigned int>());
+            parameters.m_positionVector = buffer.ReadVector();
+            parameters.m_expectedDirection = buffer.ReadVector();
+            parameters.m_cellNormalVector = buffer.ReadVector();
+            parameters.m_cellSize0 = buffer.Read<float>();
+            parameters.m_cellSize1 = buffer.Read<float>();
+            parameters.m_cellThickness = buffer.Read<float>();
+            parameters.m_nCellRadiationLengths = buffer.Read<float>();
+            parameters.m_nCellInteractionLengths = buffer.Read<float>();
+            parameters.m_time = buffer.Read<float>();
+            parameters.m_inputEnergy = buffer.Read<float>();
+            parameters.m_mipEquivalentEnergy = buffer.Read<float>();
+            parameters.m_electromagneticEnergy = buffer.Read<float>();
+            parameters.m_hadronicEnergy = buffer.Read<float>();
+            parameters.m_isDigital = (0 != buffer.Read<unsigned char>());
+            parameters.m_hitType = static_cast<pandora::HitType>(buffer.Read<unsigned int>());
+            parameters.m_hitRegion = static_cast<pandora::HitRegion>(buffer.Read<unsigned int>());
+            parameters.m_layer = buffer.Read<unsigned int>();
+            parameters.m_isInOuterSamplingLayer = (0 != buffer.Read<unsigned char>());
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(pandora, parameters));
+            break;
+        }
+        case PandoraInputFormat::TRACK :
+        {
+            PandoraApi::Track::Parameters parameters;
+            parameters.m_pParentAddress = this->ReadAddress(buffer);
+            parameters.m_d0 = buffer.Read<float>();
+            parameters.m_z0 = buffer.Read<float>();
+            parameters.m_particleId = buffer.Read<int>();
+            parameters.m_charge = buffer.Read<int>();
+            parameters.m_mass = buffer.Read<float>();
+            parameters.m_momentumAtDca = buffer.ReadVector();
+            const pandora::CartesianVector startPosition(buffer.ReadVector());
+            parameters.m_trackStateAtStart = pandora::TrackState(startPosition, buffer.ReadVector());
+            const pandora::CartesianVector endPosition(buffer.ReadVector());
+            parameters.m_trackStateAtEnd = pandora::TrackState(endPosition, buffer.ReadVector());
+            const pandora::CartesianVector calorimeterPosition(buffer.ReadVector());
+            parameters.m_trackStateAtCalorimeter = pandora::TrackState(calorimeterPosition, buffer.ReadVector());
+            parameters.m_timeAtCalorimeter = buffer.Read<float>();
+            parameters.m_reachesCalorimeter = (0 != buffer.Read<unsigned char>());
+            parameters.m_isProjectedToEndCap = (0 != buffer.Read<unsigned char>());
+            parameters.m_canFormPfo = (0 != buffer.Read<unsigned char>());
+            parameters.m_canFormClusterlessPfo = (0 != buffer.Read<unsigned char>());
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Track::Create(pandora, parameters));
+            break;
+        }
+        case PandoraInputFormat::MC_PARENT_DAUGHTER_RELATIONSHIP :
+        {
+            const void *const pParentAddress(this->ReadAddress(buffer));
+            const void *const pDaughterAddress(this->ReadAddress(buffer));
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetMCParentDaughterRelationship(pandora, pParentAddress, pDaughterAddress));
+            break;
+        }
+        case PandoraInputFormat::TRACK_PARENT_DAUGHTER_RELATIONSHIP :
+        {
+            const void *const pParentAddress(this->ReadAddress(buffer));
+            const void *const pDaughterAddress(this->ReadAddress(buffer));
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetTrackParentDaughterRelationship(pandora, pParentAddress, pDaughterAddress));
+            break;
+        }
+        case PandoraInputFormat::TRACK_SIBLING_RELATIONSHIP :
+        {
+            const void *const pFirstSiblingAddress(this->ReadAddress(buffer));
+            const void *const pSecondSiblingAddress(this->ReadAddress(buffer));
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetTrackSiblingRelationship(pandora, pFirstSiblingAddress, pSecondSiblingAddress));
+            break;
+        }
+        case PandoraInputFormat::CALO_HIT_TO_MC_PARTICLE_RELATIONSHIP :
+        {
+            const void *const pCaloHitAddress(this->ReadAddress(buffer));
+            const void *const pMCParticleAddress(this->ReadAddress(buffer));
+            const float mcParticleWeight(buffer.Read<float>());
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetCaloHitToMCParticleRelationship(pandora, pCaloHitAddress,
+                pMCParticleAddress, mcParticleWeight));
+            break;
+        }
+        case PandoraInputFormat::TRACK_TO_MC_PARTICLE_RELATIONSHIP :
+        {
+            const void *const pTrackAddress(this->ReadAddress(buffer));
+            const void *const pMCParticleAddress(this->ReadAddress(buffer));
+            const float mcParticleWeight(buffer.Read<float>());
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetTrackToMCParticleRelationship(pandora, pTrackAddress,
+                pMCParticleAddress, mcParticleWeight));
+            break;
+        }
+        default :
+            std::cout << "PandoraInputReader: unexpected event record type " << static_cast<unsigned int>(recordType) << std::endl;
+            return pandora::STATUS_CODE_FAILURE;
+        }
+    }
+
+    return pandora::STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+pandora::StatusCode PandoraInputReader::ReadBlock(unsigned int &blockType, std::string &payload)
+{
+    unsigned int blockHeader[2] = {0, 0};
+    m_file.read(reinterpret_cast<char*>(blockHeader), sizeof(blockHeader));
+
+    if (m_file.eof() && (0 == m_file.gcount()))
+        return pandora::STATUS_CODE_NOT_FOUND;
+
+    if (!m_file.good())
+        return pandora::STATUS_CODE_FAILURE;
+
+    blockType = blockHeader[0];
+    payload.resize(blockHeader[1]);
+    m_file.read(&payload[0], blockHeader[1]);
+
+    if (static_cast<size_t>(m_file.gcount()) != payload.size())
+    {
+        std::cout << "PandoraInputReader: truncated block" << std::endl;
+        return pandora::STATUS_CODE_FAILURE;
+    }
+
+    return pandora::STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const void *PandoraInputReader::ReadAddress(PandoraInputFormat::InputBuffer &buffer) const
+{
+    const unsigned int id(buffer.Read<unsigned int>());
+
+    if (id >= m_addressSlots.size())
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_OUT_OF_RANGE);
+
+    return &m_addressSlots[id];
+}
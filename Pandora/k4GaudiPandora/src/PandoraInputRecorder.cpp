@@ -0,0 +1,287 @@
+/**
+ *
+ *  @brief  Implementation of the pandora input recorder classes.
+ *
+ *  $Log: $
+ */
+
+#include "PandoraInputRecorder.h"
+
+PandoraInputWriter::PandoraInputWriter() :
+    m_nEvents(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool PandoraInputWriter::Open(const std::string &fileName, const PandoraInputFormat::RunSettings &runSettings)
+{
+    m_file.open(fileName.c_str(), std::ios::binary | std::ios::trunc);
+
+    if (!m_file.good())
+        return false;
+
+    PandoraInputFormat::OutputBuffer header;
+    header.Write<unsigned int>(PandoraInputFormat::MAGIC);
+    header.Write<unsigned int>(PandoraInputFormat::VERSION);
+    m_file.write(header.GetPayload().data(), header.GetPayload().size());
+
+    PandoraInputFormat::OutputBuffer buffer;
+    buffer.WriteString(runSettings.m_pandoraSettingsXmlFile);
+    buffer.Write<float>(runSettings.m_innerBField);
+    buffer.Write<float>(runSettings.m_muonBarrelBField);
+    buffer.Write<float>(runSettings.m_muonEndCapBField);
+    buffer.WriteFloatVector(runSettings.m_inputEnergyCorrectionPoints);
+    buffer.WriteFloatVector(runSettings.m_outputEnergyCorrectionPoints);
+    this->WriteBlock(PandoraInputFormat::RUN_SETTINGS_BLOCK, buffer);
+
+    return m_file.good();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputWriter::WriteBlock(const PandoraInputFormat::BlockType blockType, const PandoraInputFormat::OutputBuffer &buffer)
+{
+    const unsigned int type(blockType);
+    const unsigned int size(buffer.GetPayload().size());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_file.write(reinterpret_cast<const char*>(&type), sizeof(type));
+    m_file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    m_file.write(buffer.GetPayload().data(), size);
+
+    if (PandoraInputFormat::EVENT_BLOCK == blockType)
+        ++m_nEvents;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool PandoraInputWriter::Close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_file.close();
+    return !m_file.fail();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+unsigned int PandoraInputWriter::GetNEvents() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nEvents;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+PandoraInputRecorder::PandoraInputRecorder(PandoraInputWriter *const pWriter) :
+    m_pWriter(pWriter)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::RecordSubDetector(const PandoraApi::Geometry::SubDetector::Parameters &parameters)
+{
+    m_records.Write<unsigned char>(PandoraInputFormat::SUB_DETECTOR);
+    m_records.WriteString(parameters.m_subDetectorName.Get());
+    m_records.Write<unsigned int>(parameters.m_subDetectorType.Get());
+    m_records.Write<float>(parameters.m_innerRCoordinate.Get());
+    m_records.Write<float>(parameters.m_innerZCoordinate.Get());
+    m_records.Write<float>(parameters.m_innerPhiCoordinate.Get());
+    m_records.Write<unsigned int>(parameters.m_innerSymmetryOrder.Get());
+    m_records.Write<float>(parameters.m_outerRCoordinate.Get());
+    m_records.Write<float>(parameters.m_outerZCoordinate.Get());
+    m_records.Write<float>(parameters.m_outerPhiCoordinate.Get());
+    m_records.Write<unsigned int>(parameters.m_outerSymmetryOrder.Get());
+    m_records.Write<unsigned char>(parameters.m_isMirroredInZ.Get());
+    m_records.Write<unsigned int>(parameters.m_nLayers.Get());
+    m_records.Write<unsigned int>(parameters.m_layerParametersVector.size());
+
+    for (const PandoraApi::Geometry::LayerParameters &layerParameters : parameters.m_layerParametersVector)
+    {
+        m_records.Write<float>(layerParameters.m_closestDistanceToIp.Get());
+        m_records.Write<float>(layerParameters.m_nRadiationLengths.Get());
+        m_records.Write<float>(layerParameters.m_nInteractionLengths.Get());
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::RecordBoxGap(const PandoraApi::Geometry::BoxGap::Parameters &parameters)
+{
+    m_records.Write<unsigned char>(PandoraInputFormat::BOX_GAP);
+    m_records.WriteVector(parameters.m_vertex.Get());
+    m_records.WriteVector(parameters.m_side1.Get());
+    m_records.WriteVector(parameters.m_side2.Get());
+    m_records.WriteVector(parameters.m_side3.Get());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::RecordConcentricGap(const PandoraApi::Geometry::ConcentricGap::Parameters &parameters)
+{
+    m_records.Write<unsigned char>(PandoraInputFormat::CONCENTRIC_GAP);
+    m_records.Write<float>(parameters.m_minZCoordinate.Get());
+    m_records.Write<float>(parameters.m_maxZCoordinate.Get());
+    m_records.Write<float>(parameters.m_innerRCoordinate.Get());
+    m_records.Write<float>(parameters.m_innerPhiCoordinate.Get());
+    m_records.Write<unsigned int>(parameters.m_innerSymmetryOrder.Get());
+    m_records.Write<float>(parameters.m_outerRCoordinate.Get());
+    m_records.Write<float>(parameters.m_outerPhiCoordinate.Get());
+    m_records.Write<unsigned int>(parameters.m_outerSymmetryOrder.Get());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::WriteGeometry()
+{
+    m_pWriter->WriteBlock(PandoraInputFormat::GEOMETRY_BLOCK, m_records);
+    this->Clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::RecordMCParticle(const PandoraApi::MCParticle::Parameters &parameters)
+{
+    m_records.Write<unsigned char>(PandoraInputFormat::MC_PARTICLE);
+    this->WriteAddress(parameters.m_pParentAddress.Get());
+    m_records.Write<float>(parameters.m_energy.Get());
+    m_records.WriteVector(parameters.m_momentum.Get());
+    m_records.WriteVector(parameters.m_vertex.Get());
+    m_records.WriteVector(parameters.m_endpoint.Get());
+    m_records.Write<int>(parameters.m_particleId.Get());
+    m_records.Write<unsigned int>(parameters.m_mcParticleType.Get());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::RecordCaloHit(const PandoraApi::CaloHit::Parameters &parameters)
+{
+    m_records.Write<unsigned char>(PandoraInputFormat::CALO_HIT);
+    this->WriteAddress(parameters.m_pParentAddress.Get());
+    m_records.Write<unsigned int>(parameters.m_cellGeometry.Get());
+    m_records.WriteVector(parameters.m_positionVector.Get());
+    m_records.WriteVector(parameters.m_expectedDirection.Get());
+    m_records.WriteVector(parameters.m_cellNormalVector.Get());
+    m_records.Write<float>(parameters.m_cellSize0.Get());
+    m_records.Write<float>(parameters.m_cellSize1.Get());
+    m_records.Write<float>(parameters.m_cellThickness.Get());
+    m_records.Write<float>(parameters.m_nCellRadiationLengths.Get());
+    m_records.Write<float>(parameters.m_nCellInteractionLengths.Get());
+    m_records.Write<float>(parameters.m_time.Get());
+    m_records.Write<float>(parameters.m_inputEnergy.Get());
+    m_records.Write<float>(parameters.m_mipEquivalentEnergy.Get());
+    m_records.Write<float>(parameters.m_electromagneticEnergy.Get());
+    m_records.Write<float>(parameters.m_hadronicEnergy.Get());
+    m_records.Write<unsigned char>(parameters.m_isDigital.Get());
+    m_records.Write<unsigned int>(parameters.m_hitType.Get());
+    m_records.Write<unsigned int>(parameters.m_hitRegion.Get());
+    m_records.Write<unsigned int>(parameters.m_layer.Get());
+    m_records.Write<unsigned char>(parameters.m_isInOuterSamplingLayer.Get());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::RecordTrack(const PandoraApi::Track::Parameters &parameters)
+{
+    m_records.Write<unsigned char>(PandoraInputFormat::TRACK);
+    this->WriteAddress(parameters.m_pParentAddress.Get());
+    m_records.Write<float>(parameters.m_d0.Get());
+    m_records.Write<float>(parameters.m_z0.Get());
+    m_records.Write<int>(parameters.m_particleId.Get());
+    m_records.Write<int>(parameters.m_charge.Get());
+    m_records.Write<float>(parameters.m_mass.Get());
+    m_records.WriteVector(parameters.m_momentumAtDca.Get());
+    m_records.WriteVector(parameters.m_trackStateAtStart.Get().GetPosition());
+    m_records.WriteVector(parameters.m_trackStateAtStart.Get().GetMomentum());
+    m_records.WriteVector(parameters.m_trackStateAtEnd.Get().GetPosition());
+    m_records.WriteVector(parameters.m_trackStateAtEnd.Get().GetMomentum());
+    m_records.WriteVector(parameters.m_trackStateAtCalorimeter.Get().GetPosition());
+    m_records.WriteVector(parameters.m_trackStateAtCalorimeter.Get().GetMomentum());
+    m_records.Write<float>(parameters.m_timeAtCalorimeter.Get());
+    m_records.Write<unsigned char>(parameters.m_reachesCalorimeter.Get());
+    m_records.Write<unsigned char>(parameters.m_isProjectedToEndCap.Get());
+    m_records.Write<unsigned char>(parameters.m_canFormPfo.Get());
+    m_records.Write<unsigned char>(parameters.m_canFormClusterlessPfo.Get());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::RecordMCParentDaughterRelationship(const void *const pParentAddress, const void *const pDaughterAddress)
+{
+    this->WriteRelationship(PandoraInputFormat::MC_PARENT_DAUGHTER_RELATIONSHIP, pParentAddress, pDaughterAddress);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::RecordTrackParentDaughterRelationship(const void *const pParentAddress, const void *const pDaughterAddress)
+{
+    this->WriteRelationship(PandoraInputFormat::TRACK_PARENT_DAUGHTER_RELATIONSHIP, pParentAddress, pDaughterAddress);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::RecordTrackSiblingRelationship(const void *const pFirstSiblingAddress, const void *const pSecondSiblingAddress)
+{
+    this->WriteRelationship(PandoraInputFormat::TRACK_SIBLING_RELATIONSHIP, pFirstSiblingAddress, pSecondSiblingAddress);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::RecordCaloHitToMCParticleRelationship(const void *const pCaloHitAddress, const void *const pMCParticleAddress,
+    const float mcParticleWeight)
+{
+    this->WriteRelationship(PandoraInputFormat::CALO_HIT_TO_MC_PARTICLE_RELATIONSHIP, pCaloHitAddress, pMCParticleAddress);
+    m_records.Write<float>(mcParticleWeight);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::RecordTrackToMCParticleRelationship(const void *const pTrackAddress, const void *const pMCParticleAddress,
+    const float mcParticleWeight)
+{
+    this->WriteRelationship(PandoraInputFormat::TRACK_TO_MC_PARTICLE_RELATIONSHIP, pTrackAddress, pMCParticleAddress);
+    m_records.Write<float>(mcParticleWeight);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::WriteEvent(const int eventNumber)
+{
+    // The number of ids is only known once the event is complete, so the event header is written in front of the records here
+    m_eventBlock.Clear();
+    m_eventBlock.Write<int>(eventNumber);
+    m_eventBlock.Write<unsigned int>(m_addressToIdMap.size());
+    m_eventBlock.Append(m_records);
+
+    m_pWriter->WriteBlock(PandoraInputFormat::EVENT_BLOCK, m_eventBlock);
+    this->Clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::Clear()
+{
+    m_records.Clear();
+    m_addressToIdMap.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::WriteAddress(const void *const pAddress)
+{
+    // Tracks can be related before they are created, so ids are handed out on first sight rather than at creation
+    const unsigned int nextId(m_addressToIdMap.size());
+    m_records.Write<unsigned int>(m_addressToIdMap.insert(AddressToIdMap::value_type(pAddress, nextId)).first->second);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PandoraInputRecorder::WriteRelationship(const PandoraInputFormat::RecordType recordType, const void *const pFirstAddress,
+    const void *const pSecondAddress)
+{
+    m_records.Write<unsigned char>(recordType);
+    this->WriteAddress(pFirstAddress);
+    this->WriteAddress(pSecondAddress);
+}
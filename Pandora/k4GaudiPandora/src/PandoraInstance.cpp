@@ -0,0 +1,43 @@
+/**
+ *
+ *  @brief  Implementation of the pandora instance class.
+ *
+ *  $Log: $
+ */
+
+#include "Api/PandoraApi.h"
+
+#include "CaloHitCreator.h"
+#include "CollectionMaps.h"
+#include "GeometryCreator.h"
+#include "MCParticleCreator.h"
+#include "PandoraInputRecorder.h"
+#include "PandoraInstance.h"
+#include "PfoCreator.h"
+#include "TrackCreator.h"
+
+PandoraInstance::PandoraInstance() :
+    m_pPandora(NULL),
+    m_pGeometryCreator(NULL),
+    m_pCaloHitCreator(NULL),
+    m_pTrackCreator(NULL),
+    m_pMCParticleCreator(NULL),
+    m_pPfoCreator(NULL),
+    m_pCollectionMaps(new CollectionMaps()),
+    m_pInputRecorder(NULL)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+PandoraInstance::~PandoraInstance()
+{
+    delete m_pPandora;
+    delete m_pGeometryCreator;
+    delete m_pCaloHitCreator;
+    delete m_pTrackCreator;
+    delete m_pMCParticleCreator;
+    delete m_pPfoCreator;
+    delete m_pCollectionMaps;
+    delete m_pInputRecorder;
+}
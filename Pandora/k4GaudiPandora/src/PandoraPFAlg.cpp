@@ -9,13 +9,54 @@
 #include <algorithm>
 #include "gear/BField.h"
 #include <gear/GEAR.h>
+#include "GaudiKernel/ITHistSvc.h"
+#include "TH1D.h"
 
 #include "LCContent.h"
 
+DECLARE_COMPONENT( PandoraPFAlg )
 
-pandora::Pandora* PandoraPFAlg::m_pPandora=0;
+// Times one stage of execute and records it as a trace span; both parts do nothing when switched off
+class StageScope
+{
+public:
+    StageScope(StageTimingMonitor::EventTimes *const pEventTimes, TraceRecorder *const pTraceRecorder, const StageTimingMonitor::Stage stage) :
+        m_timer(pEventTimes, stage),
+        m_span(pTraceRecorder, StageTimingMonitor::GetStageName(stage))
+    {
+    }
 
-DECLARE_COMPONENT( PandoraPFAlg )
+    ScopedTraceSpan &GetSpan() { return m_span; }
+
+private:
+    ScopedStageTimer    m_timer;
+    ScopedTraceSpan     m_span;
+};
+
+// Give each binding its CollectionMaps slot; map nodes never move, so the slot addresses stay valid
+template<typename T>
+void BindSlots(std::vector< CollectionBinding<T> > & bindings, std::map<std::string, const T*> & collectionMap)
+{
+    for (CollectionBinding<T> & binding : bindings) {
+        const T* & slot = collectionMap[binding.m_name];
+        slot = NULL;
+        binding.m_pSlot = &slot;
+    }
+}
+
+// Point the slots at this event's collections, leaving NULL for collections missing from the event
+template<typename T>
+void FillSlots(const std::vector< CollectionBinding<T> > & bindings)
+{
+    for (const CollectionBinding<T> & binding : bindings) {
+        try {
+            *binding.m_pSlot = binding.m_pHandle->get();
+        }
+        catch ( ... ) {
+            std::cout<<"don't find col name="<<binding.m_name<<" in this event"<<std::endl;
+        }
+    }
+}
 
 template<typename T ,typename T1>
 StatusCode getCol(T & t, T1 & t1)
@@ -33,10 +74,19 @@ StatusCode getCol(T & t, T1 & t1)
 
 PandoraPFAlg::PandoraPFAlg(const std::string& name, ISvcLocator* svcLoc)
   : GaudiAlgorithm(name, svcLoc),
-    _nEvt(0)
+    _nEvt(0),
+    m_pPandoraInstance(NULL),
+    m_pStageTimingMonitor(NULL),
+    m_pMaskedCaloHitCounter(NULL),
+    m_pBelowCellThresholdCaloHitCounter(NULL),
+    m_pOutOfTimeCaloHitCounter(NULL),
+    m_pDuplicateCaloHitCounter(NULL),
+    m_pDuplicateTrackCounter(NULL),
+    m_pMergedCaloHitCounter(NULL),
+    m_pTraceRecorder(NULL),
+    m_pInputWriter(NULL),
+    m_pGearMgr(NULL)
 {
- m_CollectionMaps = new CollectionMaps();
-  
  declareProperty("WriteClusterCollection"              , m_ClusterCollection_w,               "Handle of the ClusterCollection               output collection" );
  declareProperty("WriteReconstructedParticleCollection", m_ReconstructedParticleCollection_w, "Handle of the ReconstructedParticleCollection output collection" );
  declareProperty("WriteVertexCollection"               , m_VertexCollection_w,                "Handle of the VertexCollection                output collection" );
@@ -69,8 +119,8 @@ void PandoraPFAlg::FinaliseSteeringParameters(ISvcLocator* svcloc)
     {
         throw "Failed to find GearSvc ...";
     }
-    gear::GearMgr* _GEAR = iSvc->getGearMgr();
-    m_settings.m_innerBField = _GEAR->getBField().at(gear::Vector3D(0., 0., 0.)).z();
+    m_pGearMgr = iSvc->getGearMgr();
+    m_settings.m_innerBField = m_pGearMgr->getBField().at(gear::Vector3D(0., 0., 0.)).z();
     std::cout<<"m_innerBField="<<m_settings.m_innerBField<<std::endl;    
     m_mcParticleCreatorSettings.m_bField = m_settings.m_innerBField;
 }
@@ -86,31 +136,30 @@ StatusCode PandoraPFAlg::initialize()
       auto seperater = col.find(':');
       std::string colType = col.substr(0, seperater);
       std::string colName = col.substr(seperater+1);
-      m_collections[colName] = colType;
 
       if ( colType == "MCParticle" ) {
-          m_dataHandles[colName] =
-              new DataHandle<edm4hep::MCParticleCollection>(colName, Gaudi::DataHandle::Reader, this);
+          m_mcParticleBindings.emplace_back(colName,
+              new DataHandle<edm4hep::MCParticleCollection>(colName, Gaudi::DataHandle::Reader, this));
       }
       else if ( colType == "Track" ) {
-          m_dataHandles[colName] =
-              new DataHandle<edm4hep::TrackCollection>(colName, Gaudi::DataHandle::Reader, this);
+          m_trackBindings.emplace_back(colName,
+              new DataHandle<edm4hep::TrackCollection>(colName, Gaudi::DataHandle::Reader, this));
       }
       else if ( colType == "CalorimeterHit" ) {
-          m_dataHandles[colName] =
-              new DataHandle<edm4hep::CalorimeterHitCollection>(colName, Gaudi::DataHandle::Reader, this);
+          m_caloHitBindings.emplace_back(colName,
+              new DataHandle<edm4hep::CalorimeterHitCollection>(colName, Gaudi::DataHandle::Reader, this));
       }
       else if ( colType == "Vertex" ) {
-          m_dataHandles[colName] =
-              new DataHandle<edm4hep::VertexCollection>(colName, Gaudi::DataHandle::Reader, this);
+          m_vertexBindings.emplace_back(colName,
+              new DataHandle<edm4hep::VertexCollection>(colName, Gaudi::DataHandle::Reader, this));
       }
       else if ( colType == "MCRecoTrackerAssociation" ) {
-          m_dataHandles[colName] =
-              new DataHandle<edm4hep::MCRecoTrackerAssociationCollection>(colName, Gaudi::DataHandle::Reader, this);
+          m_trkRelBindings.emplace_back(colName,
+              new DataHandle<edm4hep::MCRecoTrackerAssociationCollection>(colName, Gaudi::DataHandle::Reader, this));
       }
       else if ( colType == "MCRecoCaloAssociation" ) {
-          m_dataHandles[colName] =
-              new DataHandle<edm4hep::MCRecoCaloAssociationCollection>(colName, Gaudi::DataHandle::Reader, this);
+          m_caloRelBindings.emplace_back(colName,
+              new DataHandle<edm4hep::MCRecoCaloAssociationCollection>(colName, Gaudi::DataHandle::Reader, this));
       }
       else {
             error() << "invalid collection type: " << colType << endmsg;
@@ -232,6 +281,10 @@ StatusCode PandoraPFAlg::initialize()
   // For Strip Splitting method and also for hybrid ECAL
   m_caloHitCreatorSettings.m_stripSplittingOn = m_StripSplittingOn;
   m_caloHitCreatorSettings.m_useEcalScLayers = m_UseEcalScLayers;
+  m_caloHitCreatorSettings.m_nParameterThreads = std::max(1, m_CaloHitParameterThreads.value());
+  m_caloHitCreatorSettings.m_parameterChunkSize = std::max(1, m_CaloHitParameterChunkSize.value());
+  m_caloHitCreatorSettings.m_cellMaskFile = m_CellMaskFile;
+  m_caloHitCreatorSettings.m_timeWindowTofCorrection = m_TimeWindowTofCorrection;
   // Parameters for hybrid ECAL
   // Energy to MIP for Si-layers and Sc-layers, respectively.
   //Si
@@ -263,15 +316,164 @@ StatusCode PandoraPFAlg::initialize()
   {
       ISvcLocator* svcloc = serviceLocator();
       this->FinaliseSteeringParameters(svcloc);
-      m_pPandora = new pandora::Pandora();
-      m_pMCParticleCreator = new MCParticleCreator(m_mcParticleCreatorSettings, m_pPandora);
-      m_pGeometryCreator = new GeometryCreator(m_geometryCreatorSettings, m_pPandora);
-      PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, m_pGeometryCreator->CreateGeometry(svcloc));
-      m_pCaloHitCreator = new CaloHitCreator(m_caloHitCreatorSettings, m_pPandora, svcloc, 0);
-      m_pTrackCreator = new TrackCreator(m_trackCreatorSettings, m_pPandora, svcloc);
-      m_pPfoCreator = new PfoCreator(m_pfoCreatorSettings, m_pPandora);
-      PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->RegisterUserComponents());
-      PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*m_pPandora, m_settings.m_pandoraSettingsXmlFile));
+
+      const Gaudi::Property<FloatVector> *const timeWindows[] = {&m_ECalTimeWindow, &m_HCalTimeWindow, &m_MuonTimeWindow, &m_LCalTimeWindow, &m_LHCalTimeWindow};
+      float *const timeWindowLimits[][2] = {
+          {&m_caloHitCreatorSettings.m_eCalTimeWindowMin, &m_caloHitCreatorSettings.m_eCalTimeWindowMax},
+          {&m_caloHitCreatorSettings.m_hCalTimeWindowMin, &m_caloHitCreatorSettings.m_hCalTimeWindowMax},
+          {&m_caloHitCreatorSettings.m_muonTimeWindowMin, &m_caloHitCreatorSettings.m_muonTimeWindowMax},
+          {&m_caloHitCreatorSettings.m_lCalTimeWindowMin, &m_caloHitCreatorSettings.m_lCalTimeWindowMax},
+          {&m_caloHitCreatorSettings.m_lHCalTimeWindowMin, &m_caloHitCreatorSettings.m_lHCalTimeWindowMax}};
+      bool hasTimeWindow(false);
+
+      for (unsigned int iWindow = 0; iWindow < 5; ++iWindow)
+      {
+          const FloatVector &timeWindow(timeWindows[iWindow]->value());
+
+          if (timeWindow.empty())
+              continue;
+
+          if ((2 != timeWindow.size()) || !(timeWindow[0] <= timeWindow[1]))
+          {
+              error() << timeWindows[iWindow]->name() << " must be empty or hold the earliest and the latest hit time" << endmsg;
+              return StatusCode::FAILURE;
+          }
+
+          *timeWindowLimits[iWindow][0] = timeWindow[0];
+          *timeWindowLimits[iWindow][1] = timeWindow[1];
+          hasTimeWindow = true;
+      }
+
+      if (hasTimeWindow)
+          m_pOutOfTimeCaloHitCounter = &counter("OutOfTimeCaloHits");
+
+      const std::string &duplicatePolicy(m_DuplicatePolicy.value());
+
+      if ("none" == duplicatePolicy)
+      {
+          m_caloHitCreatorSettings.m_duplicatePolicy = KEEP_DUPLICATES;
+      }
+      else if ("keepFirst" == duplicatePolicy)
+      {
+          m_caloHitCreatorSettings.m_duplicatePolicy = KEEP_FIRST;
+      }
+      else if ("sumEnergy" == duplicatePolicy)
+      {
+          m_caloHitCreatorSettings.m_duplicatePolicy = SUM_ENERGY;
+      }
+      else if ("error" == duplicatePolicy)
+      {
+          m_caloHitCreatorSettings.m_duplicatePolicy = FAIL_ON_DUPLICATE;
+      }
+      else
+      {
+          error() << "DuplicatePolicy must be none, keepFirst, sumEnergy or error, got " << duplicatePolicy << endmsg;
+          return StatusCode::FAILURE;
+      }
+
+      // Tracks carry no energy to sum, so the sum energy policy keeps the first copy of a track
+      m_trackCreatorSettings.m_duplicatePolicy = (SUM_ENERGY == m_caloHitCreatorSettings.m_duplicatePolicy) ? KEEP_FIRST :
+          m_caloHitCreatorSettings.m_duplicatePolicy;
+
+      if (KEEP_DUPLICATES != m_caloHitCreatorSettings.m_duplicatePolicy)
+      {
+          m_pDuplicateCaloHitCounter = &counter("DuplicateCaloHits");
+          m_pDuplicateTrackCounter = &counter("DuplicateTracks");
+      }
+
+      const std::vector<int> &cellCoarsening(m_CellCoarsening.value());
+
+      if (!cellCoarsening.empty())
+      {
+          if ((2 != cellCoarsening.size()) || (cellCoarsening[0] < 1) || (cellCoarsening[1] < 1))
+          {
+              error() << "CellCoarsening must be empty or hold two merge factors of at least 1" << endmsg;
+              return StatusCode::FAILURE;
+          }
+
+          m_caloHitCreatorSettings.m_cellCoarseningFactor0 = cellCoarsening[0];
+          m_caloHitCreatorSettings.m_cellCoarseningFactor1 = cellCoarsening[1];
+          m_pMergedCaloHitCounter = &counter("MergedCaloHits");
+      }
+
+      if (m_RecordInput)
+      {
+          PandoraInputFormat::RunSettings runSettings;
+          runSettings.m_pandoraSettingsXmlFile = m_settings.m_pandoraSettingsXmlFile;
+          runSettings.m_innerBField = m_settings.m_innerBField;
+          runSettings.m_muonBarrelBField = m_settings.m_muonBarrelBField;
+          runSettings.m_muonEndCapBField = m_settings.m_muonEndCapBField;
+          runSettings.m_inputEnergyCorrectionPoints = m_settings.m_inputEnergyCorrectionPoints;
+          runSettings.m_outputEnergyCorrectionPoints = m_settings.m_outputEnergyCorrectionPoints;
+
+          m_pInputWriter = new PandoraInputWriter();
+
+          if (!m_pInputWriter->Open(m_RecordInputFile, runSettings))
+          {
+              error() << "Could not open " << m_RecordInputFile.value() << " to record the pandora input" << endmsg;
+              return StatusCode::FAILURE;
+          }
+      }
+
+      m_pPandoraInstance = new PandoraInstance();
+      PandoraInstance *const pInstance = m_pPandoraInstance;
+
+      CollectionMaps &collectionMaps = *pInstance->m_pCollectionMaps;
+      BindSlots(m_mcParticleBindings, collectionMaps.collectionMap_MC);
+      BindSlots(m_caloHitBindings, collectionMaps.collectionMap_CaloHit);
+      BindSlots(m_trackBindings, collectionMaps.collectionMap_Track);
+      BindSlots(m_vertexBindings, collectionMaps.collectionMap_Vertex);
+      BindSlots(m_caloRelBindings, collectionMaps.collectionMap_CaloRel);
+      BindSlots(m_trkRelBindings, collectionMaps.collectionMap_TrkRel);
+
+      pInstance->m_pPandora = new pandora::Pandora();
+      pInstance->m_pMCParticleCreator = new MCParticleCreator(m_mcParticleCreatorSettings, pInstance->m_pPandora);
+      pInstance->m_pGeometryCreator = new GeometryCreator(m_geometryCreatorSettings, pInstance->m_pPandora);
+
+      if (NULL != m_pInputWriter)
+      {
+          pInstance->m_pInputRecorder = new PandoraInputRecorder(m_pInputWriter);
+          pInstance->m_pGeometryCreator->SetInputRecorder(pInstance->m_pInputRecorder);
+      }
+
+      PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, pInstance->m_pGeometryCreator->CreateGeometry(m_pGearMgr));
+      pInstance->m_pGeometryCreator->SetInputRecorder(NULL);
+
+      if (NULL != pInstance->m_pInputRecorder)
+          pInstance->m_pInputRecorder->WriteGeometry();
+
+      pInstance->m_pCaloHitCreator = new CaloHitCreator(m_caloHitCreatorSettings, pInstance->m_pPandora, m_pGearMgr, 0);
+      pInstance->m_pTrackCreator = new TrackCreator(m_trackCreatorSettings, pInstance->m_pPandora, m_pGearMgr);
+      pInstance->m_pPfoCreator = new PfoCreator(m_pfoCreatorSettings, pInstance->m_pPandora);
+      PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->RegisterUserComponents(*pInstance->m_pPandora));
+      PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*pInstance->m_pPandora, m_settings.m_pandoraSettingsXmlFile));
+
+      pInstance->m_pMCParticleCreator->SetInputRecorder(pInstance->m_pInputRecorder);
+      pInstance->m_pCaloHitCreator->SetInputRecorder(pInstance->m_pInputRecorder);
+      pInstance->m_pTrackCreator->SetInputRecorder(pInstance->m_pInputRecorder);
+
+      if (m_Trace)
+      {
+          m_pTraceRecorder = new TraceRecorder();
+
+          pInstance->m_pMCParticleCreator->SetTraceRecorder(m_pTraceRecorder);
+          pInstance->m_pCaloHitCreator->SetTraceRecorder(m_pTraceRecorder);
+          pInstance->m_pTrackCreator->SetTraceRecorder(m_pTraceRecorder);
+      }
+
+      if (m_StageTiming)
+      {
+          m_pStageTimingMonitor = new StageTimingMonitor();
+
+          for (unsigned int iStage = 0; iStage < StageTimingMonitor::N_STAGES; ++iStage)
+              m_stageCounters[iStage] = &counter(std::string("Time_") + StageTimingMonitor::GetStageName(static_cast<StageTimingMonitor::Stage>(iStage)));
+      }
+
+      if (!m_CellMaskFile.value().empty())
+      {
+          m_pMaskedCaloHitCounter = &counter("MaskedCaloHits");
+          m_pBelowCellThresholdCaloHitCounter = &counter("BelowCellThresholdCaloHits");
+      }
   }
   catch (pandora::StatusCodeException &statusCodeException)
   {
@@ -290,38 +492,119 @@ StatusCode PandoraPFAlg::initialize()
 
 StatusCode PandoraPFAlg::execute()
 {
-    
+    // Stage timers are no-ops unless given somewhere to write to
+    StageTimingMonitor::EventTimes eventTimes = {};
+    StageTimingMonitor::EventTimes *const pEventTimes = (NULL != m_pStageTimingMonitor) ? &eventTimes : NULL;
+    const int eventNumber(_nEvt++);
+
+    if (NULL != m_pTraceRecorder)
+        m_pTraceRecorder->SetCurrentEvent(eventNumber);
+
+  {
+    StageScope eventStage(pEventTimes, m_pTraceRecorder, StageTimingMonitor::EVENT);
+
+    PandoraInstance &instance = *m_pPandoraInstance;
+    CollectionMaps &collectionMaps = *instance.m_pCollectionMaps;
+
     try
     {
-        
-        updateMap();
-        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, m_pMCParticleCreator->CreateMCParticles(*m_CollectionMaps));
-        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, m_pCaloHitCreator->CreateCaloHits(*m_CollectionMaps));
-        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, m_pMCParticleCreator->CreateCaloHitToMCParticleRelationships(*m_CollectionMaps, m_pCaloHitCreator->GetCalorimeterHitVector() ));
-        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, m_pTrackCreator->CreateTrackAssociations(*m_CollectionMaps));
-        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, m_pTrackCreator->CreateTracks(*m_CollectionMaps));
-        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, m_pMCParticleCreator->CreateTrackToMCParticleRelationships(*m_CollectionMaps, m_pTrackCreator->GetTrackVector() ));
-        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*m_pPandora));
-        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, m_pPfoCreator->CreateParticleFlowObjects(*m_CollectionMaps, m_ClusterCollection_w, m_ReconstructedParticleCollection_w, m_VertexCollection_w));
-        
-        StatusCode sc0 = CreateMCRecoParticleAssociation();
-
-        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*m_pPandora));
-        this->Reset();
+        {
+            StageScope stage(pEventTimes, m_pTraceRecorder, StageTimingMonitor::UPDATE_MAP);
+            updateMap();
+        }
+        {
+            StageScope stage(pEventTimes, m_pTraceRecorder, StageTimingMonitor::CREATE_MC_PARTICLES);
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, instance.m_pMCParticleCreator->CreateMCParticles(collectionMaps));
+        }
+        {
+            StageScope stage(pEventTimes, m_pTraceRecorder, StageTimingMonitor::CREATE_CALO_HITS);
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, instance.m_pCaloHitCreator->CreateCaloHits(collectionMaps));
+        }
+
+        if (NULL != m_pMaskedCaloHitCounter)
+        {
+            (*m_pMaskedCaloHitCounter) += instance.m_pCaloHitCreator->GetNMaskedCaloHits();
+            (*m_pBelowCellThresholdCaloHitCounter) += instance.m_pCaloHitCreator->GetNBelowCellThresholdCaloHits();
+        }
+
+        if (NULL != m_pOutOfTimeCaloHitCounter)
+            (*m_pOutOfTimeCaloHitCounter) += instance.m_pCaloHitCreator->GetNOutOfTimeCaloHits();
+
+        if (NULL != m_pMergedCaloHitCounter)
+            (*m_pMergedCaloHitCounter) += instance.m_pCaloHitCreator->GetNMergedCaloHits();
+
+        if (NULL != m_pDuplicateCaloHitCounter)
+            (*m_pDuplicateCaloHitCounter) += instance.m_pCaloHitCreator->GetNDuplicateCaloHits();
+
+        {
+            StageScope stage(pEventTimes, m_pTraceRecorder, StageTimingMonitor::CREATE_CALO_HIT_TO_MC_RELATIONSHIPS);
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, instance.m_pMCParticleCreator->CreateCaloHitToMCParticleRelationships(collectionMaps, instance.m_pCaloHitCreator->GetCalorimeterHitVector() ));
+        }
+        {
+            StageScope stage(pEventTimes, m_pTraceRecorder, StageTimingMonitor::CREATE_TRACK_ASSOCIATIONS);
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, instance.m_pTrackCreator->CreateTrackAssociations(collectionMaps));
+        }
+        {
+            StageScope stage(pEventTimes, m_pTraceRecorder, StageTimingMonitor::CREATE_TRACKS);
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, instance.m_pTrackCreator->CreateTracks(collectionMaps));
+        }
+
+        if (NULL != m_pDuplicateTrackCounter)
+            (*m_pDuplicateTrackCounter) += instance.m_pTrackCreator->GetNDuplicateTracks();
+
+        {
+            StageScope stage(pEventTimes, m_pTraceRecorder, StageTimingMonitor::CREATE_TRACK_TO_MC_RELATIONSHIPS);
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, instance.m_pMCParticleCreator->CreateTrackToMCParticleRelationships(collectionMaps, instance.m_pTrackCreator->GetTrackVector() ));
+        }
+        {
+            // Written before ProcessEvent, so that events which make pandora fail are captured too
+            if (NULL != instance.m_pInputRecorder)
+                instance.m_pInputRecorder->WriteEvent(eventNumber);
+
+            StageScope stage(pEventTimes, m_pTraceRecorder, StageTimingMonitor::PROCESS_EVENT);
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*instance.m_pPandora));
+        }
+        // Keep the collection made for this event rather than reading it back through the shared handle
+        edm4hep::ReconstructedParticleCollection *const pReconstructedParticleCollection = m_ReconstructedParticleCollection_w.createAndPut();
+        {
+            StageScope stage(pEventTimes, m_pTraceRecorder, StageTimingMonitor::CREATE_PARTICLE_FLOW_OBJECTS);
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, instance.m_pPfoCreator->CreateParticleFlowObjects(collectionMaps,
+                m_ClusterCollection_w.createAndPut(), pReconstructedParticleCollection, m_VertexCollection_w.createAndPut()));
+        }
+        {
+            StageScope stage(pEventTimes, m_pTraceRecorder, StageTimingMonitor::CREATE_MC_RECO_PARTICLE_ASSOCIATION);
+            StatusCode sc0 = CreateMCRecoParticleAssociation(collectionMaps, pReconstructedParticleCollection);
+        }
+        {
+            eventStage.GetSpan().AddArg("nCaloHits", instance.m_pCaloHitCreator->GetCalorimeterHitVector().size());
+            eventStage.GetSpan().AddArg("nTracks", instance.m_pTrackCreator->GetTrackVector().size());
+
+            StageScope stage(pEventTimes, m_pTraceRecorder, StageTimingMonitor::RESET);
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*instance.m_pPandora));
+            this->Reset();
+        }
     }
     catch (pandora::StatusCodeException &statusCodeException)
     {
         std::cout << "Gaudi pandora failed to process event: " << statusCodeException.ToString() << std::endl;
+        // Leave the instance clean for the next event
+        PandoraApi::Reset(*instance.m_pPandora);
+        this->Reset();
         throw statusCodeException;
     }
     catch (...)
     {
         std::cout << "Gaudi pandora failed to process event: unrecognized exception" << std::endl;
+        PandoraApi::Reset(*instance.m_pPandora);
+        this->Reset();
         throw;
     }
+  }
+
+  if (NULL != pEventTimes)
+      this->RecordStageTimes(eventTimes);
   
-  info() << "PandoraPFAlg Processed " << _nEvt << " events " << endmsg;
-  _nEvt ++ ;
+  info() << "PandoraPFAlg Processed " << eventNumber << " events " << endmsg;
 
   return StatusCode::SUCCESS;
 }
@@ -329,49 +612,120 @@ StatusCode PandoraPFAlg::execute()
 StatusCode PandoraPFAlg::finalize()
 {
   info() << "Finalized. Processed " << _nEvt << " events " << endmsg;
-  delete m_pPandora;
-  delete m_pGeometryCreator;
-  delete m_pCaloHitCreator;
-  delete m_pTrackCreator;
-  delete m_pMCParticleCreator;
-  delete m_pPfoCreator;
+  delete m_pPandoraInstance;
+  m_pPandoraInstance = NULL;
+
+  if (NULL != m_pTraceRecorder)
+  {
+      // Spans were buffered per thread during the event loop and are only written out here
+      if (!m_pTraceRecorder->WriteJson(m_TraceFile))
+          warning() << "Could not write trace to " << m_TraceFile.value() << endmsg;
+      else
+          info() << "Trace written to " << m_TraceFile.value() << endmsg;
+
+      delete m_pTraceRecorder;
+      m_pTraceRecorder = NULL;
+  }
+
+  if (NULL != m_pInputWriter)
+  {
+      if (!m_pInputWriter->Close())
+          warning() << "Could not write the recorded pandora input to " << m_RecordInputFile.value() << endmsg;
+      else
+          info() << "Recorded the pandora input of " << m_pInputWriter->GetNEvents() << " events to " << m_RecordInputFile.value() << endmsg;
+
+      delete m_pInputWriter;
+      m_pInputWriter = NULL;
+  }
+
+  if (NULL != m_pStageTimingMonitor)
+  {
+      this->WriteStageTimingSummary();
+      delete m_pStageTimingMonitor;
+      m_pStageTimingMonitor = NULL;
+  }
   return GaudiAlgorithm::finalize();
 }
 
 
 
 
-pandora::StatusCode PandoraPFAlg::RegisterUserComponents() const
+pandora::StatusCode PandoraPFAlg::RegisterUserComponents(const pandora::Pandora &pandora) const
 {
     
-    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterAlgorithms(*m_pPandora));
-    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterBasicPlugins(*m_pPandora));
+    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterAlgorithms(pandora));
+    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterBasicPlugins(pandora));
 
-    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterBFieldPlugin(*m_pPandora,
+    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterBFieldPlugin(pandora,
         m_settings.m_innerBField, m_settings.m_muonBarrelBField, m_settings.m_muonEndCapBField));
 
-    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterNonLinearityEnergyCorrection(*m_pPandora,
+    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterNonLinearityEnergyCorrection(pandora,
         "NonLinearity", pandora::HADRONIC, m_settings.m_inputEnergyCorrectionPoints, m_settings.m_outputEnergyCorrectionPoints));
     
     return pandora::STATUS_CODE_SUCCESS;
 }
 
 
+void PandoraPFAlg::RecordStageTimes(const StageTimingMonitor::EventTimes &eventTimes)
+{
+    m_pStageTimingMonitor->AddEvent(eventTimes);
+
+    for (unsigned int iStage = 0; iStage < StageTimingMonitor::N_STAGES; ++iStage)
+        (*m_stageCounters[iStage]) += eventTimes[iStage];
+}
+
+void PandoraPFAlg::WriteStageTimingSummary()
+{
+    // Histograms are booked at the end of the job, when the range of the samples is known
+    SmartIF<ITHistSvc> histSvc = service<ITHistSvc>("THistSvc");
+
+    for (unsigned int iStage = 0; iStage < StageTimingMonitor::N_STAGES; ++iStage)
+    {
+        const StageTimingMonitor::Stage stage(static_cast<StageTimingMonitor::Stage>(iStage));
+        const StageTimingMonitor::Summary summary(m_pStageTimingMonitor->GetSummary(stage));
+        info() << "Stage " << StageTimingMonitor::GetStageName(stage) << " [ms]: mean " << summary.m_mean << ", p50 " << summary.m_p50
+               << ", p95 " << summary.m_p95 << ", p99 " << summary.m_p99 << ", max " << summary.m_max << endmsg;
+
+        if (!histSvc)
+            continue;
+
+        const std::string name(std::string("Time_") + StageTimingMonitor::GetStageName(stage));
+        TH1D *const pHistogram = new TH1D(name.c_str(), (name + ";time [ms];events").c_str(), 100, 0., 1.05 * summary.m_max + 1.e-3);
+
+        for (const double sample : m_pStageTimingMonitor->GetSamples(stage))
+            pHistogram->Fill(sample);
+
+        if (histSvc->regHist(m_StageTimingHistDir.value() + name, pHistogram).isFailure())
+        {
+            warning() << "Could not register stage timing histogram " << name << endmsg;
+            delete pHistogram;
+        }
+    }
+
+    if (!m_pStageTimingMonitor->WriteJson(m_StageTimingFile))
+        warning() << "Could not write stage timing summary to " << m_StageTimingFile.value() << endmsg;
+    else
+        info() << "Stage timing summary written to " << m_StageTimingFile.value() << endmsg;
+}
+
 void PandoraPFAlg::Reset()
 {
-    m_pCaloHitCreator->Reset();
-    m_pTrackCreator->Reset();
-    m_pMCParticleCreator->Reset();
+    m_pPandoraInstance->m_pCaloHitCreator->Reset();
+    m_pPandoraInstance->m_pTrackCreator->Reset();
+    m_pPandoraInstance->m_pMCParticleCreator->Reset();
 
-    m_CollectionMaps->clear();
+    m_pPandoraInstance->m_pCollectionMaps->clear();
+
+    if (NULL != m_pPandoraInstance->m_pInputRecorder)
+        m_pPandoraInstance->m_pInputRecorder->Clear();
 }
 
 const pandora::Pandora *PandoraPFAlg::GetPandora() const
 {
-    if (NULL == m_pPandora)
+    if ((NULL == m_pPandoraInstance) || (NULL == m_pPandoraInstance->m_pPandora))
         throw pandora::StatusCodeException(pandora::STATUS_CODE_NOT_INITIALIZED);
 
-    return m_pPandora;
+    return m_pPandoraInstance->m_pPandora;
 }
 PandoraPFAlg::Settings::Settings() :
     m_innerBField(3.5f),
@@ -379,119 +733,24 @@ PandoraPFAlg::Settings::Settings() :
     m_muonEndCapBField(0.01f)
 {
 }
-CollectionMaps::CollectionMaps()
-{
-}
-void CollectionMaps::clear()
-{
-collectionMap_MC.clear();
-collectionMap_CaloHit.clear();
-collectionMap_Vertex.clear();
-collectionMap_Track.clear();
-collectionMap_CaloRel.clear();
-collectionMap_TrkRel.clear();
-}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
 
 StatusCode PandoraPFAlg::updateMap()
 {
-    for(auto &v : m_dataHandles){
-        //std::cout<<"going to col name="<<v.first<<",with type="<<m_collections[v.first]<<std::endl;
-        try{
-            if(m_collections[v.first]=="MCParticle"){
-                auto handle = dynamic_cast<DataHandle<edm4hep::MCParticleCollection>*> (v.second);
-                auto po = handle->get();
-                if(po != NULL){
-                    std::vector<edm4hep::MCParticle> v_mc;
-                    m_CollectionMaps->collectionMap_MC [v.first] = v_mc;
-                    for(unsigned int i=0 ; i< po->size(); i++) m_CollectionMaps->collectionMap_MC [v.first].push_back(po->at(i));
-                    std::cout<<"saved col name="<<v.first<<std::endl;
-                }
-                else{
-                std::cout<<"don't find col name="<<v.first<<std::endl;
-                }
-            }
-            else if(m_collections[v.first]=="CalorimeterHit"){
-                auto handle = dynamic_cast<DataHandle<edm4hep::CalorimeterHitCollection>*> (v.second);
-                auto po = handle->get();
-                if(po != NULL){
-                    std::vector<edm4hep::CalorimeterHit> v_cal;
-                    m_CollectionMaps->collectionMap_CaloHit[v.first] = v_cal ;
-                    for(unsigned int i=0 ; i< po->size(); i++) m_CollectionMaps->collectionMap_CaloHit [v.first].push_back(po->at(i));
-                    std::cout<<"saved col name="<<v.first<<std::endl;
-                }
-                else{
-                std::cout<<"don't find col name="<<v.first<<std::endl;
-                }
-            }
-            else if(m_collections[v.first]=="Track"){
-                auto handle = dynamic_cast<DataHandle<edm4hep::TrackCollection>*> (v.second);
-                auto po = handle->get();
-                if(po != NULL){
-                    std::vector<edm4hep::Track> v_cal;
-                    m_CollectionMaps->collectionMap_Track[v.first] = v_cal ;
-                    for(unsigned int i=0 ; i< po->size(); i++) m_CollectionMaps->collectionMap_Track [v.first].push_back(po->at(i));
-                    std::cout<<"saved col name="<<v.first<<std::endl;
-                }
-                else{
-                std::cout<<"don't find col name="<<v.first<<std::endl;
-                }
-            }
-            else if(m_collections[v.first]=="Vertex"){
-                auto handle = dynamic_cast<DataHandle<edm4hep::VertexCollection>*> (v.second);
-                auto po = handle->get();
-                if(po != NULL){
-                    std::vector<edm4hep::Vertex> v_cal;
-                    m_CollectionMaps->collectionMap_Vertex[v.first] = v_cal ;
-                    for(unsigned int i=0 ; i< po->size(); i++) m_CollectionMaps->collectionMap_Vertex [v.first].push_back(po->at(i));
-                    std::cout<<"saved col name="<<v.first<<std::endl;
-                }
-                else{
-                std::cout<<"don't find col name="<<v.first<<std::endl;
-                }
-            }
-            else if(m_collections[v.first]=="MCRecoCaloAssociation"){
-                auto handle = dynamic_cast<DataHandle<edm4hep::MCRecoCaloAssociationCollection>*> (v.second);
-                auto po = handle->get();
-                if(po != NULL){
-                    std::vector<edm4hep::MCRecoCaloAssociation> v_cal;
-                    m_CollectionMaps->collectionMap_CaloRel[v.first] = v_cal ;
-                    for(unsigned int i=0 ; i< po->size(); i++) m_CollectionMaps->collectionMap_CaloRel [v.first].push_back(po->at(i));
-                    std::cout<<"saved col name="<<v.first<<std::endl;
-                }
-                else{
-                std::cout<<"don't find col name="<<v.first<<std::endl;
-                }
-            }
-            else if(m_collections[v.first]=="MCRecoTrackerAssociation"){
-                auto handle = dynamic_cast<DataHandle<edm4hep::MCRecoTrackerAssociationCollection>*> (v.second);
-                auto po = handle->get();
-                if(po != NULL){
-                    std::vector<edm4hep::MCRecoTrackerAssociation> v_cal;
-                    m_CollectionMaps->collectionMap_TrkRel[v.first] = v_cal ;
-                    for(unsigned int i=0 ; i< po->size(); i++) m_CollectionMaps->collectionMap_TrkRel [v.first].push_back(po->at(i));
-                    std::cout<<"saved col name="<<v.first<<std::endl;
-                }
-                else{
-                std::cout<<"don't find col name="<<v.first<<std::endl;
-                }
-            }
-            else{
-            std::cout<<"wrong type name for col :"<<v.first<<std::endl;
-            }
-        }//try
-        catch(...){
-            std::cout<<"don't find "<<v.first<<"in event"<<std::endl;
-            std::cout<<"don't find  col name="<<v.first<<",with type="<<m_collections[v.first]<<" in this event"<<std::endl;
-        }
-    }
+    FillSlots(m_mcParticleBindings);
+    FillSlots(m_caloHitBindings);
+    FillSlots(m_trackBindings);
+    FillSlots(m_vertexBindings);
+    FillSlots(m_caloRelBindings);
+    FillSlots(m_trkRelBindings);
     return StatusCode::SUCCESS;
 }
 
 // create simple MCRecoParticleAssociation using calorimeter hit only now
-StatusCode PandoraPFAlg::CreateMCRecoParticleAssociation()
+StatusCode PandoraPFAlg::CreateMCRecoParticleAssociation(const CollectionMaps &collectionMaps, const edm4hep::ReconstructedParticleCollection *const reco_col)
 {
     edm4hep::MCRecoParticleAssociationCollection* pMCRecoParticleAssociationCollection  = m_MCRecoParticleAssociation_w.createAndPut();
-    const edm4hep::ReconstructedParticleCollection* reco_col = m_ReconstructedParticleCollection_w.get();
     for(int i=0; i<reco_col->size();i++)
     {
         std::map<int, edm4hep::ConstMCParticle> mc_map;
@@ -504,12 +763,15 @@ StatusCode PandoraPFAlg::CreateMCRecoParticleAssociation()
             for(int k=0; k < cluster.hits_size(); k++)
             {
                 edm4hep::ConstCalorimeterHit hit = cluster.getHits(k);
-                for(std::map<std::string, std::vector<edm4hep::MCRecoCaloAssociation> >::iterator iter = m_CollectionMaps->collectionMap_CaloRel.begin(); iter != m_CollectionMaps->collectionMap_CaloRel.end(); iter++)
+                for(std::map<std::string, const edm4hep::MCRecoCaloAssociationCollection*>::const_iterator iter = collectionMaps.collectionMap_CaloRel.begin(); iter != collectionMaps.collectionMap_CaloRel.end(); iter++)
                 {
-                    for(std::vector<edm4hep::MCRecoCaloAssociation>::iterator it = iter->second.begin(); it != iter->second.end(); it ++)
+                    if(iter->second == NULL) continue;
+                    for(unsigned int ia = 0; ia < iter->second->size(); ia++)
                     {
-                        if(it->getRec().id() != hit.id()) continue;
-                        for(std::vector<edm4hep::ConstCaloHitContribution>::const_iterator itc = it->getSim().contributions_begin(); itc != it->getSim().contributions_end(); itc++)
+                        const edm4hep::MCRecoCaloAssociation association = iter->second->at(ia);
+                        if(association.getRec().id() != hit.id()) continue;
+                        const edm4hep::ConstSimCalorimeterHit simHit = association.getSim();
+                        for(std::vector<edm4hep::ConstCaloHitContribution>::const_iterator itc = simHit.contributions_begin(); itc != simHit.contributions_end(); itc++)
                         {
                             if(mc_map.find(itc->getParticle().id()) == mc_map.end()) mc_map[itc->getParticle().id()] = itc->getParticle() ;
                             if(id_edep_map.find(itc->getParticle().id()) != id_edep_map.end()) id_edep_map[itc->getParticle().id()] = id_edep_map[itc->getParticle().id()] + itc->getEnergy() ;
@@ -0,0 +1,585 @@
+/**
+ *
+ *  @brief  Implementation of the pfo comparator class.
+ *
+ *  $Log: $
+ */
+
+#include "PfoComparator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+static uint64_t GetObjectId(const podio::ObjectID &objectID)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(objectID.collectionID)) << 32) | static_cast<uint32_t>(objectID.index);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+PfoComparator::EventCollections::EventCollections() :
+    m_pPfos(NULL),
+    m_pClusters(NULL),
+    m_pStartVertices(NULL),
+    m_pMCRecoParticleAssociations(NULL)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+PfoComparator::Settings::Settings() :
+    m_energyTolerance(1.e-5f),
+    m_momentumTolerance(1.e-5f),
+    m_positionTolerance(1.e-3f),
+    m_weightTolerance(1.e-5f),
+    m_maxPrintedDifferences(20)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+PfoComparator::RunningStatistic::RunningStatistic() :
+    m_count(0),
+    m_sum(0.),
+    m_sumSquared(0.),
+    m_maxAbs(0.)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PfoComparator::RunningStatistic::Add(const double value)
+{
+    ++m_count;
+    m_sum += value;
+    m_sumSquared += value * value;
+    m_maxAbs = std::max(m_maxAbs, std::fabs(value));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+double PfoComparator::RunningStatistic::GetMean() const
+{
+    return (m_count > 0) ? m_sum / m_count : 0.;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+double PfoComparator::RunningStatistic::GetRms() const
+{
+    return (m_count > 0) ? std::sqrt(m_sumSquared / m_count) : 0.;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+PfoComparator::Summary::Summary() :
+    m_nTypeChanges(0),
+    m_nChargeChanges(0),
+    m_nHitMembershipChanges(0),
+    m_nTrackMembershipChanges(0),
+    m_nClusterChanges(0),
+    m_nStartVertexChanges(0),
+    m_nAssociationChanges(0),
+    m_nOrderChanges(0)
+{
+    std::fill(m_nEvents, m_nEvents + N_AGREEMENTS, 0);
+    std::fill(m_nPfos, m_nPfos + N_AGREEMENTS, 0);
+    std::fill(m_nUnmatchedPfos, m_nUnmatchedPfos + 2, 0);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+PfoComparator::PfoComparator(const Settings &settings) :
+    m_settings(settings),
+    m_nPrintedDifferences(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+PfoComparator::Agreement PfoComparator::CompareEvent(const unsigned int eventNumber, const EventCollections &first, const EventCollections &second)
+{
+    PfoRecordVector firstRecords, secondRecords;
+    this->BuildPfoRecords(first, firstRecords);
+    this->BuildPfoRecords(second, secondRecords);
+
+    double firstEnergy(0.), secondEnergy(0.);
+
+    for (const PfoRecord &pfoRecord : firstRecords)
+    {
+        ++m_summary.m_typeCounts[0][pfoRecord.m_pfo.getType()];
+        firstEnergy += pfoRecord.m_pfo.getEnergy();
+    }
+
+    for (const PfoRecord &pfoRecord : secondRecords)
+    {
+        ++m_summary.m_typeCounts[1][pfoRecord.m_pfo.getType()];
+        secondEnergy += pfoRecord.m_pfo.getEnergy();
+    }
+
+    m_summary.m_eventEnergyDifference.Add(secondEnergy - firstEnergy);
+
+    std::vector<int> matches;
+    this->MatchPfos(firstRecords, secondRecords, matches);
+
+    Agreement eventAgreement(BITWISE_IDENTICAL);
+    std::vector<bool> isSecondMatched(secondRecords.size(), false);
+    bool isReordered(false);
+
+    for (unsigned int iPfo = 0; iPfo < firstRecords.size(); ++iPfo)
+    {
+        if (matches[iPfo] < 0)
+        {
+            std::ostringstream description;
+            description << "pfo " << iPfo << " of the first input (type " << firstRecords[iPfo].m_pfo.getType() << ", energy "
+                        << firstRecords[iPfo].m_pfo.getEnergy() << ") has no partner";
+            this->PrintDifference(eventNumber, description.str());
+            ++m_summary.m_nUnmatchedPfos[0];
+            eventAgreement = DIFFERENT;
+            continue;
+        }
+
+        isSecondMatched[matches[iPfo]] = true;
+        isReordered = isReordered || (static_cast<int>(iPfo) != matches[iPfo]);
+        eventAgreement = std::max(eventAgreement, this->ComparePfos(eventNumber, firstRecords[iPfo], secondRecords[matches[iPfo]]));
+    }
+
+    for (unsigned int iPfo = 0; iPfo < secondRecords.size(); ++iPfo)
+    {
+        if (isSecondMatched[iPfo])
+            continue;
+
+        std::ostringstream description;
+        description << "pfo " << iPfo << " of the second input (type " << secondRecords[iPfo].m_pfo.getType() << ", energy "
+                    << secondRecords[iPfo].m_pfo.getEnergy() << ") has no partner";
+        this->PrintDifference(eventNumber, description.str());
+        ++m_summary.m_nUnmatchedPfos[1];
+        eventAgreement = DIFFERENT;
+    }
+
+    // The same pfos in a different order are equivalent physics output, but not the same file content
+    if (isReordered)
+    {
+        ++m_summary.m_nOrderChanges;
+        eventAgreement = std::max(eventAgreement, WITHIN_TOLERANCE);
+    }
+
+    ++m_summary.m_nEvents[eventAgreement];
+
+    return eventAgreement;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PfoComparator::PrintSummary() const
+{
+    unsigned int nEvents(0), nPfos(0);
+
+    for (unsigned int iAgreement = 0; iAgreement < N_AGREEMENTS; ++iAgreement)
+    {
+        nEvents += m_summary.m_nEvents[iAgreement];
+        nPfos += m_summary.m_nPfos[iAgreement];
+    }
+
+    std::cout << "Compared " << nEvents << " events:";
+
+    for (unsigned int iAgreement = 0; iAgreement < N_AGREEMENTS; ++iAgreement)
+        std::cout << " " << m_summary.m_nEvents[iAgreement] << " " << GetAgreementName(static_cast<Agreement>(iAgreement)) << ((N_AGREEMENTS == iAgreement + 1) ? "" : ",");
+
+    std::cout << std::endl << "Matched " << nPfos << " pfos:";
+
+    for (unsigned int iAgreement = 0; iAgreement < N_AGREEMENTS; ++iAgreement)
+        std::cout << " " << m_summary.m_nPfos[iAgreement] << " " << GetAgreementName(static_cast<Agreement>(iAgreement)) << ((N_AGREEMENTS == iAgreement + 1) ? "" : ",");
+
+    std::cout << std::endl
+              << "Unmatched pfos: " << m_summary.m_nUnmatchedPfos[0] << " in the first input, " << m_summary.m_nUnmatchedPfos[1] << " in the second" << std::endl
+              << "Events with reordered pfos: " << m_summary.m_nOrderChanges << std::endl
+              << "Matched pfos with a different pid: " << m_summary.m_nTypeChanges << ", charge: " << m_summary.m_nChargeChanges
+              << ", calo hits: " << m_summary.m_nHitMembershipChanges << ", tracks: " << m_summary.m_nTrackMembershipChanges << std::endl
+              << "Matched pfos beyond tolerance in clusters: " << m_summary.m_nClusterChanges << ", start vertex: " << m_summary.m_nStartVertexChanges
+              << ", mc associations: " << m_summary.m_nAssociationChanges << std::endl;
+
+    const std::pair<const char*, const RunningStatistic*> statistics[] = {
+        std::make_pair("Relative pfo energy difference", &m_summary.m_relativeEnergyDifference),
+        std::make_pair("Relative pfo momentum difference", &m_summary.m_relativeMomentumDifference),
+        std::make_pair("Relative pfo mass difference", &m_summary.m_relativeMassDifference),
+        std::make_pair("Event pfo energy difference [GeV]", &m_summary.m_eventEnergyDifference)};
+
+    for (const auto &statistic : statistics)
+    {
+        std::cout << statistic.first << ": mean " << statistic.second->GetMean() << ", rms " << statistic.second->GetRms() << ", max |"
+                  << statistic.second->m_maxAbs << "| over " << statistic.second->m_count << std::endl;
+    }
+
+    std::set<int> types;
+
+    for (unsigned int iInput = 0; iInput < 2; ++iInput)
+    {
+        for (const auto &typeCount : m_summary.m_typeCounts[iInput])
+            types.insert(typeCount.first);
+    }
+
+    std::cout << "Pfos per pid (first, second):";
+
+    for (const int type : types)
+    {
+        const std::map<int, unsigned int>::const_iterator firstIter(m_summary.m_typeCounts[0].find(type));
+        const std::map<int, unsigned int>::const_iterator secondIter(m_summary.m_typeCounts[1].find(type));
+        std::cout << " " << type << " (" << ((m_summary.m_typeCounts[0].end() == firstIter) ? 0 : firstIter->second) << ", "
+                  << ((m_summary.m_typeCounts[1].end() == secondIter) ? 0 : secondIter->second) << ")";
+    }
+
+    std::cout << std::endl;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const char *PfoComparator::GetAgreementName(const Agreement agreement)
+{
+    switch (agreement)
+    {
+    case BITWISE_IDENTICAL : return "bitwise identical";
+    case WITHIN_TOLERANCE : return "within tolerance";
+    case DIFFERENT : return "different";
+    default : return "unknown";
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PfoComparator::BuildPfoRecords(const EventCollections &collections, PfoRecordVector &pfoRecords) const
+{
+    pfoRecords.clear();
+
+    if (!collections.m_pPfos)
+        return;
+
+    std::map<uint64_t, unsigned int> pfoIdToIndex;
+
+    for (unsigned int iPfo = 0, nPfos = collections.m_pPfos->size(); iPfo < nPfos; ++iPfo)
+    {
+        PfoRecord pfoRecord;
+        pfoRecord.m_pfo = collections.m_pPfos->at(iPfo);
+        pfoRecord.m_hasStartVertex = false;
+
+        for (unsigned int iCluster = 0, nClusters = pfoRecord.m_pfo.clusters_size(); iCluster < nClusters; ++iCluster)
+        {
+            const edm4hep::ConstCluster cluster(pfoRecord.m_pfo.getClusters(iCluster));
+
+            for (unsigned int iHit = 0, nHits = cluster.hits_size(); iHit < nHits; ++iHit)
+                pfoRecord.m_hitIds.push_back(GetObjectId(cluster.getHits(iHit).getObjectID()));
+        }
+
+        for (unsigned int iTrack = 0, nTracks = pfoRecord.m_pfo.tracks_size(); iTrack < nTracks; ++iTrack)
+            pfoRecord.m_trackIds.push_back(GetObjectId(pfoRecord.m_pfo.getTracks(iTrack).getObjectID()));
+
+        std::sort(pfoRecord.m_hitIds.begin(), pfoRecord.m_hitIds.end());
+        std::sort(pfoRecord.m_trackIds.begin(), pfoRecord.m_trackIds.end());
+
+        pfoIdToIndex[GetObjectId(pfoRecord.m_pfo.getObjectID())] = iPfo;
+        pfoRecords.push_back(pfoRecord);
+    }
+
+    if (collections.m_pStartVertices)
+    {
+        for (unsigned int iVertex = 0, nVertices = collections.m_pStartVertices->size(); iVertex < nVertices; ++iVertex)
+        {
+            const edm4hep::Vertex vertex(collections.m_pStartVertices->at(iVertex));
+            const edm4hep::ConstReconstructedParticle pfo(vertex.getAssociatedParticle());
+
+            if (!pfo.isAvailable())
+                continue;
+
+            const std::map<uint64_t, unsigned int>::const_iterator iter(pfoIdToIndex.find(GetObjectId(pfo.getObjectID())));
+
+            if (pfoIdToIndex.end() == iter)
+                continue;
+
+            pfoRecords[iter->second].m_hasStartVertex = true;
+            pfoRecords[iter->second].m_startVertexPosition = vertex.getPosition();
+        }
+    }
+
+    if (collections.m_pMCRecoParticleAssociations)
+    {
+        for (unsigned int iAssociation = 0, nAssociations = collections.m_pMCRecoParticleAssociations->size(); iAssociation < nAssociations; ++iAssociation)
+        {
+            const edm4hep::MCRecoParticleAssociation association(collections.m_pMCRecoParticleAssociations->at(iAssociation));
+            const std::map<uint64_t, unsigned int>::const_iterator iter(pfoIdToIndex.find(GetObjectId(association.getRec().getObjectID())));
+
+            if (pfoIdToIndex.end() == iter)
+                continue;
+
+            pfoRecords[iter->second].m_associations.push_back(std::make_pair(GetObjectId(association.getSim().getObjectID()), association.getWeight()));
+        }
+
+        for (PfoRecord &pfoRecord : pfoRecords)
+            std::sort(pfoRecord.m_associations.begin(), pfoRecord.m_associations.end());
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PfoComparator::MatchPfos(const PfoRecordVector &first, const PfoRecordVector &second, std::vector<int> &matches) const
+{
+    matches.assign(first.size(), -1);
+
+    // Unchanged output keeps the pfo order, so try the identity match first
+    bool isSameOrder(first.size() == second.size());
+
+    for (unsigned int iPfo = 0; isSameOrder && (iPfo < first.size()); ++iPfo)
+        isSameOrder = (first[iPfo].m_hitIds == second[iPfo].m_hitIds) && (first[iPfo].m_trackIds == second[iPfo].m_trackIds);
+
+    if (isSameOrder)
+    {
+        for (unsigned int iPfo = 0; iPfo < first.size(); ++iPfo)
+            matches[iPfo] = iPfo;
+
+        return;
+    }
+
+    // Pandora gives each hit and track to at most one pfo, so the owner of each in the second input is unique
+    std::map<uint64_t, unsigned int> hitOwners, trackOwners;
+
+    for (unsigned int iPfo = 0; iPfo < second.size(); ++iPfo)
+    {
+        for (const uint64_t hitId : second[iPfo].m_hitIds)
+            hitOwners[hitId] = iPfo;
+
+        for (const uint64_t trackId : second[iPfo].m_trackIds)
+            trackOwners[trackId] = iPfo;
+    }
+
+    // Candidate pairs, ordered by shared tracks, then shared hits
+    typedef std::pair<std::pair<unsigned int, unsigned int>, std::pair<unsigned int, unsigned int> > Candidate;
+    std::vector<Candidate> candidates;
+
+    for (unsigned int iPfo = 0; iPfo < first.size(); ++iPfo)
+    {
+        std::map<unsigned int, std::pair<unsigned int, unsigned int> > overlaps;
+
+        for (const uint64_t trackId : first[iPfo].m_trackIds)
+        {
+            const std::map<uint64_t, unsigned int>::const_iterator iter(trackOwners.find(trackId));
+
+            if (trackOwners.end() != iter)
+                ++overlaps[iter->second].first;
+        }
+
+        for (const uint64_t hitId : first[iPfo].m_hitIds)
+        {
+            const std::map<uint64_t, unsigned int>::const_iterator iter(hitOwners.find(hitId));
+
+            if (hitOwners.end() != iter)
+                ++overlaps[iter->second].second;
+        }
+
+        for (const auto &overlap : overlaps)
+            candidates.push_back(Candidate(overlap.second, std::make_pair(iPfo, overlap.first)));
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate &lhs, const Candidate &rhs) { return lhs.first > rhs.first; });
+
+    std::vector<bool> isSecondMatched(second.size(), false);
+
+    for (const Candidate &candidate : candidates)
+    {
+        const unsigned int firstIndex(candidate.second.first), secondIndex(candidate.second.second);
+
+        if ((matches[firstIndex] >= 0) || isSecondMatched[secondIndex])
+            continue;
+
+        matches[firstIndex] = secondIndex;
+        isSecondMatched[secondIndex] = true;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+PfoComparator::Agreement PfoComparator::ComparePfos(const unsigned int eventNumber, const PfoRecord &first, const PfoRecord &second)
+{
+    const edm4hep::ConstReconstructedParticle &firstPfo(first.m_pfo), &secondPfo(second.m_pfo);
+    std::ostringstream description;
+    Agreement agreement(BITWISE_IDENTICAL);
+
+    if (firstPfo.getType() != secondPfo.getType())
+    {
+        ++m_summary.m_nTypeChanges;
+        description << " pid " << firstPfo.getType() << " -> " << secondPfo.getType() << ";";
+        agreement = DIFFERENT;
+    }
+
+    if (CompareValues(firstPfo.getCharge(), secondPfo.getCharge(), 0.f) != BITWISE_IDENTICAL)
+    {
+        ++m_summary.m_nChargeChanges;
+        description << " charge " << firstPfo.getCharge() << " -> " << secondPfo.getCharge() << ";";
+        agreement = DIFFERENT;
+    }
+
+    if (first.m_hitIds != second.m_hitIds)
+    {
+        ++m_summary.m_nHitMembershipChanges;
+        description << " calo hits " << first.m_hitIds.size() << " -> " << second.m_hitIds.size() << ";";
+        agreement = DIFFERENT;
+    }
+
+    if (first.m_trackIds != second.m_trackIds)
+    {
+        ++m_summary.m_nTrackMembershipChanges;
+        description << " tracks " << first.m_trackIds.size() << " -> " << second.m_trackIds.size() << ";";
+        agreement = DIFFERENT;
+    }
+
+    const float firstEnergy(firstPfo.getEnergy()), secondEnergy(secondPfo.getEnergy());
+    const Agreement energyAgreement(CompareValues(firstEnergy, secondEnergy, m_settings.m_energyTolerance * std::max(std::fabs(firstEnergy), std::fabs(secondEnergy))));
+
+    if (std::fabs(firstEnergy) > 0.f)
+        m_summary.m_relativeEnergyDifference.Add((secondEnergy - firstEnergy) / firstEnergy);
+
+    if (DIFFERENT == energyAgreement)
+        description << " energy " << firstEnergy << " -> " << secondEnergy << ";";
+
+    const float firstMass(firstPfo.getMass()), secondMass(secondPfo.getMass());
+    const Agreement massAgreement(CompareValues(firstMass, secondMass, m_settings.m_energyTolerance * std::max(std::fabs(firstMass), std::fabs(secondMass))));
+
+    if (std::fabs(firstMass) > 0.f)
+        m_summary.m_relativeMassDifference.Add((secondMass - firstMass) / firstMass);
+
+    if (DIFFERENT == massAgreement)
+        description << " mass " << firstMass << " -> " << secondMass << ";";
+
+    const edm4hep::Vector3f firstMomentum(firstPfo.getMomentum()), secondMomentum(secondPfo.getMomentum());
+    const float dPx(secondMomentum.x - firstMomentum.x), dPy(secondMomentum.y - firstMomentum.y), dPz(secondMomentum.z - firstMomentum.z);
+    const float momentumDifference(std::sqrt(dPx * dPx + dPy * dPy + dPz * dPz));
+    const float momentum(std::max(std::sqrt(firstMomentum.x * firstMomentum.x + firstMomentum.y * firstMomentum.y + firstMomentum.z * firstMomentum.z),
+        std::sqrt(secondMomentum.x * secondMomentum.x + secondMomentum.y * secondMomentum.y + secondMomentum.z * secondMomentum.z)));
+    const Agreement momentumAgreement(std::max(std::max(CompareValues(firstMomentum.x, secondMomentum.x, 0.f), CompareValues(firstMomentum.y, secondMomentum.y, 0.f)),
+        CompareValues(firstMomentum.z, secondMomentum.z, 0.f)) == BITWISE_IDENTICAL ? BITWISE_IDENTICAL :
+        CompareValues(0.f, momentumDifference, m_settings.m_momentumTolerance * momentum));
+
+    if (momentum > 0.f)
+        m_summary.m_relativeMomentumDifference.Add(momentumDifference / momentum);
+
+    if (DIFFERENT == momentumAgreement)
+        description << " momentum changed by " << momentumDifference << ";";
+
+    agreement = std::max(agreement, std::max(energyAgreement, std::max(massAgreement, momentumAgreement)));
+
+    const Agreement clusterAgreement(this->CompareClusters(firstPfo, secondPfo));
+
+    if (DIFFERENT == clusterAgreement)
+    {
+        ++m_summary.m_nClusterChanges;
+        description << " clusters;";
+    }
+
+    agreement = std::max(agreement, clusterAgreement);
+
+    Agreement vertexAgreement(BITWISE_IDENTICAL);
+
+    if (first.m_hasStartVertex != second.m_hasStartVertex)
+    {
+        vertexAgreement = DIFFERENT;
+    }
+    else if (first.m_hasStartVertex)
+    {
+        const edm4hep::Vector3f &firstPosition(first.m_startVertexPosition), &secondPosition(second.m_startVertexPosition);
+        const float dx(secondPosition.x - firstPosition.x), dy(secondPosition.y - firstPosition.y), dz(secondPosition.z - firstPosition.z);
+        vertexAgreement = std::max(std::max(CompareValues(firstPosition.x, secondPosition.x, 0.f), CompareValues(firstPosition.y, secondPosition.y, 0.f)),
+            CompareValues(firstPosition.z, secondPosition.z, 0.f)) == BITWISE_IDENTICAL ? BITWISE_IDENTICAL :
+            CompareValues(0.f, std::sqrt(dx * dx + dy * dy + dz * dz), m_settings.m_positionTolerance);
+    }
+
+    if (DIFFERENT == vertexAgreement)
+    {
+        ++m_summary.m_nStartVertexChanges;
+        description << " start vertex;";
+    }
+
+    agreement = std::max(agreement, vertexAgreement);
+
+    Agreement associationAgreement((first.m_associations.size() == second.m_associations.size()) ? BITWISE_IDENTICAL : DIFFERENT);
+
+    for (unsigned int iAssociation = 0; (DIFFERENT != associationAgreement) && (iAssociation < first.m_associations.size()); ++iAssociation)
+    {
+        if (first.m_associations[iAssociation].first != second.m_associations[iAssociation].first)
+        {
+            associationAgreement = DIFFERENT;
+            break;
+        }
+
+        associationAgreement = std::max(associationAgreement, CompareValues(first.m_associations[iAssociation].second,
+            second.m_associations[iAssociation].second, m_settings.m_weightTolerance));
+    }
+
+    if (DIFFERENT == associationAgreement)
+    {
+        ++m_summary.m_nAssociationChanges;
+        description << " mc associations;";
+    }
+
+    agreement = std::max(agreement, associationAgreement);
+    ++m_summary.m_nPfos[agreement];
+
+    if (DIFFERENT == agreement)
+        this->PrintDifference(eventNumber, "pfo " + std::to_string(firstPfo.getObjectID().index) + " -> " +
+            std::to_string(secondPfo.getObjectID().index) + ":" + description.str());
+
+    return agreement;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+PfoComparator::Agreement PfoComparator::CompareClusters(const edm4hep::ConstReconstructedParticle &first, const edm4hep::ConstReconstructedParticle &second) const
+{
+    if (first.clusters_size() != second.clusters_size())
+        return DIFFERENT;
+
+    Agreement agreement(BITWISE_IDENTICAL);
+
+    for (unsigned int iCluster = 0, nClusters = first.clusters_size(); iCluster < nClusters; ++iCluster)
+    {
+        const edm4hep::ConstCluster firstCluster(first.getClusters(iCluster)), secondCluster(second.getClusters(iCluster));
+
+        if (firstCluster.hits_size() != secondCluster.hits_size())
+            return DIFFERENT;
+
+        const float firstEnergy(firstCluster.getEnergy()), secondEnergy(secondCluster.getEnergy());
+        agreement = std::max(agreement, CompareValues(firstEnergy, secondEnergy,
+            m_settings.m_energyTolerance * std::max(std::fabs(firstEnergy), std::fabs(secondEnergy))));
+
+        const edm4hep::Vector3f firstPosition(firstCluster.getPosition()), secondPosition(secondCluster.getPosition());
+        agreement = std::max(agreement, CompareValues(firstPosition.x, secondPosition.x, m_settings.m_positionTolerance));
+        agreement = std::max(agreement, CompareValues(firstPosition.y, secondPosition.y, m_settings.m_positionTolerance));
+        agreement = std::max(agreement, CompareValues(firstPosition.z, secondPosition.z, m_settings.m_positionTolerance));
+    }
+
+    return agreement;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+PfoComparator::Agreement PfoComparator::CompareValues(const float first, const float second, const float tolerance)
+{
+    if (0 == std::memcmp(&first, &second, sizeof(float)))
+        return BITWISE_IDENTICAL;
+
+    return (std::fabs(second - first) <= tolerance) ? WITHIN_TOLERANCE : DIFFERENT;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PfoComparator::PrintDifference(const unsigned int eventNumber, const std::string &description)
+{
+    if (m_nPrintedDifferences >= m_settings.m_maxPrintedDifferences)
+        return;
+
+    std::cout << "Event " << eventNumber << ": " << description << std::endl;
+
+    if (++m_nPrintedDifferences == m_settings.m_maxPrintedDifferences)
+        std::cout << "Further differences are counted but not printed" << std::endl;
+}
@@ -13,7 +13,7 @@
 
 #include "Pandora/PdgTable.h"
 #include "PfoCreator.h"
-#include "PandoraPFAlg.h"
+#include "CollectionMaps.h"
 
 #include <algorithm>
 #include <cmath>
@@ -32,13 +32,11 @@ PfoCreator::~PfoCreator()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-pandora::StatusCode PfoCreator::CreateParticleFlowObjects(CollectionMaps& collectionMaps, DataHandle<edm4hep::ClusterCollection>& _pClusterCollection, DataHandle<edm4hep::ReconstructedParticleCollection>& _pReconstructedParticleCollection, DataHandle<edm4hep::VertexCollection>& _pStartVertexCollection)
+pandora::StatusCode PfoCreator::CreateParticleFlowObjects(CollectionMaps& collectionMaps, edm4hep::ClusterCollection *const pClusterCollection,
+    edm4hep::ReconstructedParticleCollection *const pReconstructedParticleCollection, edm4hep::VertexCollection *const pStartVertexCollection)
 {
     m_collectionMaps = &collectionMaps;
-    edm4hep::ClusterCollection* pClusterCollection                              = _pClusterCollection.createAndPut();
-    edm4hep::ReconstructedParticleCollection* pReconstructedParticleCollection  = _pReconstructedParticleCollection.createAndPut();
-    edm4hep::VertexCollection* pStartVertexCollection                           = _pStartVertexCollection.createAndPut();
- 
+
     const pandora::PfoList *pPandoraPfoList = NULL;
     PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::GetCurrentPfoList(*m_pPandora, pPandoraPfoList));
 
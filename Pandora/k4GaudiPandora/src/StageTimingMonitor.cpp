@@ -0,0 +1,106 @@
+/**
+ *
+ *  @brief  Implementation of the stage timing monitor class.
+ *
+ *  $Log: $
+ */
+
+#include "StageTimingMonitor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+const char *StageTimingMonitor::GetStageName(const Stage stage)
+{
+    switch (stage)
+    {
+    case UPDATE_MAP : return "updateMap";
+    case CREATE_MC_PARTICLES : return "CreateMCParticles";
+    case CREATE_CALO_HITS : return "CreateCaloHits";
+    case CREATE_CALO_HIT_TO_MC_RELATIONSHIPS : return "CreateCaloHitToMCParticleRelationships";
+    case CREATE_TRACK_ASSOCIATIONS : return "CreateTrackAssociations";
+    case CREATE_TRACKS : return "CreateTracks";
+    case CREATE_TRACK_TO_MC_RELATIONSHIPS : return "CreateTrackToMCParticleRelationships";
+    case PROCESS_EVENT : return "ProcessEvent";
+    case CREATE_PARTICLE_FLOW_OBJECTS : return "CreateParticleFlowObjects";
+    case CREATE_MC_RECO_PARTICLE_ASSOCIATION : return "CreateMCRecoParticleAssociation";
+    case RESET : return "Reset";
+    case EVENT : return "Event";
+    default : return "Unknown";
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void StageTimingMonitor::AddEvent(const EventTimes &eventTimes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (unsigned int iStage = 0; iStage < N_STAGES; ++iStage)
+        m_samples[iStage].push_back(eventTimes[iStage]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StageTimingMonitor::Summary StageTimingMonitor::GetSummary(const Stage stage) const
+{
+    Summary summary = {0, 0., 0., 0., 0., 0.};
+    std::vector<double> sorted(m_samples[stage]);
+
+    if (sorted.empty())
+        return summary;
+
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum(0.);
+    for (const double sample : sorted)
+        sum += sample;
+
+    // Nearest-rank percentile
+    auto percentile = [&sorted](const double fraction)
+    {
+        const size_t rank(static_cast<size_t>(std::ceil(fraction * sorted.size())));
+        return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+    };
+
+    summary.m_nEvents = sorted.size();
+    summary.m_mean = sum / sorted.size();
+    summary.m_p50 = percentile(0.50);
+    summary.m_p95 = percentile(0.95);
+    summary.m_p99 = percentile(0.99);
+    summary.m_max = sorted.back();
+
+    return summary;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool StageTimingMonitor::WriteJson(const std::string &fileName) const
+{
+    std::ofstream file(fileName.c_str());
+
+    if (!file.good())
+        return false;
+
+    file << "{" << std::endl << "  \"unit\": \"ms\"," << std::endl << "  \"stages\": {";
+
+    for (unsigned int iStage = 0; iStage < N_STAGES; ++iStage)
+    {
+        const Stage stage(static_cast<Stage>(iStage));
+        const Summary summary(this->GetSummary(stage));
+
+        file << ((0 == iStage) ? "" : ",") << std::endl
+             << "    \"" << GetStageName(stage) << "\": {"
+             << "\"events\": " << summary.m_nEvents
+             << ", \"mean\": " << summary.m_mean
+             << ", \"p50\": " << summary.m_p50
+             << ", \"p95\": " << summary.m_p95
+             << ", \"p99\": " << summary.m_p99
+             << ", \"max\": " << summary.m_max << "}";
+    }
+
+    file << std::endl << "  }" << std::endl << "}" << std::endl;
+
+    return file.good();
+}
@@ -0,0 +1,983 @@
+/**
+ *
+ *  @brief  Implementation of the synthetic event generator class.
+ *
+ *  $Log: $
+ */
+
+#include "gear/BField.h"
+#include "gear/CalorimeterParameters.h"
+#include "gear/GEAR.h"
+#include "gear/GearMgr.h"
+#include "gear/LayerLayout.h"
+#include "gear/PadRowLayout2D.h"
+#include "gear/TPCParameters.h"
+
+#include "UTIL/BitField64.h"
+
+#include "edm4hep/TrackState.h"
+
+#include "CollectionMaps.h"
+#include "SyntheticEventGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+
+const float SPEED_OF_LIGHT = 299.792458f;       ///< The speed of light, units mm/ns
+const unsigned int N_BARREL_MODULES = 5;        ///< The number of barrel modules along z, encoded as M = 1..5
+const unsigned int ENDCAP_MODULE_MINUS_Z = 0;   ///< The module number of the -z endcap
+const unsigned int ENDCAP_MODULE_PLUS_Z = 6;    ///< The module number of the +z endcap
+const unsigned int MAX_STAVE = 7;               ///< The largest stave index the S-1 field can hold
+const unsigned int MAX_CELL_INDEX = 511;        ///< The largest cell index the I and J fields can hold
+const unsigned int N_SUB_DETECTORS = 12;        ///< The number of entries in the track sub detector hit numbers
+const unsigned int TPC_HIT_NUMBER_INDEX = 6;    ///< The index of the tpc hit count in the track sub detector hit numbers
+const unsigned int TPC_FIT_NUMBER_INDEX = 7;    ///< The index of the tpc hits used in the fit, as read by the TrackCreator
+
+/**
+ *  @brief  The track state locations, in the order the TrackCreator reads the track states
+ */
+enum TrackStateLocation
+{
+    AT_OTHER,
+    AT_IP,
+    AT_FIRST_HIT,
+    AT_LAST_HIT,
+    AT_CALORIMETER
+};
+
+/**
+ *  @brief  Get two unit vectors perpendicular to a unit direction and to each other
+ *
+ *  @param  direction the unit direction
+ *  @param  axis1 to receive the first perpendicular vector
+ *  @param  axis2 to receive the second perpendicular vector
+ */
+void GetPerpendicularAxes(const pandora::CartesianVector &direction, pandora::CartesianVector &axis1, pandora::CartesianVector &axis2)
+{
+    const pandora::CartesianVector reference((std::fabs(direction.GetZ()) < 0.9f) ? pandora::CartesianVector(0.f, 0.f, 1.f) :
+        pandora::CartesianVector(1.f, 0.f, 0.f));
+
+    axis1 = direction.GetCrossProduct(reference).GetUnitVector();
+    axis2 = direction.GetCrossProduct(axis1);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Draw a random direction, uniform in phi and in cos(theta) within [-maxCosTheta, maxCosTheta]
+ *
+ *  @param  randomEngine the random number engine
+ *  @param  maxCosTheta the maximum |cos(theta)|
+ *
+ *  @return the unit direction
+ */
+pandora::CartesianVector GetRandomDirection(std::mt19937 &randomEngine, const float maxCosTheta)
+{
+    std::uniform_real_distribution<float> cosThetaDistribution(-maxCosTheta, maxCosTheta);
+    std::uniform_real_distribution<float> phiDistribution(0.f, 2.f * M_PI);
+
+    const float cosTheta(cosThetaDistribution(randomEngine));
+    const float sinTheta(std::sqrt(1.f - cosTheta * cosTheta));
+    const float phi(phiDistribution(randomEngine));
+
+    return pandora::CartesianVector(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Draw a random direction at a gaussian distributed angle from a given axis
+ *
+ *  @param  randomEngine the random number engine
+ *  @param  axis the unit axis
+ *  @param  rmsAngle the rms of the angle to the axis
+ *
+ *  @return the unit direction
+ */
+pandora::CartesianVector GetSmearedDirection(std::mt19937 &randomEngine, const pandora::CartesianVector &axis, const float rmsAngle)
+{
+    std::normal_distribution<float> angleDistribution(0.f, rmsAngle);
+    std::uniform_real_distribution<float> phiDistribution(0.f, 2.f * M_PI);
+
+    pandora::CartesianVector axis1(0.f, 0.f, 0.f), axis2(0.f, 0.f, 0.f);
+    GetPerpendicularAxes(axis, axis1, axis2);
+
+    const float angle(std::fabs(angleDistribution(randomEngine)));
+    const float phi(phiDistribution(randomEngine));
+
+    return (axis * std::cos(angle) + (axis1 * std::cos(phi) + axis2 * std::sin(phi)) * std::sin(angle)).GetUnitVector();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Draw a poisson distributed count
+ *
+ *  @param  randomEngine the random number engine
+ *  @param  mean the mean count
+ *
+ *  @return the count, zero for a non-positive mean
+ */
+unsigned int GetPoissonCount(std::mt19937 &randomEngine, const float mean)
+{
+    if (mean <= 0.f)
+        return 0;
+
+    std::poisson_distribution<unsigned int> countDistribution(mean);
+    return countDistribution(randomEngine);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Make a track state describing a helix at a given point on it
+ *
+ *  @param  location the track state location
+ *  @param  helix the helix
+ *  @param  point the point on the helix, used as reference point
+ *
+ *  @return the track state
+ */
+edm4hep::TrackState MakeTrackState(const TrackStateLocation location, const pandora::Helix &helix, const pandora::CartesianVector &point)
+{
+    const pandora::CartesianVector momentum(helix.GetExtrapolatedMomentum(point));
+
+    edm4hep::TrackState trackState;
+    trackState.location = location;
+    trackState.D0 = 0.f;
+    trackState.phi = std::atan2(momentum.GetY(), momentum.GetX());
+    trackState.omega = helix.GetOmega();
+    trackState.Z0 = 0.f;
+    trackState.tanLambda = helix.GetTanLambda();
+    trackState.referencePoint = edm4hep::Vector3f(point.GetX(), point.GetY(), point.GetZ());
+
+    for (float &covariance : trackState.covMatrix)
+        covariance = 0.f;
+
+    // A relative curvature resolution of 1e-3, comfortably within the track creator sigmaP/P cut
+    const float sigmaOmega(1.e-3f * helix.GetOmega());
+    trackState.covMatrix[5] = sigmaOmega * sigmaOmega;
+
+    return trackState;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+SyntheticEventGenerator::SyntheticEventGenerator(const Settings &settings, gear::GearMgr *const pGearMgr) :
+    m_settings(settings),
+    m_pCellIdEncoder(NULL),
+    m_randomEngine(settings.m_seed)
+{
+    m_bField = pGearMgr->getBField().at(gear::Vector3D(0., 0., 0.)).z();
+
+    const gear::TPCParameters &tpcParameters(pGearMgr->getTPCParameters());
+    m_tpcInnerR = tpcParameters.getPadLayout().getPlaneExtent()[0];
+    m_tpcOuterR = tpcParameters.getPadLayout().getPlaneExtent()[1];
+    m_tpcZmax = tpcParameters.getMaxDriftLength();
+    m_tpcNRows = tpcParameters.getPadLayout().getNRows();
+
+    ReadCaloLayout(pGearMgr->getEcalBarrelParameters(), m_settings.m_absorberRadLengthECal, m_settings.m_absorberIntLengthECal,
+        m_settings.m_eCalMipEnergy, m_caloLayouts[ECAL_BARREL]);
+    ReadCaloLayout(pGearMgr->getEcalEndcapParameters(), m_settings.m_absorberRadLengthECal, m_settings.m_absorberIntLengthECal,
+        m_settings.m_eCalMipEnergy, m_caloLayouts[ECAL_ENDCAP]);
+    ReadCaloLayout(pGearMgr->getHcalBarrelParameters(), m_settings.m_absorberRadLengthHCal, m_settings.m_absorberIntLengthHCal,
+        m_settings.m_hCalMipEnergy, m_caloLayouts[HCAL_BARREL]);
+    ReadCaloLayout(pGearMgr->getHcalEndcapParameters(), m_settings.m_absorberRadLengthHCal, m_settings.m_absorberIntLengthHCal,
+        m_settings.m_hCalMipEnergy, m_caloLayouts[HCAL_ENDCAP]);
+
+    for (unsigned int iRegion = 0; iRegion < N_CALO_REGIONS; ++iRegion)
+    {
+        const CaloLayout &layout(m_caloLayouts[iRegion]);
+
+        if (layout.m_layerCentres.empty() || (layout.m_isBarrel && ((layout.m_symmetryOrder < 3) || (layout.m_symmetryOrder > MAX_STAVE + 1))))
+        {
+            std::cout << "SyntheticEventGenerator: unsupported layout for calo hit collection " << m_settings.m_caloHitCollectionNames[iRegion]
+                      << std::endl;
+            throw pandora::StatusCodeException(pandora::STATUS_CODE_INVALID_PARAMETER);
+        }
+    }
+
+    if (0 == m_tpcNRows)
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_INVALID_PARAMETER);
+
+    m_pCellIdEncoder = new UTIL::BitField64("M:3,S-1:3,I:9,J:9,K-1:6");
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+SyntheticEventGenerator::~SyntheticEventGenerator()
+{
+    delete m_pCellIdEncoder;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::Generate(Event &event)
+{
+    event.Clear();
+    m_mcParticles.clear();
+    m_cellDeposits.clear();
+    m_cellIndices.clear();
+
+    std::uniform_int_distribution<unsigned int> nJetsDistribution(m_settings.m_minNJets, std::max(m_settings.m_minNJets, m_settings.m_maxNJets));
+    std::uniform_int_distribution<int> quarkDistribution(1, 5);
+    std::exponential_distribution<float> energyShareDistribution(1.f);
+
+    const unsigned int nJets(nJetsDistribution(m_randomEngine));
+
+    for (unsigned int iJet = 0; iJet < nJets; ++iJet)
+    {
+        const pandora::CartesianVector jetAxis(GetRandomDirection(m_randomEngine, m_settings.m_maxCosTheta));
+        const pandora::CartesianVector jetMomentum(jetAxis * m_settings.m_jetEnergy);
+
+        edm4hep::MCParticle quark(event.m_mcParticles.create());
+        quark.setPDG(((iJet % 2) ? -1 : 1) * quarkDistribution(m_randomEngine));
+        quark.setGeneratorStatus(2);
+        quark.setMass(0.f);
+        quark.setMomentum(edm4hep::Vector3f(jetMomentum.GetX(), jetMomentum.GetY(), jetMomentum.GetZ()));
+        quark.setVertex(edm4hep::Vector3d(0., 0., 0.));
+
+        const unsigned int nParticles(std::max(1U, GetPoissonCount(m_randomEngine, m_settings.m_nParticlesPerJet)));
+
+        pandora::FloatVector energyShares;
+        float energyShareSum(0.f);
+
+        for (unsigned int iParticle = 0; iParticle < nParticles; ++iParticle)
+        {
+            energyShares.push_back(energyShareDistribution(m_randomEngine));
+            energyShareSum += energyShares.back();
+        }
+
+        for (unsigned int iParticle = 0; iParticle < nParticles; ++iParticle)
+        {
+            const pandora::CartesianVector direction(GetSmearedDirection(m_randomEngine, jetAxis, m_settings.m_jetConeAngle));
+            this->GenerateParticle(event, m_settings.m_jetEnergy * energyShares[iParticle] / energyShareSum, direction, &quark);
+        }
+    }
+
+    std::uniform_real_distribution<float> isolatedEnergyDistribution(1.f, std::max(1.f, m_settings.m_maxIsolatedParticleEnergy));
+
+    for (unsigned int iParticle = 0; iParticle < m_settings.m_nIsolatedParticles; ++iParticle)
+    {
+        const pandora::CartesianVector direction(GetRandomDirection(m_randomEngine, m_settings.m_maxCosTheta));
+        this->GenerateParticle(event, isolatedEnergyDistribution(m_randomEngine), direction, NULL);
+    }
+
+    this->DepositNoise();
+    this->WriteCaloHits(event);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::FillCollectionMaps(const Event &event, CollectionMaps &collectionMaps) const
+{
+    collectionMaps.collectionMap_MC[m_settings.m_mcParticleCollectionName] = &event.m_mcParticles;
+
+    for (unsigned int iRegion = 0; iRegion < N_CALO_REGIONS; ++iRegion)
+        collectionMaps.collectionMap_CaloHit[m_settings.m_caloHitCollectionNames[iRegion]] = &event.m_caloHits[iRegion];
+
+    collectionMaps.collectionMap_Track[m_settings.m_trackCollectionName] = &event.m_tracks;
+
+    if (m_settings.m_createMCTruth)
+    {
+        collectionMaps.collectionMap_CaloRel[m_settings.m_caloHitRelationCollectionName] = &event.m_caloHitAssociations;
+        collectionMaps.collectionMap_TrkRel[m_settings.m_trackerHitRelationCollectionName] = &event.m_trackerHitAssociations;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::GenerateParticle(Event &event, float energy, const pandora::CartesianVector &direction,
+    edm4hep::MCParticle *const pParent)
+{
+    std::uniform_real_distribution<float> flatDistribution(0.f, 1.f);
+
+    int pdg(22), charge(0);
+    float mass(0.f);
+    const float type(flatDistribution(m_randomEngine));
+
+    if (type < m_settings.m_photonFraction)
+    {
+        pdg = 22;
+    }
+    else if (type < m_settings.m_photonFraction + m_settings.m_neutralHadronFraction)
+    {
+        pdg = 130;
+        mass = 0.497611f;
+    }
+    else
+    {
+        charge = (flatDistribution(m_randomEngine) < 0.5f) ? 1 : -1;
+        pdg = 211 * charge;
+        mass = 0.13957f;
+    }
+
+    // Keep enough kinetic energy for hadrons to leave a visible deposit
+    energy = std::max(energy, mass + 0.1f);
+    const pandora::CartesianVector momentum(direction * std::sqrt(energy * energy - mass * mass));
+
+    edm4hep::MCParticle mcParticle(event.m_mcParticles.create());
+    mcParticle.setPDG(pdg);
+    mcParticle.setGeneratorStatus(1);
+    mcParticle.setCharge(static_cast<float>(charge));
+    mcParticle.setMass(mass);
+    mcParticle.setMomentum(edm4hep::Vector3f(momentum.GetX(), momentum.GetY(), momentum.GetZ()));
+    mcParticle.setVertex(edm4hep::Vector3d(0., 0., 0.));
+
+    if (NULL != pParent)
+    {
+        pParent->addToDaughters(mcParticle);
+        mcParticle.addToParents(*pParent);
+    }
+
+    const int mcIndex(m_mcParticles.size());
+    m_mcParticles.push_back(mcParticle);
+
+    if (0 == charge)
+    {
+        const ShowerAxis axis(pandora::CartesianVector(0.f, 0.f, 0.f), direction);
+
+        if (22 == pdg)
+        {
+            this->DepositEMShower(axis, energy, mcIndex);
+        }
+        else
+        {
+            this->DepositHadronicShower(axis, energy, false, mcIndex);
+        }
+
+        return;
+    }
+
+    const pandora::Helix helix(pandora::CartesianVector(0.f, 0.f, 0.f), momentum, static_cast<float>(charge), m_bField);
+    const CaloLayout &eCalBarrel(m_caloLayouts[ECAL_BARREL]), &eCalEndcap(m_caloLayouts[ECAL_ENDCAP]);
+
+    pandora::CartesianVector calorimeterEntry(0.f, 0.f, 0.f);
+    float genericTime(0.f);
+    bool reachesCalorimeter(false);
+
+    if ((pandora::STATUS_CODE_SUCCESS == helix.GetPointOnCircle(eCalBarrel.m_innerR, helix.GetReferencePoint(), calorimeterEntry, genericTime)) &&
+        (std::fabs(calorimeterEntry.GetZ()) < eCalBarrel.m_outerZ))
+    {
+        reachesCalorimeter = true;
+    }
+    else
+    {
+        const float endcapZ((momentum.GetZ() > 0.f) ? eCalEndcap.m_innerZ : -eCalEndcap.m_innerZ);
+
+        if (pandora::STATUS_CODE_SUCCESS == helix.GetPointInZ(endcapZ, helix.GetReferencePoint(), calorimeterEntry, genericTime))
+        {
+            const float entryR(std::sqrt(calorimeterEntry.GetX() * calorimeterEntry.GetX() + calorimeterEntry.GetY() * calorimeterEntry.GetY()));
+            reachesCalorimeter = (entryR > eCalEndcap.m_innerR) && (entryR < eCalEndcap.m_outerR);
+        }
+    }
+
+    this->GenerateTrack(event, helix, mcIndex, reachesCalorimeter ? &calorimeterEntry : NULL);
+
+    if (!reachesCalorimeter)
+        return;
+
+    m_mcParticles.back().setEndpoint(edm4hep::Vector3d(calorimeterEntry.GetX(), calorimeterEntry.GetY(), calorimeterEntry.GetZ()));
+
+    const ShowerAxis axis(calorimeterEntry, helix.GetExtrapolatedMomentum(calorimeterEntry).GetUnitVector());
+    this->DepositHadronicShower(axis, energy, true, mcIndex);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::GenerateTrack(Event &event, const pandora::Helix &helix, const int mcIndex,
+    const pandora::CartesianVector *const pCalorimeterEntry)
+{
+    pandora::CartesianPointVector rowPoints;
+    const float rowPitch((m_tpcOuterR - m_tpcInnerR) / static_cast<float>(m_tpcNRows));
+
+    for (unsigned int iRow = 0; iRow < m_tpcNRows; ++iRow)
+    {
+        pandora::CartesianVector rowPoint(0.f, 0.f, 0.f);
+        float genericTime(0.f);
+
+        if (pandora::STATUS_CODE_SUCCESS != helix.GetPointOnCircle(m_tpcInnerR + (iRow + 0.5f) * rowPitch, helix.GetReferencePoint(), rowPoint,
+            genericTime))
+        {
+            break;
+        }
+
+        if (std::fabs(rowPoint.GetZ()) > m_tpcZmax)
+            break;
+
+        rowPoints.push_back(rowPoint);
+    }
+
+    // Particles leaving no tpc hits are not reconstructed as tracks
+    if (rowPoints.empty())
+        return;
+
+    const unsigned int nRowPoints(rowPoints.size());
+    const unsigned int stride(((0 == m_settings.m_maxTrackerHitsPerTrack) || (nRowPoints <= m_settings.m_maxTrackerHitsPerTrack)) ? 1 :
+        (nRowPoints + m_settings.m_maxTrackerHitsPerTrack - 1) / m_settings.m_maxTrackerHitsPerTrack);
+
+    edm4hep::Track track(event.m_tracks.create());
+
+    for (unsigned int iPoint = 0; iPoint < nRowPoints; iPoint += stride)
+    {
+        const pandora::CartesianVector &rowPoint(rowPoints[iPoint]);
+        const edm4hep::Vector3d position(rowPoint.GetX(), rowPoint.GetY(), rowPoint.GetZ());
+
+        edm4hep::TrackerHit trackerHit(event.m_trackerHits.create());
+        trackerHit.setPosition(position);
+        trackerHit.setTime(rowPoint.GetMagnitude() / SPEED_OF_LIGHT);
+        track.addToTrackerHits(trackerHit);
+
+        if (!m_settings.m_createMCTruth)
+            continue;
+
+        edm4hep::SimTrackerHit simTrackerHit(event.m_simTrackerHits.create());
+        simTrackerHit.setPosition(position);
+        simTrackerHit.setTime(trackerHit.getTime());
+        simTrackerHit.setMCParticle(m_mcParticles[mcIndex]);
+
+        edm4hep::MCRecoTrackerAssociation association(event.m_trackerHitAssociations.create());
+        association.setRec(trackerHit);
+        association.setSim(simTrackerHit);
+        association.setWeight(1.f);
+    }
+
+    // Every pad row crossed counts as a hit in the fit, as for a full tpc track
+    for (unsigned int iDetector = 0; iDetector < N_SUB_DETECTORS; ++iDetector)
+        track.addToSubDetectorHitNumbers(((TPC_HIT_NUMBER_INDEX == iDetector) || (TPC_FIT_NUMBER_INDEX == iDetector)) ? nRowPoints : 0);
+
+    const pandora::CartesianVector &firstPoint(rowPoints.front()), &lastPoint(rowPoints.back());
+    track.setRadiusOfInnermostHit(std::sqrt(firstPoint.GetX() * firstPoint.GetX() + firstPoint.GetY() * firstPoint.GetY()));
+    track.setChi2(static_cast<float>(nRowPoints));
+    track.setNdf(2 * nRowPoints - 5);
+
+    track.addToTrackStates(MakeTrackState(AT_OTHER, helix, helix.GetReferencePoint()));
+    track.addToTrackStates(MakeTrackState(AT_IP, helix, helix.GetReferencePoint()));
+    track.addToTrackStates(MakeTrackState(AT_FIRST_HIT, helix, firstPoint));
+    track.addToTrackStates(MakeTrackState(AT_LAST_HIT, helix, lastPoint));
+    track.addToTrackStates(MakeTrackState(AT_CALORIMETER, helix, (NULL != pCalorimeterEntry) ? *pCalorimeterEntry : lastPoint));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::DepositEMShower(const ShowerAxis &axis, const float energy, const int mcIndex)
+{
+    const unsigned int nHits(GetPoissonCount(m_randomEngine, m_settings.m_occupancy * m_settings.m_eCalHitsPerGeV * energy));
+
+    if (0 == nHits)
+        return;
+
+    // Longitudinal gamma profile in radiation lengths, peaking at ln(E/Ec) + 0.5 for a critical energy of 10 MeV
+    const float profileScale(0.5f);
+    const float profileShape(1.f + profileScale * std::max(0.5f, std::log(energy / 0.01f) + 0.5f));
+
+    std::gamma_distribution<float> depthDistribution(profileShape, 1.f / profileScale);
+    std::exponential_distribution<float> radiusDistribution(1.f / m_settings.m_emShowerRadius);
+    std::exponential_distribution<float> energyDistribution(1.f);
+
+    const float meanHitEnergy(energy / static_cast<float>(nHits));
+
+    for (unsigned int iHit = 0; iHit < nHits; ++iHit)
+    {
+        const float depth(depthDistribution(m_randomEngine));
+        const float radius(radiusDistribution(m_randomEngine));
+        this->DepositAtDepth(axis, depth, false, radius, meanHitEnergy * energyDistribution(m_randomEngine), mcIndex);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::DepositHadronicShower(const ShowerAxis &axis, const float energy, const bool isCharged, const int mcIndex)
+{
+    std::exponential_distribution<float> firstInteractionDistribution(1.f);
+    std::uniform_real_distribution<float> mipFluctuationDistribution(0.8f, 1.2f);
+
+    const float showerStart(firstInteractionDistribution(m_randomEngine));
+
+    // Charged hadrons leave a mip track in every layer in front of their first interaction
+    if (isCharged)
+    {
+        const CaloRegion barrelRegions[2] = {ECAL_BARREL, HCAL_BARREL};
+        float depthOffset(0.f);
+
+        for (const CaloRegion barrelRegion : barrelRegions)
+        {
+            CaloRegion region(barrelRegion);
+            unsigned int stave(0);
+
+            if (!this->FindEntryRegion(barrelRegion, axis, region, stave))
+                continue;
+
+            const CaloLayout &layout(m_caloLayouts[region]);
+            const unsigned int nLayers(layout.m_interactionLengths.size());
+
+            for (unsigned int iLayer = 0; iLayer < nLayers; ++iLayer)
+            {
+                if (depthOffset + layout.m_interactionLengths[iLayer] > showerStart)
+                    break;
+
+                this->DepositInLayer(region, stave, iLayer, axis, 0.f, layout.m_mipEnergy * mipFluctuationDistribution(m_randomEngine), mcIndex);
+            }
+
+            depthOffset += layout.m_interactionLengths.back();
+
+            if (depthOffset > showerStart)
+                break;
+        }
+    }
+
+    const unsigned int nHits(GetPoissonCount(m_randomEngine, m_settings.m_occupancy * m_settings.m_hCalHitsPerGeV * energy));
+
+    if (0 == nHits)
+        return;
+
+    // Longitudinal gamma profile in interaction lengths beyond the first interaction, lengthening slowly with energy
+    std::gamma_distribution<float> depthDistribution(2.f, 0.5f + 0.1f * std::log(1.f + energy));
+    std::exponential_distribution<float> radiusDistribution(1.f / m_settings.m_hadShowerRadius);
+    std::exponential_distribution<float> energyDistribution(1.f);
+
+    const float meanHitEnergy(energy / static_cast<float>(nHits));
+
+    for (unsigned int iHit = 0; iHit < nHits; ++iHit)
+    {
+        const float depth(showerStart + depthDistribution(m_randomEngine));
+        const float radius(radiusDistribution(m_randomEngine));
+        this->DepositAtDepth(axis, depth, true, radius, meanHitEnergy * energyDistribution(m_randomEngine), mcIndex);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::DepositAtDepth(const ShowerAxis &axis, float depth, const bool useInteractionLengths, const float lateralRadius,
+    const float energy, const int mcIndex)
+{
+    const CaloRegion barrelRegions[2] = {ECAL_BARREL, HCAL_BARREL};
+
+    for (const CaloRegion barrelRegion : barrelRegions)
+    {
+        CaloRegion region(barrelRegion);
+        unsigned int stave(0);
+
+        if (!this->FindEntryRegion(barrelRegion, axis, region, stave))
+            continue;
+
+        const CaloLayout &layout(m_caloLayouts[region]);
+        const pandora::FloatVector &cumulativeLengths(useInteractionLengths ? layout.m_interactionLengths : layout.m_radiationLengths);
+
+        if (depth < cumulativeLengths.back())
+        {
+            const unsigned int layer(std::upper_bound(cumulativeLengths.begin(), cumulativeLengths.end(), depth) - cumulativeLengths.begin());
+            this->DepositInLayer(region, stave, layer, axis, lateralRadius, energy, mcIndex);
+            return;
+        }
+
+        depth -= cumulativeLengths.back();
+    }
+
+    // Energy beyond the back of the hcal leaks out of the detector
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::DepositInLayer(const CaloRegion region, const unsigned int stave, const unsigned int layer, const ShowerAxis &axis,
+    const float lateralRadius, const float energy, const int mcIndex)
+{
+    const CaloLayout &layout(m_caloLayouts[region]);
+    const pandora::CartesianVector &direction(axis.m_direction);
+    const pandora::CartesianVector normal(layout.m_isBarrel ? this->GetStaveNormal(layout, stave) :
+        pandora::CartesianVector(0.f, 0.f, (direction.GetZ() > 0.f) ? 1.f : -1.f));
+
+    const float cosAngle(direction.GetDotProduct(normal));
+
+    if (cosAngle < std::numeric_limits<float>::epsilon())
+        return;
+
+    const float layerDistance(layout.m_layerCentres[layer]);
+    pandora::CartesianVector position(axis.m_origin + direction * ((layerDistance - axis.m_origin.GetDotProduct(normal)) / cosAngle));
+
+    if (lateralRadius > 0.f)
+    {
+        std::uniform_real_distribution<float> phiDistribution(0.f, 2.f * M_PI);
+        const float phi(phiDistribution(m_randomEngine));
+
+        pandora::CartesianVector axis1(0.f, 0.f, 0.f), axis2(0.f, 0.f, 0.f);
+        GetPerpendicularAxes(direction, axis1, axis2);
+
+        // Displace perpendicular to the axis, then slide along the axis back onto the layer plane
+        position = position + (axis1 * std::cos(phi) + axis2 * std::sin(phi)) * lateralRadius;
+        position = position - direction * ((position.GetDotProduct(normal) - layerDistance) / cosAngle);
+    }
+
+    this->AddToCell(region, stave, layer, position, energy, mcIndex);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::AddToCell(const CaloRegion region, const unsigned int stave, const unsigned int layer,
+    const pandora::CartesianVector &position, const float energy, const int mcIndex)
+{
+    const CaloLayout &layout(m_caloLayouts[region]);
+    const float cellSize0(layout.m_cellSize0[layer]), cellSize1(layout.m_cellSize1[layer]);
+    const float layerDistance(layout.m_layerCentres[layer]);
+
+    unsigned int module(0), staveField(0);
+    int cellI(0), cellJ(0);
+    pandora::CartesianVector cellCentre(0.f, 0.f, 0.f);
+
+    if (layout.m_isBarrel)
+    {
+        const pandora::CartesianVector normal(this->GetStaveNormal(layout, stave));
+        const pandora::CartesianVector along(normal.GetY(), -normal.GetX(), 0.f);
+        const float halfWidth(layerDistance * std::tan(M_PI / static_cast<float>(layout.m_symmetryOrder)));
+        const float moduleLength(2.f * layout.m_outerZ / static_cast<float>(N_BARREL_MODULES));
+        const float alongStave(position.GetDotProduct(along)), z(position.GetZ());
+
+        if ((std::fabs(alongStave) >= halfWidth) || (std::fabs(z) >= layout.m_outerZ))
+            return;
+
+        module = std::min(N_BARREL_MODULES - 1, static_cast<unsigned int>((z + layout.m_outerZ) / moduleLength));
+        cellI = static_cast<int>((alongStave + halfWidth) / cellSize0);
+        cellJ = static_cast<int>((z + layout.m_outerZ - module * moduleLength) / cellSize1);
+
+        cellCentre = normal * layerDistance + along * (-halfWidth + (cellI + 0.5f) * cellSize0) +
+            pandora::CartesianVector(0.f, 0.f, -layout.m_outerZ + module * moduleLength + (cellJ + 0.5f) * cellSize1);
+
+        module += 1;
+        staveField = stave;
+    }
+    else
+    {
+        const float x(position.GetX()), y(position.GetY()), z(position.GetZ());
+        const float r(std::sqrt(x * x + y * y));
+
+        if ((r < layout.m_innerR) || (r >= layout.m_outerR))
+            return;
+
+        cellI = static_cast<int>(std::fabs(x) / cellSize0);
+        cellJ = static_cast<int>(std::fabs(y) / cellSize1);
+
+        const float signX((x < 0.f) ? -1.f : 1.f), signY((y < 0.f) ? -1.f : 1.f), signZ((z < 0.f) ? -1.f : 1.f);
+        cellCentre = pandora::CartesianVector(signX * (cellI + 0.5f) * cellSize0, signY * (cellJ + 0.5f) * cellSize1, signZ * layerDistance);
+
+        module = (z < 0.f) ? ENDCAP_MODULE_MINUS_Z : ENDCAP_MODULE_PLUS_Z;
+        staveField = ((x < 0.f) ? 1 : 0) + ((y < 0.f) ? 2 : 0);
+    }
+
+    if ((cellI < 0) || (cellJ < 0) || (cellI > static_cast<int>(MAX_CELL_INDEX)) || (cellJ > static_cast<int>(MAX_CELL_INDEX)))
+        return;
+
+    m_pCellIdEncoder->reset();
+    (*m_pCellIdEncoder)["M"] = module;
+    (*m_pCellIdEncoder)["S-1"] = staveField;
+    (*m_pCellIdEncoder)["I"] = cellI;
+    (*m_pCellIdEncoder)["J"] = cellJ;
+    (*m_pCellIdEncoder)["K-1"] = layer;
+
+    const uint64_t cellId(m_pCellIdEncoder->getValue());
+    const uint64_t cellKey((static_cast<uint64_t>(region) << 48) | cellId);
+
+    CellIndexMap::const_iterator iter = m_cellIndices.find(cellKey);
+
+    if (m_cellIndices.end() == iter)
+    {
+        iter = m_cellIndices.insert(CellIndexMap::value_type(cellKey, m_cellDeposits.size())).first;
+
+        m_cellDeposits.push_back(CellDeposit(region, cellId, cellCentre));
+    }
+
+    CellDeposit &cellDeposit(m_cellDeposits[iter->second]);
+    cellDeposit.m_energy += energy;
+
+    if (!m_settings.m_createMCTruth || (mcIndex < 0))
+        return;
+
+    for (std::pair<int, float> &contribution : cellDeposit.m_contributions)
+    {
+        if (mcIndex == contribution.first)
+        {
+            contribution.second += energy;
+            return;
+        }
+    }
+
+    cellDeposit.m_contributions.push_back(std::make_pair(mcIndex, energy));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool SyntheticEventGenerator::FindEntryRegion(const CaloRegion barrelRegion, const ShowerAxis &axis, CaloRegion &region, unsigned int &stave) const
+{
+    const CaloRegion endcapRegion(static_cast<CaloRegion>(barrelRegion + 1));
+    const CaloLayout &barrel(m_caloLayouts[barrelRegion]), &endcap(m_caloLayouts[endcapRegion]);
+    const pandora::CartesianVector &origin(axis.m_origin), &direction(axis.m_direction);
+
+    // The axis leaves the polygon bounded by the inner faces of the staves through the face it reaches first
+    float bestPathLength(std::numeric_limits<float>::max());
+    unsigned int bestStave(0);
+
+    for (unsigned int iStave = 0; iStave < barrel.m_symmetryOrder; ++iStave)
+    {
+        const pandora::CartesianVector normal(this->GetStaveNormal(barrel, iStave));
+        const float cosAngle(direction.GetDotProduct(normal));
+
+        if (cosAngle < std::numeric_limits<float>::epsilon())
+            continue;
+
+        const float pathLength((barrel.m_innerR - origin.GetDotProduct(normal)) / cosAngle);
+
+        if (pathLength < bestPathLength)
+        {
+            bestPathLength = pathLength;
+            bestStave = iStave;
+        }
+    }
+
+    if ((bestPathLength < std::numeric_limits<float>::max()) && (std::fabs((origin + direction * bestPathLength).GetZ()) < barrel.m_outerZ))
+    {
+        region = barrelRegion;
+        stave = bestStave;
+        return true;
+    }
+
+    if (std::fabs(direction.GetZ()) < std::numeric_limits<float>::epsilon())
+        return false;
+
+    const float endcapZ((direction.GetZ() > 0.f) ? endcap.m_innerZ : -endcap.m_innerZ);
+    const float pathLength((endcapZ - origin.GetZ()) / direction.GetZ());
+
+    if (pathLength < 0.f)
+        return false;
+
+    const pandora::CartesianVector endcapPoint(origin + direction * pathLength);
+    const float endcapR(std::sqrt(endcapPoint.GetX() * endcapPoint.GetX() + endcapPoint.GetY() * endcapPoint.GetY()));
+
+    if ((endcapR < endcap.m_innerR) || (endcapR > endcap.m_outerR))
+        return false;
+
+    region = endcapRegion;
+    stave = 0;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+pandora::CartesianVector SyntheticEventGenerator::GetStaveNormal(const CaloLayout &layout, const unsigned int stave) const
+{
+    const float phi(layout.m_phi0 + 2.f * M_PI * static_cast<float>(stave) / static_cast<float>(layout.m_symmetryOrder));
+    return pandora::CartesianVector(-std::sin(phi), std::cos(phi), 0.f);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::DepositNoise()
+{
+    std::uniform_int_distribution<unsigned int> regionDistribution(0, N_CALO_REGIONS - 1);
+    std::uniform_real_distribution<float> flatDistribution(0.f, 1.f);
+    std::exponential_distribution<float> energyDistribution(1.f);
+
+    for (unsigned int iHit = 0; iHit < m_settings.m_nNoiseHits; ++iHit)
+    {
+        const CaloRegion region(static_cast<CaloRegion>(regionDistribution(m_randomEngine)));
+        const CaloLayout &layout(m_caloLayouts[region]);
+        const unsigned int layer(std::min<unsigned int>(layout.m_layerCentres.size() - 1, flatDistribution(m_randomEngine) * layout.m_layerCentres.size()));
+        const float layerDistance(layout.m_layerCentres[layer]);
+
+        unsigned int stave(0);
+        pandora::CartesianVector position(0.f, 0.f, 0.f);
+
+        if (layout.m_isBarrel)
+        {
+            stave = std::min(layout.m_symmetryOrder - 1, static_cast<unsigned int>(flatDistribution(m_randomEngine) * layout.m_symmetryOrder));
+
+            const pandora::CartesianVector normal(this->GetStaveNormal(layout, stave));
+            const pandora::CartesianVector along(normal.GetY(), -normal.GetX(), 0.f);
+            const float halfWidth(layerDistance * std::tan(M_PI / static_cast<float>(layout.m_symmetryOrder)));
+            const float alongStave(halfWidth * (2.f * flatDistribution(m_randomEngine) - 1.f));
+            const float z(layout.m_outerZ * (2.f * flatDistribution(m_randomEngine) - 1.f));
+
+            position = normal * layerDistance + along * alongStave + pandora::CartesianVector(0.f, 0.f, z);
+        }
+        else
+        {
+            const float innerR2(layout.m_innerR * layout.m_innerR), outerR2(layout.m_outerR * layout.m_outerR);
+            const float r(std::sqrt(innerR2 + (outerR2 - innerR2) * flatDistribution(m_randomEngine)));
+            const float phi(2.f * M_PI * flatDistribution(m_randomEngine));
+            const float z((flatDistribution(m_randomEngine) < 0.5f) ? -layerDistance : layerDistance);
+
+            position = pandora::CartesianVector(r * std::cos(phi), r * std::sin(phi), z);
+        }
+
+        this->AddToCell(region, stave, layer, position, layout.m_mipEnergy * (0.5f + energyDistribution(m_randomEngine)), -1);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::WriteCaloHits(Event &event)
+{
+    for (const CellDeposit &cellDeposit : m_cellDeposits)
+    {
+        const pandora::CartesianVector &cellCentre(cellDeposit.m_position);
+        const edm4hep::Vector3f position(cellCentre.GetX(), cellCentre.GetY(), cellCentre.GetZ());
+
+        edm4hep::CalorimeterHit caloHit(event.m_caloHits[cellDeposit.m_region].create());
+        caloHit.setCellID(cellDeposit.m_cellId);
+        caloHit.setEnergy(cellDeposit.m_energy);
+        caloHit.setTime(cellDeposit.m_time);
+        caloHit.setPosition(position);
+
+        if (!m_settings.m_createMCTruth)
+            continue;
+
+        edm4hep::SimCalorimeterHit simCaloHit(event.m_simCaloHits.create());
+        simCaloHit.setCellID(cellDeposit.m_cellId);
+        simCaloHit.setEnergy(cellDeposit.m_energy);
+        simCaloHit.setPosition(position);
+
+        for (const std::pair<int, float> &contribution : cellDeposit.m_contributions)
+        {
+            const edm4hep::MCParticle &mcParticle(m_mcParticles[contribution.first]);
+
+            edm4hep::CaloHitContribution caloHitContribution(event.m_caloHitContributions.create());
+            caloHitContribution.setPDG(mcParticle.getPDG());
+            caloHitContribution.setEnergy(contribution.second);
+            caloHitContribution.setTime(cellDeposit.m_time);
+            caloHitContribution.setParticle(mcParticle);
+            simCaloHit.addToContributions(caloHitContribution);
+        }
+
+        edm4hep::MCRecoCaloAssociation association(event.m_caloHitAssociations.create());
+        association.setRec(caloHit);
+        association.setSim(simCaloHit);
+        association.setWeight(1.f);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::ReadCaloLayout(const gear::CalorimeterParameters &parameters, const float radLength, const float intLength,
+    const float mipEnergy, CaloLayout &layout)
+{
+    const std::vector<double> &extent(parameters.getExtent());
+    const gear::LayerLayout &layerLayout(parameters.getLayerLayout());
+
+    layout.m_isBarrel = (gear::CalorimeterParameters::BARREL == parameters.getLayoutType());
+    layout.m_symmetryOrder = parameters.getSymmetryOrder();
+    layout.m_phi0 = parameters.getPhi0();
+    layout.m_innerR = extent[0];
+    layout.m_outerR = extent[1];
+    layout.m_innerZ = extent[2];
+    layout.m_outerZ = extent[3];
+    layout.m_mipEnergy = mipEnergy;
+
+    float radiationLengths(0.f), interactionLengths(0.f);
+
+    for (int iLayer = 0, nLayers = layerLayout.getNLayers(); iLayer < nLayers; ++iLayer)
+    {
+        radiationLengths += radLength * layerLayout.getAbsorberThickness(iLayer);
+        interactionLengths += intLength * layerLayout.getAbsorberThickness(iLayer);
+
+        layout.m_layerCentres.push_back(layerLayout.getDistance(iLayer) + 0.5f * layerLayout.getThickness(iLayer));
+        layout.m_cellSize0.push_back(layerLayout.getCellSize0(iLayer));
+        layout.m_cellSize1.push_back(layerLayout.getCellSize1(iLayer));
+        layout.m_radiationLengths.push_back(radiationLengths);
+        layout.m_interactionLengths.push_back(interactionLengths);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+SyntheticEventGenerator::Settings::Settings() :
+    m_seed(42),
+    m_minNJets(2),
+    m_maxNJets(2),
+    m_nParticlesPerJet(20.f),
+    m_jetEnergy(45.f),
+    m_jetConeAngle(0.15f),
+    m_nIsolatedParticles(0),
+    m_maxIsolatedParticleEnergy(10.f),
+    m_photonFraction(0.3f),
+    m_neutralHadronFraction(0.1f),
+    m_maxCosTheta(0.9f),
+    m_occupancy(1.f),
+    m_eCalHitsPerGeV(40.f),
+    m_hCalHitsPerGeV(20.f),
+    m_emShowerRadius(15.f),
+    m_hadShowerRadius(60.f),
+    m_nNoiseHits(0),
+    m_maxTrackerHitsPerTrack(100),
+    m_createMCTruth(true),
+    m_absorberRadLengthECal(0.2854f),
+    m_absorberIntLengthECal(0.0101f),
+    m_absorberRadLengthHCal(0.0569f),
+    m_absorberIntLengthHCal(0.006f),
+    m_eCalMipEnergy(1.f / 160.f),
+    m_hCalMipEnergy(1.f / 34.8f),
+    m_mcParticleCollectionName("MCParticle"),
+    m_caloHitCollectionNames{"ECALBarrel", "ECALEndcap", "HCALBarrel", "HCALEndcap"},
+    m_trackCollectionName("Tracks"),
+    m_caloHitRelationCollectionName("RelationCaloHit"),
+    m_trackerHitRelationCollectionName("RecoTrackerAssociation")
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+SyntheticEventGenerator::Event::Event()
+{
+    // podio object ids combine the collection id with the object index, so the collections must not share an id
+    unsigned int collectionId(1);
+
+    m_mcParticles.setID(collectionId++);
+
+    for (unsigned int iRegion = 0; iRegion < N_CALO_REGIONS; ++iRegion)
+        m_caloHits[iRegion].setID(collectionId++);
+
+    m_trackerHits.setID(collectionId++);
+    m_tracks.setID(collectionId++);
+    m_simCaloHits.setID(collectionId++);
+    m_caloHitContributions.setID(collectionId++);
+    m_caloHitAssociations.setID(collectionId++);
+    m_simTrackerHits.setID(collectionId++);
+    m_trackerHitAssociations.setID(collectionId++);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEventGenerator::Event::Clear()
+{
+    m_mcParticles.clear();
+
+    for (unsigned int iRegion = 0; iRegion < N_CALO_REGIONS; ++iRegion)
+        m_caloHits[iRegion].clear();
+
+    m_trackerHits.clear();
+    m_tracks.clear();
+    m_simCaloHits.clear();
+    m_caloHitContributions.clear();
+    m_caloHitAssociations.clear();
+    m_simTrackerHits.clear();
+    m_trackerHitAssociations.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+unsigned int SyntheticEventGenerator::Event::GetNCaloHits() const
+{
+    unsigned int nCaloHits(0);
+
+    for (unsigned int iRegion = 0; iRegion < N_CALO_REGIONS; ++iRegion)
+        nCaloHits += m_caloHits[iRegion].size();
+
+    return nCaloHits;
+}
@@ -0,0 +1,143 @@
+/**
+ *
+ *  @brief  Implementation of the trace recorder class.
+ *
+ *  $Log: $
+ */
+
+#include "TraceRecorder.h"
+
+#include <atomic>
+#include <fstream>
+
+namespace
+{
+    std::atomic<unsigned int> g_nextRecorderId(1);
+
+    /**
+     *  @brief  The buffer the calling thread last used, and the recorder it belongs to
+     */
+    struct ThreadBufferCache
+    {
+        unsigned int    m_recorderId;
+        void           *m_pBuffer;
+    };
+
+    thread_local ThreadBufferCache t_threadBufferCache = {0, NULL};
+
+    /**
+     *  @brief  Write a string as a json string literal
+     */
+    void WriteJsonString(std::ostream &stream, const std::string &text)
+    {
+        stream << '"';
+
+        for (const char character : text)
+        {
+            if (('"' == character) || ('\\' == character))
+                stream << '\\';
+
+            stream << character;
+        }
+
+        stream << '"';
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+TraceRecorder::TraceRecorder() :
+    m_recorderId(g_nextRecorderId++),
+    m_origin(Clock::now())
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void TraceRecorder::SetCurrentEvent(const int eventNumber)
+{
+    this->GetThreadBuffer().m_currentEvent = eventNumber;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void TraceRecorder::AddSpan(Span &span)
+{
+    ThreadBuffer &threadBuffer(this->GetThreadBuffer());
+    span.m_eventNumber = threadBuffer.m_currentEvent;
+    threadBuffer.m_spans.push_back(span);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+TraceRecorder::ThreadBuffer &TraceRecorder::GetThreadBuffer()
+{
+    if (m_recorderId == t_threadBufferCache.m_recorderId)
+        return *static_cast<ThreadBuffer*>(t_threadBufferCache.m_pBuffer);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ThreadBuffer *&pThreadBuffer(m_threadBuffers[std::this_thread::get_id()]);
+
+    if (!pThreadBuffer)
+    {
+        std::unique_ptr<ThreadBuffer> pNewThreadBuffer(new ThreadBuffer());
+        pNewThreadBuffer->m_threadIndex = m_buffers.size();
+        pNewThreadBuffer->m_currentEvent = -1;
+        pNewThreadBuffer->m_spans.reserve(4096);
+
+        pThreadBuffer = pNewThreadBuffer.get();
+        m_buffers.push_back(std::move(pNewThreadBuffer));
+    }
+
+    t_threadBufferCache.m_recorderId = m_recorderId;
+    t_threadBufferCache.m_pBuffer = pThreadBuffer;
+
+    return *pThreadBuffer;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool TraceRecorder::WriteJson(const std::string &fileName) const
+{
+    std::ofstream file(fileName.c_str());
+
+    if (!file.good())
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool isFirst(true);
+
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+
+    for (const std::unique_ptr<ThreadBuffer> &pThreadBuffer : m_buffers)
+    {
+        file << (isFirst ? "" : ",") << std::endl
+             << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << pThreadBuffer->m_threadIndex
+             << ", \"args\": {\"name\": \"worker " << pThreadBuffer->m_threadIndex << "\"}}";
+        isFirst = false;
+
+        for (const Span &span : pThreadBuffer->m_spans)
+        {
+            file << "," << std::endl << "{\"name\": ";
+            WriteJsonString(file, span.m_pName);
+            file << ", \"cat\": \"pandora\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << pThreadBuffer->m_threadIndex
+                 << ", \"ts\": " << span.m_start << ", \"dur\": " << span.m_duration
+                 << ", \"args\": {\"event\": " << span.m_eventNumber;
+
+            if (!span.m_detail.empty())
+            {
+                file << ", \"detail\": ";
+                WriteJsonString(file, span.m_detail);
+            }
+
+            for (unsigned int iArg = 0; iArg < span.m_nArgs; ++iArg)
+                file << ", \"" << span.m_argNames[iArg] << "\": " << span.m_argValues[iArg];
+
+            file << "}}";
+        }
+    }
+
+    file << std::endl << "]}" << std::endl;
+
+    return file.good();
+}
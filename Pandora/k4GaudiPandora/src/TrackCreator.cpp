@@ -18,31 +18,30 @@
 #include "gear/FTDParameters.h"
 #include "gear/FTDLayerLayout.h"
 
-#include "GaudiKernel/IService.h"
-#include "GearSvc/IGearSvc.h"
-#include "PandoraPFAlg.h"
+#include "edm4hep/TrackerHit.h"
+#include "CollectionMaps.h"
 
 #include "TrackCreator.h"
+#include "PandoraInputRecorder.h"
+#include "TraceRecorder.h"
 #include "Pandora/PdgTable.h"
 
 #include <algorithm>
 #include <cmath>
+#include <functional>
 #include <limits>
 
-TrackCreator::TrackCreator(const Settings &settings, const pandora::Pandora *const pPandora, ISvcLocator* svcloc) :
+TrackCreator::TrackCreator(const Settings &settings, const pandora::Pandora *const pPandora, gear::GearMgr *const pGearMgr) :
     m_settings(settings),
-    m_pPandora(pPandora)
+    m_pPandora(pPandora),
+    m_pTraceRecorder(NULL),
+    m_pInputRecorder(NULL),
+    m_tracksBound(false),
+    m_nTrackSlots(0),
+    m_nDuplicateTracks(0),
+    _GEAR(pGearMgr)
 {
 
-    IGearSvc*  iSvc = 0;
-    StatusCode sc = svcloc->service("GearSvc", iSvc, false);
-    if ( !sc ) 
-    {
-        throw "Failed to find GearSvc ...";
-    }
-    _GEAR = iSvc->getGearMgr();
-
-
     m_bField                  = (_GEAR->getBField().at(gear::Vector3D(0., 0., 0.)).z());
     m_tpcInnerR               = (_GEAR->getTPCParameters().getPadLayout().getPlaneExtent()[0]);
     m_tpcOuterR               = (_GEAR->getTPCParameters().getPadLayout().getPlaneExtent()[1]);
@@ -52,6 +51,7 @@ TrackCreator::TrackCreator(const Settings &settings, const pandora::Pandora *con
     m_eCalBarrelInnerPhi0     = (_GEAR->getEcalBarrelParameters().getPhi0());
     m_eCalBarrelInnerR        = (_GEAR->getEcalBarrelParameters().getExtent()[0]);
     m_eCalEndCapInnerZ        = (_GEAR->getEcalEndcapParameters().getExtent()[2]);
+    m_eCalBarrelFaces         = ECalBarrelFaces(m_eCalBarrelInnerSymmetry, m_eCalBarrelInnerPhi0, m_eCalBarrelInnerR);
     // fg: FTD description in GEAR has changed ...
     try
     {
@@ -105,6 +105,7 @@ TrackCreator::TrackCreator(const Settings &settings, const pandora::Pandora *con
     }
 
     m_tanLambdaFtd = m_ftdZPositions[0] / m_ftdOuterRadii[0];
+    this->InitialiseFtdLookups();
 
     // Calculate etd and set parameters
     // fg: make SET and ETD optional - as they might not be in the model ...
@@ -140,178 +141,102 @@ TrackCreator::~TrackCreator()
 
 pandora::StatusCode TrackCreator::CreateTrackAssociations(const CollectionMaps& collectionMaps)
 {
-    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->ExtractKinks(collectionMaps));
-    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->ExtractProngsAndSplits(collectionMaps));
-    PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->ExtractV0s(collectionMaps));
+    this->BindTracks(collectionMaps);
+
+    // Later collection types only add vertices whose tracks the earlier ones leave unused, so the order sets the precedence
+    this->AddVertices(collectionMaps, m_settings.m_kinkVertexCollections, VertexTopology::KINK_VERTEX);
+    this->AddVertices(collectionMaps, m_settings.m_prongSplitVertexCollections, VertexTopology::PRONG_SPLIT_VERTEX);
+    this->AddVertices(collectionMaps, m_settings.m_v0VertexCollections, VertexTopology::V0_VERTEX);
+
+    {
+        ScopedTraceSpan traceSpan(m_pTraceRecorder, "ResolveVertexTopology");
+        traceSpan.AddArg("nInput", m_vertexTopology.GetNVertices());
+        m_vertexTopology.Resolve(m_nTrackSlots);
+        traceSpan.AddArg("nAccepted", m_vertexTopology.GetNAcceptedVertices());
+    }
+
+    if (0 != m_settings.m_shouldFormTrackRelationships)
+        PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, this->SetTrackRelationships());
 
     return pandora::STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-pandora::StatusCode TrackCreator::ExtractKinks(const CollectionMaps& collectionMaps)
+
+void TrackCreator::AddVertices(const CollectionMaps& collectionMaps, const StringVector &collectionNames, const VertexTopology::VertexType vertexType)
 {
-    std::cout<<"start TrackCreator::ExtractKinks:"<<std::endl;
-    for (StringVector::const_iterator iter = m_settings.m_kinkVertexCollections.begin(), iterEnd = m_settings.m_kinkVertexCollections.end();
-        iter != iterEnd; ++iter)
+    for (StringVector::const_iterator iter = collectionNames.begin(), iterEnd = collectionNames.end(); iter != iterEnd; ++iter)
     {
-        if(collectionMaps.collectionMap_Vertex.find(*iter) == collectionMaps.collectionMap_Vertex.end()) { std::cout<<"not find "<<(*iter)<<std::endl; continue;}
+        const edm4hep::VertexCollection *const pVertexCollection(CollectionMaps::Find(collectionMaps.collectionMap_Vertex, *iter));
+        if(NULL == pVertexCollection) { std::cout<<"not find "<<(*iter)<<std::endl; continue;}
         try
         {
-            const std::vector<edm4hep::Vertex>& pKinkCollection = (collectionMaps.collectionMap_Vertex.find(*iter))->second;
+            ScopedTraceSpan traceSpan(m_pTraceRecorder, "AddVertices");
+            traceSpan.SetDetail(*iter);
+            traceSpan.AddArg("nInput", pVertexCollection->size());
 
-            for (int i = 0, iMax = pKinkCollection.size(); i < iMax; ++i)
+            for (int i = 0, iMax = pVertexCollection->size(); i < iMax; ++i)
             {
+                m_vertexTopology.BeginVertex(vertexType);
+
                 try
                 {
-                    const edm4hep::Vertex  pVertex0 = pKinkCollection.at(i);
-                    const edm4hep::Vertex* pVertex  = &(pVertex0);
-
-                    if (NULL == pVertex) throw ("Collection type mismatch");
-
-                    //std::cout<<"pVertex getChi2="<<pVertex->getChi2()<<std::endl;
-                    //std::cout<<"pReconstructedParticle en="<<pReconstructedParticle.getEnergy()<<",type="<<pReconstructedParticle.getType()<<std::endl;
-                    const edm4hep::ConstReconstructedParticle pReconstructedParticle = pVertex->getAssociatedParticle();
-                    if (this->IsConflictingRelationship(pReconstructedParticle))continue;
-
+                    const edm4hep::ConstReconstructedParticle pReconstructedParticle = pVertexCollection->at(i).getAssociatedParticle();
                     const int vertexPdgCode(pReconstructedParticle.getType());
 
-                    // Extract the kink vertex information
                     for (unsigned int iTrack = 0, nTracks = pReconstructedParticle.tracks_size(); iTrack < nTracks; ++iTrack)
                     {
-                        edm4hep::ConstTrack pTrack = pReconstructedParticle.getTracks(iTrack);
-                        (0 == iTrack) ? m_parentTrackList.insert(pTrack.id()) : m_daughterTrackList.insert(pTrack.id());
-
-                        int trackPdgCode = pandora::UNKNOWN_PARTICLE_TYPE;
-
-                        if (0 == iTrack)
-                        {
-                            trackPdgCode = vertexPdgCode;
-                        }
-                        else
-                        {
-                            switch (vertexPdgCode)
-                            {
-                            case pandora::PI_PLUS :
-                            case pandora::K_PLUS :
-                                trackPdgCode = pandora::MU_PLUS;
-                                break;
-                            case pandora::PI_MINUS :
-                            case pandora::K_MINUS :
-                                trackPdgCode = pandora::MU_MINUS;
-                                break;
-                            case pandora::HYPERON_MINUS_BAR :
-                            case pandora::SIGMA_PLUS :
-                                trackPdgCode = pandora::PI_PLUS;
-                                break;
-                            case pandora::SIGMA_MINUS :
-                            case pandora::HYPERON_MINUS :
-                                trackPdgCode = pandora::PI_PLUS;
-                                break;
-                            default :
-                                (pTrack.getTrackStates(0).omega > 0) ? trackPdgCode = pandora::PI_PLUS : trackPdgCode = pandora::PI_MINUS;
-                                break;
-                            }
-                        }
-
-                        m_trackToPidMap.insert(TrackToPidMap::value_type(pTrack, trackPdgCode));
-
-                        if (0 == m_settings.m_shouldFormTrackRelationships)
-                            continue;
-
-                        // Make track parent-daughter relationships
-                        if (0 == iTrack)
-                        {
-                            for (unsigned int jTrack = iTrack + 1; jTrack < nTracks; ++jTrack)
-                            {
-                                PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetTrackParentDaughterRelationship(*m_pPandora, GetTrackAddress(collectionMaps, pTrack), GetTrackAddress(collectionMaps, pReconstructedParticle.getTracks(jTrack) ) ) );
-                            }
-                        }
-
-                        // Make track sibling relationships
-                        else
-                        {
-                            for (unsigned int jTrack = iTrack + 1; jTrack < nTracks; ++jTrack)
-                            {
-                                PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetTrackSiblingRelationship(*m_pPandora, GetTrackAddress(collectionMaps, pTrack), GetTrackAddress(collectionMaps, pReconstructedParticle.getTracks(jTrack) ) ) );
-                            }
-                        }
+                        const edm4hep::ConstTrack pTrack = pReconstructedParticle.getTracks(iTrack);
+                        const int trackPdgCode(GetVertexTrackParticleId(vertexType, vertexPdgCode, iTrack, pTrack));
+                        m_vertexTopology.AddVertexTrack(this->GetTrackSlot(pTrack), trackPdgCode);
                     }
+
+                    m_vertexTopology.EndVertex();
                 }
                 catch (...)
                 {
-                    std::cout << "Failed to extract kink vertex: " <<  std::endl;
+                    m_vertexTopology.DiscardVertex();
+                    std::cout << "Failed to extract vertex " << i << " of vertex collection: " << *iter << std::endl;
                 }
             }
         }
         catch (...)
         {
-            std::cout << "Failed to extract kink vertex collection: " << *iter <<  std::endl;
+            std::cout << "Failed to extract vertex collection: " << *iter << std::endl;
         }
     }
-
-    return pandora::STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-pandora::StatusCode TrackCreator::ExtractProngsAndSplits(const CollectionMaps& collectionMaps)
+pandora::StatusCode TrackCreator::SetTrackRelationships() const
 {
-    std::cout<<"start TrackCreator::ExtractProngsAndSplits:"<<std::endl;
-    for (StringVector::const_iterator iter = m_settings.m_prongSplitVertexCollections.begin(), iterEnd = m_settings.m_prongSplitVertexCollections.end(); iter != iterEnd; ++iter)
+    ScopedTraceSpan traceSpan(m_pTraceRecorder, "SetTrackRelationships");
+
+    // Parent daughter relationships are listed from the parent, and each sibling pair once, from its lower slot
+    for (unsigned int slot = 0, nSlots = m_vertexTopology.GetNSlots(); slot < nSlots; ++slot)
     {
-        if(collectionMaps.collectionMap_Vertex.find(*iter) == collectionMaps.collectionMap_Vertex.end()) { std::cout<<"not find "<<(*iter)<<std::endl; continue;}
-        try
+        const edm4hep::Track *const pFirstTrack(this->GetSlotTrack(slot));
+
+        for (const unsigned int daughterSlot : m_vertexTopology.GetDaughters(slot))
         {
-            const std::vector<edm4hep::Vertex>& pProngOrSplitCollection = (collectionMaps.collectionMap_Vertex.find(*iter))->second;
+            const edm4hep::Track *const pSecondTrack(this->GetSlotTrack(daughterSlot));
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetTrackParentDaughterRelationship(*m_pPandora, pFirstTrack, pSecondTrack));
 
-            for (int i = 0, iMax = pProngOrSplitCollection.size(); i < iMax; ++i)
-            {
-                try
-                {
-                    const edm4hep::Vertex  pVertex0 = pProngOrSplitCollection.at(i);
-                    const edm4hep::Vertex* pVertex  = &(pVertex0);
+            if (NULL != m_pInputRecorder)
+                m_pInputRecorder->RecordTrackParentDaughterRelationship(pFirstTrack, pSecondTrack);
+        }
 
-                    if (NULL == pVertex) throw ("Collection type mismatch");
-                    const edm4hep::ConstReconstructedParticle pReconstructedParticle = pVertex->getAssociatedParticle();
+        for (const unsigned int siblingSlot : m_vertexTopology.GetSiblings(slot))
+        {
+            if (siblingSlot < slot)
+                continue;
 
-                    if (this->IsConflictingRelationship(pReconstructedParticle))continue;
+            const edm4hep::Track *const pSecondTrack(this->GetSlotTrack(siblingSlot));
+            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetTrackSiblingRelationship(*m_pPandora, pFirstTrack, pSecondTrack));
 
-                    // Extract the prong/split vertex information
-                    for (unsigned int iTrack = 0, nTracks = pReconstructedParticle.tracks_size(); iTrack < nTracks; ++iTrack)
-                    {
-                        edm4hep::ConstTrack pTrack = pReconstructedParticle.getTracks(iTrack);
-                        (0 == iTrack) ? m_parentTrackList.insert(pTrack.id()) : m_daughterTrackList.insert(pTrack.id());
-
-                        if (0 == m_settings.m_shouldFormTrackRelationships) continue;
-
-                        // Make track parent-daughter relationships
-                        if (0 == iTrack)
-                        {
-                            for (unsigned int jTrack = iTrack + 1; jTrack < nTracks; ++jTrack)
-                            {
-                                PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetTrackParentDaughterRelationship(*m_pPandora, GetTrackAddress(collectionMaps, pTrack), GetTrackAddress(collectionMaps, pReconstructedParticle.getTracks(jTrack) ) ) );
-                            }
-                        }
-
-                        // Make track sibling relationships
-                        else
-                        {
-                            for (unsigned int jTrack = iTrack + 1; jTrack < nTracks; ++jTrack)
-                            {
-                                PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetTrackSiblingRelationship(*m_pPandora, GetTrackAddress(collectionMaps, pTrack), GetTrackAddress(collectionMaps, pReconstructedParticle.getTracks(jTrack) ) ) );
-                            }
-                        }
-                    }
-                }
-                catch (...)
-                {
-                    std::cout << "Failed to extract prong/split vertex" <<std::endl;
-                }
-            }
-        }
-        catch (...)
-        {
-            std::cout<< "Failed to extract prong/split vertex collection: " << *iter << std::endl;
+            if (NULL != m_pInputRecorder)
+                m_pInputRecorder->RecordTrackSiblingRelationship(pFirstTrack, pSecondTrack);
         }
     }
 
@@ -320,209 +245,233 @@ pandora::StatusCode TrackCreator::ExtractProngsAndSplits(const CollectionMaps& c
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-pandora::StatusCode TrackCreator::ExtractV0s(const CollectionMaps& collectionMaps)
+int TrackCreator::GetVertexTrackParticleId(const VertexTopology::VertexType vertexType, const int vertexPdgCode, const unsigned int iTrack,
+    const edm4hep::ConstTrack &track)
 {
-    std::cout<<"start TrackCreator::ExtractV0s:"<<std::endl;
-    for (StringVector::const_iterator iter = m_settings.m_v0VertexCollections.begin(), iterEnd = m_settings.m_v0VertexCollections.end(); iter != iterEnd; ++iter)
+    if (VertexTopology::PRONG_SPLIT_VERTEX == vertexType)
+        return pandora::UNKNOWN_PARTICLE_TYPE;
+
+    const bool isPositive(track.getTrackStates(0).omega > 0);
+
+    if (VertexTopology::V0_VERTEX == vertexType)
     {
-        if(collectionMaps.collectionMap_Vertex.find(*iter) == collectionMaps.collectionMap_Vertex.end()) { std::cout<<"not find "<<(*iter)<<std::endl; continue;}
-        try
+        switch (vertexPdgCode)
         {
-            const std::vector<edm4hep::Vertex>& pV0Collection = (collectionMaps.collectionMap_Vertex.find(*iter))->second;
+        case pandora::PHOTON :
+            return isPositive ? pandora::E_PLUS : pandora::E_MINUS;
+        case pandora::LAMBDA :
+            return isPositive ? pandora::PROTON : pandora::PI_MINUS;
+        case pandora::LAMBDA_BAR :
+            return isPositive ? pandora::PI_PLUS : pandora::PROTON_BAR;
+        case pandora::K_SHORT :
+        default :
+            return isPositive ? pandora::PI_PLUS : pandora::PI_MINUS;
+        }
+    }
 
-            for (int i = 0, iMax = pV0Collection.size(); i < iMax; ++i)
-            {
-                try
-                {
-                    const edm4hep::Vertex  pVertex0 = pV0Collection.at(i);
-                    const edm4hep::Vertex* pVertex  = &(pVertex0);
+    // The kink parent takes the vertex particle id, the daughters the id of the expected decay product
+    if (0 == iTrack)
+        return vertexPdgCode;
 
-                    if (NULL == pVertex) throw ("Collection type mismatch");
+    switch (vertexPdgCode)
+    {
+    case pandora::PI_PLUS :
+    case pandora::K_PLUS :
+        return pandora::MU_PLUS;
+    case pandora::PI_MINUS :
+    case pandora::K_MINUS :
+        return pandora::MU_MINUS;
+    case pandora::HYPERON_MINUS_BAR :
+    case pandora::SIGMA_PLUS :
+        return pandora::PI_PLUS;
+    case pandora::SIGMA_MINUS :
+    case pandora::HYPERON_MINUS :
+        return pandora::PI_PLUS;
+    default :
+        return isPositive ? pandora::PI_PLUS : pandora::PI_MINUS;
+    }
+}
 
-                    const edm4hep::ConstReconstructedParticle pReconstructedParticle = pVertex->getAssociatedParticle();
+//------------------------------------------------------------------------------------------------------------------------------------------
 
-                    if (this->IsConflictingRelationship(pReconstructedParticle))continue;
+void TrackCreator::BindTracks(const CollectionMaps& collectionMaps)
+{
+    if (m_tracksBound)
+        return;
 
-                    // Extract the v0 vertex information
-                    const int vertexPdgCode(pReconstructedParticle.getType());
+    // Pandora keeps the addresses of the stored tracks, so the store must never reallocate while the event is processed
+    size_t nTracks(0);
 
-                    for (unsigned int iTrack = 0, nTracks = pReconstructedParticle.tracks_size(); iTrack < nTracks; ++iTrack)
-                    {
-                        edm4hep::ConstTrack pTrack = pReconstructedParticle.getTracks(iTrack);
-                        m_v0TrackList.insert(pTrack.id());
-
-                        int trackPdgCode = pandora::UNKNOWN_PARTICLE_TYPE;
-
-                        switch (vertexPdgCode)
-                        {
-                        case pandora::PHOTON :
-                            (pTrack.getTrackStates(0).omega > 0) ? trackPdgCode = pandora::E_PLUS : trackPdgCode = pandora::E_MINUS;
-                            break;
-                        case pandora::LAMBDA :
-                            (pTrack.getTrackStates(0).omega > 0) ? trackPdgCode = pandora::PROTON : trackPdgCode = pandora::PI_MINUS;
-                            break;
-                        case pandora::LAMBDA_BAR :
-                            (pTrack.getTrackStates(0).omega > 0) ? trackPdgCode = pandora::PI_PLUS : trackPdgCode = pandora::PROTON_BAR;
-                            break;
-                        case pandora::K_SHORT :
-                            (pTrack.getTrackStates(0).omega > 0) ? trackPdgCode = pandora::PI_PLUS : trackPdgCode = pandora::PI_MINUS;
-                            break;
-                        default :
-                            (pTrack.getTrackStates(0).omega > 0) ? trackPdgCode = pandora::PI_PLUS : trackPdgCode = pandora::PI_MINUS;
-                            break;
-                        }
-
-                        m_trackToPidMap.insert(TrackToPidMap::value_type(pTrack, trackPdgCode));
-
-                        if (0 == m_settings.m_shouldFormTrackRelationships) continue;
-
-                        // Make track sibling relationships
-                        for (unsigned int jTrack = iTrack + 1; jTrack < nTracks; ++jTrack)
-                        {
-                            PANDORA_RETURN_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::SetTrackSiblingRelationship(*m_pPandora, GetTrackAddress(collectionMaps, pTrack), GetTrackAddress(collectionMaps, pReconstructedParticle.getTracks(jTrack) ) ) );
-                        }
-                    }
-                }
-                catch (...)
+    for (StringVector::const_iterator iter = m_settings.m_trackCollections.begin(), iterEnd = m_settings.m_trackCollections.end(); iter != iterEnd; ++iter)
+    {
+        const edm4hep::TrackCollection *const pTrackCollection(CollectionMaps::Find(collectionMaps.collectionMap_Track, *iter));
+
+        if (NULL != pTrackCollection)
+            nTracks += pTrackCollection->size();
+    }
+
+    ScopedTraceSpan traceSpan(m_pTraceRecorder, "BindTracks");
+    traceSpan.AddArg("nInput", nTracks);
+
+    m_trackStore.reserve(nTracks);
+    m_trackVector.reserve(nTracks);
+    m_trackSlots.reserve(nTracks);
+    m_trackIds.Reserve(nTracks);
+
+    for (StringVector::const_iterator iter = m_settings.m_trackCollections.begin(), iterEnd = m_settings.m_trackCollections.end(); iter != iterEnd; ++iter)
+    {
+        const edm4hep::TrackCollection *const pTrackCollection(CollectionMaps::Find(collectionMaps.collectionMap_Track, *iter));
+        if(NULL == pTrackCollection) { std::cout<<"not find "<<(*iter)<<std::endl; continue;}
+
+        for (int i = 0, iMax = pTrackCollection->size(); i < iMax; ++i)
+        {
+            const edm4hep::Track track(pTrackCollection->at(i));
+            unsigned int slot(m_trackStore.size());
+
+            // The index always maps an id to its first copy, which is the one the address lookups return and whose flags are used
+            if (!m_trackIds.Insert(track.id(), slot, slot) && (KEEP_DUPLICATES != m_settings.m_duplicatePolicy))
+            {
+                ++m_nDuplicateTracks;
+
+                if (FAIL_ON_DUPLICATE == m_settings.m_duplicatePolicy)
                 {
-                    std::cout<< "Failed to extract v0 vertex" << std::endl;
+                    std::cout << "TrackCreator: track " << i << " of track collection " << *iter << " duplicates track id " << track.id() << std::endl;
+                    throw pandora::StatusCodeException(pandora::STATUS_CODE_ALREADY_PRESENT);
                 }
+
+                continue;
             }
-        }
-        catch (...)
-        {
-            std::cout << "Failed to extract v0 vertex collection: " << *iter << std::endl;
+
+            m_trackStore.push_back(track);
+            m_trackSlots.push_back(slot);
         }
     }
 
-    return pandora::STATUS_CODE_SUCCESS;
+    if (KEEP_DUPLICATES != m_settings.m_duplicatePolicy)
+        traceSpan.AddArg("nDuplicate", m_nDuplicateTracks);
+
+    // Tracks of the vertex collections that are not stored get slots beyond the stored ones as they are met
+    m_nTrackSlots = m_trackStore.size();
+    m_tracksBound = true;
 }
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-bool TrackCreator::IsConflictingRelationship(const edm4hep::ConstReconstructedParticle &Particle) const
+unsigned int TrackCreator::GetTrackSlot(const edm4hep::ConstTrack &track)
 {
-    for (unsigned int iTrack = 0, nTracks = Particle.tracks_size(); iTrack < nTracks; ++iTrack)
-    {
-        edm4hep::ConstTrack pTrack = Particle.getTracks(iTrack) ;
-        unsigned int pTrack_id = pTrack.id() ;
+    unsigned int slot(m_nTrackSlots);
 
-        if (this->IsDaughter(pTrack_id) || this->IsParent(pTrack_id) || this->IsV0(pTrack_id))
-            return true;
-    }
+    if (m_trackIds.Insert(track.id(), slot, slot))
+        ++m_nTrackSlots;
 
-    return false;
+    return slot;
 }
 
-const edm4hep::Track* TrackCreator::GetTrackAddress(const CollectionMaps& collectionMaps, const edm4hep::ConstTrack& pTrack )
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+unsigned char TrackCreator::GetTrackFlags(const edm4hep::Track *const pTrack) const
 {
-    for (StringVector::const_iterator iter = m_settings.m_trackCollections.begin(), iterEnd = m_settings.m_trackCollections.end(); iter != iterEnd; ++iter)
+    unsigned int slot(0);
+
+    // Stored tracks are found from their address, without a hash lookup
+    if (!m_trackStore.empty() && std::greater_equal<const edm4hep::Track *>()(pTrack, m_trackStore.data()) &&
+        std::less<const edm4hep::Track *>()(pTrack, m_trackStore.data() + m_trackStore.size()))
     {
-        if(collectionMaps.collectionMap_Track.find(*iter) == collectionMaps.collectionMap_Track.end()) { std::cout<<"not find "<<(*iter)<<std::endl; continue;}
-        const std::vector<edm4hep::Track>& pTrackCollection = (collectionMaps.collectionMap_Track.find(*iter))->second;
-        for (int i = 0, iMax = pTrackCollection.size(); i < iMax; ++i)
-        {
-            const edm4hep::Track& pTrack0 = pTrackCollection.at(i);
-            if (pTrack.id() == pTrack0.id()) return (const edm4hep::Track*) (&pTrack0);
-        }
+        slot = m_trackSlots[pTrack - m_trackStore.data()];
+    }
+    else if (!m_trackIds.Find(pTrack->id(), slot))
+    {
+        return 0;
     }
-    return NULL;
+
+    return m_vertexTopology.GetTrackFlags(slot);
 }
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 pandora::StatusCode TrackCreator::CreateTracks(const CollectionMaps& collectionMaps)
 {
     std::cout<<"start TrackCreator::CreateTracks:"<<std::endl;
-    for (StringVector::const_iterator iter = m_settings.m_trackCollections.begin(), iterEnd = m_settings.m_trackCollections.end();
-        iter != iterEnd; ++iter)
-    {
-        if(collectionMaps.collectionMap_Track.find(*iter) == collectionMaps.collectionMap_Track.end()) { std::cout<<"not find "<<(*iter)<<std::endl; continue;}
-        try
-        {
-            const std::vector<edm4hep::Track>& pTrackCollection = (collectionMaps.collectionMap_Track.find(*iter))->second;
+    this->BindTracks(collectionMaps);
 
-            for (int i = 0, iMax = pTrackCollection.size(); i < iMax; ++i)
-            {
-                try
-                {
-                    const edm4hep::Track& pTrack0 = pTrackCollection.at(i);
-                    const edm4hep::Track* pTrack  = (const edm4hep::Track*)(&pTrack0);
+    {
+        ScopedTraceSpan projectionSpan(m_pTraceRecorder, "ProjectTracksToCalorimeter");
+        projectionSpan.AddArg("nInput", m_trackStore.size());
+        this->CalculateTrackTimesAtCalorimeter(m_trackStore, m_genericTimesAtCalorimeter);
+        projectionSpan.AddArg("nSelected", m_projectionColumns.m_selectedTracks.size());
+    }
 
-                    if (NULL == pTrack) throw ("Collection type mismatch");
+    // Only the tracks passing the hit count cuts, selected during the projection
+    const UIntVector &selectedTracks(m_projectionColumns.m_selectedTracks);
 
-                    int minTrackHits = m_settings.m_minTrackHits;
-                    const float tanLambda(std::fabs(pTrack->getTrackStates(0).tanLambda));
+    ScopedTraceSpan traceSpan(m_pTraceRecorder, "CreateTracks");
+    traceSpan.AddArg("nInput", selectedTracks.size());
+    try
+    {
+        for (const unsigned int i : selectedTracks)
+        {
+            try
+            {
+                const edm4hep::Track* pTrack  = &(m_trackStore[i]);
 
-                    if (tanLambda > m_tanLambdaFtd)
-                    {
-                        int expectedFtdHits(0);
-
-                        for (unsigned int iFtdLayer = 0; iFtdLayer < m_nFtdLayers; ++iFtdLayer)
-                        {
-                            if ((tanLambda > m_ftdZPositions[iFtdLayer] / m_ftdOuterRadii[iFtdLayer]) &&
-                                (tanLambda < m_ftdZPositions[iFtdLayer] / m_ftdInnerRadii[iFtdLayer]))
-                            {
-                                expectedFtdHits++;
-                            }
-                        }
-
-                        minTrackHits = std::max(m_settings.m_minFtdTrackHits, expectedFtdHits);
-                    }
+                if (NULL == pTrack) throw ("Collection type mismatch");
 
-                    const int nTrackHits(static_cast<int>(pTrack->trackerHits_size()));
+                // Proceed to create the pandora track
+                PandoraApi::Track::Parameters trackParameters;
+                trackParameters.m_d0 = pTrack->getTrackStates(0).D0;
+                trackParameters.m_z0 = pTrack->getTrackStates(0).Z0;
+                trackParameters.m_pParentAddress = pTrack;
+                // By default, assume tracks are charged pions
+                const float signedCurvature(pTrack->getTrackStates(0).omega);
+                trackParameters.m_particleId = (signedCurvature > 0) ? pandora::PI_PLUS : pandora::PI_MINUS;
+                trackParameters.m_mass = pandora::PdgTable::GetParticleMass(pandora::PI_PLUS);
 
-                    if ((nTrackHits < minTrackHits) || (nTrackHits > m_settings.m_maxTrackHits)) continue;
+                // Use particle id information from V0 and Kink finders
+                int particleId(pandora::UNKNOWN_PARTICLE_TYPE);
 
-                    // Proceed to create the pandora track
-                    PandoraApi::Track::Parameters trackParameters;
-                    trackParameters.m_d0 = pTrack->getTrackStates(0).D0;
-                    trackParameters.m_z0 = pTrack->getTrackStates(0).Z0;
-                    trackParameters.m_pParentAddress = pTrack;
-                    // By default, assume tracks are charged pions
-                    const float signedCurvature(pTrack->getTrackStates(0).omega);
-                    trackParameters.m_particleId = (signedCurvature > 0) ? pandora::PI_PLUS : pandora::PI_MINUS;
-                    trackParameters.m_mass = pandora::PdgTable::GetParticleMass(pandora::PI_PLUS);
+                if (m_vertexTopology.GetTrackParticleId(m_trackSlots[i], particleId))
+                {
+                    trackParameters.m_particleId = particleId;
+                    trackParameters.m_mass = pandora::PdgTable::GetParticleMass(particleId);
+                }
 
-                    // Use particle id information from V0 and Kink finders
-                    TrackToPidMap::const_iterator iter_t = m_trackToPidMap.find(*pTrack);
+                if (std::numeric_limits<float>::epsilon() < std::fabs(signedCurvature))
+                    trackParameters.m_charge = static_cast<int>(signedCurvature / std::fabs(signedCurvature));
 
-                    if(iter_t != m_trackToPidMap.end())
-                    {
-                        trackParameters.m_particleId = (*iter_t).second;
-                        trackParameters.m_mass = pandora::PdgTable::GetParticleMass((*iter_t).second);
-                    }
+                this->GetTrackStates(pTrack, m_genericTimesAtCalorimeter[i], trackParameters);
+                this->TrackReachesECAL(pTrack, trackParameters);
+                this->DefineTrackPfoUsage(pTrack, trackParameters);
 
-                    if (std::numeric_limits<float>::epsilon() < std::fabs(signedCurvature))
-                        trackParameters.m_charge = static_cast<int>(signedCurvature / std::fabs(signedCurvature));
+                PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Track::Create(*m_pPandora, trackParameters));
 
-                    this->GetTrackStates(pTrack, trackParameters);
-                    this->TrackReachesECAL(pTrack, trackParameters);
-                    this->DefineTrackPfoUsage(pTrack, trackParameters);
+                if (NULL != m_pInputRecorder)
+                    m_pInputRecorder->RecordTrack(trackParameters);
 
-                    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Track::Create(*m_pPandora, trackParameters));
-                    m_trackVector.push_back(pTrack);
-                }
-                catch (pandora::StatusCodeException &statusCodeException)
-                {
-                    std::cout<<"Failed to extract a track: " << statusCodeException.ToString() << std::endl;
-                }
-                catch (...)
-                {
-                    std::cout << "Failed to extract a track "<< std::endl;
-                }
+                m_trackVector.push_back(pTrack);
+            }
+            catch (pandora::StatusCodeException &statusCodeException)
+            {
+                std::cout<<"Failed to extract a track: " << statusCodeException.ToString() << std::endl;
+            }
+            catch (...)
+            {
+                std::cout << "Failed to extract a track "<< std::endl;
             }
         }
-        catch (...)
-        {
-            std::cout<<"Failed to extract track collection: " << *iter << std::endl;
-        }
+    }
+    catch (...)
+    {
+        std::cout<<"Failed to extract tracks" << std::endl;
     }
 
+    traceSpan.AddArg("nCreated", m_trackVector.size());
+
     return pandora::STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void TrackCreator::GetTrackStates(const edm4hep::Track *const pTrack, PandoraApi::Track::Parameters &trackParameters) const
+void TrackCreator::GetTrackStates(const edm4hep::Track *const pTrack, const float genericTimeAtCalorimeter, PandoraApi::Track::Parameters &trackParameters) const
 {
     edm4hep::TrackState pTrackState = pTrack->getTrackStates(1); // ref  /cvmfs/cepcsw.ihep.ac.cn/prototype/LCIO/include/EVENT/TrackState.h 
 
@@ -540,8 +489,11 @@ void TrackCreator::GetTrackStates(const edm4hep::Track *const pTrack, PandoraApi
     
     trackParameters.m_isProjectedToEndCap = ((std::fabs(trackParameters.m_trackStateAtCalorimeter.Get().GetPosition().GetZ()) < m_eCalEndCapInnerZ) ? false : true);
 
+    if (std::isnan(genericTimeAtCalorimeter))
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_NOT_INITIALIZED);
+
     // Convert generic time (length from reference point to intersection, divided by momentum) into nanoseconds
-    const float minGenericTime(this->CalculateTrackTimeAtCalorimeter(pTrack));
+    const float minGenericTime(genericTimeAtCalorimeter);
     const float particleMass(trackParameters.m_mass.Get());
     const float particleEnergy(std::sqrt(particleMass * particleMass + trackParameters.m_momentumAtDca.Get().GetMagnitudeSquared()));
     trackParameters.m_timeAtCalorimeter = minGenericTime * particleEnergy / 299.792f;
@@ -554,6 +506,116 @@ float TrackCreator::CalculateTrackTimeAtCalorimeter(const edm4hep::Track *const
     const pandora::Helix helix(pTrack->getTrackStates(0).phi, pTrack->getTrackStates(0).D0, pTrack->getTrackStates(0).Z0, pTrack->getTrackStates(0).omega, pTrack->getTrackStates(0).tanLambda, m_bField);
     const pandora::CartesianVector &referencePoint(helix.GetReferencePoint());
 
+    unsigned int firstFace(0), nFaces(0);
+    this->GetCandidateECalFaces(helix.GetXCentre(), helix.GetYCentre(), helix.GetRadius(),
+        std::sqrt(referencePoint.GetX() * referencePoint.GetX() + referencePoint.GetY() * referencePoint.GetY()), firstFace, nFaces);
+
+    const float minGenericTime(this->GetGenericTimeAtCalorimeter(helix, firstFace, nFaces));
+
+    if (std::isnan(minGenericTime))
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_NOT_INITIALIZED);
+
+    return minGenericTime;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void TrackCreator::CalculateTrackTimesAtCalorimeter(const TrackStore &tracks, pandora::FloatVector &genericTimes)
+{
+    TrackProjectionColumns &columns(m_projectionColumns);
+    columns.m_selectedTracks.clear();
+    columns.m_helices.clear();
+    columns.m_trackIndices.clear();
+    columns.m_centreX.clear();
+    columns.m_centreY.clear();
+    columns.m_radius.clear();
+    columns.m_referenceR.clear();
+    genericTimes.assign(tracks.size(), std::numeric_limits<float>::quiet_NaN());
+
+    for (unsigned int iTrack = 0, nTracks = tracks.size(); iTrack < nTracks; ++iTrack)
+    {
+        // Rejected tracks are never created, so they are not projected either
+        if (!this->PassesTrackHitCuts(tracks[iTrack]))
+            continue;
+
+        columns.m_selectedTracks.push_back(iTrack);
+
+        try
+        {
+            const edm4hep::TrackState trackState(tracks[iTrack].getTrackStates(0));
+            columns.m_helices.push_back(pandora::Helix(trackState.phi, trackState.D0, trackState.Z0, trackState.omega, trackState.tanLambda, m_bField));
+        }
+        catch (pandora::StatusCodeException &)
+        {
+            continue;
+        }
+
+        const pandora::Helix &helix(columns.m_helices.back());
+        const pandora::CartesianVector &referencePoint(helix.GetReferencePoint());
+        columns.m_trackIndices.push_back(iTrack);
+        columns.m_centreX.push_back(helix.GetXCentre());
+        columns.m_centreY.push_back(helix.GetYCentre());
+        columns.m_radius.push_back(helix.GetRadius());
+        columns.m_referenceR.push_back(std::sqrt(referencePoint.GetX() * referencePoint.GetX() + referencePoint.GetY() * referencePoint.GetY()));
+    }
+
+    const unsigned int nHelices(columns.m_helices.size());
+    columns.m_firstFaces.resize(nHelices);
+    columns.m_nFaces.resize(nHelices);
+
+    for (unsigned int iHelix = 0; iHelix < nHelices; ++iHelix)
+    {
+        this->GetCandidateECalFaces(columns.m_centreX[iHelix], columns.m_centreY[iHelix], columns.m_radius[iHelix], columns.m_referenceR[iHelix],
+            columns.m_firstFaces[iHelix], columns.m_nFaces[iHelix]);
+    }
+
+    for (unsigned int iHelix = 0; iHelix < nHelices; ++iHelix)
+    {
+        genericTimes[columns.m_trackIndices[iHelix]] = this->GetGenericTimeAtCalorimeter(columns.m_helices[iHelix], columns.m_firstFaces[iHelix],
+            columns.m_nFaces[iHelix]);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void TrackCreator::GetCandidateECalFaces(const float centreX, const float centreY, const float radius, const float referenceR, unsigned int &firstFace,
+    unsigned int &nFaces) const
+{
+    const unsigned int nAllFaces(m_eCalBarrelFaces.m_pointX.size());
+    const double centreR(std::sqrt(static_cast<double>(centreX) * centreX + static_cast<double>(centreY) * centreY));
+    firstFace = 0;
+    nFaces = nAllFaces;
+
+    if ((nAllFaces < 3) || !(referenceR < m_eCalBarrelInnerR) || !(centreR > 0.))
+        return;
+
+    // Outside the inscribed circle, the helix circle is nearest the z axis either at the inscribed circle or at its tangent point
+    const double radiusSquared(static_cast<double>(radius) * radius);
+    const double minR(std::max(static_cast<double>(m_eCalBarrelInnerR), std::sqrt(std::max(0., centreR * centreR - radiusSquared))));
+    const double cosHalfSpan((centreR * centreR - radiusSquared + minR * minR) / (2. * centreR * minR));
+
+    // The margin keeps faces meeting at the exit point within the candidates despite rounding
+    const double halfFaceAngle(0.5 * m_eCalBarrelFaces.m_faceAngle);
+    const double halfSpan(std::acos(std::max(-1., std::min(1., cosHalfSpan))) + halfFaceAngle + 1.e-3);
+
+    if (halfSpan >= M_PI)
+        return;
+
+    const double centrePhi(std::atan2(static_cast<double>(centreY), static_cast<double>(centreX)) - m_eCalBarrelFaces.m_phi0);
+    const int firstCandidate(static_cast<int>(std::ceil((centrePhi - halfSpan) / m_eCalBarrelFaces.m_faceAngle)));
+    const int lastCandidate(static_cast<int>(std::floor((centrePhi + halfSpan) / m_eCalBarrelFaces.m_faceAngle)));
+    const int nSymmetry(static_cast<int>(nAllFaces));
+
+    firstFace = ((firstCandidate % nSymmetry) + nSymmetry) % nSymmetry;
+    nFaces = std::min(nAllFaces, static_cast<unsigned int>(std::max(0, lastCandidate - firstCandidate + 1)));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+float TrackCreator::GetGenericTimeAtCalorimeter(const pandora::Helix &helix, const unsigned int firstFace, const unsigned int nFaces) const
+{
+    const pandora::CartesianVector &referencePoint(helix.GetReferencePoint());
+
     // First project to endcap
     float minGenericTime(std::numeric_limits<float>::max());
 
@@ -566,15 +628,14 @@ float TrackCreator::CalculateTrackTimeAtCalorimeter(const edm4hep::Track *const
     if (m_eCalBarrelInnerSymmetry > 0)
     {
         // Polygon
-        float twopi_n = 2. * M_PI / (static_cast<float>(m_eCalBarrelInnerSymmetry));
+        const unsigned int nAllFaces(m_eCalBarrelFaces.m_pointX.size());
 
-        for (int i = 0; i < m_eCalBarrelInnerSymmetry; ++i)
+        for (unsigned int iFace = 0, face = firstFace; iFace < nFaces; ++iFace, face = (face + 1 < nAllFaces) ? face + 1 : 0)
         {
             float genericTime(std::numeric_limits<float>::max());
-            const float phi(twopi_n * static_cast<float>(i) + m_eCalBarrelInnerPhi0);
 
-            const pandora::StatusCode statusCode(helix.GetPointInXY(m_eCalBarrelInnerR * std::cos(phi), m_eCalBarrelInnerR * std::sin(phi),
-                std::cos(phi + 0.5 * M_PI), std::sin(phi + 0.5 * M_PI), referencePoint, barrelProjection, genericTime));
+            const pandora::StatusCode statusCode(helix.GetPointInXY(m_eCalBarrelFaces.m_pointX[face], m_eCalBarrelFaces.m_pointY[face],
+                m_eCalBarrelFaces.m_directionX[face], m_eCalBarrelFaces.m_directionY[face], referencePoint, barrelProjection, genericTime));
 
             if ((pandora::STATUS_CODE_SUCCESS == statusCode) && (genericTime < minGenericTime))
             {
@@ -597,7 +658,7 @@ float TrackCreator::CalculateTrackTimeAtCalorimeter(const edm4hep::Track *const
     }
 
     if (bestECalProjection.GetMagnitudeSquared() < std::numeric_limits<float>::epsilon())
-        throw pandora::StatusCodeException(pandora::STATUS_CODE_NOT_INITIALIZED);
+        return std::numeric_limits<float>::quiet_NaN();
 
     return minGenericTime;
 }
@@ -653,16 +714,9 @@ void TrackCreator::TrackReachesECAL(const edm4hep::Track *const pTrack, PandoraA
 
         if ((r > m_tpcInnerR) && (r < m_tpcOuterR) && (std::fabs(z) <= m_tpcZmax))  continue;
 
-        for (unsigned int j = 0; j < m_nFtdLayers; ++j)
-        {
-            if ((r > m_ftdInnerRadii[j]) && (r < m_ftdOuterRadii[j]) &&
-                (std::fabs(z) - m_settings.m_reachesECalFtdZMaxDistance < m_ftdZPositions[j]) &&
-                (std::fabs(z) + m_settings.m_reachesECalFtdZMaxDistance > m_ftdZPositions[j]))
-            {
-                if ( j > maxOccupiedFtdLayer) maxOccupiedFtdLayer = j;
-                break;
-            }
-        }
+        const int ftdLayer(this->GetFtdLayer(r, z));
+
+        if (ftdLayer > maxOccupiedFtdLayer) maxOccupiedFtdLayer = ftdLayer;
     }
     const int nTpcHits(this->GetNTpcHits(pTrack));
     const int nFtdHits(this->GetNFtdHits(pTrack));
@@ -709,8 +763,9 @@ void TrackCreator::DefineTrackPfoUsage(const edm4hep::Track *const pTrack, Pando
 {
     bool canFormPfo(false);
     bool canFormClusterlessPfo(false);
+    const unsigned char trackFlags(this->GetTrackFlags(pTrack));
 
-    if (trackParameters.m_reachesCalorimeter.Get() && !this->IsParent(pTrack->id()))
+    if (trackParameters.m_reachesCalorimeter.Get() && !this->IsParent(trackFlags))
     {
         const float d0(std::fabs(pTrack->getTrackStates(0).D0)), z0(std::fabs(pTrack->getTrackStates(0).Z0));
 
@@ -738,8 +793,8 @@ void TrackCreator::DefineTrackPfoUsage(const edm4hep::Track *const pTrack, Pando
             const float zCutForNonVertexTracks(m_tpcInnerR * std::fabs(pZ / pT) + m_settings.m_zCutForNonVertexTracks);
             const bool passRzQualityCuts((zMin < zCutForNonVertexTracks) && (rInner < m_tpcInnerR + m_settings.m_maxTpcInnerRDistance));
 
-            const bool isV0(this->IsV0(pTrack->id()));
-            const bool isDaughter(this->IsDaughter(pTrack->id()));
+            const bool isV0(this->IsV0(trackFlags));
+            const bool isDaughter(this->IsDaughter(trackFlags));
 
             // Decide whether track can be associated with a pandora cluster and used to form a charged PFO
             if ((d0 < m_settings.m_d0TrackCut) && (z0 < m_settings.m_z0TrackCut) && (rInner < m_tpcInnerR + m_settings.m_maxTpcInnerRDistance))
@@ -776,7 +831,7 @@ void TrackCreator::DefineTrackPfoUsage(const edm4hep::Track *const pTrack, Pando
                 }
             }
         }
-        else if (this->IsDaughter(pTrack->id()) || this->IsV0(pTrack->id()))
+        else if (this->IsDaughter(trackFlags) || this->IsV0(trackFlags))
         {
             std::cout<<"WARNING Recovering daughter or v0 track " << trackParameters.m_momentumAtDca.Get().GetMagnitude() << std::endl;
             canFormPfo = true;
@@ -890,6 +945,138 @@ int TrackCreator::GetNFtdHits(const edm4hep::Track *const pTrack) const
     return pTrack->getSubDetectorHitNumbers( 2 * 3 - 1 );// lcio::ILDDetID::FTD=3
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void TrackCreator::InitialiseFtdLookups()
+{
+    // A layer counts a track if z / outer radius < tan lambda < z / inner radius; empty windows never count and are left out
+    for (unsigned int iFtdLayer = 0; iFtdLayer < m_nFtdLayers; ++iFtdLayer)
+    {
+        const double minTanLambda(m_ftdZPositions[iFtdLayer] / m_ftdOuterRadii[iFtdLayer]);
+        const double maxTanLambda(m_ftdZPositions[iFtdLayer] / m_ftdInnerRadii[iFtdLayer]);
+
+        if (minTanLambda < maxTanLambda)
+        {
+            m_ftdMinTanLambdas.push_back(minTanLambda);
+            m_ftdMaxTanLambdas.push_back(maxTanLambda);
+        }
+    }
+
+    std::sort(m_ftdMinTanLambdas.begin(), m_ftdMinTanLambdas.end());
+    std::sort(m_ftdMaxTanLambdas.begin(), m_ftdMaxTanLambdas.end());
+
+    // A hit lies on a layer if |z| is within the z tolerance of the layer z; a zero or negative tolerance accepts no hits
+    const double zTolerance(m_settings.m_reachesECalFtdZMaxDistance);
+    m_ftdZBinMin = 0.;
+    m_ftdZBinInverseWidth = 0.;
+
+    if (!(zTolerance > 0.))
+        return;
+
+    // Each layer is listed in every bin its |z| range touches, widened so that rounding of the hit |z| cannot miss a bin
+    DoubleVector minZ, maxZ;
+
+    for (unsigned int iFtdLayer = 0; iFtdLayer < m_nFtdLayers; ++iFtdLayer)
+    {
+        const double margin(1.e-3 + 1.e-5 * (std::fabs(m_ftdZPositions[iFtdLayer]) + zTolerance));
+        minZ.push_back(m_ftdZPositions[iFtdLayer] - zTolerance - margin);
+        maxZ.push_back(m_ftdZPositions[iFtdLayer] + zTolerance + margin);
+    }
+
+    const double binMin(*std::min_element(minZ.begin(), minZ.end())), binMax(*std::max_element(maxZ.begin(), maxZ.end()));
+    const unsigned int nBins(static_cast<unsigned int>(std::max(1., std::min(1024., std::ceil((binMax - binMin) / (2. * zTolerance))))));
+
+    m_ftdZBinMin = binMin;
+    m_ftdZBinInverseWidth = static_cast<double>(nBins) / (binMax - binMin);
+    m_ftdZBinOffsets.assign(nBins + 1, 0);
+
+    UIntVector firstBins, lastBins;
+
+    for (unsigned int iFtdLayer = 0; iFtdLayer < m_nFtdLayers; ++iFtdLayer)
+    {
+        firstBins.push_back(std::min(nBins - 1, static_cast<unsigned int>((minZ[iFtdLayer] - binMin) * m_ftdZBinInverseWidth)));
+        lastBins.push_back(std::min(nBins - 1, static_cast<unsigned int>((maxZ[iFtdLayer] - binMin) * m_ftdZBinInverseWidth)));
+
+        for (unsigned int bin = firstBins.back(); bin <= lastBins.back(); ++bin)
+            ++m_ftdZBinOffsets[bin + 1];
+    }
+
+    for (unsigned int bin = 0; bin < nBins; ++bin)
+        m_ftdZBinOffsets[bin + 1] += m_ftdZBinOffsets[bin];
+
+    m_ftdZBinLayers.resize(m_ftdZBinOffsets[nBins]);
+    UIntVector fillPositions(m_ftdZBinOffsets.begin(), m_ftdZBinOffsets.end() - 1);
+
+    for (unsigned int iFtdLayer = 0; iFtdLayer < m_nFtdLayers; ++iFtdLayer)
+    {
+        for (unsigned int bin = firstBins[iFtdLayer]; bin <= lastBins[iFtdLayer]; ++bin)
+            m_ftdZBinLayers[fillPositions[bin]++] = iFtdLayer;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool TrackCreator::PassesTrackHitCuts(const edm4hep::Track &track) const
+{
+    // Without a track state at the ip the track cannot be created
+    if (0 == track.trackStates_size())
+        return false;
+
+    int minTrackHits(m_settings.m_minTrackHits);
+    const float tanLambda(std::fabs(track.getTrackStates(0).tanLambda));
+
+    if (tanLambda > m_tanLambdaFtd)
+    {
+        const int expectedFtdHits(this->GetNExpectedFtdHits(tanLambda));
+        minTrackHits = std::max(m_settings.m_minFtdTrackHits, expectedFtdHits);
+    }
+
+    const int nTrackHits(static_cast<int>(track.trackerHits_size()));
+
+    return (nTrackHits >= minTrackHits) && (nTrackHits <= m_settings.m_maxTrackHits);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int TrackCreator::GetNExpectedFtdHits(const float tanLambda) const
+{
+    // Every nonempty window whose upper bound is passed also has its lower bound passed
+    const int nAboveMin(std::lower_bound(m_ftdMinTanLambdas.begin(), m_ftdMinTanLambdas.end(), tanLambda) - m_ftdMinTanLambdas.begin());
+    const int nAtOrAboveMax(std::upper_bound(m_ftdMaxTanLambdas.begin(), m_ftdMaxTanLambdas.end(), tanLambda) - m_ftdMaxTanLambdas.begin());
+
+    return nAboveMin - nAtOrAboveMax;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int TrackCreator::GetFtdLayer(const float r, const float z) const
+{
+    if (m_ftdZBinOffsets.empty())
+        return -1;
+
+    const unsigned int nBins(m_ftdZBinOffsets.size() - 1);
+    const double binPosition((std::fabs(z) - m_ftdZBinMin) * m_ftdZBinInverseWidth);
+
+    if (!(binPosition >= 0.) || !(binPosition < static_cast<double>(nBins)))
+        return -1;
+
+    const unsigned int bin(static_cast<unsigned int>(binPosition));
+
+    for (unsigned int iCandidate = m_ftdZBinOffsets[bin], iEnd = m_ftdZBinOffsets[bin + 1]; iCandidate < iEnd; ++iCandidate)
+    {
+        const unsigned int j(m_ftdZBinLayers[iCandidate]);
+
+        if ((r > m_ftdInnerRadii[j]) && (r < m_ftdOuterRadii[j]) &&
+            (std::fabs(z) - m_settings.m_reachesECalFtdZMaxDistance < m_ftdZPositions[j]) &&
+            (std::fabs(z) + m_settings.m_reachesECalFtdZMaxDistance > m_ftdZPositions[j]))
+        {
+            return static_cast<int>(j);
+        }
+    }
+
+    return -1;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -920,6 +1107,38 @@ TrackCreator::Settings::Settings() :
     m_tpcMembraneMaxZ(10.f),
     m_maxTpcInnerRDistance(50.f),
     m_minTpcHitFractionOfExpected(0.2f),
-    m_minFtdHitsForTpcHitFraction(2)
+    m_minFtdHitsForTpcHitFraction(2),
+    m_duplicatePolicy(KEEP_DUPLICATES)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+TrackCreator::ECalBarrelFaces::ECalBarrelFaces() :
+    m_phi0(0.f),
+    m_faceAngle(0.f)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+TrackCreator::ECalBarrelFaces::ECalBarrelFaces(const int symmetryOrder, const float phi0, const float innerR) :
+    m_phi0(phi0),
+    m_faceAngle(0.f)
 {
+    if (symmetryOrder <= 0)
+        return;
+
+    // Evaluated exactly as the per track calculations they replace, so that the projections do not change
+    float twopi_n = 2. * M_PI / (static_cast<float>(symmetryOrder));
+    m_faceAngle = twopi_n;
+
+    for (int i = 0; i < symmetryOrder; ++i)
+    {
+        const float phi(twopi_n * static_cast<float>(i) + phi0);
+        m_pointX.push_back(innerR * std::cos(phi));
+        m_pointY.push_back(innerR * std::sin(phi));
+        m_directionX.push_back(std::cos(phi + 0.5 * M_PI));
+        m_directionY.push_back(std::sin(phi + 0.5 * M_PI));
+    }
 }
@@ -0,0 +1,132 @@
+/**
+ *
+ *  @brief  Implementation of the vertex topology class.
+ *
+ *  $Log: $
+ */
+
+#include "VertexTopology.h"
+
+VertexTopology::VertexTopology() :
+    m_vertexOffsets(1, 0),
+    m_nAcceptedVertices(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void VertexTopology::Clear()
+{
+    m_vertexTypes.clear();
+    m_vertexOffsets.assign(1, 0);
+    m_vertexTrackSlots.clear();
+    m_vertexTrackParticleIds.clear();
+    m_nAcceptedVertices = 0;
+
+    m_trackFlags.clear();
+    m_trackParticleIds.clear();
+    m_parentDaughterPairs.clear();
+    m_siblingPairs.clear();
+    m_parentOffsets.clear();
+    m_parentSlots.clear();
+    m_daughterOffsets.clear();
+    m_daughterSlots.clear();
+    m_siblingOffsets.clear();
+    m_siblingSlots.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void VertexTopology::Resolve(const unsigned int nSlots)
+{
+    m_nAcceptedVertices = 0;
+    m_trackFlags.assign(nSlots, 0);
+    m_trackParticleIds.assign(nSlots, 0);
+    m_parentDaughterPairs.clear();
+    m_siblingPairs.clear();
+
+    for (unsigned int iVertex = 0, nVertices = m_vertexTypes.size(); iVertex < nVertices; ++iVertex)
+    {
+        const VertexType vertexType(m_vertexTypes[iVertex]);
+        const unsigned int tracksBegin(m_vertexOffsets[iVertex]), tracksEnd(m_vertexOffsets[iVertex + 1]);
+        bool isConflicting(false);
+
+        // A track takes part in at most one accepted vertex, the first in configuration order
+        for (unsigned int iTrack = tracksBegin; !isConflicting && (iTrack < tracksEnd); ++iTrack)
+            isConflicting = (0 != (m_trackFlags[m_vertexTrackSlots[iTrack]] & (PARENT_TRACK | DAUGHTER_TRACK | V0_TRACK)));
+
+        if (isConflicting)
+            continue;
+
+        ++m_nAcceptedVertices;
+
+        for (unsigned int iTrack = tracksBegin; iTrack < tracksEnd; ++iTrack)
+        {
+            const unsigned int slot(m_vertexTrackSlots[iTrack]);
+            const bool isParent((V0_VERTEX != vertexType) && (tracksBegin == iTrack));
+            unsigned char &trackFlags(m_trackFlags[slot]);
+
+            trackFlags |= (V0_VERTEX == vertexType) ? V0_TRACK : isParent ? PARENT_TRACK : DAUGHTER_TRACK;
+
+            if ((PRONG_SPLIT_VERTEX != vertexType) && (0 == (trackFlags & HAS_PARTICLE_ID)))
+            {
+                trackFlags |= HAS_PARTICLE_ID;
+                m_trackParticleIds[slot] = m_vertexTrackParticleIds[iTrack];
+            }
+
+            for (unsigned int jTrack = iTrack + 1; jTrack < tracksEnd; ++jTrack)
+            {
+                const unsigned int otherSlot(m_vertexTrackSlots[jTrack]);
+
+                if (otherSlot == slot)
+                    continue;
+
+                if (isParent)
+                {
+                    m_parentDaughterPairs.push_back(SlotPair(slot, otherSlot));
+                }
+                else
+                {
+                    m_siblingPairs.push_back(SlotPair(slot, otherSlot));
+                }
+            }
+        }
+    }
+
+    this->FillAdjacency(m_parentDaughterPairs, false, true, m_parentOffsets, m_parentSlots);
+    this->FillAdjacency(m_parentDaughterPairs, true, false, m_daughterOffsets, m_daughterSlots);
+    this->FillAdjacency(m_siblingPairs, true, true, m_siblingOffsets, m_siblingSlots);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void VertexTopology::FillAdjacency(const SlotPairVector &slotPairs, const bool addForward, const bool addReverse, UIntVector &offsets,
+    UIntVector &adjacentSlots)
+{
+    const unsigned int nSlots(m_trackFlags.size());
+    offsets.assign(nSlots + 1, 0);
+
+    for (const SlotPair &slotPair : slotPairs)
+    {
+        if (addForward)
+            ++offsets[slotPair.first + 1];
+
+        if (addReverse)
+            ++offsets[slotPair.second + 1];
+    }
+
+    for (unsigned int slot = 0; slot < nSlots; ++slot)
+        offsets[slot + 1] += offsets[slot];
+
+    adjacentSlots.resize(offsets[nSlots]);
+    m_fillPositions.assign(offsets.begin(), offsets.end() - 1);
+
+    for (const SlotPair &slotPair : slotPairs)
+    {
+        if (addForward)
+            adjacentSlots[m_fillPositions[slotPair.first]++] = slotPair.second;
+
+        if (addReverse)
+            adjacentSlots[m_fillPositions[slotPair.second]++] = slotPair.first;
+    }
+}
@@ -0,0 +1,104 @@
+/**
+ *
+ *  @brief  Implementation of the worker pool class.
+ *
+ *  $Log: $
+ */
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(const unsigned int nThreads) :
+    m_pTask(NULL),
+    m_nTasks(0),
+    m_nextTask(0),
+    m_nBusyWorkers(0),
+    m_jobNumber(0),
+    m_isStopping(false)
+{
+    for (unsigned int iThread = 1; iThread < nThreads; ++iThread)
+        m_threads.push_back(std::thread(&WorkerPool::WorkerLoop, this));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+
+    m_jobStarted.notify_all();
+
+    for (std::thread &thread : m_threads)
+        thread.join();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void WorkerPool::Run(const unsigned int nTasks, const Task &task)
+{
+    if (m_threads.empty() || (nTasks < 2))
+    {
+        for (unsigned int iTask = 0; iTask < nTasks; ++iTask)
+            task(iTask);
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pTask = &task;
+        m_nTasks = nTasks;
+        m_nextTask = 0;
+        m_nBusyWorkers = m_threads.size();
+        ++m_jobNumber;
+    }
+
+    m_jobStarted.notify_all();
+    this->RunTasks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobFinished.wait(lock, [this]{ return 0 == m_nBusyWorkers; });
+    m_pTask = NULL;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void WorkerPool::WorkerLoop()
+{
+    unsigned long lastJobNumber(0);
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobStarted.wait(lock, [this, lastJobNumber]{ return m_isStopping || (m_jobNumber != lastJobNumber); });
+
+            if (m_isStopping)
+                return;
+
+            lastJobNumber = m_jobNumber;
+        }
+
+        this->RunTasks();
+
+        bool isLastWorker(false);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            isLastWorker = (0 == --m_nBusyWorkers);
+        }
+
+        if (isLastWorker)
+            m_jobFinished.notify_one();
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void WorkerPool::RunTasks()
+{
+    // The job description is only written while no worker is busy, so it can be read here without the lock
+    for (unsigned int iTask = m_nextTask++; iTask < m_nTasks; iTask = m_nextTask++)
+        (*m_pTask)(iTask);
+}
@@ -0,0 +1,208 @@
+/**
+ *
+ *  @brief  Checks the calo hit duplicate detection on synthetic events: an ecal and an hcal hit sharing a cell id are not
+ *          duplicates, as the ecal and hcal encodings have no system field, while a second ecal hit with the cell id of an ecal hit
+ *          is. Exits with 1 on any wrong count.
+ *
+ *  $Log: $
+ */
+
+#include "gearxml/GearXML.h"
+#include "gear/BField.h"
+#include "gear/GEAR.h"
+#include "gear/GearMgr.h"
+
+#include "edm4hep/CalorimeterHitCollection.h"
+
+#include "Api/PandoraApi.h"
+#include "LCContent.h"
+
+#include "BenchmarkCreatorSettings.h"
+#include "CaloHitCreator.h"
+#include "CollectionMaps.h"
+#include "GeometryCreator.h"
+#include "SyntheticEventGenerator.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace
+{
+    /**
+     *  @brief  The command line parameters
+     */
+    class Parameters
+    {
+    public:
+        std::string     m_gearFile;                             ///< The gear xml file describing the detector
+        std::string     m_settingsFile = "PandoraSettingsDefault.xml"; ///< The pandora settings xml file
+        SyntheticEventGenerator::Settings m_generatorSettings;  ///< The event generator settings
+    };
+
+    void PrintUsage(const char *const pProgramName)
+    {
+        std::cout << "Usage: " << pProgramName << " -g FullDetGear.xml [-s PandoraSettings.xml] [-r seed]" << std::endl
+                  << "    -g  gear xml file describing the detector" << std::endl
+                  << "    -s  pandora settings xml file, default PandoraSettingsDefault.xml" << std::endl
+                  << "    -r  random seed, default " << SyntheticEventGenerator::Settings().m_seed << std::endl;
+    }
+
+    bool ParseCommandLine(const int argc, char *argv[], Parameters &parameters)
+    {
+        for (int iArg = 1; iArg < argc; ++iArg)
+        {
+            const std::string option(argv[iArg]);
+
+            if (iArg + 1 >= argc)
+                return false;
+
+            const std::string value(argv[++iArg]);
+
+            if ("-g" == option) parameters.m_gearFile = value;
+            else if ("-s" == option) parameters.m_settingsFile = value;
+            else if ("-r" == option) parameters.m_generatorSettings.m_seed = std::atoi(value.c_str());
+            else return false;
+        }
+
+        return !parameters.m_gearFile.empty();
+    }
+
+    /**
+     *  @brief  Append a copy of a calo hit to a collection
+     *
+     *  @param  caloHit the calo hit
+     *  @param  cellId the cell id of the copy
+     *  @param  caloHitCollection the collection to receive the copy
+     */
+    void AppendCaloHit(const edm4hep::CalorimeterHit &caloHit, const uint64_t cellId, edm4hep::CalorimeterHitCollection &caloHitCollection)
+    {
+        edm4hep::CalorimeterHit copy(caloHitCollection.create());
+        copy.setCellID(cellId);
+        copy.setEnergy(caloHit.getEnergy());
+        copy.setEnergyError(caloHit.getEnergyError());
+        copy.setTime(caloHit.getTime());
+        copy.setPosition(caloHit.getPosition());
+        copy.setType(caloHit.getType());
+    }
+
+    /**
+     *  @brief  Create the calo hits of an event and reset the creator and pandora
+     *
+     *  @param  collectionMaps the event collections
+     *  @param  pandora the pandora instance
+     *  @param  caloHitCreator the calo hit creator
+     *
+     *  @return the number of duplicate calo hits found
+     */
+    unsigned int CountDuplicateCaloHits(const CollectionMaps &collectionMaps, const pandora::Pandora &pandora, CaloHitCreator &caloHitCreator)
+    {
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, caloHitCreator.CreateCaloHits(collectionMaps));
+        const unsigned int nDuplicateCaloHits(caloHitCreator.GetNDuplicateCaloHits());
+
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(pandora));
+        caloHitCreator.Reset();
+
+        return nDuplicateCaloHits;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    Parameters parameters;
+
+    if (!ParseCommandLine(argc, argv, parameters))
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        gear::GearXML gearXML(parameters.m_gearFile);
+        std::unique_ptr<gear::GearMgr> pGearMgr(gearXML.createGearMgr());
+
+        const float innerBField(pGearMgr->getBField().at(gear::Vector3D(0., 0., 0.)).z());
+        BenchmarkCreatorSettings creatorSettings(parameters.m_generatorSettings, innerBField);
+        creatorSettings.m_caloHitCreatorSettings.m_duplicatePolicy = KEEP_FIRST;
+
+        const std::unique_ptr<pandora::Pandora> pPandora(new pandora::Pandora());
+        GeometryCreator geometryCreator(creatorSettings.m_geometryCreatorSettings, pPandora.get());
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, geometryCreator.CreateGeometry(pGearMgr.get()));
+
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterAlgorithms(*pPandora));
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterBasicPlugins(*pPandora));
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, LCContent::RegisterBFieldPlugin(*pPandora, innerBField, -1.5f, 0.01f));
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*pPandora, parameters.m_settingsFile));
+
+        CaloHitCreator caloHitCreator(creatorSettings.m_caloHitCreatorSettings, pPandora.get(), pGearMgr.get(), 0);
+
+        SyntheticEventGenerator generator(parameters.m_generatorSettings, pGearMgr.get());
+        SyntheticEventGenerator::Event event;
+        generator.Generate(event);
+
+        const edm4hep::CalorimeterHitCollection &eCalBarrelHits(event.m_caloHits[SyntheticEventGenerator::ECAL_BARREL]);
+        const edm4hep::CalorimeterHitCollection &hCalBarrelHits(event.m_caloHits[SyntheticEventGenerator::HCAL_BARREL]);
+
+        if ((0 == eCalBarrelHits.size()) || (0 == hCalBarrelHits.size()))
+        {
+            std::cout << "Calo hit duplicate test: the event has no ecal or no hcal barrel hits" << std::endl;
+            return 1;
+        }
+
+        // The collections the creator reads: the generated barrel hits, with the first hcal hit moved to the cell id of the first ecal hit
+        edm4hep::CalorimeterHitCollection eCalHits, hCalHits, eCalEndCapHits;
+        eCalHits.setID(1);
+        hCalHits.setID(2);
+        eCalEndCapHits.setID(3);
+
+        for (unsigned int i = 0; i < eCalBarrelHits.size(); ++i)
+            AppendCaloHit(eCalBarrelHits.at(i), eCalBarrelHits.at(i).getCellID(), eCalHits);
+
+        for (unsigned int i = 0; i < hCalBarrelHits.size(); ++i)
+            AppendCaloHit(hCalBarrelHits.at(i), (0 == i) ? eCalBarrelHits.at(0).getCellID() : hCalBarrelHits.at(i).getCellID(), hCalHits);
+
+        const SyntheticEventGenerator::Settings &generatorSettings(parameters.m_generatorSettings);
+        CollectionMaps collectionMaps;
+        collectionMaps.collectionMap_CaloHit[generatorSettings.m_caloHitCollectionNames[SyntheticEventGenerator::ECAL_BARREL]] = &eCalHits;
+        collectionMaps.collectionMap_CaloHit[generatorSettings.m_caloHitCollectionNames[SyntheticEventGenerator::HCAL_BARREL]] = &hCalHits;
+        collectionMaps.collectionMap_CaloHit[generatorSettings.m_caloHitCollectionNames[SyntheticEventGenerator::ECAL_ENDCAP]] = &eCalEndCapHits;
+
+        const unsigned int nCrossDetectorDuplicates(CountDuplicateCaloHits(collectionMaps, *pPandora, caloHitCreator));
+
+        if (0 != nCrossDetectorDuplicates)
+        {
+            std::cout << "Calo hit duplicate test: an ecal and an hcal hit sharing a cell id gave " << nCrossDetectorDuplicates
+                      << " duplicates, expected 0" << std::endl;
+            return 1;
+        }
+
+        // A copy of an ecal hit in another ecal collection is a duplicate
+        AppendCaloHit(eCalBarrelHits.at(0), eCalBarrelHits.at(0).getCellID(), eCalEndCapHits);
+        const unsigned int nEcalDuplicates(CountDuplicateCaloHits(collectionMaps, *pPandora, caloHitCreator));
+
+        if (1 != nEcalDuplicates)
+        {
+            std::cout << "Calo hit duplicate test: two ecal hits sharing a cell id gave " << nEcalDuplicates << " duplicates, expected 1"
+                      << std::endl;
+            return 1;
+        }
+
+        std::cout << "Calo hit duplicate test: duplicates found within the ecal only" << std::endl;
+    }
+    catch (pandora::StatusCodeException &statusCodeException)
+    {
+        std::cout << "Calo hit duplicate test failed: " << statusCodeException.ToString() << std::endl;
+        return 1;
+    }
+    catch (gear::Exception &exception)
+    {
+        std::cout << "Calo hit duplicate test failed to read the geometry: " << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
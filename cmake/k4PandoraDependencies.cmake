@@ -16,6 +16,7 @@ Find all the dependencies here, so in each package user don't need to find the p
 - PandoraSDK
 - podio
 - ROOT
+- Threads
 #]]
 
 find_package(CLHEP REQUIRED;CONFIG)
@@ -31,3 +32,4 @@ find_package(LCIO REQUIRED)
 find_package(PandoraSDK REQUIRED)
 find_package(podio REQUIRED)
 find_package(ROOT COMPONENTS EG Graf Graf3d Gpad MathCore Net RIO Tree TreePlayer REQUIRED)
+find_package(Threads REQUIRED)